@@ -1,13 +1,32 @@
 #include "app_TLV320ADC5120.h"
 #include "driver_TLV320ADC5120.h"
+#include "dsp_biquad.h"
+#include "dsp_charge.h"
+#include "dsp_cic.h"
+#include "dsp_drift.h"
+#include "dsp_fft.h"
+#include "dsp_lossless.h"
+#include "dsp_merge.h"
+#include "dsp_pack24.h"
+#include "dsp_resample.h"
+#include "dsp_sdt.h"
+#include "dsp_stats.h"
+#include "dsp_trigger.h"
+#include "dsp_units.h"
 #include "model_sample.h"
 #include "models.h"
 #include "util_mqtt.h"
+#include "util_pipe.h"
 #include "util_net_events.h"
 #include "util_err.h"
+#include "util_flash.h"
+#include "util_hist.h"
+#include "util_time.h"
 
 // #include "driver/i2c_master.h"
 #include "driver/i2s_std.h"
+#include "esp_heap_caps.h"
+#include "sdkconfig.h"
 #include "esp_timer.h"
 #include "freertos/queue.h"
 #include "freertos/task.h"
@@ -15,19 +34,18 @@
 
 
 #include "cJSON.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
 
 static const char *TAG = "APP_TLV";
 static volatile bool s_running = false;
 static uint32_t s_seq = 0;
 
-// Queue for handing off 512-byte blocks to the publisher
-static QueueHandle_t s_publish_q = NULL;
-
 // Forward declarations
-static void sampler_task(void *arg);
 static void publisher_task(void *arg);
 
-/* ---------- Downsample 8:1 (8 x 8ms → one 64ms block @1 kHz) ---------- */
+/* ---------- Sample layout helpers ---------- */
 
 static inline int32_t sign_extend_24(uint32_t x32) { return (int32_t)(x32 << 8) >> 8; }
 static inline uint32_t pack_24_right_justified(int32_t v) {
@@ -36,57 +54,44 @@ static inline uint32_t pack_24_right_justified(int32_t v) {
     return (uint32_t)(v & 0x00FFFFFF);
 }
 
-/* in8: 8 source blocks, out: one downsampled 512B block (64 frames, 2x32-bit each) */
-static void decimate8_to1(const uint8_t in8[8][512], uint8_t out[512]) {
-    const uint32_t *src[8];
-    for (int k = 0; k < 8; ++k) src[k] = (const uint32_t *)in8[k];
+/* n samples in the ring layout (sb = 4: 24-in-32 words, sb = 3: packed) -> int32 */
+static void load_samples(const uint8_t *in, uint32_t sb, uint32_t n, int32_t *out) {
+    if (sb == 3) {
+        dsp_unpack24(in, out, n);
+        return;
+    }
+    const uint32_t *w = (const uint32_t *)in;
+    for (uint32_t i = 0; i < n; ++i) out[i] = sign_extend_24(w[i]);
+}
 
-    uint32_t *dst = (uint32_t *)out;
-    for (int i = 0; i < 64; ++i) {
-        int64_t accL = 0, accR = 0;
-        for (int k = 0; k < 8; ++k) {
-            accL += sign_extend_24(src[k][2*i + 0]);
-            accR += sign_extend_24(src[k][2*i + 1]);
+/* n int32 samples -> ring layout */
+static void store_samples(const int32_t *in, uint32_t sb, uint32_t n, uint8_t *out) {
+    for (uint32_t i = 0; i < n; ++i) {
+        if (sb == 3) {
+            dsp_st24(out + 3 * i, in[i]);
+        } else {
+            ((uint32_t *)out)[i] = pack_24_right_justified(in[i]);
         }
-        int32_t dL = (int32_t)(accL / 8);
-        int32_t dR = (int32_t)(accR / 8);
-        dst[2*i + 0] = pack_24_right_justified(dL);
-        dst[2*i + 1] = pack_24_right_justified(dR);
     }
 }
 
 
-// Convert I2S 32-bit words containing right-justified 24-bit samples to float volts.
-// ADC single-ended full-scale is 1 VRMS; scale to instantaneous voltage as needed. [1](https://www.ti.com/lit/ds/symlink/tlv320adc5120.pdf?ts=1751362068444)
-static inline float s32_to_volts(int32_t x) {
-    // x: 24-bit sample in low bits of 32-bit slot (right-justified). Sign-extend 24→32.
-    x = (x << 8) >> 8;
-    // Normalize to [-1, 1] using 23-bit magnitude (signed 24-bit)
-    const float norm = (float)x / (float)(1 << 23);
-    // If you want peak volts referenced to 1.0 FS, multiply by 1.0 (VRMS scaling is application-specific).
-    return norm; // "FS=1.0" units; you can later multiply by actual FS volts if needed
-}
-
-// Current from INA outputs: Vout = Gain * I * Rshunt → I = Vout / (Gain * R)
-// INA213 gain=50; INA212 gain=1000; R=2Ω. [4](https://www.ti.com/lit/ds/symlink/ina212.pdf)
-static inline float volts_to_current_A(float v_out, float gain) {
-    const float R = 2.0f; // ohms
-    return v_out / (gain * R);
-}
-
 static uint32_t blocks_published = 0;
-static void publish_one_block(const uint8_t raw[512]) {
+static void publish_one_block(const uint8_t *raw) {
+    tlv320adc5120_geometry_t geo;
+    tlv320adc5120_get_geometry(&geo);
+
     sample_t s = {
         .hw_class = DEF_HW_CLASS,
         .hw_version = DEF_HW_VERSION,
         .serial = DEF_SERIAL, // fill with MAC-based ID if available
         .seq = s_seq++,
         .timestamp_ms = (uint32_t)(esp_timer_get_time() / 1000),
-        .sample_rate_hz = 8000, // if you expose s_cfg or pass in value
+        .sample_rate_hz = geo.sample_rate_hz,
     };
     
     // LOG_INFO(TAG, "Publishing to jaqc/sig/sample");
-    memcpy(s.blob, raw, 512);
+    memcpy(s.blob, raw, geo.block_bytes < sizeof(s.blob) ? geo.block_bytes : sizeof(s.blob));
     
     if (!util_mqtt_is_ready()) {
         // LOG_WARN(TAG, ESP_FAIL, "MQTT not ready; drop sample seq=%u", (unsigned)s.seq);
@@ -112,51 +117,6 @@ static void publish_one_block(const uint8_t raw[512]) {
     }
     
     blocks_published++;
-    // Optional: parse the 512B as 64 stereo frames of 32-bit slots and compute currents
-    // for (int i = 0; i < 64; ++i) {
-    //     int32_t ch1 = ((int32_t*)block)[2*i + 0];
-    //     int32_t ch2 = ((int32_t*)block)[2*i + 1];
-    //     float v1 = s32_to_volts(ch1);
-    //     float v2 = s32_to_volts(ch2);
-    //     float i_lo = volts_to_current_A(v1, 50.0f);    // INA213
-    //     float i_hi = volts_to_current_A(v2, 1000.0f);  // INA212
-    //     // ... accumulate if needed ...
-    // }
-}
-
-static uint32_t s_blk_count = 0;
-static uint32_t s_missed_blk_count = 0;
-// Task @125Hz: pop a 512B block and publish
-static void sampler_task(void *arg) {
-    LOG_INFO(TAG, "sampler_task started");
-    uint8_t block[TLV_DMA_BUF_SZ];
-    const TickType_t period = pdMS_TO_TICKS(8);
-    // uint32_t enq = 0; /* TODO: Remove after debug */
-    while (s_running) {
-        vTaskDelay(period);
-
-        if (tlv320adc5120_pop(block)) {
-
-            // Try to enqueue; if queue is full, drop or block briefly
-            if (xQueueSend(s_publish_q, block, 0) != pdPASS) {
-            // if (xQueueSend(s_publish_q, block, pdMS_TO_TICKS(2)) == pdPASS) {
-                // if ((++enq % 100) == 0) { /* TODO: Remove after debug */
-                //     LOG_INFO(TAG, "sampler: %lu blocks enqueued", enq);
-                // }
-            // } else {
-            //     LOG_WARN(TAG, ESP_FAIL, "sampler: queue full; dropping");
-                s_missed_blk_count++;
-            }
-            s_blk_count++;
-
-            if(s_blk_count % 64 == 0) {
-                LOG_INFO(TAG, "%lu / %lu failed", s_missed_blk_count, s_blk_count);
-            }
-        }
-
-        taskYIELD();
-    }
-    vTaskDelete(NULL);
 }
 
 // static void publisher_task(void *arg) {
@@ -255,136 +215,2328 @@ static void sampler_task(void *arg) {
 
 /* END RAW DATA MESSAGE V1 ******************************************/
 
-/* RAW DATA MESSAGE V2 **********************************************/
-// Little-Endian V2 header
+/* RAW DATA MESSAGE V4 **********************************************/
+// Little-Endian V4 header: v3 (unchanged up to clk_ppb) plus 64-bit acquisition
+// times. v3 has where each channel comes from when several ADCs share the TDM
+// line and the measured sample clock (see SAMPLE CLOCK). JQMS / JQMF / JQMD /
+// JQMC channels are in the same order as the map. Times come from the DMA
+// completion stamp of each raw block, less the decimation chain's group delay;
+// frame k of the payload is at t_us + k / sample_rate.
 typedef struct __attribute__((packed)) {
     uint8_t  magic[4];     // "JQMB"
-    uint8_t  version;      // 0x02
+    uint8_t  version;      // 0x04
     uint8_t  flags;        // bit0: LE=1, bit1: Philips-I2S=1
     uint16_t hdr_len;      // sizeof this header
     uint32_t seq_first;    // sequence of the first block in this batch
     uint16_t block_count;  // N blocks in this payload
     uint16_t block_size;   // bytes per block (512)
-    uint32_t ts_ms;        // timestamp of first block (or batch time)
+    uint32_t ts_ms;        // t_us / 1000, wraps after 49 days; kept for v2 / v3 readers
     uint16_t sample_rate;  // e.g., 8000
     uint8_t  ch_count;     // 2
     uint8_t  word_bits;    // 24
-    uint8_t  slot_bits;    // 32
+    uint8_t  slot_bits;    // 32 = 24-in-32 words; 24 = packed 3-byte samples
     uint8_t  reserved;     // align/reserved
     uint32_t dev_id;       // device id (32-bit)
-} sample_mb_hdr_v2_t;
-
-#define DS_N_SOURCE         8       // batch size
-#define DS_BLOCK_BYTES      512
+    uint8_t  adc_count;    // ADCs on the data line
+    uint8_t  adc_addr[TLV_MAX_DEVS]; // their I2C addresses, in slot order
+    uint8_t  reserved2[3];
+    uint8_t  ch_map[TLV_MAX_CH];     // per channel: ADC index << 4 | ADC channel (1..4);
+                                     // a gain-merged channel maps to its low-gain input
+    int32_t  clk_ppb;      // measured sample clock error vs nominal, ppb (INT32_MIN = not yet
+                           // locked); against UTC with flags bit6, else the local crystal
+    int64_t  t_us;         // esp_timer time of the first frame
+    int64_t  utc_us;       // the same instant in UTC us since the epoch (util_time); 0 before SNTP sync
+} sample_mb_hdr_v4_t;
+
+#define DS_CUTOFF           0.4f    // anti-alias -6 dB point, as a fraction of the output rate
+#define DS_CIC_ORDER        4       // CIC stages in front of the compensation FIR
+#define DS_MAX_STREAMS      4       // output rates published from one raw stream
+#define DS_PUBLISH_MS       1000    // slow streams shrink their blocks to publish about this often
 #define BATCH_DS_BLOCKS     4       // publish 4 ds blocks per MQTT msg
 #define TOPIC_MAX           64
+#define CLK_NONE            INT32_MIN   // clk_ppb before the clock estimate locks
 
 static uint32_t s_dev_id = 0xA1B2C3D4; // TODO: derive from MAC/NVS
-static char s_topic_raw[TOPIC_MAX];
 
-static inline void make_raw_topic(void) {
-    snprintf(s_topic_raw, sizeof(s_topic_raw), "jaqc/sig/sample/raw/v2/%08X", (unsigned)s_dev_id);
+/* Common JQMB v4 fields: ch channels taken every `stride` from the ring's
+   (2 for gain-merged pairs, else 1) */
+static void mb_hdr_init(sample_mb_hdr_v4_t *hdr, const tlv320adc5120_geometry_t *geo,
+    uint8_t flags, uint32_t ch, uint32_t stride, uint32_t sb
+) {
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, "JQMB", 4);
+    hdr->version   = 0x04;
+    hdr->flags     = flags;
+    hdr->hdr_len   = sizeof(*hdr);
+    hdr->ch_count  = (uint8_t)ch;
+    hdr->word_bits = 24;
+    hdr->slot_bits = (uint8_t)(sb * 8);
+    hdr->dev_id    = s_dev_id;
+    hdr->adc_count = (uint8_t)geo->dev_count;
+    for (uint32_t c = 0; c < ch && c * stride < geo->ch_count; ++c) {
+        const tlv320adc5120_chan_t *src = &geo->chan[c * stride];
+        hdr->adc_addr[src->dev] = src->addr;
+        hdr->ch_map[c] = (uint8_t)((src->dev << 4) | src->adc_ch);
+    }
+    hdr->clk_ppb = CLK_NONE;
 }
 
-static void publisher_task(void *arg) {
-    LOG_INFO(TAG, "publisher_task started");
-    make_raw_topic();
-
-    /* header template */
-    sample_mb_hdr_v2_t hdr = {0};
-    memcpy(hdr.magic, "JQMB", 4);
-    hdr.version     = 0x02;
-    hdr.flags       = 0x03;
-    hdr.hdr_len     = sizeof(hdr);
-    hdr.sample_rate = 1000;
-    hdr.ch_count    = 2;
-    hdr.word_bits   = 24;
-    hdr.slot_bits   = 32;
-    hdr.reserved    = 0;
-    hdr.dev_id      = s_dev_id;
-    hdr.block_size  = DS_BLOCK_BYTES;
-
-    /* buffers */
-    uint8_t src8[DS_N_SOURCE][DS_BLOCK_BYTES];   // accumulate 8 raw blocks
-    uint8_t ds_block[DS_BLOCK_BYTES];            // one downsampled block
-    uint8_t payload[sizeof(hdr) + BATCH_DS_BLOCKS * DS_BLOCK_BYTES];
-
-    uint8_t *pay_body = payload + sizeof(hdr);
+/* Time of the first frame, esp_timer us */
+static void mb_hdr_stamp(sample_mb_hdr_v4_t *hdr, int64_t t_us) {
+    hdr->t_us   = t_us;
+    hdr->utc_us = time_utc_us(t_us);
+    hdr->ts_ms  = (uint32_t)(t_us / 1000);
+}
 
-    while (1) {
-        /* Build one downsampled block from 8 source blocks */
-        int got_src = 0;
-        while (got_src < DS_N_SOURCE) {
-            if (xQueueReceive(s_publish_q, src8[got_src], pdMS_TO_TICKS(16)) == pdPASS) {
-                got_src++;
-            } else {
-                taskYIELD();
+/* LATENCY PROBE ****************************************************/
+/* How old data is when a subscriber gets it, held against cfg lat_slo_ms.
+   Four legs, each a histogram (util_hist) over the report period:
+     adc_pub   DMA completion of a stream payload's newest block -> handed to MQTT
+     pub_ack   probe publish -> broker PUBACK (seen through NET_EVENT_MQTT_PUBLISHED)
+     pub_sub   probe publish -> the probe back from the broker
+     adc_sub   DMA completion -> subscriber; its p99 is the SLO
+   Every lat_probe_s the next stream payload is followed by a small QoS 1 probe
+   carrying that payload's DMA stamp. The device subscribes to its own probe
+   topic and stands in for the host, so every leg is on one clock; point
+   mqtt_uri at a broker on the host's segment to measure the path a host sees.
+   A broker forwards one client's messages in order, so the probe reaches a
+   subscriber no earlier than the payload it follows. */
+
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "JQML"
+    uint8_t  version;       // 0x01
+    uint8_t  reserved[3];
+    uint32_t seq;           // probe sequence
+    uint32_t dev_id;
+    int64_t  t_dma_us;      // esp_timer DMA completion of the payload's newest block
+    int64_t  t_pub_us;      // esp_timer when this probe went to MQTT
+} lat_probe_v1_t;
+
+typedef enum { LAT_ADC_PUB, LAT_PUB_ACK, LAT_PUB_SUB, LAT_ADC_SUB, LAT_LEGS } lat_leg_t;
+static const char *LAT_LEG_NAMES[LAT_LEGS] = { "adc_pub", "pub_ack", "pub_sub", "adc_sub" };
+
+typedef struct {
+    bool     on;
+    hist_t  *hist;          // LAT_LEGS legs, then a report snapshot
+    int64_t  next_us;       // next probe due
+    uint32_t seq;           // next probe sequence
+    uint32_t sent;          // probes this period
+    uint32_t lost;          // probes not back before the next went out
+    bool     waiting;       // probe seq - 1 is out
+    int      ack_id;        // its msg_id until the PUBACK (-1: none)
+    int64_t  ack_pub_us;
+    char     topic[TOPIC_MAX];
+} lat_probe_t;
+
+// Stream publishes (a pipe lane), PUBACKs (event loop) and echoes (MQTT task) all record
+static portMUX_TYPE s_lat_lock = portMUX_INITIALIZER_UNLOCKED;
+static lat_probe_t s_lat = { .ack_id = -1 };
+
+static inline uint32_t lat_us(int64_t d) {
+    return d <= 0 ? 0 : d >= UINT32_MAX ? UINT32_MAX : (uint32_t)d;
+}
+
+static void on_lat_puback(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    const int64_t now = esp_timer_get_time();
+    const int msg_id = *(const int *)data;
+    taskENTER_CRITICAL(&s_lat_lock);
+    if (msg_id == s_lat.ack_id) {
+        hist_add(&s_lat.hist[LAT_PUB_ACK], lat_us(now - s_lat.ack_pub_us));
+        s_lat.ack_id = -1;
+    }
+    taskEXIT_CRITICAL(&s_lat_lock);
+}
+
+static void on_lat_probe(const char *topic, const uint8_t *data, int len, void *ctx) {
+    const int64_t now = esp_timer_get_time();
+    lat_probe_v1_t p;
+    if (len != sizeof(p)) return;
+    memcpy(&p, data, sizeof(p));
+    if (memcmp(p.magic, "JQML", 4) != 0 || p.dev_id != s_dev_id) return;
+    taskENTER_CRITICAL(&s_lat_lock);
+    if (s_lat.waiting && p.seq == s_lat.seq - 1) {
+        hist_add(&s_lat.hist[LAT_PUB_SUB], lat_us(now - p.t_pub_us));
+        hist_add(&s_lat.hist[LAT_ADC_SUB], lat_us(now - p.t_dma_us));
+        s_lat.waiting = false;
+    }
+    taskEXIT_CRITICAL(&s_lat_lock);
+}
+
+static void lat_setup(void) {
+    if (s_cfg.lat_probe_s == 0) return;
+    s_lat.hist = calloc(LAT_LEGS + 1, sizeof(hist_t));
+    if (!s_lat.hist) {
+        LOG_WARN(TAG, ESP_ERR_NO_MEM, "no room for latency histograms; probe off");
+        return;
+    }
+    snprintf(s_lat.topic, sizeof(s_lat.topic), "jaqc/sig/latency/probe/v1/%08X", (unsigned)s_dev_id);
+    util_mqtt_subscribe(s_lat.topic, 1, on_lat_probe, NULL);
+    net_events_subscribe(NET_EVENT_MQTT_PUBLISHED, on_lat_puback, NULL);
+    s_lat.next_us = esp_timer_get_time();
+    s_lat.on = true;
+    LOG_INFO(TAG, "latency probe every %lu s on %s, SLO p99 %lu ms", s_cfg.lat_probe_s, s_lat.topic, s_cfg.lat_slo_ms);
+}
+
+/* A stream payload whose newest block completed DMA at t_dma went to MQTT at t_pub */
+static void lat_published(int64_t t_dma, int64_t t_pub) {
+    if (!s_lat.on) return;
+    lat_probe_v1_t p = { .magic = {'J', 'Q', 'M', 'L'}, .version = 0x01, .dev_id = s_dev_id, .t_dma_us = t_dma };
+
+    taskENTER_CRITICAL(&s_lat_lock);
+    hist_add(&s_lat.hist[LAT_ADC_PUB], lat_us(t_pub - t_dma));
+    const bool due = t_pub >= s_lat.next_us;
+    if (due) {
+        s_lat.next_us = t_pub + (int64_t)s_cfg.lat_probe_s * 1000000;
+        if (s_lat.waiting) s_lat.lost++;
+        s_lat.waiting = true;
+        s_lat.sent++;
+        s_lat.ack_id = -1;
+        p.seq = s_lat.seq++;
+    }
+    taskEXIT_CRITICAL(&s_lat_lock);
+    if (!due) return;
+
+    p.t_pub_us = esp_timer_get_time();
+    const int msg_id = util_mqtt_publish_bytes_id(s_lat.topic, (const uint8_t *)&p, sizeof(p), 1, false);
+    taskENTER_CRITICAL(&s_lat_lock);
+    s_lat.ack_pub_us = p.t_pub_us;
+    s_lat.ack_id = msg_id;
+    if (msg_id < 0) {
+        s_lat.waiting = false;
+        s_lat.sent--;
+    }
+    taskEXIT_CRITICAL(&s_lat_lock);
+}
+
+/* Percentiles per leg over the period, then start the next */
+static void lat_report(int64_t period_us) {
+    if (!s_lat.on) return;
+    hist_t *snap = &s_lat.hist[LAT_LEGS];
+    const uint32_t slo_us = s_cfg.lat_slo_ms * 1000;
+    uint32_t p99_sub = 0, miss = 0, n_sub = 0;
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "period_s", (double)period_us / 1e6);
+    cJSON_AddNumberToObject(root, "slo_ms", s_cfg.lat_slo_ms);
+    for (int leg = 0; leg < LAT_LEGS; ++leg) {
+        // copy out so percentiles run outside the lock
+        taskENTER_CRITICAL(&s_lat_lock);
+        *snap = s_lat.hist[leg];
+        hist_reset(&s_lat.hist[leg]);
+        taskEXIT_CRITICAL(&s_lat_lock);
+
+        cJSON *j = cJSON_AddObjectToObject(root, LAT_LEG_NAMES[leg]);
+        cJSON_AddNumberToObject(j, "n", snap->count);
+        cJSON_AddNumberToObject(j, "p50_us", hist_percentile(snap, 50.0f));
+        cJSON_AddNumberToObject(j, "p90_us", hist_percentile(snap, 90.0f));
+        cJSON_AddNumberToObject(j, "p99_us", hist_percentile(snap, 99.0f));
+        cJSON_AddNumberToObject(j, "max_us", snap->max);
+        cJSON_AddNumberToObject(j, "mean_us", snap->count ? (double)snap->sum / snap->count : 0.0);
+        if (leg == LAT_ADC_SUB) {
+            n_sub   = snap->count;
+            p99_sub = hist_percentile(snap, 99.0f);
+            miss    = hist_count_above(snap, slo_us);
+        }
+    }
+    taskENTER_CRITICAL(&s_lat_lock);
+    const uint32_t sent = s_lat.sent, lost = s_lat.lost;
+    s_lat.sent = s_lat.lost = 0;
+    taskEXIT_CRITICAL(&s_lat_lock);
+
+    const bool ok = n_sub > 0 && p99_sub <= slo_us;
+    cJSON_AddNumberToObject(root, "probes", sent);
+    cJSON_AddNumberToObject(root, "lost", lost);
+    cJSON_AddNumberToObject(root, "slo_miss", miss);
+    cJSON_AddNumberToObject(root, "slo_miss_pct", n_sub ? 100.0 * miss / n_sub : 0.0);
+    cJSON_AddBoolToObject(root, "slo_ok", ok);
+    if (util_mqtt_is_ready()) {
+        char topic[TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "jaqc/sig/latency/v1/%08X", (unsigned)s_dev_id);
+        util_mqtt_publish_json(topic, root, 0, false);
+    }
+    cJSON_Delete(root);
+
+    if (n_sub > 0 && !ok) {
+        LOG_WARN(TAG, ESP_ERR_TIMEOUT, "latency SLO missed: ADC->subscriber p99 %lu ms > %lu ms (%lu of %lu probes over, %lu lost)",
+            p99_sub / 1000, s_cfg.lat_slo_ms, miss, n_sub, lost);
+    } else {
+        LOG_INFO(TAG, "latency ADC->subscriber p99 %lu ms over %lu probes (%lu lost), SLO %lu ms",
+            p99_sub / 1000, n_sub, lost, s_cfg.lat_slo_ms);
+    }
+}
+
+/* END LATENCY PROBE ************************************************/
+
+/* Per-channel counts -> amps from cfg (ADC full scale, INA gains, shunt) */
+#define UNITS_LOG_BLOCKS 1000
+static dsp_units_t s_units;
+static bool s_units_ok = false;     // s_units holds the current geometry's scaling
+static float s_gain[TLV_MAX_CH];    // per ring channel; every ADC has the same front end (cfg ina_gain1..4)
+
+/* One published output rate: its own decimation chain, payload and sequence */
+typedef struct {
+    uint32_t rate_hz;
+    dsp_decim_chain_t dec;
+    int32_t  *out32;        // decimator output scratch
+    dsp_merge_t merge;      // dual-gain pairs -> one auto-ranged channel
+    bool      merged;
+    uint32_t  out_ch;       // published channels: ch, or ch / 2 when merged
+    int32_t  *merged32;     // merge output scratch
+    dsp_rs_t  rs;           // to exactly rate_hz, when resampling
+    float    *rs_state;
+    int32_t  *rs32;         // resampler output scratch
+    int32_t   clk_ppb;      // latest sample clock estimate (CLK_NONE until locked)
+    uint8_t  *cpayload;     // header + BATCH_DS_BLOCKS x {u16 len, coded block}, when compressing
+    int32_t  *cblock32;     // one ds block as int32, plus coder scratch
+    struct sdt_stream *sdt; // report-by-exception mode instead of JQMB v4 blocks
+    uint32_t  ds_frames;    // frames per ds block
+    uint32_t  batch_frames; // BATCH_DS_BLOCKS x ds_frames
+    uint8_t  *payload;      // header + batch
+    size_t    payload_len;
+    uint32_t  filled;       // frames in the current payload
+    uint32_t  seq;          // ds block sequence
+    uint32_t  first_seq;
+    uint32_t  ratio;        // raw frames per output frame
+    float     delay;        // decimation chain group delay, raw frames
+    uint64_t  in_frames;    // raw frames fed
+    uint64_t  dec_out;      // decimator outputs so far
+    int64_t   t0_us;        // first frame of the current payload
+    char      topic[TOPIC_MAX];
+} ds_stream_t;
+
+/* Swinging-door points: JQMD v1 header, then per channel
+   {float amps_per_lsb, float dev (counts), u16 points, u16 bytes, points}.
+   Each point is uvarint(t - previous t) then zigzag varint(v - previous v); the
+   first point of a channel is relative to t_base and 0, so messages stand alone. */
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "JQMD"
+    uint8_t  version;       // 0x01
+    uint8_t  flags;         // bit0: amps_per_lsb valid
+    uint16_t hdr_len;       // sizeof this header
+    uint32_t seq;           // message sequence
+    uint32_t ts_ms;         // time of t_base
+    uint32_t t_base;        // stream sample index the point times count from (last frame of the previous message)
+    uint32_t rate_hz;       // stream rate (one t step)
+    uint16_t hb_s;          // heartbeat: at least one point per channel this often
+    uint8_t  ch_count;
+    uint8_t  reserved;
+    uint32_t dev_id;
+} sdt_hdr_v1_t;
+
+#define SDT_CH_BYTES        2048    // point bytes per channel per message
+#define SDT_POINT_MAX       10      // two 5-byte varints
+
+typedef struct sdt_stream {
+    dsp_sdt_t door[DSP_UNITS_MAX_CH];
+    float     scale[DSP_UNITS_MAX_CH];
+    uint8_t  *pts;          // ch x SDT_CH_BYTES
+    uint16_t  len[DSP_UNITS_MAX_CH];
+    uint16_t  count[DSP_UNITS_MAX_CH];
+    uint32_t  last_t[DSP_UNITS_MAX_CH];
+    int32_t   last_v[DSP_UNITS_MAX_CH];
+    uint32_t  t;            // stream sample index of the next frame
+    uint32_t  t_base;
+    uint32_t  ts_base_ms;   // DMA-derived time of t_base
+    bool      unstamped;    // t_base not yet fed, ts_base_ms comes with it
+    uint32_t  seq;
+    uint8_t  *msg;
+    char      topic[TOPIC_MAX];
+} sdt_stream_t;
+
+static inline uint8_t *put_uvarint(uint8_t *p, uint32_t v) {
+    while (v >= 0x80) { *p++ = (uint8_t)(v | 0x80); v >>= 7; }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+static void sdt_free(sdt_stream_t *sd) {
+    if (!sd) return;
+    free(sd->pts);
+    free(sd->msg);
+    free(sd);
+}
+
+/* The caller stamps ts_base_ms with the time of t_base, or leaves the stream
+   unstamped until that frame is fed */
+static void sdt_open(sdt_stream_t *sd, uint32_t ch) {
+    // The doors may still archive the last frame already fed, so count from it
+    sd->t_base = sd->t ? sd->t - 1 : 0;
+    for (uint32_t c = 0; c < ch; ++c) {
+        sd->len[c] = 0;
+        sd->count[c] = 0;
+        sd->last_t[c] = sd->t_base;
+        sd->last_v[c] = 0;
+    }
+}
+
+static sdt_stream_t *sdt_create(uint32_t rate_hz, uint32_t ch) {
+    sdt_stream_t *sd = calloc(1, sizeof(*sd));
+    if (!sd) return NULL;
+    sd->pts = malloc((size_t)ch * SDT_CH_BYTES);
+    sd->msg = malloc(sizeof(sdt_hdr_v1_t) + (size_t)ch * (12 + SDT_CH_BYTES));
+    if (!sd->pts || !sd->msg) {
+        sdt_free(sd);
+        return NULL;
+    }
+
+    const bool amps = s_units_ok && s_units.ch == ch;
+    for (uint32_t c = 0; c < ch; ++c) {
+        // tolerance is set in amps; each channel has its own LSB size
+        sd->scale[c] = amps ? s_units.amps_per_lsb[c] : 0.0f;
+        const float dev = amps ? s_cfg.sdt_dev_a / s_units.amps_per_lsb[c] : s_cfg.sdt_dev_a;
+        dsp_sdt_init(&sd->door[c], dev, s_cfg.sdt_hb_s * rate_hz);
+    }
+
+    sdt_hdr_v1_t *hdr = (sdt_hdr_v1_t *)sd->msg;
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, "JQMD", 4);
+    hdr->version  = 0x01;
+    hdr->flags    = amps ? 0x01 : 0x00;
+    hdr->hdr_len  = sizeof(*hdr);
+    hdr->rate_hz  = rate_hz;
+    hdr->hb_s     = (uint16_t)s_cfg.sdt_hb_s;
+    hdr->ch_count = (uint8_t)ch;
+    hdr->dev_id   = s_dev_id;
+
+    sdt_open(sd, ch);
+    sd->unstamped = true;
+    snprintf(sd->topic, sizeof(sd->topic), "jaqc/sig/sdt/v1/%08X/%lu", (unsigned)s_dev_id, rate_hz);
+    LOG_INFO(TAG, "sdt %lu Hz: dev %.3g A, heartbeat %lu s -> %s", 
+        rate_hz, s_cfg.sdt_dev_a, s_cfg.sdt_hb_s, sd->topic);
+    return sd;
+}
+
+static void sdt_publish(sdt_stream_t *sd, uint32_t ch, uint32_t rate_hz) {
+    sdt_hdr_v1_t *hdr = (sdt_hdr_v1_t *)sd->msg;
+    hdr->seq    = sd->seq++;
+    hdr->ts_ms  = sd->ts_base_ms;
+    hdr->t_base = sd->t_base;
+
+    uint8_t *w = sd->msg + sizeof(*hdr);
+    for (uint32_t c = 0; c < ch; ++c) {
+        const float dev = sd->door[c].dev;
+        memcpy(w, &sd->scale[c], 4); w += 4;
+        memcpy(w, &dev, 4); w += 4;
+        memcpy(w, &sd->count[c], 2); w += 2;
+        memcpy(w, &sd->len[c], 2); w += 2;
+        memcpy(w, sd->pts + (size_t)c * SDT_CH_BYTES, sd->len[c]);
+        w += sd->len[c];
+    }
+
+    if (util_mqtt_is_ready()) {
+        esp_err_t perr = util_mqtt_publish_bytes(sd->topic, sd->msg, (size_t)(w - sd->msg), 0, false);
+        if (perr != ESP_OK) {
+            LOG_ERR(TAG, perr, "publish failed (sdt %lu Hz, seq=%u)", rate_hz, (unsigned)hdr->seq);
+        }
+    }
+    sdt_open(sd, ch);
+}
+
+/* Run each decimated frame through the doors; publish once a message has points
+   and DS_PUBLISH_MS of stream time has passed, or a channel buffer is nearly full.
+   Frame i of in32 is at t0_us + i x dt_us, from the block's DMA stamp. */
+static void sdt_feed(sdt_stream_t *sd, const int32_t *in32, uint32_t frames, uint32_t ch, uint32_t rate_hz,
+    double t0_us, double dt_us) {
+    const uint32_t period = rate_hz * DS_PUBLISH_MS / 1000;
+
+    if (sd->unstamped && frames) {
+        sd->ts_base_ms = (uint32_t)(llround(t0_us) / 1000);
+        sd->unstamped = false;
+    }
+
+    for (uint32_t i = 0; i < frames; ++i) {
+        const uint32_t t = sd->t++;
+        bool full = false, any = false;
+        for (uint32_t c = 0; c < ch; ++c) {
+            dsp_sdt_point_t pt[2];
+            const uint32_t k = dsp_sdt_push(&sd->door[c], t, in32[i * ch + c], pt);
+            uint8_t *base = sd->pts + (size_t)c * SDT_CH_BYTES;
+            for (uint32_t j = 0; j < k; ++j) {
+                const int32_t dv = pt[j].v - sd->last_v[c];
+                uint8_t *w = base + sd->len[c];
+                w = put_uvarint(w, pt[j].t - sd->last_t[c]);
+                w = put_uvarint(w, ((uint32_t)dv << 1) ^ (uint32_t)(dv >> 31));
+                sd->len[c] = (uint16_t)(w - base);
+                sd->count[c]++;
+                sd->last_t[c] = pt[j].t;
+                sd->last_v[c] = pt[j].v;
             }
+            full |= sd->len[c] > SDT_CH_BYTES - 2 * SDT_POINT_MAX;
+            any  |= sd->count[c] > 0;
         }
-        decimate8_to1(src8, ds_block);
+        if (full || (any && sd->t - sd->t_base >= period)) {
+            sdt_publish(sd, ch, rate_hz);
+            sd->ts_base_ms = (uint32_t)(llround(t0_us + i * dt_us) / 1000);    // t_base is frame i
+        }
+    }
+}
 
-        /* Batch 4 ds blocks per publish */
-        static int   ds_in_batch = 0;
-        static uint32_t first_seq = 0;
-        static uint32_t ts0_ms    = 0;
+static ds_stream_t s_streams[DS_MAX_STREAMS];
+static uint32_t s_stream_count = 0;
+static float *s_rs_coef = NULL;     // resampler kernel, shared by every stream
+
+static void stream_free(ds_stream_t *st) {
+    dsp_decim_chain_destroy(&st->dec);
+    free(st->out32);
+    free(st->merged32);
+    free(st->rs_state);
+    free(st->rs32);
+    free(st->cpayload);
+    free(st->cblock32);
+    sdt_free(st->sdt);
+    free(st->payload);
+    memset(st, 0, sizeof(*st));
+}
 
-        if (ds_in_batch == 0) {
-            first_seq = s_seq;
-            ts0_ms    = (uint32_t)(esp_timer_get_time() / 1000);
+/* Gain merge takes ring channels (2k, 2k + 1) as a pair: they must be CH1 / CH2 or
+   CH3 / CH4 of one ADC, low gain first. Ring order is ADC by ADC, so that holds
+   whenever each ADC runs an even channel count; anything else publishes unmerged. */
+static bool merge_pairs_ok(const tlv320adc5120_geometry_t *geo) {
+    for (uint32_t c = 0; c < geo->ch_count; c += 2) {
+        const tlv320adc5120_chan_t *lo = &geo->chan[c];
+        const tlv320adc5120_chan_t *hi = &geo->chan[c + 1];
+        if (c + 1 >= geo->ch_count || lo->dev != hi->dev || (lo->adc_ch & 1) == 0 || hi->adc_ch != lo->adc_ch + 1) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "ch %lu (ADC %u CH%u) has no gain partner; streams publish unmerged", 
+                c, lo->dev, lo->adc_ch);
+            return false;
         }
+    }
+    return true;
+}
 
-        memcpy(pay_body + ds_in_batch * DS_BLOCK_BYTES, ds_block, DS_BLOCK_BYTES);
-        ds_in_batch++;
-        s_seq++;
+static esp_err_t stream_setup(ds_stream_t *st, uint32_t rate_hz, const tlv320adc5120_geometry_t *geo, bool merge) {
+    const uint32_t ch = geo->ch_count;
+    const uint32_t ratio = geo->sample_rate_hz / rate_hz;
 
-        if (ds_in_batch == BATCH_DS_BLOCKS) {
-            /* finalize header */
-            hdr.seq_first   = first_seq;
-            hdr.block_count = BATCH_DS_BLOCKS;
-            hdr.ts_ms       = ts0_ms;
+    memset(st, 0, sizeof(*st));
+    if (!dsp_decim_chain_valid(ratio, ch, DS_CIC_ORDER, s_cfg.ds_taps, DS_CUTOFF)) {
+        LOG_ERR(TAG, ESP_ERR_INVALID_ARG, "no decimation chain for %lu Hz: %lu:1 from %lu Hz, %lu taps", 
+            rate_hz, ratio, geo->sample_rate_hz, s_cfg.ds_taps);
+        return ESP_ERR_INVALID_ARG;
+    }
+    st->rate_hz = rate_hz;
+    st->ratio   = ratio;
+
+    /* one ds block is at most as many frames as one raw block; slow streams use
+       fewer so a payload still goes out about every DS_PUBLISH_MS */
+    st->ds_frames = (rate_hz * DS_PUBLISH_MS / 1000) / BATCH_DS_BLOCKS;
+    if (st->ds_frames > geo->block_frames) st->ds_frames = geo->block_frames;
+    if (st->ds_frames == 0) st->ds_frames = 1;
+    st->batch_frames = BATCH_DS_BLOCKS * st->ds_frames;
+
+    st->merged = merge;
+    st->out_ch = st->merged ? ch / 2 : ch;
+
+    const size_t ds_block_bytes = (size_t)st->ds_frames * st->out_ch * geo->sample_bytes;
+    st->payload_len = sizeof(sample_mb_hdr_v4_t) + BATCH_DS_BLOCKS * ds_block_bytes;
+    st->payload = malloc(st->payload_len);
+
+    if (!st->payload
+    ||  !dsp_decim_chain_create(&st->dec, ratio, ch, DS_CIC_ORDER, s_cfg.ds_taps, DS_CUTOFF, geo->block_frames)
+    ||  !(st->out32 = malloc((size_t)dsp_decim_chain_max_out(&st->dec, geo->block_frames) * ch * sizeof(int32_t)))
+    ) {
+        stream_free(st);
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (st->merged) {
+        /* Hold low range for the chain's full impulse response (in input frames) so no
+           output mixes in a clipped high-gain sample */
+        float nominal[DSP_MERGE_MAX_PAIRS];
+        for (uint32_t k = 0; k < st->out_ch; ++k) {
+            nominal[k] = s_gain[2 * k + 1] / s_gain[2 * k];
+        }
+        const uint32_t hold = st->dec.cic_ratio * (st->dec.fir.ntaps + st->dec.cic.order);
+        if (!dsp_merge_init(&st->merge, st->out_ch, nominal, hold)
+        ||  !(st->merged32 = malloc((size_t)dsp_decim_chain_max_out(&st->dec, geo->block_frames) * st->out_ch * sizeof(int32_t)))
+        ) {
+            LOG_ERR(TAG, ESP_ERR_INVALID_ARG, "gain merge setup failed (gains %.1f / %.1f)", 
+                s_gain[0], s_gain[1]);
+            stream_free(st);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    /* header template, built in place at the front of the payload */
+    sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)st->payload;
+    // bit2: auto-ranged dual-gain words (dsp_merge.h)
+    mb_hdr_init(hdr, geo, st->merged ? 0x07 : 0x03, st->out_ch, st->merged ? 2 : 1, geo->sample_bytes);
+    hdr->sample_rate = (uint16_t)rate_hz;
+    hdr->block_size  = (uint16_t)ds_block_bytes;
+    st->clk_ppb = CLK_NONE;
+    /* Linear-phase chain: CIC (N (R - 1) / 2 of its inputs), then the FIR ((taps - 1) / 2
+       of its inputs, each R raw frames); the resampler's kernel is centred on its read position */
+    st->delay = (st->dec.cic_ratio > 1 ? st->dec.cic.order * (st->dec.cic_ratio - 1) / 2.0f : 0.0f)
+              + (st->dec.fir.ntaps - 1) / 2.0f * st->dec.cic_ratio;
+
+    if (s_rs_coef) {
+        const uint32_t max_in = dsp_decim_chain_max_out(&st->dec, geo->block_frames);
+        st->rs_state = malloc(dsp_rs_state_len(st->out_ch, max_in) * sizeof(float));
+        st->rs32 = malloc((size_t)dsp_rs_max_out(max_in) * st->out_ch * sizeof(int32_t));
+        if (!st->rs_state || !st->rs32 || !dsp_rs_init(&st->rs, s_rs_coef, st->out_ch, max_in, st->rs_state)) {
+            stream_free(st);
+            return ESP_ERR_NO_MEM;
+        }
+        hdr->flags |= 0x20; // bit5: resampled to exactly sample_rate against the measured clock
+    }
+
+    if (s_cfg.sdt && !(st->sdt = sdt_create(rate_hz, ch))) {
+        stream_free(st);
+        return ESP_ERR_NO_MEM;
+    }
+    if (s_cfg.compress && !s_cfg.sdt) {
+        const size_t cmax = sizeof(*hdr) + BATCH_DS_BLOCKS * (2 + dsp_ll_max_bytes(st->ds_frames, st->out_ch));
+        st->cpayload = malloc(cmax);
+        st->cblock32 = malloc((size_t)st->ds_frames * (st->out_ch + 2) * sizeof(int32_t));
+        if (!st->cpayload || !st->cblock32) {
+            stream_free(st);
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    if (st->dec.cic_ratio > 1 && st->dec.cic.order < DS_CIC_ORDER) {
+        LOG_WARN(TAG, ESP_OK, "stream %lu Hz: CIC %lu:1 runs at order %lu (%d overflows its registers)", 
+            rate_hz, st->dec.cic_ratio, st->dec.cic.order, DS_CIC_ORDER);
+    }
+    snprintf(st->topic, sizeof(st->topic), "jaqc/sig/sample/raw/v2/%08X/%lu", (unsigned)s_dev_id, rate_hz);
+    LOG_INFO(TAG, "stream %lu Hz: %lu:1 (CIC %lu x FIR %lu, %lu taps), %lu ch%s%s, %u B blocks -> %s", 
+        rate_hz, ratio, st->dec.cic_ratio, st->dec.fir_ratio, s_cfg.ds_taps, 
+        st->out_ch, st->merged ? " gain-merged" : "", st->rs_state ? " resampled" : "", (unsigned)ds_block_bytes, st->topic);
+    return ESP_OK;
+}
 
-            /* serialize hdr + body */
-            memcpy(payload, &hdr, sizeof(hdr));
+/* Parse cfg ds_rates ("2000,500,100,10"); each rate must divide the ADC rate */
+static void streams_setup(const tlv320adc5120_geometry_t *geo) {
+    const char *p = s_cfg.ds_rates;
+    const bool merge = s_cfg.merge_gain && !s_cfg.sdt && merge_pairs_ok(geo);
+    s_stream_count = 0;
+    if (s_cfg.resample && !s_rs_coef) {
+        s_rs_coef = malloc(DSP_RS_COEF_LEN * sizeof(float));
+        if (s_rs_coef) {
+            dsp_rs_design(s_rs_coef);
+        } else {
+            LOG_WARN(TAG, ESP_ERR_NO_MEM, "no room for the resampler kernel; streams keep the measured rate");
+        }
+    }
+    while (*p && s_stream_count < DS_MAX_STREAMS) {
+        char *end;
+        unsigned long rate = strtoul(p, &end, 10);
+        if (end == p) { p++; continue; }
+        p = end;
+
+        if (rate == 0 || rate >= geo->sample_rate_hz || geo->sample_rate_hz % rate != 0) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "ds rate %lu Hz skipped (must divide %lu Hz)", 
+                rate, geo->sample_rate_hz);
+            continue;
+        }
+        esp_err_t err = stream_setup(&s_streams[s_stream_count], (uint32_t)rate, geo, merge);
+        if (err) {
+            LOG_ERR(TAG, err, "ds stream %lu Hz setup failed", rate);
+            continue;
+        }
+        s_stream_count++;
+    }
+}
+
+/* Lossless-code a full batch: same header with flags bit3 set, then each ds block as
+   {u16 LE length, dsp_lossless block}. Blocks are self-contained. Returns payload bytes. */
+static size_t stream_compress(ds_stream_t *st, uint32_t sb) {
+    const uint32_t ch = st->out_ch;
+    const size_t raw_block = (size_t)st->ds_frames * ch * sb;
+    int32_t *blk32 = st->cblock32, *scratch = st->cblock32 + (size_t)st->ds_frames * ch;
+
+    memcpy(st->cpayload, st->payload, sizeof(sample_mb_hdr_v4_t));
+    ((sample_mb_hdr_v4_t *)st->cpayload)->flags |= 0x08; // bit3: lossless-coded, self-contained blocks
+    uint8_t *w = st->cpayload + sizeof(sample_mb_hdr_v4_t);
+    for (uint32_t b = 0; b < BATCH_DS_BLOCKS; ++b) {
+        load_samples(st->payload + sizeof(sample_mb_hdr_v4_t) + b * raw_block, sb, st->ds_frames * ch, blk32);
+        size_t n = dsp_ll_encode(blk32, st->ds_frames, ch, scratch, w + 2);
+        w[0] = (uint8_t)n;
+        w[1] = (uint8_t)(n >> 8);
+        w += 2 + n;
+    }
+    return (size_t)(w - st->cpayload);
+}
+
+/* Decimate one raw block's worth of samples into a stream, publishing full payloads.
+   The block's pipe buffer carries its DMA completion time and the sample clock's
+   error against nominal. */
+static void stream_feed(ds_stream_t *st, const pipe_buf_t *b, uint32_t sb) {
+    const uint32_t ch = st->out_ch;
+    const int32_t *in32 = b->data;
+    const uint32_t frames = b->frames;
+    const int32_t clk_ppb = b->clk_ppb;
+    sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)st->payload;
+    uint8_t *pay_body = st->payload + sizeof(*hdr);
+
+    /* Both decimator stages emit on their first input, so output j is raw frame
+       j x ratio; t_us is when this block's last frame landed */
+    st->in_frames += frames;
+    const double last = (double)(st->in_frames - 1);
+    const double us_per_frame = 1e6 / ((double)st->rate_hz * st->ratio);
+    double x0 = (double)st->dec_out, dx = 1.0;   // decimator output index of this call's first output
+
+    uint32_t n = dsp_decim_chain_process(&st->dec, in32, frames, st->out32);
+    st->dec_out += n;
+    const int32_t *out = st->out32;
+    if (st->merged) {
+        dsp_merge_detect(&st->merge, in32, frames);
+        dsp_merge_process(&st->merge, st->out32, n, st->merged32);
+        out = st->merged32;
+    }
+    st->clk_ppb = clk_ppb;
+    if (st->rs_state) {
+        // A clock running fast by e makes 1 + e real samples per nominal sample period
+        const double step = clk_ppb == CLK_NONE ? 1.0 : 1.0 + clk_ppb * 1e-9;
+        x0 = dsp_rs_next_in(&st->rs);
+        dx = step;
+        n = dsp_rs_process(&st->rs, out, n, step, st->rs32);
+        out = st->rs32;
+    }
+    if (st->sdt) {
+        const double raw0 = x0 * st->ratio - st->delay;
+        sdt_feed(st->sdt, out, n, st->dec.ch, st->rate_hz,
+            b->t_us - (last - raw0) * us_per_frame, dx * st->ratio * us_per_frame);
+        return;
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        if (st->filled == 0) {
+            const double raw = (x0 + i * dx) * st->ratio - st->delay;
+            st->first_seq = st->seq;
+            st->t0_us     = b->t_us - (int64_t)((last - raw) * us_per_frame);
+        }
+        store_samples(&out[i * ch], sb, ch, pay_body + (size_t)st->filled * ch * sb);
+        if ((++st->filled % st->ds_frames) == 0) {
+            st->seq++;
+        }
+
+        if (st->filled == st->batch_frames) {
+            /* finalize header */
+            hdr->seq_first   = st->first_seq;
+            hdr->block_count = BATCH_DS_BLOCKS;
+            mb_hdr_stamp(hdr, st->t0_us);
+            hdr->clk_ppb     = st->clk_ppb;
+            // bit6: clk_ppb is against SNTP-disciplined UTC (else the local crystal)
+            hdr->flags       = (uint8_t)((hdr->flags & ~0x40) | (time_is_disciplined() ? 0x40 : 0x00));
+
+            const uint8_t *pub = st->payload;
+            size_t pub_len = st->payload_len;
+            if (st->cpayload) {
+                pub_len = stream_compress(st, sb);
+                pub = st->cpayload;
+            }
 
             /* publish (QoS0, retain=false) */
             if (util_mqtt_is_ready()) {
+                const int64_t t_pub = esp_timer_get_time();
                 esp_err_t perr = util_mqtt_publish_bytes(
-                    s_topic_raw, payload, sizeof(payload), 0, false);
+                    st->topic, pub, pub_len, 0, false);
                 if (perr != ESP_OK) {
-                    LOG_ERR(TAG, perr, "publish failed (seq_first=%u)", (unsigned)first_seq);
+                    LOG_ERR(TAG, perr, "publish failed (%lu Hz, seq_first=%u)", 
+                        st->rate_hz, (unsigned)st->first_seq);
+                } else {
+                    lat_published(b->t_us, t_pub);
                 }
             }
 
             /* reset batch */
-            ds_in_batch = 0;
+            st->filled = 0;
+        }
+    }
+}
+
+/* WINDOWED STATISTICS V1 ******************************************/
+// Little-Endian stats header; followed by rec_count x ch_count stats_ch_v1_t (window-major)
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "JQMS"
+    uint8_t  version;       // 0x01
+    uint8_t  flags;         // bit0: values in amps (else ADC counts)
+    uint16_t hdr_len;       // sizeof this header
+    uint32_t seq_first;     // window sequence of the first record
+    uint16_t rec_count;     // windows in this payload
+    uint16_t window_ms;     // window length
+    uint32_t window_frames; // ADC frames per window
+    uint32_t ts_ms;         // close time of the first window
+    uint8_t  ch_count;
+    uint8_t  reserved[3];
+    uint32_t dev_id;
+} stats_hdr_v1_t;
+
+typedef struct __attribute__((packed)) {
+    float    min;
+    float    max;
+    float    mean;
+    float    rms;           // includes DC
+    float    p2p;           // max - min
+    uint32_t clips;         // samples at or beyond ~99.9% of ADC full scale
+} stats_ch_v1_t;
+
+#define STATS_MAX_WINDOWS   4
+#define STATS_PUBLISH_MS    100     // short windows are batched to publish about this often
+
+typedef struct {
+    uint32_t window_ms;
+    dsp_stats_t acc;
+    uint32_t rec_count;     // records per payload
+    uint32_t filled;        // records in the current payload
+    uint32_t seq;
+    uint8_t *payload;
+    size_t   payload_len;
+    char     topic[TOPIC_MAX];
+} stats_stream_t;
+
+static stats_stream_t s_stats[STATS_MAX_WINDOWS];
+static uint32_t s_stats_count = 0;
+
+static void stats_free(stats_stream_t *st) {
+    free(st->payload);
+    memset(st, 0, sizeof(*st));
+}
+
+static esp_err_t stats_setup(stats_stream_t *st, uint32_t window_ms, const tlv320adc5120_geometry_t *geo, bool amps) {
+    const uint32_t ch = geo->ch_count;
+    const uint32_t frames = (uint32_t)((uint64_t)geo->sample_rate_hz * window_ms / 1000);
+
+    memset(st, 0, sizeof(*st));
+    if (window_ms > UINT16_MAX || !dsp_stats_init(&st->acc, ch, frames)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    st->window_ms = window_ms;
+    st->rec_count = (STATS_PUBLISH_MS + window_ms - 1) / window_ms;
+    st->payload_len = sizeof(stats_hdr_v1_t) + (size_t)st->rec_count * ch * sizeof(stats_ch_v1_t);
+    st->payload = malloc(st->payload_len);
+    if (!st->payload) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    stats_hdr_v1_t *hdr = (stats_hdr_v1_t *)st->payload;
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, "JQMS", 4);
+    hdr->version       = 0x01;
+    hdr->flags         = amps ? 0x01 : 0x00;
+    hdr->hdr_len       = sizeof(*hdr);
+    hdr->rec_count     = (uint16_t)st->rec_count;
+    hdr->window_ms     = (uint16_t)window_ms;
+    hdr->window_frames = frames;
+    hdr->ch_count      = (uint8_t)ch;
+    hdr->dev_id        = s_dev_id;
+
+    snprintf(st->topic, sizeof(st->topic), "jaqc/sig/stats/v1/%08X/%lu", (unsigned)s_dev_id, window_ms);
+    LOG_INFO(TAG, "stats %lu ms: %lu frames, %lu windows / %u B payload -> %s", 
+        window_ms, frames, st->rec_count, (unsigned)st->payload_len, st->topic);
+    return ESP_OK;
+}
+
+/* Parse cfg stats_ms ("10,100,1000"); "0" or an empty list disables statistics */
+static void stats_streams_setup(const tlv320adc5120_geometry_t *geo, bool amps) {
+    const char *p = s_cfg.stats_ms;
+    s_stats_count = 0;
+    while (*p && s_stats_count < STATS_MAX_WINDOWS) {
+        char *end;
+        unsigned long ms = strtoul(p, &end, 10);
+        if (end == p) { p++; continue; }
+        p = end;
+        if (ms == 0) continue;
+
+        esp_err_t err = stats_setup(&s_stats[s_stats_count], (uint32_t)ms, geo, amps);
+        if (err) {
+            LOG_ERR(TAG, err, "stats window %lu ms setup failed (max %lu frames)", ms, (unsigned long)DSP_STATS_MAX_FRAMES);
+            continue;
+        }
+        s_stats_count++;
+    }
+}
+
+/* Close one window into the payload; publish once rec_count windows are in.
+   close_us: when the window's last frame landed. */
+static void stats_emit(stats_stream_t *st, int64_t close_us) {
+    const uint32_t ch = st->acc.ch;
+    stats_hdr_v1_t *hdr = (stats_hdr_v1_t *)st->payload;
+    stats_ch_v1_t *rec = (stats_ch_v1_t *)(st->payload + sizeof(*hdr)) + (size_t)st->filled * ch;
+
+    if (st->filled == 0) {
+        hdr->seq_first = st->seq;
+        hdr->ts_ms     = (uint32_t)(close_us / 1000);
+    }
+    for (uint32_t c = 0; c < ch; ++c) {
+        const double k = (hdr->flags & 0x01) ? s_units.amps_per_lsb[c] : 1.0;
+        dsp_stats_result_t r;
+        dsp_stats_result(&st->acc, c, &r);
+        rec[c].min   = (float)(r.min * k);
+        rec[c].max   = (float)(r.max * k);
+        rec[c].mean  = (float)(r.mean * k);
+        rec[c].rms   = (float)(r.rms * k);
+        rec[c].p2p   = (float)(((double)r.max - r.min) * k);
+        rec[c].clips = r.clips;
+    }
+    dsp_stats_reset(&st->acc);
+    st->seq++;
+
+    if (++st->filled == st->rec_count) {
+        if (util_mqtt_is_ready()) {
+            esp_err_t perr = util_mqtt_publish_bytes(st->topic, st->payload, st->payload_len, 0, false);
+            if (perr != ESP_OK) {
+                LOG_ERR(TAG, perr, "publish failed (stats %lu ms, seq_first=%u)", 
+                    st->window_ms, (unsigned)hdr->seq_first);
+            }
+        }
+        st->filled = 0;
+    }
+}
+
+/* Windows need not line up with raw blocks; split the block at each window edge.
+   t_us is when the block's last frame landed; a window closing with frames
+   still to go closed that many frame periods earlier. */
+static void stats_feed(stats_stream_t *st, const int32_t *in32, uint32_t frames, int64_t t_us, uint32_t fs) {
+    const uint32_t ch = st->acc.ch;
+    while (frames) {
+        uint32_t n = dsp_stats_accumulate(&st->acc, in32, frames);
+        in32   += (size_t)n * ch;
+        frames -= n;
+        if (dsp_stats_ready(&st->acc)) {
+            stats_emit(st, t_us - (int64_t)frames * 1000000 / fs);
+        }
+    }
+}
+
+/* END WINDOWED STATISTICS V1 ***************************************/
+
+/* SPECTRUM V1 ******************************************************/
+// Little-Endian spectrum header; followed by band_count x {lo_hz, hi_hz} (uint32), then
+// per channel: band_count x float band RMS, peak_count x {float hz, float RMS}
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "JQMF"
+    uint8_t  version;       // 0x01
+    uint8_t  flags;         // bit0: values in amps (else ADC counts)
+    uint16_t hdr_len;       // sizeof this header
+    uint32_t seq;           // frame sequence
+    uint32_t ts_ms;         // time the frame completed
+    uint32_t sample_rate;   // ADC rate the FFT ran at
+    uint16_t fft_n;
+    uint16_t hop;           // frames between FFTs (fft_n x (1 - overlap))
+    uint8_t  window;        // dsp_window_t
+    uint8_t  ch_count;
+    uint8_t  band_count;
+    uint8_t  peak_count;
+    uint32_t dev_id;
+} spec_hdr_v1_t;
+
+#define SPEC_MAX_BANDS      8
+#define SPEC_MAX_PEAKS      8
+#define SPEC_BENCH_RUNS     20
+
+typedef struct {
+    dsp_rfft_t fft;
+    uint32_t ch;
+    uint32_t hop;
+    uint32_t fill;          // frames in hist
+    float   *hist;          // ch x N, channel-major
+    float   *work;          // N
+    float   *pow;           // N/2 + 1
+    float    scale[DSP_UNITS_MAX_CH];
+    uint32_t band_count;
+    uint32_t band_lo[SPEC_MAX_BANDS];  // bins [lo, hi)
+    uint32_t band_hi[SPEC_MAX_BANDS];
+    uint32_t peak_count;
+    uint8_t *payload;
+    size_t   payload_len;
+    uint32_t seq;
+    char     topic[TOPIC_MAX];
+} spectrum_t;
+
+static spectrum_t s_spec;
+static bool s_spec_on = false;
+
+static void spectrum_free(spectrum_t *sp) {
+    dsp_rfft_destroy(&sp->fft);
+    free(sp->hist);
+    free(sp->work);
+    free(sp->pow);
+    free(sp->payload);
+    memset(sp, 0, sizeof(*sp));
+}
+
+/* FFTs per second at every supported size, so the frame rate a config asks for
+   can be checked against the core it runs on */
+static void spectrum_bench(void) {
+    float *x = malloc(DSP_FFT_MAX_N * sizeof(float));
+    float *w = malloc(DSP_FFT_MAX_N * sizeof(float));
+    float *p = malloc((DSP_FFT_MAX_N / 2 + 1) * sizeof(float));
+    if (!x || !w || !p) {
+        free(x); free(w); free(p);
+        return;
+    }
+    for (uint32_t i = 0; i < DSP_FFT_MAX_N; ++i) x[i] = (float)((i * 2654435761u) >> 8) / 16777216.0f - 0.5f;
+
+    for (uint32_t n = DSP_FFT_MIN_N; n <= DSP_FFT_MAX_N; n *= 2) {
+        dsp_rfft_t f;
+        if (!dsp_rfft_create(&f, n, DSP_WIN_HANN)) continue;
+        int64_t t0 = esp_timer_get_time();
+        for (int r = 0; r < SPEC_BENCH_RUNS; ++r) dsp_rfft_power(&f, x, w, p);
+        uint32_t us = (uint32_t)(esp_timer_get_time() - t0) / SPEC_BENCH_RUNS;
+        LOG_INFO(TAG, "fft bench N=%lu: %lu us, %lu FFT/s", n, us, us ? 1000000 / us : 0);
+        dsp_rfft_destroy(&f);
+    }
+    free(x); free(w); free(p);
+}
+
+/* Parse cfg fft_bands ("0-100,100-500,...") in Hz into bin ranges */
+static void spectrum_bands(spectrum_t *sp, uint32_t fs) {
+    const char *p = s_cfg.fft_bands;
+    const uint32_t n = sp->fft.n;
+    sp->band_count = 0;
+    while (*p && sp->band_count < SPEC_MAX_BANDS) {
+        char *end;
+        unsigned long lo = strtoul(p, &end, 10);
+        if (end == p || *end != '-') { p = (end == p) ? p + 1 : end; continue; }
+        p = end + 1;
+        unsigned long hi = strtoul(p, &end, 10);
+        if (end == p) continue;
+        p = end;
+
+        uint32_t klo = (uint32_t)(((uint64_t)lo * n + fs - 1) / fs);
+        uint32_t khi = (uint32_t)(((uint64_t)hi * n + fs - 1) / fs);
+        if (khi > n / 2 + 1) khi = n / 2 + 1;
+        if (klo >= khi) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "fft band %lu-%lu Hz skipped (no bins at %lu Hz / %lu)", lo, hi, fs, n);
+            continue;
         }
+        sp->band_lo[sp->band_count] = klo;
+        sp->band_hi[sp->band_count] = khi;
+        sp->band_count++;
+    }
+}
+
+static esp_err_t spectrum_setup(spectrum_t *sp, const tlv320adc5120_geometry_t *geo, bool amps) {
+    const uint32_t n = s_cfg.fft_n;
+    const uint32_t ch = geo->ch_count;
+    memset(sp, 0, sizeof(*sp));
+
+    if (s_cfg.fft_overlap > 90 || s_cfg.fft_window > DSP_WIN_BLACKMAN
+    ||  !dsp_rfft_create(&sp->fft, n, (dsp_window_t)s_cfg.fft_window)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    sp->ch   = ch;
+    sp->hop  = n - n * s_cfg.fft_overlap / 100;
+    sp->peak_count = s_cfg.fft_peaks > SPEC_MAX_PEAKS ? SPEC_MAX_PEAKS : s_cfg.fft_peaks;
+    for (uint32_t c = 0; c < ch; ++c) sp->scale[c] = amps ? s_units.amps_per_lsb[c] : 1.0f;
+    spectrum_bands(sp, geo->sample_rate_hz);
+
+    sp->payload_len = sizeof(spec_hdr_v1_t) + sp->band_count * 2 * sizeof(uint32_t)
+                    + (size_t)ch * (sp->band_count + 2 * sp->peak_count) * sizeof(float);
+    sp->hist    = malloc((size_t)ch * n * sizeof(float));
+    sp->work    = malloc((size_t)n * sizeof(float));
+    sp->pow     = malloc((size_t)(n / 2 + 1) * sizeof(float));
+    sp->payload = malloc(sp->payload_len);
+    if (!sp->hist || !sp->work || !sp->pow || !sp->payload) {
+        spectrum_free(sp);
+        return ESP_ERR_NO_MEM;
+    }
 
-        taskYIELD();
+    spec_hdr_v1_t *hdr = (spec_hdr_v1_t *)sp->payload;
+    memset(hdr, 0, sizeof(*hdr));
+    memcpy(hdr->magic, "JQMF", 4);
+    hdr->version     = 0x01;
+    hdr->flags       = amps ? 0x01 : 0x00;
+    hdr->hdr_len     = sizeof(*hdr);
+    hdr->sample_rate = geo->sample_rate_hz;
+    hdr->fft_n       = (uint16_t)n;
+    hdr->hop         = (uint16_t)sp->hop;
+    hdr->window      = (uint8_t)s_cfg.fft_window;
+    hdr->ch_count    = (uint8_t)ch;
+    hdr->band_count  = (uint8_t)sp->band_count;
+    hdr->peak_count  = (uint8_t)sp->peak_count;
+    hdr->dev_id      = s_dev_id;
+
+    // band table in Hz (bin edges as actually summed)
+    uint32_t *edges = (uint32_t *)(sp->payload + sizeof(*hdr));
+    for (uint32_t b = 0; b < sp->band_count; ++b) {
+        edges[2 * b + 0] = (uint32_t)((uint64_t)sp->band_lo[b] * geo->sample_rate_hz / n);
+        edges[2 * b + 1] = (uint32_t)((uint64_t)sp->band_hi[b] * geo->sample_rate_hz / n);
     }
 
+    snprintf(sp->topic, sizeof(sp->topic), "jaqc/sig/fft/v1/%08X/%lu", (unsigned)s_dev_id, n);
+    LOG_INFO(TAG, "fft N=%lu hop=%lu (%lu FFT/s per ch), %lu bands, %lu peaks, %u B -> %s", 
+        n, sp->hop, geo->sample_rate_hz / sp->hop, sp->band_count, sp->peak_count, 
+        (unsigned)sp->payload_len, sp->topic);
+    return ESP_OK;
 }
 
+/* Band RMS and the strongest local maxima (parabolic interpolation on magnitude) */
+static void spectrum_channel(spectrum_t *sp, uint32_t fs, float *rec) {
+    const uint32_t m = sp->fft.n / 2;
+    const float *pw = sp->pow;
 
-/* END RAW DATA MESSAGE V2 ******************************************/
+    for (uint32_t b = 0; b < sp->band_count; ++b) {
+        float e = 0.0f;
+        for (uint32_t k = sp->band_lo[b]; k < sp->band_hi[b]; ++k) e += pw[k];
+        *rec++ = sqrtf(e);
+    }
 
+    uint32_t top[SPEC_MAX_PEAKS];
+    uint32_t found = 0;
+    for (uint32_t k = 1; k < m; ++k) {
+        if (!(pw[k] > pw[k - 1] && pw[k] >= pw[k + 1])) continue;
+        uint32_t j = found < sp->peak_count ? found++ : sp->peak_count;
+        if (j == sp->peak_count && (j == 0 || pw[k] <= pw[top[j - 1]])) continue;
+        if (j == sp->peak_count) j--;
+        while (j > 0 && pw[top[j - 1]] < pw[k]) { top[j] = top[j - 1]; j--; }
+        top[j] = k;
+    }
+    for (uint32_t i = 0; i < sp->peak_count; ++i) {
+        float hz = 0.0f, rms = 0.0f;
+        if (i < found) {
+            const uint32_t k = top[i];
+            const float a = sqrtf(pw[k - 1]), b = sqrtf(pw[k]), c = sqrtf(pw[k + 1]);
+            const float den = a - 2.0f * b + c;
+            const float d = den != 0.0f ? 0.5f * (a - c) / den : 0.0f;
+            hz  = ((float)k + d) * (float)fs / (float)sp->fft.n;
+            rms = sqrtf(pw[k - 1] + pw[k] + pw[k + 1]); // main lobe
+        }
+        *rec++ = hz;
+        *rec++ = rms;
+    }
+}
 
+// done_us: when the newest frame in the history landed
+static void spectrum_emit(spectrum_t *sp, uint32_t fs, int64_t done_us) {
+    const uint32_t n = sp->fft.n;
+    spec_hdr_v1_t *hdr = (spec_hdr_v1_t *)sp->payload;
+    float *rec = (float *)(sp->payload + sizeof(*hdr) + sp->band_count * 2 * sizeof(uint32_t));
+
+    hdr->seq   = sp->seq++;
+    hdr->ts_ms = (uint32_t)(done_us / 1000);
+    for (uint32_t c = 0; c < sp->ch; ++c) {
+        dsp_rfft_power(&sp->fft, sp->hist + (size_t)c * n, sp->work, sp->pow);
+        spectrum_channel(sp, fs, rec);
+        rec += sp->band_count + 2 * sp->peak_count;
+    }
 
+    if (util_mqtt_is_ready()) {
+        esp_err_t perr = util_mqtt_publish_bytes(sp->topic, sp->payload, sp->payload_len, 0, false);
+        if (perr != ESP_OK) {
+            LOG_ERR(TAG, perr, "publish failed (fft seq=%u)", (unsigned)hdr->seq);
+        }
+    }
+}
+
+/* Deinterleave into per-channel history; an FFT runs every hop frames once N are in.
+   t_us is when the block's last frame landed. */
+static void spectrum_feed(spectrum_t *sp, const int32_t *in32, uint32_t frames, uint32_t fs, int64_t t_us) {
+    const uint32_t n = sp->fft.n, ch = sp->ch;
+    while (frames) {
+        uint32_t take = n - sp->fill;
+        if (take > frames) take = frames;
+        for (uint32_t c = 0; c < ch; ++c) {
+            float *h = sp->hist + (size_t)c * n + sp->fill;
+            const float k = sp->scale[c];
+            for (uint32_t i = 0; i < take; ++i) h[i] = (float)in32[i * ch + c] * k;
+        }
+        sp->fill += take;
+        in32     += (size_t)take * ch;
+        frames   -= take;
+
+        if (sp->fill == n) {
+            spectrum_emit(sp, fs, t_us - (int64_t)frames * 1000000 / fs);
+            for (uint32_t c = 0; c < ch; ++c) {
+                float *h = sp->hist + (size_t)c * n;
+                memmove(h, h + sp->hop, (size_t)(n - sp->hop) * sizeof(float));
+            }
+            sp->fill = n - sp->hop;
+        }
+    }
+}
+
+/* END SPECTRUM V1 **************************************************/
+
+/* TRIGGERED CAPTURE V1 *********************************************/
+// A capture is one JQMB v4 payload (flags bit4) whose blocks are single frames,
+// with this descriptor between the header and the first frame
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "TRIG"
+    uint8_t  version;       // 0x01
+    uint8_t  cause;         // dsp_trig_kind_t; 0 = heartbeat (no frames)
+    uint8_t  ch;            // 1-based channel that fired
+    uint8_t  flags;         // bit0: value / threshold in amps (else counts)
+    int64_t  trig_us;       // esp_timer time of the trigger frame
+    uint32_t sample_rate;   // full rate (the JQMB header field is only 16 bits)
+    uint32_t pre_frames;    // frames before the trigger frame
+    uint32_t post_frames;   // trigger frame and after
+    float    value;         // sample that fired (slope: the difference over span)
+    float    threshold;
+} trig_desc_v1_t;
+
+#define TRIG_MAX_FRAMES     UINT16_MAX  // JQMB block_count
+
+typedef struct {
+    dsp_trig_t trig[DSP_TRIG_MAX];
+    uint32_t n_trig;
+    uint32_t ch;
+    uint32_t sb;
+    uint32_t fs;
+    uint32_t pre_frames;
+    uint32_t post_frames;
+    uint8_t *hist;          // pre-trigger ring, pre_frames x frame bytes
+    uint32_t hist_pos;      // next frame slot
+    uint32_t hist_fill;
+    uint8_t *cap;           // header + descriptor + (pre + post) frames
+    uint32_t cap_frames;    // frames in cap so far
+    uint32_t post_left;     // > 0 while collecting
+    uint32_t seq;
+    int64_t  last_pub_us;
+    bool     amps;
+    char     topic[TOPIC_MAX];
+} trig_engine_t;
+
+static trig_engine_t s_trig;
+static bool s_trig_on = false;
+
+/* Large history lives in PSRAM when the board has it; otherwise internal RAM */
+static void *alloc_prefer_psram(size_t n, bool *psram) {
+    void *p = heap_caps_malloc(n, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    *psram = (p != NULL);
+    return p ? p : malloc(n);
+}
+
+static void trig_free(trig_engine_t *te) {
+    free(te->hist);
+    free(te->cap);
+    memset(te, 0, sizeof(*te));
+}
+
+static uint32_t trig_frame_bytes(const trig_engine_t *te) {
+    return te->ch * te->sb;
+}
+
+/* Parse cfg trig ("1:level:0.010,2:slope:0.002,1:window:-0.005:0.015"); values in
+   amps (slope: amps per ms) when unit scaling is valid, else counts */
+static void trig_parse(trig_engine_t *te) {
+    const char *p = s_cfg.trig;
+    const uint32_t span = te->fs / 1000 > DSP_TRIG_MAX_SPAN ? DSP_TRIG_MAX_SPAN : (te->fs / 1000 ? te->fs / 1000 : 1);
+    te->n_trig = 0;
+    while (*p && te->n_trig < DSP_TRIG_MAX) {
+        char *end;
+        unsigned long ch = strtoul(p, &end, 10);
+        if (end == p || *end != ':') { p = (end == p) ? p + 1 : end; continue; }
+        p = end + 1;
+
+        dsp_trig_kind_t kind = DSP_TRIG_NONE;
+        if      (strncmp(p, "level:", 6) == 0)  { kind = DSP_TRIG_LEVEL;  p += 6; }
+        else if (strncmp(p, "slope:", 6) == 0)  { kind = DSP_TRIG_SLOPE;  p += 6; }
+        else if (strncmp(p, "window:", 7) == 0) { kind = DSP_TRIG_WINDOW; p += 7; }
+        float a = strtof(p, &end);
+        p = end;
+        float b = 0.0f;
+        if (kind == DSP_TRIG_WINDOW && *p == ':') b = strtof(p + 1, &end), p = end;
+        while (*p && *p != ',') p++;
+
+        if (kind == DSP_TRIG_NONE || ch < 1 || ch > te->ch) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "trigger entry %lu skipped (bad channel or kind)", te->n_trig);
+            continue;
+        }
+        const float lsb = te->amps ? s_units.amps_per_lsb[ch - 1] : 1.0f;
+        // slope is given per ms and compared over span samples
+        if (kind == DSP_TRIG_SLOPE) a *= (float)span * 1000.0f / (float)te->fs;
+        const int32_t ia = (int32_t)(a / lsb), ib = (int32_t)(b / lsb);
+        const int32_t mag = kind == DSP_TRIG_WINDOW ? (ib - ia) / 2 : ia;
+        const int32_t hyst = (int32_t)((int64_t)mag * s_cfg.trig_hyst_pct / 100);
+        if (!dsp_trig_init(&te->trig[te->n_trig], kind, (uint32_t)ch - 1, ia, ib, hyst, span)) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "trigger entry %lu skipped (bad thresholds)", te->n_trig);
+            continue;
+        }
+        te->n_trig++;
+    }
+}
+
+static esp_err_t trig_setup(trig_engine_t *te, const tlv320adc5120_geometry_t *geo, bool amps) {
+    memset(te, 0, sizeof(*te));
+    te->ch   = geo->ch_count;
+    te->sb   = geo->sample_bytes;
+    te->fs   = geo->sample_rate_hz;
+    te->amps = amps;
+    te->pre_frames  = (uint32_t)((uint64_t)s_cfg.trig_pre_ms * te->fs / 1000);
+    te->post_frames = (uint32_t)((uint64_t)s_cfg.trig_post_ms * te->fs / 1000);
+    if (te->post_frames == 0) te->post_frames = 1;
+    if (te->pre_frames + te->post_frames > TRIG_MAX_FRAMES) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_SIZE, "trigger capture clipped to %u frames", TRIG_MAX_FRAMES);
+        if (te->post_frames > TRIG_MAX_FRAMES / 2) te->post_frames = TRIG_MAX_FRAMES / 2;
+        te->pre_frames = TRIG_MAX_FRAMES - te->post_frames;
+    }
+
+    trig_parse(te);
+    if (te->n_trig == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const uint32_t fb = trig_frame_bytes(te);
+    bool hist_psram = false, cap_psram = false;
+    te->hist = te->pre_frames ? alloc_prefer_psram((size_t)te->pre_frames * fb, &hist_psram) : NULL;
+    te->cap  = alloc_prefer_psram(sizeof(sample_mb_hdr_v4_t) + sizeof(trig_desc_v1_t)
+                                  + (size_t)(te->pre_frames + te->post_frames) * fb, &cap_psram);
+    if ((te->pre_frames && !te->hist) || !te->cap) {
+        trig_free(te);
+        return ESP_ERR_NO_MEM;
+    }
+
+    sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)te->cap;
+    mb_hdr_init(hdr, geo, 0x13, te->ch, 1, te->sb);   // bit4: trigger capture, descriptor follows the header
+    hdr->block_size  = (uint16_t)fb;
+    hdr->sample_rate = (uint16_t)(te->fs > UINT16_MAX ? 0 : te->fs);
+
+    te->last_pub_us = esp_timer_get_time();
+    snprintf(te->topic, sizeof(te->topic), "jaqc/sig/trig/v1/%08X", (unsigned)s_dev_id);
+    LOG_INFO(TAG, "%lu triggers, %lu + %lu frames (history in %s, capture in %s) -> %s", 
+        te->n_trig, te->pre_frames, te->post_frames, 
+        hist_psram ? "PSRAM" : "internal RAM", cap_psram ? "PSRAM" : "internal RAM", te->topic);
+    return ESP_OK;
+}
+
+static void hist_append(trig_engine_t *te, const int32_t *in32, uint32_t frames) {
+    if (!te->pre_frames) return;
+    const uint32_t ch = te->ch, fb = trig_frame_bytes(te);
+    // only the newest pre_frames can matter
+    if (frames > te->pre_frames) {
+        in32 += (size_t)(frames - te->pre_frames) * ch;
+        frames = te->pre_frames;
+    }
+    while (frames) {
+        uint32_t n = te->pre_frames - te->hist_pos;
+        if (n > frames) n = frames;
+        store_samples(in32, te->sb, n * ch, te->hist + (size_t)te->hist_pos * fb);
+        in32 += (size_t)n * ch;
+        frames -= n;
+        te->hist_pos = (te->hist_pos + n) % te->pre_frames;
+        te->hist_fill = te->hist_fill + n > te->pre_frames ? te->pre_frames : te->hist_fill + n;
+    }
+}
+
+static void trig_publish(trig_engine_t *te, uint32_t frames) {
+    sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)te->cap;
+    hdr->seq_first   = te->seq++;
+    hdr->block_count = (uint16_t)frames;
+    const size_t len = sizeof(*hdr) + sizeof(trig_desc_v1_t) + (size_t)frames * trig_frame_bytes(te);
+    if (util_mqtt_is_ready()) {
+        esp_err_t perr = util_mqtt_publish_bytes(te->topic, te->cap, len, 0, false);
+        if (perr != ESP_OK) {
+            LOG_ERR(TAG, perr, "publish failed (trigger seq=%u)", (unsigned)hdr->seq_first);
+        }
+    }
+    te->last_pub_us = esp_timer_get_time();
+}
+
+/* Start a capture at the trigger frame: descriptor, then the history oldest first */
+static void trig_start(trig_engine_t *te, int k, int64_t trig_us) {
+    const dsp_trig_t *t = &te->trig[k];
+    const float lsb = te->amps ? s_units.amps_per_lsb[t->ch] : 1.0f;
+    const uint32_t fb = trig_frame_bytes(te);
+    sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)te->cap;
+    trig_desc_v1_t *d = (trig_desc_v1_t *)(te->cap + sizeof(*hdr));
+
+    memcpy(d->magic, "TRIG", 4);
+    d->version     = 0x01;
+    d->cause       = (uint8_t)t->kind;
+    d->ch          = (uint8_t)(t->ch + 1);
+    d->flags       = te->amps ? 0x01 : 0x00;
+    d->trig_us     = trig_us;
+    d->sample_rate = te->fs;
+    d->pre_frames  = te->hist_fill;
+    d->post_frames = te->post_frames;
+    d->value       = (float)t->last * lsb;
+    d->threshold   = (float)t->a * lsb;
+    mb_hdr_stamp(hdr, trig_us - (int64_t)te->hist_fill * 1000000 / te->fs);
+
+    uint8_t *body = te->cap + sizeof(*hdr) + sizeof(*d);
+    const uint32_t oldest = (te->hist_pos + te->pre_frames - te->hist_fill) % (te->pre_frames ? te->pre_frames : 1);
+    for (uint32_t i = 0; i < te->hist_fill; ++i) {
+        memcpy(body + (size_t)i * fb, te->hist + (size_t)((oldest + i) % te->pre_frames) * fb, fb);
+    }
+    te->cap_frames = te->hist_fill;
+    te->post_left  = te->post_frames;
+}
+
+static void cap_append(trig_engine_t *te, const int32_t *in32, uint32_t frames) {
+    uint8_t *body = te->cap + sizeof(sample_mb_hdr_v4_t) + sizeof(trig_desc_v1_t);
+    store_samples(in32, te->sb, frames * te->ch, body + (size_t)te->cap_frames * trig_frame_bytes(te));
+    te->cap_frames += frames;
+    te->post_left  -= frames;
+    if (te->post_left == 0) {
+        trig_publish(te, te->cap_frames);
+    }
+}
+
+/* One raw block. blk_us: time the block's last frame landed. */
+static void trig_feed(trig_engine_t *te, const int32_t *in32, uint32_t frames, int64_t blk_us) {
+    const uint32_t ch = te->ch;
+    uint32_t pos = 0;
+    while (pos < frames) {
+        int k;
+        uint32_t left = frames - pos;
+        if (te->post_left && left > te->post_left) left = te->post_left;
+        const uint32_t n = dsp_trig_scan(te->trig, te->n_trig, in32 + (size_t)pos * ch, ch, left, &k);
+        if (te->post_left) {
+            // collecting: triggers keep tracking (re-arm, slope history) but cannot start another capture
+            hist_append(te, in32 + (size_t)pos * ch, n);
+            cap_append(te, in32 + (size_t)pos * ch, n);
+            pos += n;
+            continue;
+        }
+        if (k < 0) {
+            hist_append(te, in32 + (size_t)pos * ch, n);
+            pos += n;
+            break;
+        }
+        // frame pos + n - 1 fired: history up to it, then the capture starts at it
+        const uint32_t at = pos + n - 1;
+        hist_append(te, in32 + (size_t)pos * ch, n - 1);
+        const int64_t t_us = blk_us - (int64_t)(frames - 1 - at) * 1000000 / te->fs;
+        trig_start(te, k, t_us);
+        hist_append(te, in32 + (size_t)at * ch, 1);
+        cap_append(te, in32 + (size_t)at * ch, 1);
+        pos = at + 1;
+    }
+
+    // heartbeat: descriptor only, cause 0
+    if (!te->post_left && esp_timer_get_time() - te->last_pub_us >= (int64_t)s_cfg.trig_hb_s * 1000000) {
+        sample_mb_hdr_v4_t *hdr = (sample_mb_hdr_v4_t *)te->cap;
+        trig_desc_v1_t *d = (trig_desc_v1_t *)(te->cap + sizeof(*hdr));
+        memset(d, 0, sizeof(*d));
+        memcpy(d->magic, "TRIG", 4);
+        d->version     = 0x01;
+        d->trig_us     = blk_us;
+        d->sample_rate = te->fs;
+        mb_hdr_stamp(hdr, blk_us);
+        trig_publish(te, 0);
+    }
+}
+/* END TRIGGERED CAPTURE V1 *****************************************/
+
+
+/* CHARGE COUNTERS V1 ***********************************************/
+/* Full-rate coulomb counters. They integrate every raw block the publisher
+   leases, whether or not MQTT is up, persist to NVS (ops namespace) every
+   qc_persist_s and publish a small retained counter message every qc_pub_s.
+   Blocks lost before the publisher sees them (ring drops and overwrites, see
+   ring_lost) and the time parked in the VAD gate, when nothing is captured,
+   cannot be integrated; they are counted as gap frames so the server knows how
+   much is missing. */
+
+// Little-Endian counter header; followed by ch_count x qc_ch_v1_t
+typedef struct __attribute__((packed)) {
+    uint8_t  magic[4];      // "JQMC"
+    uint8_t  version;       // 0x01
+    uint8_t  flags;         // bit0: amps_per_lsb valid (coulombs / A·h meaningful)
+    uint16_t hdr_len;       // sizeof this header
+    uint32_t seq;           // publish sequence since boot
+    uint32_t ts_ms;         // time the last counted frame landed
+    uint32_t sample_rate;
+    uint64_t frames;        // frames integrated since the counters were zeroed
+    uint64_t gap_frames;    // frames lost to ring drops or VAD idle over the same period
+    uint8_t  ch_count;
+    uint8_t  reserved[3];
+    uint32_t dev_id;
+} qc_hdr_v1_t;
+
+typedef struct __attribute__((packed)) {
+    int64_t  net_whole;     // exact net charge: net_whole + net_part / sample_rate, counts x s
+    int64_t  fwd_whole;     // exact forward (positive) charge, same units
+    int32_t  net_part;
+    int32_t  fwd_part;
+    float    amps_per_lsb;
+    float    reserved;
+    double   net_ah;        // net_* x amps_per_lsb / 3600
+    double   fwd_ah;
+} qc_ch_v1_t;
+
+// NVS image; counts are in the units (fs, amps_per_lsb) they were integrated in
+#define QC_NVS_KEY      "qc"
+#define QC_NVS_VERSION  2
+#define QC_NVS_V1_CH    4       // v1 images (single ADC) hold four channels
+typedef struct {
+    uint32_t version;
+    uint32_t fs;
+    uint32_t ch;
+    float    amps_per_lsb[DSP_CHARGE_MAX_CH];
+    uint64_t frames;
+    uint64_t gap_frames;
+    dsp_charge_acc_t net[DSP_CHARGE_MAX_CH];
+    dsp_charge_acc_t fwd[DSP_CHARGE_MAX_CH];
+} qc_nvs_t;
+
+typedef struct {
+    uint32_t version;
+    uint32_t fs;
+    uint32_t ch;
+    float    amps_per_lsb[QC_NVS_V1_CH];
+    uint64_t frames;
+    uint64_t gap_frames;
+    dsp_charge_acc_t net[QC_NVS_V1_CH];
+    dsp_charge_acc_t fwd[QC_NVS_V1_CH];
+} qc_nvs_v1_t;
+
+typedef struct {
+    dsp_charge_t acc;
+    float    lsb[DSP_CHARGE_MAX_CH];
+    bool     amps;
+    uint64_t gap_frames;
+    uint32_t block_frames;
+    uint32_t seq;
+    int64_t  last_pub_us;
+    int64_t  last_save_us;
+    char     topic[TOPIC_MAX];
+} qc_t;
+
+static qc_t s_qc;
+static bool s_qc_on = false;
+
+/* Re-express a stored counter in the current units when fs or the LSB size
+   changed since it was saved; exact when neither did. */
+static void qc_restore_acc(dsp_charge_acc_t *dst, const dsp_charge_acc_t *src,
+    uint32_t fs_old, double k, uint32_t fs
+) {
+    if (fs_old == fs && k == 1.0) {
+        *dst = *src;
+        return;
+    }
+    const double q = ((double)src->whole + (double)src->part / fs_old) * k;
+    dst->whole = (int64_t)q;
+    dst->part  = llround((q - (double)dst->whole) * fs);
+}
+
+static void qc_load(qc_t *qc) {
+    union {
+        qc_nvs_t    cur;
+        qc_nvs_v1_t v1;
+    } blob;
+    memset(&blob, 0, sizeof(blob));
+    esp_err_t err = flash_get_blob(s_ops_nvs, QC_NVS_KEY, &blob, sizeof(blob)); // a shorter v1 blob reads fine
+    if (err) {
+        LOG_WARN(TAG, err, "charge counters unreadable; starting from zero");
+        return;
+    }
+    qc_nvs_t img = blob.cur;
+    if (blob.v1.version == 1 && blob.v1.ch <= QC_NVS_V1_CH) {
+        const qc_nvs_v1_t *v1 = &blob.v1;
+        memset(&img, 0, sizeof(img));
+        img.version    = QC_NVS_VERSION;
+        img.fs         = v1->fs;
+        img.ch         = v1->ch;
+        img.frames     = v1->frames;
+        img.gap_frames = v1->gap_frames;
+        memcpy(img.amps_per_lsb, v1->amps_per_lsb, sizeof(v1->amps_per_lsb));
+        memcpy(img.net, v1->net, sizeof(v1->net));
+        memcpy(img.fwd, v1->fwd, sizeof(v1->fwd));
+    }
+    if (img.version != QC_NVS_VERSION || img.fs == 0 || img.ch != qc->acc.ch) {
+        if (img.version != 0) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "stored charge counters (v%lu, %lu ch) do not match; starting from zero",
+                img.version, img.ch);
+        }
+        return;
+    }
+    bool rescaled = (img.fs != qc->acc.fs);
+    for (uint32_t c = 0; c < qc->acc.ch; ++c) {
+        double k = 1.0;
+        if (qc->amps && img.amps_per_lsb[c] > 0.0f && img.amps_per_lsb[c] != qc->lsb[c]) {
+            k = (double)img.amps_per_lsb[c] / qc->lsb[c];
+            rescaled = true;
+        }
+        qc_restore_acc(&qc->acc.net[c], &img.net[c], img.fs, k, qc->acc.fs);
+        qc_restore_acc(&qc->acc.fwd[c], &img.fwd[c], img.fs, k, qc->acc.fs);
+    }
+    qc->acc.frames  = img.frames;
+    qc->gap_frames  = img.gap_frames;
+    if (rescaled) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "charge counters rescaled to the current sample rate / unit scaling");
+    }
+    LOG_INFO(TAG, "charge counters restored: %llu frames, %llu gap frames", img.frames, img.gap_frames);
+}
+
+static void qc_save(qc_t *qc) {
+    qc_nvs_t img;
+    memset(&img, 0, sizeof(img));
+    img.version    = QC_NVS_VERSION;
+    img.fs         = qc->acc.fs;
+    img.ch         = qc->acc.ch;
+    img.frames     = qc->acc.frames;
+    img.gap_frames = qc->gap_frames;
+    for (uint32_t c = 0; c < qc->acc.ch; ++c) {
+        img.amps_per_lsb[c] = qc->amps ? qc->lsb[c] : 0.0f;
+        img.net[c] = qc->acc.net[c];
+        img.fwd[c] = qc->acc.fwd[c];
+    }
+    esp_err_t err = flash_set_blob(s_ops_nvs, QC_NVS_KEY, &img, sizeof(img));
+    if (!err) err = flash_commit(s_ops_nvs);
+    if (err) {
+        LOG_ERR(TAG, err, "failed to persist charge counters");
+    }
+}
+
+static esp_err_t qc_setup(qc_t *qc, const tlv320adc5120_geometry_t *geo, bool amps) {
+    memset(qc, 0, sizeof(*qc));
+    if (!dsp_charge_init(&qc->acc, geo->ch_count, geo->sample_rate_hz)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    qc->amps = amps;
+    for (uint32_t c = 0; c < geo->ch_count; ++c) qc->lsb[c] = amps ? s_units.amps_per_lsb[c] : 0.0f;
+    qc->block_frames = geo->block_frames;
+    qc_load(qc);
+    qc->last_pub_us = qc->last_save_us = esp_timer_get_time();
+
+    snprintf(qc->topic, sizeof(qc->topic), "jaqc/sig/charge/v1/%08X", (unsigned)s_dev_id);
+    LOG_INFO(TAG, "charge counters: %lu ch at %lu Hz, publish %lu s, persist %lu s -> %s",
+        geo->ch_count, geo->sample_rate_hz, s_cfg.qc_pub_s, s_cfg.qc_persist_s, qc->topic);
+    return ESP_OK;
+}
+
+// t_us: when the last integrated frame landed
+static void qc_publish(qc_t *qc, int64_t t_us) {
+    uint8_t buf[sizeof(qc_hdr_v1_t) + DSP_CHARGE_MAX_CH * sizeof(qc_ch_v1_t)];
+    const uint32_t ch = qc->acc.ch;
+    qc_hdr_v1_t *hdr = (qc_hdr_v1_t *)buf;
+    qc_ch_v1_t *rec = (qc_ch_v1_t *)(buf + sizeof(*hdr));
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(hdr->magic, "JQMC", 4);
+    hdr->version     = 0x01;
+    hdr->flags       = qc->amps ? 0x01 : 0x00;
+    hdr->hdr_len     = sizeof(*hdr);
+    hdr->seq         = qc->seq++;
+    hdr->ts_ms       = (uint32_t)(t_us / 1000);
+    hdr->sample_rate = qc->acc.fs;
+    hdr->frames      = qc->acc.frames;
+    hdr->gap_frames  = qc->gap_frames;
+    hdr->ch_count    = (uint8_t)ch;
+    hdr->dev_id      = s_dev_id;
+    for (uint32_t c = 0; c < ch; ++c) {
+        const double k = qc->lsb[c] / 3600.0;
+        rec[c].net_whole    = qc->acc.net[c].whole;
+        rec[c].net_part     = (int32_t)qc->acc.net[c].part;
+        rec[c].fwd_whole    = qc->acc.fwd[c].whole;
+        rec[c].fwd_part     = (int32_t)qc->acc.fwd[c].part;
+        rec[c].amps_per_lsb = qc->lsb[c];
+        rec[c].net_ah       = dsp_charge_value(&qc->acc, &qc->acc.net[c]) * k;
+        rec[c].fwd_ah       = dsp_charge_value(&qc->acc, &qc->acc.fwd[c]) * k;
+    }
+
+    // Counters are cumulative, so a publish missed while offline loses nothing
+    if (util_mqtt_is_ready()) {
+        esp_err_t err = util_mqtt_publish_bytes(qc->topic, buf, sizeof(*hdr) + ch * sizeof(qc_ch_v1_t), 1, true);
+        if (err != ESP_OK) {
+            LOG_ERR(TAG, err, "publish failed (charge, seq=%lu)", hdr->seq);
+        }
+    }
+}
+
+/* One raw block, whose last frame landed at t_us. lost: blocks the ring
+   dropped or overwrote just before it, or not captured while VAD idle. */
+static void qc_feed(qc_t *qc, const int32_t *in32, uint32_t frames, uint32_t lost, int64_t t_us) {
+    qc->gap_frames += (uint64_t)lost * qc->block_frames;
+    dsp_charge_accumulate(&qc->acc, in32, frames);
+
+    const int64_t now = esp_timer_get_time();
+    if (now - qc->last_pub_us >= (int64_t)s_cfg.qc_pub_s * 1000000) {
+        qc->last_pub_us = now;
+        qc_publish(qc, t_us);
+    }
+    if (now - qc->last_save_us >= (int64_t)s_cfg.qc_persist_s * 1000000) {
+        qc->last_save_us = now;
+        qc_save(qc);
+    }
+}
+
+/* END CHARGE COUNTERS V1 *******************************************/
+
+/* SAMPLE CLOCK *****************************************************/
+/* As I2S master the ESP divides its PLL down to the frame rate with a
+   fractional MCLK divider, so the true rate sits a few ppm off nominal, and
+   the crystal behind it is off UTC by about as much again. A DLL on block
+   arrival times (dsp_drift) measures the rate against esp_timer, which runs
+   from the same crystal; util_time adds the crystal's own error once SNTP has
+   disciplined it. Every pipe buffer carries the estimate, JQMB headers publish
+   it (clk_ppb), and with cfg resample the decimated streams are resampled to
+   exactly their nominal rate: output sample n is at the stream's start time
+   plus n / rate on every device, so joins across devices are index arithmetic. */
+
+#define CLK_BW_HZ       0.02f   // DLL bandwidth once locked
+
+typedef struct {
+    dsp_drift_t dll;
+    bool        on;
+    bool        primed;
+    int32_t     ppb;            // CLK_NONE until the DLL first locks
+} sample_clk_t;
+
+static sample_clk_t s_clk;
+
+static void clk_setup(sample_clk_t *k, const tlv320adc5120_geometry_t *geo) {
+    memset(k, 0, sizeof(*k));
+    k->ppb = CLK_NONE;
+    // A sped-up synthetic source has no real rate to measure
+    k->on = s_cfg.synth_x <= 1 && dsp_drift_init(&k->dll, geo->sample_rate_hz, geo->block_frames, CLK_BW_HZ);
+}
+
+/* After the stream stopped (VAD idle): relock the phase, keep the last estimate */
+static void clk_restart(sample_clk_t *k) {
+    dsp_drift_reset(&k->dll);
+    k->primed = false;
+}
+
+/* One leased block, stamped at DMA completion. lost blocks (ring_lost) still
+   took their share of time. */
+static int32_t clk_feed(sample_clk_t *k, uint32_t lost, int64_t t_us) {
+    if (!k->on) return CLK_NONE;
+    const uint32_t blocks = k->primed ? lost + 1 : 1;
+    k->primed = true;
+
+    dsp_drift_update(&k->dll, blocks, t_us);
+    if (dsp_drift_locked(&k->dll)) {
+        k->ppb = dsp_drift_ppb(&k->dll) + time_timer_ppb();
+    }
+    return k->ppb;
+}
+
+/* Blocks lost ahead of each leased one. Overwritten blocks leave a gap in the
+   ring sequence; dropped ones never get a sequence and only show in the ring's
+   drop count, so both are needed. */
+typedef struct {
+    bool     primed;
+    uint32_t next_seq;          // ring sequence expected next
+    uint32_t dropped;           // ring drops already accounted for
+} ring_gap_t;
+
+static ring_gap_t s_gap;
+
+static uint32_t ring_lost(ring_gap_t *g, uint32_t seq) {
+    ring_stats_t rs;
+    tlv320adc5120_get_ring_stats(&rs);
+    const uint32_t lost = g->primed ? (seq - g->next_seq) + (rs.dropped - g->dropped) : 0;
+    g->primed   = true;
+    g->next_seq = seq + 1;
+    g->dropped  = rs.dropped;
+    return lost;
+}
+
+static void clk_report(const sample_clk_t *k, uint32_t fs) {
+    if (!k->on) return;
+    const dsp_drift_t *d = &k->dll;
+    const bool locked = k->ppb != CLK_NONE;
+    const bool utc = time_is_disciplined();
+    const double rate = locked ? fs * (1.0 + k->ppb * 1e-9) : 0.0;
+    LOG_INFO(TAG, "sample clock %.4f Hz (%+.3f ppm vs %s; I2S divider %+.3f ppm, crystal %+.3f ppm), %lu outliers, %lu reseeds",
+        rate, locked ? k->ppb * 1e-3 : 0.0, utc ? "UTC" : "crystal", dsp_drift_ppb(d) * 1e-3, time_timer_ppb() * 1e-3,
+        d->outliers, d->reseeds);
+
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "nominal_hz", fs);
+    cJSON_AddNumberToObject(root, "rate_hz", rate);
+    cJSON_AddBoolToObject(root, "locked", locked);
+    cJSON_AddBoolToObject(root, "utc", utc);
+    cJSON_AddNumberToObject(root, "ppb", locked ? k->ppb : 0);
+    cJSON_AddNumberToObject(root, "i2s_ppb", dsp_drift_ppb(d));
+    cJSON_AddNumberToObject(root, "xtal_ppb", time_timer_ppb());
+    cJSON_AddNumberToObject(root, "outliers", d->outliers);
+    cJSON_AddNumberToObject(root, "reseeds", d->reseeds);
+    if (util_mqtt_is_ready()) {
+        char topic[TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "jaqc/sig/clock/v1/%08X", (unsigned)s_dev_id);
+        util_mqtt_publish_json(topic, root, 0, false);
+    }
+    cJSON_Delete(root);
+}
+
+/* END SAMPLE CLOCK *************************************************/
+
+/* PIPELINE *********************************************************/
+/* Processing stages run on util_pipe lanes, placed by cfg "pipe":
+       "0:charge,ds,stats,fft,trig"           one lane on core 0 (default)
+       "0:charge,trig;1:ds,stats,fft"         capture-critical work on core 0, the rest on core 1
+       "0:charge,trig;1:ds;1:stats,fft"       MQTT publishing in a lane of its own
+   Every lane sees every block: one pooled buffer is shared by reference, and
+   goes back to the pool when the last lane is done with it. Stages only read
+   the buffer, so lanes never wait on each other; a stalled publish holds
+   buffers but the trigger and charge lanes keep running until the pool is
+   out. Stages: ds (decimated streams: filter, merge, compress, publish),
+   stats, fft, trig, charge, units (current conversion + mean log), vad
+   (activity gate). An enabled stage left out of the spec is appended to the
+   last lane, except units: it is a bench check of the scaling, and a
+   conversion and a log line nothing else reads, so it runs only when named. */
+
+#define PIPE_DEPTH      4       // block buffers in flight
+#define V1_QUEUE_BYTES  (256 * 512) // the v1 publish queue: 256 raw blocks, copied in, one consumer
+#define PIPE_STACK      8192
+#define PIPE_PRIO       3
+
+typedef struct {
+    float   *amps;
+    float    sum[DSP_UNITS_MAX_CH];
+    uint32_t blocks;
+} units_stage_t;
+
+static tlv320adc5120_geometry_t s_geo;
+static pipe_t s_pipe;
+static units_stage_t s_units_stage;
+
+static void stage_ds(void *ctx, const pipe_buf_t *b) {
+    (void)ctx;
+    for (uint32_t k = 0; k < s_stream_count; ++k) {
+        stream_feed(&s_streams[k], b, s_geo.sample_bytes);
+    }
+}
+
+static void stage_stats(void *ctx, const pipe_buf_t *b) {
+    (void)ctx;
+    for (uint32_t k = 0; k < s_stats_count; ++k) {
+        stats_feed(&s_stats[k], b->data, b->frames, b->t_us, s_geo.sample_rate_hz);
+    }
+}
+
+static void stage_fft(void *ctx, const pipe_buf_t *b) {
+    spectrum_feed((spectrum_t *)ctx, b->data, b->frames, s_geo.sample_rate_hz, b->t_us);
+}
+
+static void stage_trig(void *ctx, const pipe_buf_t *b) {
+    trig_engine_t *te = (trig_engine_t *)ctx;
+    ((sample_mb_hdr_v4_t *)te->cap)->clk_ppb = b->clk_ppb;
+    // t_us is the block's DMA completion, i.e. when its last frame landed
+    trig_feed(te, b->data, b->frames, b->t_us);
+}
+
+static void stage_charge(void *ctx, const pipe_buf_t *b) {
+    qc_feed((qc_t *)ctx, b->data, b->frames, b->lost, b->t_us);
+}
+
+/* Pipe buffers hold sign-extended int32, which the sb = 4 kernel reads as-is */
+static void stage_units(void *ctx, const pipe_buf_t *b) {
+    units_stage_t *u = (units_stage_t *)ctx;
+    const uint32_t ch = s_units.ch;
+    dsp_units_amps_f32(&s_units, (const uint8_t *)b->data, 4, b->frames, u->amps);
+    for (uint32_t i = 0; i < b->frames; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) u->sum[c] += u->amps[i * ch + c];
+    }
+    if (++u->blocks == UNITS_LOG_BLOCKS) {
+        const float n = (float)u->blocks * b->frames;
+        char line[TLV_MAX_CH * 11 + 1];
+        size_t len = 0;
+        for (uint32_t c = 0; c < ch && len < sizeof(line); ++c) len += snprintf(line + len, sizeof(line) - len, " %.6f", u->sum[c] / n);
+        LOG_INFO(TAG, "mean current CH1..CH%lu:%s A", ch, line);
+        memset(u->sum, 0, sizeof(u->sum));
+        u->blocks = 0;
+    }
+}
+
+/* Activity gate: after vad_hold_s of blocks whose peak-to-peak on the VAD
+   channel stays under vad_quiet_a, ask the publisher to park acquisition in
+   the ADC's voice-activity detector (see tlv320adc5120_vad_idle) */
+typedef struct {
+    uint32_t ch;            // 0-based
+    int32_t  quiet;         // p2p threshold, counts
+    uint32_t hold_blocks;
+    uint32_t quiet_blocks;
+} vad_stage_t;
+
+static vad_stage_t s_vad;
+static volatile bool s_vad_idle_req = false;
+
+static void stage_vad(void *ctx, const pipe_buf_t *b) {
+    vad_stage_t *v = (vad_stage_t *)ctx;
+    const uint32_t ch = s_geo.ch_count;
+    const int32_t *x = b->data + v->ch;
+    int32_t mn = INT32_MAX, mx = INT32_MIN;
+    for (uint32_t i = 0; i < b->frames; ++i, x += ch) {
+        if (*x < mn) mn = *x;
+        if (*x > mx) mx = *x;
+    }
+    if (mx - mn >= v->quiet) {
+        v->quiet_blocks = 0;
+    } else if (++v->quiet_blocks >= v->hold_blocks) {
+        v->quiet_blocks = 0;
+        s_vad_idle_req = true;
+    }
+}
+
+static esp_err_t vad_setup(vad_stage_t *v, const tlv320adc5120_geometry_t *geo, bool amps) {
+    if (s_cfg.synth_x) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    if (s_cfg.vad_ch == 0 || s_cfg.vad_ch > geo->ch_count) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    v->ch = s_cfg.vad_ch - 1;
+    const float lsb = amps ? s_units.amps_per_lsb[v->ch] : 1.0f;
+    v->quiet = (int32_t)(s_cfg.vad_quiet_a / lsb) + 1;
+    v->hold_blocks = (uint32_t)((uint64_t)s_cfg.vad_hold_s * 1000000 / geo->block_us);
+    if (v->hold_blocks == 0) v->hold_blocks = 1;
+    v->quiet_blocks = 0;
+    if (s_cfg.charge) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "VAD gate with charge counters on: time idle is counted as gap frames, not integrated");
+    }
+    LOG_INFO(TAG, "VAD gate: CH%lu, idle after %lu blocks under %ld counts p2p", s_cfg.vad_ch, v->hold_blocks, v->quiet);
+    return ESP_OK;
+}
+
+/* Park in the ADC's VAD until activity, then stream again. Runs on the publisher,
+   which owns the I2S channel; the lanes just see no buffers meanwhile. Returns
+   the blocks not captured, which the next buffer reports as lost so the charge
+   counters count them as gap frames. */
+static uint32_t vad_idle_wait(uint32_t block_us) {
+    const int64_t t0 = esp_timer_get_time();
+    esp_err_t err = tlv320adc5120_vad_idle(s_vad.ch, xTaskGetCurrentTaskHandle());
+    if (err) {
+        LOG_ERR(TAG, err, "VAD idle failed; streaming continues");
+        tlv320adc5120_vad_resume();
+        return 0;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    err = tlv320adc5120_vad_resume();
+    if (err) {
+        LOG_ERR(TAG, err, "VAD resume failed");
+    }
+    const int64_t idle_us = esp_timer_get_time() - t0;
+    LOG_INFO(TAG, "VAD activity after %lu s idle", (uint32_t)(idle_us / 1000000));
+    return (uint32_t)((idle_us + block_us / 2) / block_us);
+}
+
+typedef struct {
+    const char *name;
+    pipe_stage_fn_t fn;
+    void *ctx;
+    bool on;
+    bool named;             // runs only when the spec names it
+    bool placed;
+} stage_def_t;
+
+/* Build lanes from the spec; returns the number of stages placed */
+static uint32_t pipe_build(pipe_t *p, stage_def_t *defs, uint32_t n_defs, const char *spec) {
+    uint32_t placed = 0;
+    int lane = -1;
+    const char *s = spec;
+    while (*s) {
+        // "core:" opens a lane
+        char *end;
+        long core = strtol(s, &end, 10);
+        if (end == s || *end != ':' || core < 0 || core > 1) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "bad pipe lane at \"%s\"", s);
+            break;
+        }
+        lane = pipe_add_lane(p, (int)core);
+        if (lane < 0) {
+            LOG_WARN(TAG, ESP_ERR_NO_MEM, "pipe has at most %d lanes; ignoring \"%s\"", PIPE_MAX_LANES, s);
+            break;
+        }
+        s = end + 1;
+        while (*s && *s != ';') {
+            size_t len = strcspn(s, ",;");
+            uint32_t d = 0;
+            while (d < n_defs && (strlen(defs[d].name) != len || strncmp(defs[d].name, s, len) != 0)) d++;
+            if (d == n_defs) {
+                LOG_WARN(TAG, ESP_ERR_NOT_FOUND, "unknown pipe stage \"%.*s\"", (int)len, s);
+            } else if (defs[d].on && !defs[d].placed) {
+                if (pipe_add_stage(p, (uint32_t)lane, defs[d].name, defs[d].fn, defs[d].ctx) == ESP_OK) {
+                    defs[d].placed = true;
+                    placed++;
+                }
+            }
+            s += len;
+            if (*s == ',') s++;
+        }
+        if (*s == ';') s++;
+    }
+    if (lane < 0) {
+        lane = pipe_add_lane(p, 0);
+        if (lane < 0) return 0;
+    }
+    for (uint32_t d = 0; d < n_defs; ++d) {
+        if (defs[d].on && !defs[d].named && !defs[d].placed
+        &&  pipe_add_stage(p, (uint32_t)lane, defs[d].name, defs[d].fn, defs[d].ctx) == ESP_OK) {
+            LOG_WARN(TAG, ESP_ERR_NOT_FOUND, "stage \"%s\" not in pipe spec; appended to lane %d", defs[d].name, lane);
+            defs[d].placed = true;
+            placed++;
+        }
+    }
+    return placed;
+}
+
+/* Per-stage CPU share of one core, from cycles over the wall time they covered */
+static void pipe_report(pipe_t *p, int64_t span_us) {
+    cJSON *root = cJSON_CreateObject();
+    cJSON *arr = cJSON_AddArrayToObject(root, "stages");
+    const double cycles_per_us = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    for (uint32_t i = 0; i < p->n_lanes; ++i) {
+        const pipe_lane_t *l = &p->lanes[i];
+        for (uint32_t k = 0; k < l->n_stages; ++k) {
+            const pipe_stage_t *s = &l->stages[k];
+            const double cpu = span_us > 0 ? 100.0 * s->cycles / (cycles_per_us * span_us) : 0.0;
+            const uint32_t avg = s->calls ? (uint32_t)(s->cycles / s->calls) : 0;
+            LOG_INFO(TAG, "pipe %lu/%s core %d: %lu cyc avg, %lu max, %.2f%% cpu, latency max %lu us",
+                i, s->name, l->core, avg, s->max_cycles, cpu, s->max_latency_us);
+            cJSON *o = cJSON_CreateObject();
+            cJSON_AddStringToObject(o, "name", s->name);
+            cJSON_AddNumberToObject(o, "lane", i);
+            cJSON_AddNumberToObject(o, "core", l->core);
+            cJSON_AddNumberToObject(o, "calls", s->calls);
+            cJSON_AddNumberToObject(o, "cyc_avg", avg);
+            cJSON_AddNumberToObject(o, "cyc_max", s->max_cycles);
+            cJSON_AddNumberToObject(o, "cpu_pct", cpu);
+            cJSON_AddNumberToObject(o, "lat_max_us", s->max_latency_us);
+            cJSON_AddItemToArray(arr, o);
+        }
+    }
+    cJSON *lanes = cJSON_AddArrayToObject(root, "lanes");
+    for (uint32_t i = 0; i < p->n_lanes; ++i) {
+        cJSON *o = cJSON_CreateObject();
+        cJSON_AddNumberToObject(o, "core", p->lanes[i].core);
+        cJSON_AddNumberToObject(o, "backlog", p->lanes[i].backlog);
+        cJSON_AddItemToArray(lanes, o);
+    }
+    LOG_INFO(TAG, "pipe pool %lu of %lu buffers out at most, %lu waits, %u B",
+        p->high_water, p->depth, p->waits, (unsigned)p->pool_bytes);
+    cJSON_AddNumberToObject(root, "depth", p->depth);
+    cJSON_AddNumberToObject(root, "high_water", p->high_water);
+    cJSON_AddNumberToObject(root, "waits", p->waits);
+    cJSON_AddNumberToObject(root, "pool_bytes", p->pool_bytes);
+    if (util_mqtt_is_ready()) {
+        char topic[TOPIC_MAX];
+        snprintf(topic, sizeof(topic), "jaqc/sig/pipe/v1/%08X", (unsigned)s_dev_id);
+        util_mqtt_publish_json(topic, root, 0, false);
+    }
+    cJSON_Delete(root);
+    pipe_stats_reset(p);
+}
+
+/* END PIPELINE *****************************************************/
+
+/* Lease the next raw block straight from the driver ring, sleeping until the
+   DMA ISR signals that one has landed. */
+static void next_block(tlv320adc5120_block_t *blk) {
+    static uint32_t blk_count = 0;
+    while (!tlv320adc5120_acquire(blk)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(200));
+    }
+    if ((++blk_count % 1000) == 0) {
+        ring_stats_t st;
+        tlv320adc5120_get_ring_stats(&st);
+        LOG_INFO(TAG, "%lu blocks; ring dropped=%lu overwritten=%lu high_water=%lu", 
+            blk_count, st.dropped, st.overwritten, st.high_water);
+    }
+}
+
+/* Ring consumer: copies each leased block into a pipe buffer, hands the slot
+   straight back to the DMA and submits the buffer to every lane. */
+static void publisher_task(void *arg) {
+    LOG_INFO(TAG, "publisher_task started");
+    tlv320adc5120_set_consumer(xTaskGetCurrentTaskHandle());
+
+    /* block geometry follows the configured sample rate */
+    tlv320adc5120_geometry_t *geo = &s_geo;
+    tlv320adc5120_get_geometry(geo);
+    const uint32_t ch = geo->ch_count;
+    const uint32_t sb = geo->sample_bytes;
+
+    /* Full-rate current */
+    for (uint32_t c = 0; c < ch; ++c) s_gain[c] = s_cfg.ina_gain[geo->chan[c].adc_ch - 1];
+    s_units_ok = dsp_units_init(&s_units, ch, s_cfg.adc_fs_v, s_cfg.shunt_ohms, s_gain);
+    const bool amps = s_units_ok;
+    if (amps) {
+        s_units_stage.amps = malloc((size_t)geo->block_frames * ch * sizeof(float));
+    } else {
+        LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "invalid unit scaling (fs=%.3f V, shunt=%.3f ohm); current disabled",
+            s_cfg.adc_fs_v, s_cfg.shunt_ohms);
+    }
+
+    streams_setup(geo);
+    stats_streams_setup(geo, amps);
+    if (s_cfg.fft_n) {
+        spectrum_bench();
+        esp_err_t err = spectrum_setup(&s_spec, geo, amps);
+        if (err) {
+            LOG_ERR(TAG, err, "fft setup failed (N=%lu, overlap %lu%%, window %lu)", 
+                s_cfg.fft_n, s_cfg.fft_overlap, s_cfg.fft_window);
+        }
+        s_spec_on = (err == ESP_OK);
+    }
+    if (s_cfg.trig[0] != '\0') {
+        esp_err_t err = trig_setup(&s_trig, geo, amps);
+        if (err) {
+            LOG_ERR(TAG, err, "trigger setup failed (\"%s\")", s_cfg.trig);
+        }
+        s_trig_on = (err == ESP_OK);
+    }
+    if (s_cfg.charge) {
+        esp_err_t err = qc_setup(&s_qc, geo, amps);
+        if (err) {
+            LOG_ERR(TAG, err, "charge counter setup failed");
+        }
+        s_qc_on = (err == ESP_OK);
+    }
+    bool vad_on = false;
+    if (s_cfg.vad) {
+        esp_err_t err = vad_setup(&s_vad, geo, amps);
+        if (err) {
+            LOG_ERR(TAG, err, "VAD gate setup failed (vad_ch %lu of %lu)", s_cfg.vad_ch, ch);
+        }
+        vad_on = (err == ESP_OK);
+    }
+
+    stage_def_t defs[] = {
+        { "units",  stage_units,  &s_units_stage, s_units_stage.amps != NULL, true,  false },
+        { "charge", stage_charge, &s_qc,          s_qc_on,                    false, false },
+        { "ds",     stage_ds,     NULL,           s_stream_count > 0,         false, false },
+        { "stats",  stage_stats,  NULL,           s_stats_count > 0,          false, false },
+        { "fft",    stage_fft,    &s_spec,        s_spec_on,                  false, false },
+        { "trig",   stage_trig,   &s_trig,        s_trig_on,                  false, false },
+        { "vad",    stage_vad,    &s_vad,         vad_on,                     false, false },
+    };
+    esp_err_t err = pipe_init(&s_pipe, PIPE_DEPTH, geo->block_frames, ch);
+    uint32_t n_stages = 0;
+    if (!err) {
+        n_stages = pipe_build(&s_pipe, defs, sizeof(defs) / sizeof(defs[0]), s_cfg.pipe);
+        if (!defs[0].placed) {
+            free(s_units_stage.amps);
+            s_units_stage.amps = NULL;
+        }
+        // only the units log / activity gate would be running: nothing to publish
+        const uint32_t helpers = (defs[0].placed ? 1 : 0) + (vad_on ? 1 : 0);
+        err = (n_stages <= helpers) ? ESP_ERR_INVALID_STATE : pipe_start(&s_pipe, PIPE_PRIO, PIPE_STACK);
+    }
+    if (!err) {
+        LOG_INFO(TAG, "pipe pool: %lu x %lu-frame buffers shared by %lu lanes, %u B (v1 publish queue: %u B)",
+            s_pipe.depth, geo->block_frames, s_pipe.n_lanes, (unsigned)s_pipe.pool_bytes, (unsigned)V1_QUEUE_BYTES);
+    }
+    if (err) {
+        LOG_ERR(TAG, err, "publisher setup failed (%lu streams from \"%s\", %lu stats from \"%s\", pipe \"%s\")", 
+            s_stream_count, s_cfg.ds_rates, s_stats_count, s_cfg.stats_ms, s_cfg.pipe);
+        free(s_units_stage.amps);
+        for (uint32_t k = 0; k < s_stream_count; ++k) stream_free(&s_streams[k]);
+        for (uint32_t k = 0; k < s_stats_count; ++k) stats_free(&s_stats[k]);
+        if (s_spec_on) spectrum_free(&s_spec);
+        if (s_trig_on) trig_free(&s_trig);
+        vTaskDelete(NULL);
+        return;
+    }
+
+    clk_setup(&s_clk, geo);
+    memset(&s_gap, 0, sizeof(s_gap));
+    lat_setup();
+    int64_t report_us = esp_timer_get_time();
+    uint32_t idle_blocks = 0;
+    while (1) {
+        /* Stages keep their own history, so each raw block goes straight back to the ring */
+        if (s_vad_idle_req) {
+            idle_blocks += vad_idle_wait(geo->block_us);
+            clk_restart(&s_clk);
+            s_vad_idle_req = false;
+        }
+        tlv320adc5120_block_t blk;
+        next_block(&blk);
+        const uint32_t lost = ring_lost(&s_gap, blk.seq);
+        const int32_t clk_ppb = clk_feed(&s_clk, lost, blk.t_us);
+        pipe_buf_t *b = pipe_get(&s_pipe);
+        b->t_us    = blk.t_us;
+        b->seq     = blk.seq;
+        b->lost    = lost + idle_blocks;
+        b->clk_ppb = clk_ppb;
+        load_samples(blk.data, sb, geo->block_frames * ch, b->data);
+        tlv320adc5120_release(&blk);
+        pipe_submit(&s_pipe, b);
+        idle_blocks = 0;
+
+        const int64_t now = esp_timer_get_time();
+        if (now - report_us >= (int64_t)s_cfg.pipe_report_s * 1000000) {
+            pipe_report(&s_pipe, now - report_us);
+            clk_report(&s_clk, geo->sample_rate_hz);
+            lat_report(now - report_us);
+            report_us = now;
+        }
+    }
+}
+
+
+/* END RAW DATA MESSAGE V4 ******************************************/
+
+
+
+
+/* ON-CHIP FILTERS ***************************************************/
+/* The ADC's first-order IIR and biquads run in its decimator, so they cost no
+   ESP cycles. Everything downstream sees the filtered signal, including the
+   charge counters and current statistics: a high-pass removes DC current. */
+
+esp_err_t app_tlv_set_filters(const char *spec) {
+    tlv320adc5120_geometry_t geo;
+    tlv320adc5120_get_geometry(&geo);
+    const uint32_t fs = geo.sample_rate_hz;
+    dsp_iir1_t f1;
+    dsp_iir1_hpf(&f1, fs, 0.0);
+    dsp_biquad_t chain[TLV_BIQUAD_MAX_PER_CH];
+    uint32_t n = 0;
+    bool hpf = false;
+
+    const char *p = spec ? spec : "";
+    while (*p) {
+        char type[8];
+        double f0 = 0.0, q = 0.7071;
+        int len = 0;
+        if (sscanf(p, "%7[a-z0-9]:%lf%n", type, &f0, &len) < 2) {
+            LOG_ERR(TAG, ESP_ERR_INVALID_ARG, "bad filter at \"%s\"", p);
+            return ESP_ERR_INVALID_ARG;
+        }
+        p += len;
+        if (*p == ':') {
+            char *end;
+            q = strtod(p + 1, &end);
+            p = end;
+        }
+        if (*p == ',') p++;
+
+        if (strcmp(type, "hpf1") == 0) {
+            if (!dsp_iir1_hpf(&f1, fs, f0)) return ESP_ERR_INVALID_ARG;
+            hpf = true;
+            continue;
+        }
+        const dsp_bq_type_t t = strcmp(type, "hpf") == 0 ? DSP_BQ_HPF
+                              : strcmp(type, "lpf") == 0 ? DSP_BQ_LPF
+                              : strcmp(type, "notch") == 0 ? DSP_BQ_NOTCH : DSP_BQ_ALLPASS;
+        if (t == DSP_BQ_ALLPASS || n == TLV_BIQUAD_MAX_PER_CH || !dsp_biquad_design(&chain[n], t, fs, f0, q)) {
+            LOG_ERR(TAG, ESP_ERR_INVALID_ARG, "filter %s %.3f Hz Q %.3f rejected (fs %lu Hz, %u biquads max)",
+                type, f0, q, fs, TLV_BIQUAD_MAX_PER_CH);
+            return ESP_ERR_INVALID_ARG;
+        }
+        hpf |= (t == DSP_BQ_HPF);
+        n++;
+    }
+
+    int32_t iir1[DSP_IIR1_COEFS];
+    int32_t bq[TLV_BIQUAD_MAX_PER_CH * 4][DSP_BQ_COEFS];
+    dsp_iir1_regs(&f1, iir1);
+    for (uint32_t j = 0; j < n; ++j) {
+        int32_t r[DSP_BQ_COEFS];
+        const double k = dsp_biquad_regs(&chain[j], r);
+        if (k < 1.0) {
+            LOG_WARN(TAG, ESP_ERR_INVALID_SIZE, "biquad %lu scaled by %.6f to fit Q31", j + 1, k);
+        }
+        for (uint32_t c = 0; c < 4; ++c) memcpy(bq[j * 4 + c], r, sizeof(r));
+    }
+    if (hpf && s_cfg.charge) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "high-pass filter set: DC current (and charge) will read as zero");
+    }
+    LOG_INFO(TAG, "on-chip filters \"%s\": %lu biquad(s) per channel", spec ? spec : "", n);
+    return tlv320adc5120_set_filters(iir1, n, n ? (const int32_t (*)[DSP_BQ_COEFS])bq : NULL);
+}
+
+/* END ON-CHIP FILTERS ***********************************************/
+
+/* RATE NEGOTIATION **************************************************/
+/* With rate_auto, capture at the lowest native rate every consumer accepts
+   instead of a fixed sample_rate_hz, so the decimators only make up the rest:
+     ds streams   rate < fs and fs % rate == 0 (integer decimation)
+     spectrum     fs >= 2 x the top fft band edge
+     raw users    fs >= raw_min_hz (stats, triggers, charge)
+   raw_min_hz 0 leaves the raw users at sample_rate_hz while any of them is
+   on, so a fleet configured for 48 kHz doesn't drop to 8 kHz because only
+   the ds rates were looked at; with none of them on it means any rate.
+   Every header reports the geometry's rate, so nothing downstream changes. */
+
+static bool rate_fits(uint32_t fs, uint32_t min_hz) {
+    if (fs < min_hz) return false;
+    const char *p = s_cfg.ds_rates;
+    while (*p) {
+        char *end;
+        unsigned long rate = strtoul(p, &end, 10);
+        if (end == p) { p++; continue; }
+        p = end;
+        if (rate != 0 && (rate >= fs || fs % rate != 0)) return false;
+    }
+    return true;
+}
+
+static uint32_t rate_negotiate(const tlv320adc5120_bus_cfg_t *bus) {
+    uint32_t min_hz = s_cfg.raw_min_hz;
+    // stats_ms of only zeros and separators ("0", "") sets up no window
+    const bool stats_on = s_cfg.stats_ms[strspn(s_cfg.stats_ms, "0, ")] != '\0';
+    const bool raw_users = stats_on || s_cfg.trig[0] != '\0' || s_cfg.charge;
+    if (min_hz == 0 && raw_users) min_hz = s_cfg.sample_rate_hz;
+    if (s_cfg.fft_n) {
+        const char *p = s_cfg.fft_bands;
+        while (*p) {
+            char *end;
+            unsigned long hz = strtoul(p, &end, 10);
+            if (end == p) { p++; continue; }
+            p = end;
+            if (2 * hz > min_hz) min_hz = (uint32_t)(2 * hz);
+        }
+    }
+    const uint32_t *rates;
+    const size_t n = tlv320adc5120_rates(&rates);
+    tlv320adc5120_bus_cfg_t c = *bus;
+    uint8_t slot0[TLV_MAX_DEVS];
+    uint32_t slots;
+    for (size_t i = 0; i < n; ++i) {
+        c.sample_rate_hz = rates[i];
+        // the TDM frame must also fit the BCLK limit at this rate
+        if (rate_fits(rates[i], min_hz) && tlv320adc5120_slot_alloc(&c, slot0, &slots) == ESP_OK) {
+            LOG_INFO(TAG, "native rate %lu Hz (needs: >= %lu Hz, divisible by ds rates \"%s\", %lu slots; configured %lu Hz)",
+                rates[i], min_hz, s_cfg.ds_rates, slots, s_cfg.sample_rate_hz);
+            return rates[i];
+        }
+    }
+    LOG_WARN(TAG, ESP_ERR_NOT_SUPPORTED, "no native rate fits ds rates \"%s\" at >= %lu Hz with %lu ch; using %lu Hz",
+        s_cfg.ds_rates, min_hz, bus->ch_count, s_cfg.sample_rate_hz);
+    return s_cfg.sample_rate_hz;
+}
+
+/* END RATE NEGOTIATION **********************************************/
+
+/* MULTI-ADC PANELS **************************************************/
+/* cfg "adcs" lists the ADCs sharing the I2C bus and TDM line, in slot order:
+       "4C:4,4D:4,4E:4,4F:4"   hex I2C address, channels used (CH1..CHn, default 4)
+   Each device's channels go out in consecutive slots (tlv320adc5120_slot_alloc).
+   Empty: the single ADC at TLV_I2C_ADDR_DEFAULT, stereo or 4-slot TDM per ch_count. */
+
+static esp_err_t adcs_parse(tlv320adc5120_bus_cfg_t *cfg) {
+    if (s_cfg.adcs[0] == '\0') {
+        cfg->dev_count   = 1;
+        cfg->i2c_addr[0] = TLV_I2C_ADDR_DEFAULT;
+        cfg->dev_ch[0]   = (uint8_t)(s_cfg.ch_count == 2 ? 2 : TLV_DEV_CH);
+        cfg->ch_count    = s_cfg.ch_count;
+        return ESP_OK;
+    }
+    const char *p = s_cfg.adcs;
+    uint32_t n = 0, ch = 0;
+    while (*p) {
+        char *end;
+        const unsigned long addr = strtoul(p, &end, 16);
+        if (end == p || addr < 0x08 || addr > 0x77 || n == TLV_MAX_DEVS) return ESP_ERR_INVALID_ARG;
+        p = end;
+        unsigned long k = TLV_DEV_CH;
+        if (*p == ':') {
+            k = strtoul(p + 1, &end, 10);
+            if (end == p + 1) return ESP_ERR_INVALID_ARG;
+            p = end;
+        }
+        if (k == 0 || k > TLV_DEV_CH) return ESP_ERR_INVALID_ARG;
+        cfg->i2c_addr[n] = (uint8_t)addr;
+        cfg->dev_ch[n++] = (uint8_t)k;
+        ch += k;
+        while (*p == ',' || *p == ' ') p++;
+    }
+    if (n == 0) return ESP_ERR_INVALID_ARG;
+    cfg->dev_count = n;
+    cfg->ch_count  = ch;
+    return ESP_OK;
+}
+
+/* END MULTI-ADC PANELS **********************************************/
 
 void startup_task(void *arg) {
     // Safe to log here; this task has a bigger stack than main
     BaseType_t rc;
-    // Start the sampler task on core 1, moderate priority (3)
-    // This task will ONLY pop from the ring and enqueue to s_publish_q.
-    rc = xTaskCreatePinnedToCore(sampler_task, "tlv_samp", 4096, NULL, 3, NULL, 1);
-    LOG_INFO(TAG, "sampler_task create rc=%ld", (long)rc);
-
-    // Start the publisher task on core 1, lower priority (2)
-    // This task will do the heavier JSON/Base64/MQTT work.
-    rc = xTaskCreatePinnedToCore(publisher_task, "tlv_pub", 8192, NULL, 2, NULL, 0);
+    // Start the publisher task on core 0, moderate priority (3).
+    // It is the ring consumer: the DMA ISR wakes it once per block.
+    // It feeds the processing lanes (cfg "pipe"), which do the decimation/MQTT work.
+    rc = xTaskCreatePinnedToCore(publisher_task, "tlv_pub", 8192, NULL, 3, NULL, 0);
     LOG_INFO(TAG, "publisher_task create rc=%ld", (long)rc);
 
-    // vTaskDelay(pdMS_TO_TICKS(1));
-
     vTaskDelete(NULL);
 }
 
@@ -395,33 +2547,36 @@ esp_err_t app_tlv_start(void) {
         .i2c_port = I2C_NUM_0,
         .gpio_sda = 8, .gpio_scl = 9,
         .i2c_freq_hz = 400000,
-        .i2c_addr = TLV_I2C_ADDR,
         .i2s_port = I2S_NUM_0,
         .gpio_bclk = 36, 
         .gpio_ws = 38, 
         .gpio_din = 35,
 
-        .sample_rate_hz = 8000,
+        .sample_rate_hz = s_cfg.sample_rate_hz,
+        .block_ms = s_cfg.block_ms,
         .word_bits = 24,
         .slot_bits = 32,
+        .pack24 = s_cfg.pack24,
+
+        .overrun = RING_DROP_NEWEST,
+        .synth_x = s_cfg.synth_x,
     };
+    if (adcs_parse(&cfg) != ESP_OK) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "bad adcs \"%s\"; using the single default ADC", s_cfg.adcs);
+        s_cfg.adcs[0] = '\0';
+        adcs_parse(&cfg);
+    }
+    if (s_cfg.rate_auto) cfg.sample_rate_hz = rate_negotiate(&cfg);
 
     ESP_ERROR_CHECK(tlv320adc5120_init(&cfg));
-    ESP_ERROR_CHECK(tlv320adc5120_start());
-
-
-    // Create a queue that holds 512-byte samples (set depth to e.g. 16)
-    if (!s_publish_q) {
-        s_publish_q = xQueueCreate(/*depth*/256, /*item size*/BLOCK_BYTES);
+    if (s_cfg.adc_flt[0] != '\0' && app_tlv_set_filters(s_cfg.adc_flt) != ESP_OK) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_ARG, "on-chip filters \"%s\" not applied; running all-pass", s_cfg.adc_flt);
     }
-    // configASSERT(s_publish_q != NULL);
+    ESP_ERROR_CHECK(tlv320adc5120_start());
     
     // Signal tasks to run BEFORE creating them
     s_running = true;
 
-    // xTaskCreatePinnedToCore(sampler_task, "tlv_samp", 4096, NULL, 3, NULL, /*core*/ 1));
-    // xTaskCreatePinnedToCore(publisher_task, "tlv_pub", 4096, NULL, 2, NULL, /*core*/ 1));
-
     xTaskCreatePinnedToCore(startup_task, "startup", 6144, NULL, 5, NULL, 1);
     
     return ESP_OK;
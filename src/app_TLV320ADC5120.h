@@ -12,6 +12,8 @@ extern "C" {
 #endif
 
 esp_err_t app_tlv_start(void);
+// On-chip filter chain, applied to every channel: "hpf1:1,hpf:10,lpf:2000:0.707,notch:60:30" ("" = all-pass)
+esp_err_t app_tlv_set_filters(const char *spec);
 #ifdef __cplusplus
 }
 #endif
@@ -7,6 +7,7 @@
 #include "util_wifi.h"
 #include "util_http.h"
 #include "util_mqtt.h"
+#include "util_time.h"
 
 #include "esp_log.h"
 #include "esp_task_wdt.h"
@@ -186,6 +187,8 @@ void confirm_ADC_start() {
 /* END DEBUG / TEST ***************************************************************/
 
 
+// Unit-test builds link the test runner's app_main instead
+#ifndef PIO_UNIT_TESTING
 void app_main(void) {
 
     /*** WATCHDOG STUFF *************************************************/
@@ -216,6 +219,11 @@ void app_main(void) {
     // Initialize TCP/IP stack & default event loop for Wi-Fi & IP events
     // ESP_ERROR_CHECK(net_events_init_once());
     confirm_net_events_init();
+
+    // SNTP once Wi-Fi has an IP; disciplines the time base the sample clock is measured against
+    if (time_sync_init(s_cfg.ntp) != ESP_OK) {
+        LOG_ERR(TAG, ESP_FAIL, "time sync init failed");
+    }
     
     // Initialize Wi-Fi
     // ESP_ERROR_CHECK(wifi_init());
@@ -272,4 +280,5 @@ void app_main(void) {
             }
         }
     }
-}
\ No newline at end of file
+}
+#endif // PIO_UNIT_TESTING
@@ -1,8 +1,12 @@
+#include "app_TLV320ADC5120.h"
 #include "util_mqtt.h"
 #include "util_err.h"
+#include "util_flash.h"
 #include "models.h"
 #include "cJSON.h"
 
+#include <string.h>
+
 static const char *TAG = "APP_MQTT";
 
 static void on_cmd_toggle(const char *topic, const uint8_t *data, int len, void *ctx) {
@@ -21,6 +25,43 @@ static void on_cmd_set(const char *topic, const uint8_t *data, int len, void *ct
     cJSON_Delete(root);
 }
 
+// Payload: the pipe spec, e.g. "0:charge,trig;1:ds,stats,fft". Stored now, applied at the next boot.
+static void on_cmd_pipe(const char *topic, const uint8_t *data, int len, void *ctx) {
+    if (len <= 0 || len >= (int)sizeof(s_cfg.pipe)) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_SIZE, "CMD PIPE: spec length %d out of range", len);
+        return;
+    }
+    memcpy(s_cfg.pipe, data, len);
+    s_cfg.pipe[len] = '\0';
+    esp_err_t err = flash_set_str(s_cfg_nvs, "pipe", s_cfg.pipe);
+    if (!err) err = flash_commit(s_cfg_nvs);
+    if (err) {
+        LOG_ERR(TAG, err, "CMD PIPE: failed to store \"%s\"", s_cfg.pipe);
+        return;
+    }
+    LOG_INFO(TAG, "CMD PIPE: \"%s\" stored; applied at next boot", s_cfg.pipe);
+}
+
+// Payload: the on-chip filter chain (see app_tlv_set_filters); applied now, stored if it took
+static void on_cmd_adc_flt(const char *topic, const uint8_t *data, int len, void *ctx) {
+    char spec[sizeof(s_cfg.adc_flt)];
+    if (len < 0 || len >= (int)sizeof(spec)) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_SIZE, "CMD ADC_FLT: spec length %d out of range", len);
+        return;
+    }
+    memcpy(spec, data, len);
+    spec[len] = '\0';
+    if (app_tlv_set_filters(spec) != ESP_OK) {
+        return;
+    }
+    strcpy(s_cfg.adc_flt, spec);
+    esp_err_t err = flash_set_str(s_cfg_nvs, "adc_flt", s_cfg.adc_flt);
+    if (!err) err = flash_commit(s_cfg_nvs);
+    if (err) {
+        LOG_ERR(TAG, err, "CMD ADC_FLT: failed to store \"%s\"", s_cfg.adc_flt);
+    }
+}
+
 esp_err_t app_mqtt_start(char prefix[10]) {
     char mqtt_id[23] = "";
     make_mqtt_client_id(prefix, mqtt_id);
@@ -44,6 +85,8 @@ esp_err_t app_mqtt_start(char prefix[10]) {
 
     util_mqtt_subscribe("jaqc/cmd/toggle", /*qos*/1, on_cmd_toggle, NULL);
     util_mqtt_subscribe("jaqc/cmd/set",    /*qos*/1, on_cmd_set,    NULL);
+    util_mqtt_subscribe("jaqc/cmd/pipe",   /*qos*/1, on_cmd_pipe,   NULL);
+    util_mqtt_subscribe("jaqc/cmd/adc_flt",/*qos*/1, on_cmd_adc_flt,NULL);
 
     // Publish an “online” retained status on connect (or rely on LWT retained offline)
     cJSON *hello = cJSON_CreateObject();
@@ -1,12 +1,22 @@
 #include "driver_TLV320ADC5120.h"
+#include "dsp_biquad.h"
+#include "dsp_pack24.h"
+#include "dsp_synth.h"
 #include "util_err.h"
 
 #include "esp_mac.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 
+#include "driver/gpio.h"
 #include "driver/i2c_master.h"
 #include "driver/i2s_std.h"
+#include "driver/i2s_tdm.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
 #include <string.h>
 
 
@@ -15,28 +25,170 @@ static const char *TAG = "TLV320DRV";
 static tlv320adc5120_bus_cfg_t s_cfg;
 static i2s_chan_handle_t s_rx_chan = NULL;
 
-typedef struct {
-    uint8_t  dma_buf[TLV_DMA_BUF_COUNT][TLV_DMA_BUF_SZ];
-    uint16_t rd_idx;
-    uint16_t wr_idx;
-} tlv_ring_t;
-
 static tlv320adc5120_dma_ring_t s_ring;
+static tlv320adc5120_geometry_t s_geo;
+
+// Rates the TLV320ADC5120 ASI auto-detects in slave mode (48 kHz and 44.1 kHz families)
+static const uint32_t s_rates_hz[] = {
+    8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000,
+};
 
 
 // ---------------- I2C helpers ----------------
-static esp_err_t i2c_write_reg(uint8_t reg, const uint8_t *data, size_t len) {
-    return  
-    i2c_master_write_to_device(
-        s_cfg.i2c_port, s_cfg.i2c_addr, (uint8_t[]){reg}, 1, 10 / portTICK_PERIOD_MS) 
-    ||     
-    i2c_master_write_to_device(
-        s_cfg.i2c_port, s_cfg.i2c_addr, data, len, 10 / portTICK_PERIOD_MS);
+// Every register access goes through the page-aware helpers below. They keep a
+// shadow copy of each register written or read, so page selects and writes of
+// unchanged values are skipped, and consecutive registers go out as a single
+// auto-increment burst (the TLV increments the register address per data byte).
+
+#define TLV_I2C_TIMEOUT_MS      20      // per transaction; a 64-byte burst at 400 kHz takes ~1.5 ms
+#define TLV_I2C_BURST_MAX       64      // data bytes per auto-increment write
+#define TLV_SHADOW_PAGES        5       // pages 0..4 are cached; higher pages are always written
+#define TLV_PAGE_UNKNOWN        0xFF
+
+// Driver-private table flags (public ones are TLV_REG_* in the header)
+#define TLV_REG_I2S_ONLY        0x40    // stereo mode only
+#define TLV_REG_TDM_ONLY        0x80    // 4-channel TDM mode only
+
+typedef struct {
+    uint8_t  page;                            // selected page, TLV_PAGE_UNKNOWN after reset
+    uint8_t  val[TLV_SHADOW_PAGES][128];
+    uint32_t valid[TLV_SHADOW_PAGES][4];      // one bit per register
+} tlv_shadow_t;
+
+// One ADC on the bus. Register tables, the shadow and power state are per device.
+typedef struct {
+    uint8_t      addr;
+    uint8_t      slot0;                       // TDM slot of CH1; CHn goes out in slot0 + n - 1
+    uint8_t      ch;                          // channels in use, CH1..CHn
+    uint8_t      pwr_run;                     // PWR_CFG while streaming (restored after VAD idle)
+    tlv_shadow_t shadow;
+} tlv_dev_t;
+
+static tlv_dev_t s_devs[TLV_MAX_DEVS];
+static uint32_t s_dev_count;
+static bool s_tdm;                            // TDM on the data line (else I2S stereo, one device)
+static uint32_t s_i2c_xfers;                  // transactions issued (bring-up stats)
+
+/* Register sequences come from several tasks (MQTT commands, the publisher's
+   VAD idle / resume), and each one depends on the page select and the shadow
+   left by the last; the public entry points that touch the bus hold this. */
+static SemaphoreHandle_t s_lock = NULL;
+static StaticSemaphore_t s_lock_buf;
+
+static inline void drv_lock(void) {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
 }
 
-static esp_err_t i2c_read_reg(uint8_t reg, uint8_t *data, size_t len) {
+static inline void drv_unlock(void) {
+    xSemaphoreGive(s_lock);
+}
+
+static void shadow_invalidate(tlv_dev_t *d) {
+    memset(&d->shadow, 0, sizeof(d->shadow));
+    d->shadow.page = TLV_PAGE_UNKNOWN;
+}
+
+static bool shadow_get(const tlv_dev_t *d, uint8_t page, uint8_t reg, uint8_t *v) {
+    if (page >= TLV_SHADOW_PAGES || reg >= 128) return false;
+    if (!(d->shadow.valid[page][reg >> 5] & (1u << (reg & 31)))) return false;
+    *v = d->shadow.val[page][reg];
+    return true;
+}
+
+static void shadow_put(tlv_dev_t *d, uint8_t page, uint8_t reg, const uint8_t *data, size_t len) {
+    if (page >= TLV_SHADOW_PAGES) return;
+    for (size_t i = 0; i < len && reg + i < 128; ++i) {
+        uint8_t r = (uint8_t)(reg + i);
+        d->shadow.val[page][r] = data[i];
+        d->shadow.valid[page][r >> 5] |= (1u << (r & 31));
+    }
+}
+
+// One transaction: register address followed by len data bytes
+static esp_err_t i2c_write_reg(const tlv_dev_t *d, uint8_t reg, const uint8_t *data, size_t len) {
+    uint8_t buf[1 + TLV_I2C_BURST_MAX];
+    if (len > TLV_I2C_BURST_MAX) return ESP_ERR_INVALID_SIZE;
+    buf[0] = reg;
+    memcpy(&buf[1], data, len);
+    s_i2c_xfers++;
+    return i2c_master_write_to_device(
+        s_cfg.i2c_port, d->addr, buf, 1 + len, pdMS_TO_TICKS(TLV_I2C_TIMEOUT_MS));
+}
+
+static esp_err_t i2c_read_reg(const tlv_dev_t *d, uint8_t reg, uint8_t *data, size_t len) {
+    s_i2c_xfers++;
     return i2c_master_write_read_device(
-        s_cfg.i2c_port, s_cfg.i2c_addr, &reg, 1, data, len, 10 / portTICK_PERIOD_MS);
+        s_cfg.i2c_port, d->addr, &reg, 1, data, len, pdMS_TO_TICKS(TLV_I2C_TIMEOUT_MS));
+}
+
+// 0x00 - PAGE_CFG exists on every page
+static esp_err_t tlv_select_page(tlv_dev_t *d, uint8_t page) {
+    if (d->shadow.page == page) return ESP_OK;
+    esp_err_t err = i2c_write_reg(d, 0x00, &page, 1);
+    d->shadow.page = (err == ESP_OK) ? page : TLV_PAGE_UNKNOWN;
+    return err;
+}
+
+static esp_err_t tlv_write(tlv_dev_t *d, uint8_t page, uint8_t reg, const uint8_t *data, size_t len, bool cache) {
+    ESP_RETURN_ON_ERROR(tlv_select_page(d, page), TAG, "0x%02X page %u select", d->addr, page);
+    while (len) {
+        size_t n = len < TLV_I2C_BURST_MAX ? len : TLV_I2C_BURST_MAX;
+        ESP_RETURN_ON_ERROR(i2c_write_reg(d, reg, data, n), TAG, "0x%02X write P%u R0x%02X", d->addr, page, reg);
+        if (cache) shadow_put(d, page, reg, data, n);
+        reg += n; data += n; len -= n;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t tlv_read(tlv_dev_t *d, uint8_t page, uint8_t reg, uint8_t *data, size_t len) {
+    ESP_RETURN_ON_ERROR(tlv_select_page(d, page), TAG, "0x%02X page %u select", d->addr, page);
+    ESP_RETURN_ON_ERROR(i2c_read_reg(d, reg, data, len), TAG, "0x%02X read P%u R0x%02X", d->addr, page, reg);
+    shadow_put(d, page, reg, data, len);
+    return ESP_OK;
+}
+
+/* Write a register table. Entries are taken in order; each run of consecutive
+   registers on one page becomes one burst. Unless force is set, registers whose
+   cached value already matches are skipped (and split the run). Entries flagged
+   for the other channel mode are ignored. */
+static esp_err_t tlv_apply(tlv_dev_t *d, const tlv320adc5120_reg_t *regs, size_t n, bool force) {
+    const uint8_t skip_mode = s_tdm ? TLV_REG_I2S_ONLY : TLV_REG_TDM_ONLY;
+    uint8_t run[TLV_I2C_BURST_MAX];
+    size_t  run_len = 0;
+    uint8_t run_page = 0, run_reg = 0;
+    bool    run_cache = true;
+
+    for (size_t i = 0; i <= n; ++i) {
+        const tlv320adc5120_reg_t *r = (i < n) ? &regs[i] : NULL;
+
+        if (r) {
+            if (r->flags & skip_mode) continue;
+            const bool volatile_reg = (r->flags & TLV_REG_VOLATILE);
+            uint8_t cur;
+            if (!force && !volatile_reg && shadow_get(d, r->page, r->reg, &cur) && cur == r->val) {
+                continue;
+            }
+            // Extend the current run if this register follows on directly
+            if (run_len && run_cache && !volatile_reg
+            &&  r->page == run_page && r->reg == run_reg + run_len && run_len < TLV_I2C_BURST_MAX
+            ) {
+                run[run_len++] = r->val;
+                continue;
+            }
+        }
+
+        if (run_len) {
+            ESP_RETURN_ON_ERROR(tlv_write(d, run_page, run_reg, run, run_len, run_cache), TAG, "apply");
+            run_len = 0;
+        }
+        if (r) {
+            run_page  = r->page;
+            run_reg   = r->reg;
+            run_cache = !(r->flags & TLV_REG_VOLATILE);
+            run[run_len++] = r->val;
+        }
+    }
+    return ESP_OK;
 }
 
 void i2c_scan(void) {
@@ -69,103 +221,85 @@ void i2c_scan(void) {
 }
 
 
-static void tlv_dump_status(void) {
+static void tlv_dump_status(tlv_dev_t *d) {
     uint8_t v;
-    // Page 0
-    TLV_WR(0x00, 0x00);
-    if (i2c_read_reg(0x15, &v, 1) == ESP_OK) {
-        LOG_INFO(TAG, "TLV 0x15 ASI_STS = 0x%02X", v);
+    // Page 0; status registers are live, so always read from the device
+    if (tlv_read(d, 0, 0x15, &v, 1) == ESP_OK) {
+        LOG_INFO(TAG, "TLV 0x%02X 0x15 ASI_STS = 0x%02X", d->addr, v);
     }
-    if (i2c_read_reg(0x76, &v, 1) == ESP_OK) {
-        LOG_INFO(TAG, "TLV 0x76 DEV_STS0 = 0x%02X", v);
+    if (tlv_read(d, 0, 0x76, &v, 1) == ESP_OK) {
+        LOG_INFO(TAG, "TLV 0x%02X 0x76 DEV_STS0 = 0x%02X", d->addr, v);
     }
 }
 
-static void tlv_dump_regs(void) {
-    uint8_t v;
-
-    LOG_INFO(TAG, "TLV Page 0:");
-    TLV_WR(0x00, 0x00);
-    i2c_read_reg(0x02, &v, 1); LOG_INFO(TAG, "TLV 0x02 SLEEP_CFG = 0x%02X", v);
-    i2c_read_reg(0x05, &v, 1); LOG_INFO(TAG, "TLV 0x05 SHDN_CFG = 0x%02X", v);
-    i2c_read_reg(0x07, &v, 1); LOG_INFO(TAG, "TLV 0x07 ASI_CFG0 = 0x%02X", v);
-    
-    i2c_read_reg(0x0C, &v, 1); LOG_INFO(TAG, "TLV 0x0C ASI_CH2 = 0x%02X", v);
-    i2c_read_reg(0x0D, &v, 1); LOG_INFO(TAG, "TLV 0x0D ASI_CH3 = 0x%02X", v);
-    i2c_read_reg(0x0E, &v, 1); LOG_INFO(TAG, "TLV 0x0E ASI_CH4 = 0x%02X", v);
-
-    i2c_read_reg(0x13, &v, 1); LOG_INFO(TAG, "TLV 0x13 MST_CFG0 = 0x%02X", v);
-    i2c_read_reg(0x1F, &v, 1); LOG_INFO(TAG, "TLV 0x1F PDMCLK_CFG = 0x%02X", v);
-
-    i2c_read_reg(0x3C, &v, 1); LOG_INFO(TAG, "TLV 0x3C CH1_CFG0 = 0x%02X", v);
-    i2c_read_reg(0x3E, &v, 1); LOG_INFO(TAG, "TLV 0x3E CH1_CFG2 = 0x%02X", v);
-    i2c_read_reg(0x41, &v, 1); LOG_INFO(TAG, "TLV 0x41 CH2_CFG0 = 0x%02X", v);
-    i2c_read_reg(0x43, &v, 1); LOG_INFO(TAG, "TLV 0x43 CH2_CFG2 = 0x%02X", v);
-
-    i2c_read_reg(0x6B, &v, 1); LOG_INFO(TAG, "TLV 0x6B DSP_CFG0 = 0x%02X", v);
-    i2c_read_reg(0x73, &v, 1); LOG_INFO(TAG, "TLV 0x73 IN_CH_EN = 0x%02X", v);
-    i2c_read_reg(0x74, &v, 1); LOG_INFO(TAG, "TLV 0x74 ASI_OUT_CH_EN = 0x%02X", v);
-    
-    LOG_INFO(TAG, "TLV Page 1:");
-    TLV_WR(0x00, 0x01);
-    i2c_read_reg(0x1E, &v, 1); LOG_INFO(TAG, "TLV 0x1E VAD_CFG1 = 0x%02X", v);
-    i2c_read_reg(0x1F, &v, 1); LOG_INFO(TAG, "TLV 0x1F VAD_CFG2 = 0x%02X", v);
-    
-    LOG_INFO(TAG, "TLV Page 4:");
-    TLV_WR(0x00, 0x04);
-    i2c_read_reg(0x48, &v, 1); LOG_INFO(TAG, "TLV 0x48 N0 coefficient byte[31:24] = 0x%02X", v);
-    i2c_read_reg(0x49, &v, 1); LOG_INFO(TAG, "TLV 0x49 N0 coefficient byte[23:16] = 0x%02X", v);
-    i2c_read_reg(0x4A, &v, 1); LOG_INFO(TAG, "TLV 0x4A N0 coefficient byte[15:8] = 0x%02X", v);
-    i2c_read_reg(0x4B, &v, 1); LOG_INFO(TAG, "TLV 0x4B N0 coefficient byte[7:0] = 0x%02X", v);
-    
-    i2c_read_reg(0x4C, &v, 1); LOG_INFO(TAG, "TLV 0x4C N1 coefficient byte[31:24] = 0x%02X", v);
-    i2c_read_reg(0x4D, &v, 1); LOG_INFO(TAG, "TLV 0x4D N1 coefficient byte[23:16] = 0x%02X", v);
-    i2c_read_reg(0x4E, &v, 1); LOG_INFO(TAG, "TLV 0x4E N1 coefficient byte[15:8] = 0x%02X", v);
-    i2c_read_reg(0x4F, &v, 1); LOG_INFO(TAG, "TLV 0x4F N1 coefficient byte[7:0] = 0x%02X", v);
-    
-    i2c_read_reg(0x50, &v, 1); LOG_INFO(TAG, "TLV 0x50 D1 coefficient byte[31:24] = 0x%02X", v);
-    i2c_read_reg(0x51, &v, 1); LOG_INFO(TAG, "TLV 0x51 D1 coefficient byte[23:16] = 0x%02X", v);
-    i2c_read_reg(0x52, &v, 1); LOG_INFO(TAG, "TLV 0x52 D1 coefficient byte[15:8] = 0x%02X", v);
-    i2c_read_reg(0x53, &v, 1); LOG_INFO(TAG, "TLV 0x53 D1 coefficient byte[7:0] = 0x%02X", v);
+/* Read back every register in a table and report mismatches. One burst read per
+   page covers the table's span on that page, instead of one round trip per register. */
+static esp_err_t tlv_verify_regs(tlv_dev_t *d, const tlv320adc5120_reg_t *regs, size_t n) {
+    const uint8_t skip_mode = s_tdm ? TLV_REG_I2S_ONLY : TLV_REG_TDM_ONLY;
+    uint8_t  span[128];
+    uint32_t checked = 0, bad = 0;
+
+    for (size_t i = 0; i < n; ) {
+        // [lo, hi] span of this page's entries (tables are grouped by page)
+        const uint8_t page = regs[i].page;
+        uint8_t lo = 0x7F, hi = 0;
+        size_t j = i;
+        for (; j < n && regs[j].page == page; ++j) {
+            if (regs[j].reg < lo) lo = regs[j].reg;
+            if (regs[j].reg > hi) hi = regs[j].reg;
+        }
+        ESP_RETURN_ON_ERROR(tlv_read(d, page, lo, span, hi - lo + 1), TAG, "verify read");
+
+        for (; i < j; ++i) {
+            if (regs[i].flags & (skip_mode | TLV_REG_VOLATILE)) continue;
+            uint8_t got = span[regs[i].reg - lo];
+            checked++;
+            if (got != regs[i].val) {
+                bad++;
+                LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "TLV 0x%02X P%u 0x%02X = 0x%02X (wrote 0x%02X)",
+                    d->addr, page, regs[i].reg, got, regs[i].val);
+            }
+        }
+    }
+    LOG_INFO(TAG, "TLV 0x%02X register check: %lu verified, %lu mismatched", d->addr, checked, bad);
+    return bad ? ESP_ERR_INVALID_STATE : ESP_OK;
 }
 
-static esp_err_t tlv_reset_device_pg0() {
+static esp_err_t tlv_reset_device_pg0(tlv_dev_t *d) {
     esp_err_t err = ESP_OK;
 
-    /* 0x00 - PAGE_CFG Register SELECT PAGE 0
-    7-0 00000000    Set device page to zero 0  
-    */ 
-   err |= TLV_WR(0x00, 0x00); // 0000 0000 - 0x00
-    
     /* 0x01 - SW_RESET Register (Reset everything before we start writing our stuff)
     7-1 0000000     RESERVED; Write only reset value (0000000b)
     0   1           Reset all registers to their reset values              
     */ 
-   err |= TLV_WR(0x01, 0x01); // 0000 0001 - 0x01
+    shadow_invalidate(d);
+    const uint8_t sw_reset = 0x01;
+    err = tlv_write(d, 0, 0x01, &sw_reset, 1, false); // self-clearing; never cached
+
+    // Reset returns PAGE_CFG to 0, and the device needs 1 ms before the next access
+    shadow_invalidate(d);
+    d->shadow.page = 0;
+    esp_rom_delay_us(1000);
 
     if (err == ESP_OK) {
-        LOG_INFO(TAG, "TLV320ADC5120 device reset script applied (addr 0x4E).");
+        LOG_INFO(TAG, "TLV320ADC5120 device reset script applied (addr 0x%02X).", d->addr);
         LOG_INFO(TAG, "All values set to default.");
-        // tlv_dump_regs();
     } else {
-        LOG_ERR(TAG, ESP_FAIL, "TLV320ADC5120 device reset script failed");
+        LOG_ERR(TAG, ESP_FAIL, "TLV320ADC5120 device reset script failed (addr 0x%02X)", d->addr);
     }
     return err;
 }
 
 // ---------------- TLV320ADC5120 register init (I2C) ----------------
-static esp_err_t tlv_cfg_device(void) {
-    esp_err_t err = ESP_OK;
+/* Device configuration, grouped by page and in ascending register order within
+   each page so tlv_apply() can merge neighbours into bursts. PWR_CFG (0x75) is
+   the last page-0 register, so the channels power up only once configured.
+   Start by resetting all page 0 registers to default (tlv_reset_device_pg0),
+   then write only those we want to change. */
+static const tlv320adc5120_reg_t s_tlv_cfg[] = {
 
-    // Start by resetting all page 0 registers to default. 
-    // Use tlv_reset_device_pg0();
-    // Then write only to those we want to change.
+    /* PAGE 0 ***********************************************************************************/
 
-    /* 0x00 - PAGE_CFG Register SELECT PAGE 0 ***************************************************
-    7-0 00000000    Set device page to zero 0   
-    */ 
-    err |= TLV_WR(0x00, 0x00); // 0000 0000 - 0x00
-    
     /* 0x02 - SLEEP_CFG Register
     7   1           Internally generated 1.8-V AREG supply using an on-chip regulator (use this setting when AVDD is 3.3 V)
     6-5 00          RESERVED; Write only reset value (00b) 
@@ -174,7 +308,7 @@ static esp_err_t tlv_cfg_device(void) {
     1   0           RESERVED; Write only reset value (0b)
     0   1           Device is not in sleep mode
     */ 
-   err |= TLV_WR(0x02, 0x81); // 1000 0001 - 0x81 
+    { 0, 0x02, 0x81, 0 }, // 1000 0001 - 0x81 
 
     /* 0x05 - SHDN_CFG Register
     7-6 00          RESERVED; Write only reset value (00b)
@@ -182,7 +316,7 @@ static esp_err_t tlv_cfg_device(void) {
     3-2 00          RESERVED; Write only reset value (01b) But PPC3 told me to write 00b so... 
     1-0 01          RESERVED; Write only reset value 01b)
     */ 
-   err |= TLV_WR(0x05, 0x01); // 0000 0001 - 0x01
+    { 0, 0x05, 0x01, 0 }, // 0000 0001 - 0x01
 
     /* 0x07 - ASI_CFG0 Register
     7-6 01          I2S model
@@ -192,33 +326,53 @@ static esp_err_t tlv_cfg_device(void) {
     1   0           Default transmit edge ()
     0   0           Transmit 0 for unused cycles
     */ 
-//    err |= TLV_WR(0x07, 0x70); // 0111 0000 - 0x70 - I2S - 32 bit slot
-   err |= TLV_WR(0x07, 0x60); // 0110 0000 - 0x60 - TDM - 24 bit slot
+//  { 0, 0x07, 0x70, 0 }, // 0111 0000 - 0x70 - I2S - 32 bit slot
+    { 0, 0x07, 0x60, TLV_REG_I2S_ONLY }, // 0110 0000 - 0x60 - I2S - 24 bit word
+    /* 0x07 - ASI_CFG0 Register (4-channel TDM)
+    7-6 00          TDM mode
+    5-4 11          Word length 32 bits; in TDM the slot width equals the word length,
+                    so this matches the ESP's 32-bit TDM slots (the ESP keeps the top 24 bits)
+    3-1 000         As above
+    0   0           Transmit 0 for unused cycles; 1 (Hi-Z) when several devices share SDOUT (tlv_dev_table)
+    */ 
+    { 0, 0x07, 0x30, TLV_REG_TDM_ONLY }, // 0011 0000 - 0x30 - TDM - 32 bit slot
+
+    /* 0x08 - ASI_CFG1 Register (TDM)
+    7   0           LSB driven for a full cycle; 1 (half cycle, then Hi-Z) on a shared SDOUT,
+                    so the next device's MSB never overlaps it (tlv_dev_table)
+    6-5 00          Bus keeper disabled
+    4-0 00000       TX_OFFSET 0: slot 0 starts on the FSYNC edge
+    */
+    { 0, 0x08, 0x00, TLV_REG_TDM_ONLY }, // 0000 0000 - 0x00
     
     /* 0x0B - ASI_CH1 Register
     7-6 00          RESERVED; Write only reset value (00b)
     5-0 000000      Ch1 is registered to I2S left slot 0
+                    (TDM: 0x0B..0x0E get the device's slot0 + n - 1, see tlv_dev_table)
     */ 
-   err |= TLV_WR(0x0B, 0x00); // 0000 0000 - 0x00
+    { 0, 0x0B, 0x00, 0 }, // 0000 0000 - 0x00
 
     /* 0x0C - ASI_CH2 Register
     7-6 00          RESERVED; Write only reset value (00b)
     5-0 000001      Ch2 is registered to I2S left slot 1
     */ 
-//    err |= TLV_WR(0x0C, 0x01); // 0000 0001 - 0x01
-   err |= TLV_WR(0x0C, 0x20); // 0010 0000 - 0x20 (right slot 0)
+//  { 0, 0x0C, 0x01, 0 }, // 0000 0001 - 0x01
+    { 0, 0x0C, 0x20, TLV_REG_I2S_ONLY }, // 0010 0000 - 0x20 (right slot 0)
+    { 0, 0x0C, 0x01, TLV_REG_TDM_ONLY }, // 0000 0001 - 0x01 (TDM slot 1)
 
     /* 0x0D - ASI_CH3 Register
     7-6 00          RESERVED; Write only reset value (00b)
     5-0 000000      Ch3 is NOT USED but PPC3 wants it registered to I2S left slot 0
     */ 
-   err |= TLV_WR(0x0D, 0x00); // 0000 0000 - 0x00
+    { 0, 0x0D, 0x00, TLV_REG_I2S_ONLY }, // 0000 0000 - 0x00
+    { 0, 0x0D, 0x02, TLV_REG_TDM_ONLY }, // 0000 0010 - 0x02 (TDM slot 2)
     
     /* 0x0E - ASI_CH4 Register
     7-6 00          RESERVED; Write only reset value (00b)
     5-0 000000      Ch4 is NOT USED but PPC3 wants it registered to I2S left slot 0
     */ 
-   err |= TLV_WR(0x0E, 0x00); // 0000 0000- 0x00
+    { 0, 0x0E, 0x00, TLV_REG_I2S_ONLY }, // 0000 0000- 0x00
+    { 0, 0x0E, 0x03, TLV_REG_TDM_ONLY }, // 0000 0011 - 0x03 (TDM slot 3)
     
     /* 0x13 - MST_CFG0 Register
     7   0           SLAVE MODE; both BCLK and FSYNC are inputs to ADC
@@ -228,15 +382,15 @@ static esp_err_t tlv_cfg_device(void) {
     3   0           Sample rate is multible of 48 kHz (doesn't mater because ADC is slave)
     2-0 000       12 MHz MCLK ignored because ADC is slave         
     */ 
-   err |= TLV_WR(0x13, 0x00); // 0000 0000 - 0x00 - SLAVE MODE
+    { 0, 0x13, 0x00, 0 }, // 0000 0000 - 0x00 - SLAVE MODE
 
     /* 0x1F - PDMCLK_CFG Register (Pulse Density Modulation Clock)
     7   0           RESERVED; Write only reset value (0b)
     6-2 00100       RESERVED; Write only reset value (10000b) But PPC3 told me to write 00100b so... 
     1-2 00          PDMCLK is 2.8224 MHz or 3.072 MHz
     */
-    // err |= TLV_WR(0x1F, 0x08); // 0001 1000 - 0x08
-    err |= TLV_WR(0x1F, 0x01); // 0001 0000 - 0x10
+//  { 0, 0x1F, 0x08, 0 }, // 0001 1000 - 0x08
+    { 0, 0x1F, 0x01, 0 }, // 0001 0000 - 0x10
     
     /* 0x3C - CH1_CFG0 Register - CHANNEL 1 CONFIG
     7   1           Line input type
@@ -246,7 +400,13 @@ static esp_err_t tlv_cfg_device(void) {
     1   0           RESERVED; Write only reset value (0b)
     0   0           DRE / AGC / DRC disabled
     */
-    err |= TLV_WR(0x3C, 0xB0); // 1011 0000
+    { 0, 0x3C, 0xB0, 0 }, // 1011 0000
+
+    /* *** NOT ORIGINALLY INCLUDED IN PPC3 OUTPUT ***
+    0x3E - CH1_CFG2 Register - CHANNEL 1 CONFIG
+    7-0 11001001    Digital volume control is set to 0 dB
+    */
+    { 0, 0x3E, 0xC9, 0 }, // 11001001 - 0xC9
 
     /* 0x41 - CH2_CFG0 Register - CHANNEL 2 CONFIG
     7   1           Line input type
@@ -256,7 +416,26 @@ static esp_err_t tlv_cfg_device(void) {
     1   0           RESERVED; Write only reset value (0b)
     0   0           DRE / AGC / DRC disabled
     */
-    err |= TLV_WR(0x41, 0xB0); // 1010 0000
+    { 0, 0x41, 0xB0, 0 }, // 1010 0000
+
+    /* *** NOT ORIGINALLY INCLUDED IN PPC3 OUTPUT ***
+    0x43 - CH2_CFG2 Register - CHANNEL 2 CONFIG
+    7-0 11001001    Digital volume control is set to 0 dB
+    */
+    { 0, 0x43, 0xC9, 0 }, // 11001001 - 0xC9
+
+    /* 0x46 / 0x4B - CH3_CFG0 / CH4_CFG0 Registers - CHANNEL 3 & 4 CONFIG (TDM only)
+    Same as CH1/CH2: line input, single-ended, DC-coupled, 2.5-kΩ, DRE/AGC off.
+    NOTE: on the TLV320ADC5120 itself CH3/CH4 are PDM-only; these are the analog
+    settings for the register-compatible 4-channel TLV320ADC5140 fitted to the
+    4-shunt boards.
+    0x48 / 0x4D - CH3_CFG2 / CH4_CFG2 Registers
+    7-0 11001001    Digital volume control is set to 0 dB
+    */
+    { 0, 0x46, 0xB0, TLV_REG_TDM_ONLY }, // 1011 0000
+    { 0, 0x48, 0xC9, TLV_REG_TDM_ONLY }, // 11001001 - 0xC9
+    { 0, 0x4B, 0xB0, TLV_REG_TDM_ONLY }, // 1011 0000
+    { 0, 0x4D, 0xC9, TLV_REG_TDM_ONLY }, // 11001001 - 0xC9
 
     /* 0x6B - DSP_CFG0 - "all-pass" (HPF OFF), linear-phase
     7   0           Digital volume control changes supported while ADC is powered-on
@@ -266,7 +445,7 @@ static esp_err_t tlv_cfg_device(void) {
     1-0 00          Set as the all-pass filter (with default coefficient values in P4_R72 to P4_R83) 
                     See Page 4 writes below
     */
-    err |= TLV_WR(0x6B, 0x00); // 0000 0000 - 0x00 all-pass
+    { 0, 0x6B, 0x00, 0 }, // 0000 0000 - 0x00 all-pass
    
     /* *** NOT ORIGINALLY INCLUDED IN PPC3 OUTPUT ***
     0x73 - IN_CH_EN Register - Enable CH1 and CH2 INPUT/ADC paths into the internal pipeline
@@ -276,7 +455,8 @@ static esp_err_t tlv_cfg_device(void) {
     4   1           Channel 4 input disabled
     3-0 0000        RESERVED; Write only reset value (0000b)
     */
-    err |= TLV_WR(0x73, 0xC0); // 1100 0000 - 0xC0 
+    { 0, 0x73, 0xC0, TLV_REG_I2S_ONLY }, // 1100 0000 - 0xC0
+    { 0, 0x73, 0xF0, TLV_REG_TDM_ONLY }, // 1111 0000 - 0xF0 (TDM: all four inputs)
 
     /* 0x74 - ASI_OUT_CH_EN Register - 
     7   1           Channel 1 output slot is enabled
@@ -285,19 +465,8 @@ static esp_err_t tlv_cfg_device(void) {
     4   1           Channel 4 output slot is a tri-state condition
     3-0 0000        RESERVED; Write only reset value (0000b)
     */
-    err |= TLV_WR(0x74, 0xC0); // 1100 0000 - 0xC0
-
-    /* *** NOT ORIGINALLY INCLUDED IN PPC3 OUTPUT ***
-    0x3E - CH1_CFG2 Register - CHANNEL 1 CONFIG
-    7-0 11001001    Digital volume control is set to 0 dB
-    */
-    err |= TLV_WR(0x3E, 0xC9);  // 11001001 - 0xC9
-
-    /* *** NOT ORIGINALLY INCLUDED IN PPC3 OUTPUT ***
-    0x43 - CH2_CFG2 Register - CHANNEL 2 CONFIG
-    7-0 11001001    Digital volume control is set to 0 dB
-    */
-    err |= TLV_WR(0x43, 0xC9);  // 11001001 - 0xC9
+    { 0, 0x74, 0xC0, TLV_REG_I2S_ONLY }, // 1100 0000 - 0xC0
+    { 0, 0x74, 0xF0, TLV_REG_TDM_ONLY }, // 1111 0000 - 0xF0 (TDM: all four slots)
 
     /* 0x75 - PWR_CFG Register - 
     7   0           Power down MICBIAS
@@ -308,16 +477,10 @@ static esp_err_t tlv_cfg_device(void) {
     1   0           RESERVED; Write only reset value (0b)
     0   0           VAD Voice activity detection disabled
     */
-    // err |= TLV_WR(0x75, 0x70); // 0111 0000 - 0x70 YUP
-    err |= TLV_WR(0x75, 0xE0); // 1110 0000 - 0xE0 "Known Good" according to ChatGPT
-/******** */
-
+//  { 0, 0x75, 0x70, 0 }, // 0111 0000 - 0x70 YUP
+    { 0, 0x75, 0xE0, 0 }, // 1110 0000 - 0xE0 "Known Good" according to ChatGPT
 
-
-    /* 0x00 - PAGE_CFG Register SELECT PAGE 1 ***************************************************
-    7-0 00000001    Set device page to 1  
-    */ 
-    err |= TLV_WR(0x00, 0x01); // 0000 0001 - 0x01
+    /* PAGE 1 ***********************************************************************************/
 
     /* 0x1E - VAD_CFG1 Register
     7-6 00          User initiated ADC power-up and ADC power-down
@@ -325,7 +488,7 @@ static esp_err_t tlv_cfg_device(void) {
     3-2 00          VAD processing using internal oscillator clock (IGNORED: VAD NOT USED)
     1-0 00          External clock is 3.072 MHz (IGNORED: VAD NOT USED)
     */
-    err |= TLV_WR(0x1E, 0x00); // 0000 0000
+    { 1, 0x1E, 0x00, 0 }, // 0000 0000
 
     /* 0x1F - VAD_CFG2 Register
     7   0           RESERVED; Write only reset value (0b)
@@ -335,20 +498,17 @@ static esp_err_t tlv_cfg_device(void) {
     3   0           VAD processing is not enabled during ADC recording
     2-0 000         RESERVED; Write only reset value (000b)
     */
-    err |= TLV_WR(0x1F, 0x00); // 0000 0000
+    { 1, 0x1F, 0x00, 0 }, // 0000 0000
 
-
-    /* 0x00 - PAGE_CFG Register SELECT PAGE 4 ***************************************************
-    7-0 00000001    Set device page to 4  
-    */ 
-    err |= TLV_WR(0x00, 0x04); // 0000 0100 - 0x04
+    /* PAGE 4 ***********************************************************************************/
     
     /* Programmable first-order IIR coefficients ************************************************
     8.6.4 Programmable Coefficient Registers
     8.6.4.3 Programmable Coefficient Registers: Page 4 
     Reset Programmable first-order IIR coefficients to Defaults 
+    tlv320adc5120_set_filters() reprograms these (and the page 2-3 biquads) afterwards
     */
-    err |= TLV_WR(0x01, 0x01); 
+    { 4, 0x01, 0x01, TLV_REG_VOLATILE },
     /* N0 coefficient */
     // IIR_N0_BYT1 Register - N0 coefficient byte[31:24]     - P4_R72 - 0x48 = 0x7F
     // IIR_N0_BYT2 Register - N0 coefficient byte[23:16]     - P4_R73 - 0x49 = 0xFF
@@ -366,28 +526,90 @@ static esp_err_t tlv_cfg_device(void) {
     // IIR_D1_BYT2 Register - D1 coefficient byte[23:16]     - P4_R81 - 0x51 = 0x00
     // IIR_D1_BYT3 Register - D1 coefficient byte[15:8]      - P4_R82 - 0x52 = 0x00
     // IIR_D1_BYT4 Register - D1 coefficient byte[7:0]       - P4_R83 - 0x53 = 0x00
+};
+
+#define TLV_CFG_COUNT (sizeof(s_tlv_cfg) / sizeof(s_tlv_cfg[0]))
+
+static tlv320adc5120_reg_t s_dev_cfg[TLV_MAX_DEVS][TLV_CFG_COUNT];
+
+/* Each device's copy of s_tlv_cfg. In TDM mode: its slots (ASI_CH1..4), the
+   inputs / output slots it uses (IN_CH_EN, ASI_OUT_CH_EN), and when the data
+   line is shared, Hi-Z outside its own slots. Stereo tables are used as is. */
+static void tlv_dev_table(const tlv_dev_t *d, tlv320adc5120_reg_t *out) {
+    const bool shared = s_dev_count > 1;
+    const uint8_t en = (uint8_t)((0xF0u << (TLV_DEV_CH - d->ch)) & 0xF0u);
+    memcpy(out, s_tlv_cfg, sizeof(s_tlv_cfg));
+    for (size_t i = 0; i < TLV_CFG_COUNT && s_tdm; ++i) {
+        tlv320adc5120_reg_t *r = &out[i];
+        if (r->page != 0 || (r->flags & TLV_REG_I2S_ONLY)) continue;
+        switch (r->reg) {
+        case 0x07: if (shared) r->val |= 0x01; break;                        // TX_FILL: Hi-Z
+        case 0x08: if (shared) r->val |= 0x80; break;                        // TX_LSB: half cycle
+        case 0x0B: case 0x0C: case 0x0D: case 0x0E:
+            r->val = (uint8_t)(d->slot0 + (r->reg - 0x0B)); break;           // unused ones are tri-stated
+        case 0x73: case 0x74: r->val = en; break;
+        default: break;
+        }
+    }
+}
+
+// force: write every register (after reset the shadow is empty anyway); otherwise diff-apply
+static esp_err_t tlv_cfg_device(uint32_t i, bool force) {
+    tlv_dev_t *d = &s_devs[i];
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t x0 = s_i2c_xfers;
+
+    esp_err_t err = tlv_apply(d, s_dev_cfg[i], TLV_CFG_COUNT, force);
 
     if (err == ESP_OK) {
-        LOG_INFO(TAG, "TLV320ADC5120 init script applied (addr 0x4E).");
-        LOG_INFO(TAG, "Expect I²S master with 32-bit slots; verify FS≈8kHz, BCLK≈FS*2*32.");
-        tlv_dump_regs();
+        LOG_INFO(TAG, "TLV320ADC5120 init script applied (addr 0x%02X, CH1..CH%u in slots %u..%u): %lu I2C transactions, %lu us",
+            d->addr, d->ch, d->slot0, d->slot0 + d->ch - 1, s_i2c_xfers - x0, (uint32_t)(esp_timer_get_time() - t0));
+        tlv_verify_regs(d, s_dev_cfg[i], TLV_CFG_COUNT);
     } else {
-        LOG_ERR(TAG, ESP_FAIL, "TLV320ADC5120 init script failed");
+        LOG_ERR(TAG, err, "TLV320ADC5120 init script failed (addr 0x%02X)", d->addr);
     }
     return err;
 }
 
+// ---------------- DMA-complete callback ----------------
+// Each I2S DMA buffer is exactly one ring block (see i2s_setup), so every
+// on_recv interrupt stamps one block with esp_timer, copies it into the ring
+// and wakes the consumer.
+static TaskHandle_t s_consumer = NULL;
+
+static IRAM_ATTR bool on_dma_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    BaseType_t hp_task_woken = pdFALSE;
+
+    const int64_t now = esp_timer_get_time();
+    uint8_t *slot = ring_write_begin(&s_ring.ring);
+    if (slot) {
+        s_ring.blk_us[(slot - s_ring.dma_buf) / s_geo.block_bytes] = now;
+        size_t n = event->size < s_geo.dma_bytes ? event->size : s_geo.dma_bytes;
+        if (s_geo.sample_bytes == 3) {
+            dsp_pack24((const uint32_t *)event->dma_buf, slot, n / 4); // drop slot padding on the way in
+        } else {
+            memcpy(slot, event->dma_buf, n);
+        }
+        ring_write_commit(&s_ring.ring);
+    }
+    // Wake the consumer either way; it may need to catch up on a backlog
+    if (s_consumer) {
+        vTaskNotifyGiveFromISR(s_consumer, &hp_task_woken);
+    }
+    return hp_task_woken == pdTRUE;
+}
+
+// We never call i2s_channel_read(), so the driver's internal event queue is
+// always full; it discards its own oldest entry. Nothing to do here.
+static IRAM_ATTR bool on_dma_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    return false;
+}
+
 // ---------------- I2S RX setup (ESP32-S3) ----------------
 // Use the new I2S STD driver (IDF v5.x). ESP is master generating BCLK/FSYNC.
 // Slot width 32 allows simple 32-bit packing; word length is 24 from ADC. [2](https://docs.espressif.com/projects/esp-idf/en/stable/esp32s3/api-reference/peripherals/i2s.html)[6](https://github.com/espressif/esp-idf/blob/master/components/esp_driver_i2s/include/driver/i2s_std.h)
-static esp_err_t i2s_setup(void) {
-    esp_err_t err = ESP_OK;
-
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(s_cfg.i2s_port, I2S_ROLE_MASTER);
-
-    err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan); // RX only
-    if (err) return err;
-
+// Philips I2S 24-bit stereo (CH1 left, CH2 right)
+static esp_err_t i2s_setup_std(void) {
     // Build Philips I2S 24-bit stereo slot config for ESP32‑S3
     i2s_std_slot_config_t slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(
         I2S_DATA_BIT_WIDTH_24BIT,
@@ -399,7 +621,7 @@ static esp_err_t i2s_setup(void) {
     slot_cfg.bit_shift = true;   // Philips I²S one-bit delay
 
     // Standard clock config
-    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(8000);
+    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(s_geo.sample_rate_hz);
     // NOTE in IDF: set mclk_multiple=384 when using 24-bit data for accurate rates if needed
     clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256; // leave default unless you see small ppm drift
 
@@ -408,123 +630,252 @@ static esp_err_t i2s_setup(void) {
         .slot_cfg = slot_cfg,
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,     //  MCLK unused; ESP will output BCLK/WS as master
-            .bclk = 36,                 
-            .ws   = 38,
+            .bclk = s_cfg.gpio_bclk,
+            .ws   = s_cfg.gpio_ws,
             .dout = I2S_GPIO_UNUSED,
-            .din  = 35,
-            .invert_flags = { 
-                .mclk_inv=false, 
-                .bclk_inv=false,     
-                .ws_inv=false,       
-            }
+            .din  = s_cfg.gpio_din,
         },
     };
+    return i2s_channel_init_std_mode(s_rx_chan, &std_cfg);
+}
+
+// TDM with ch_count slots in use (every device's CH1..CHn, packed from slot 0) in a
+// frame of frame_slots 32-bit slots, matching ASI_CFG0 = TDM / 32-bit words.
+// The TLV TDM frame starts on the FSYNC rising edge with no bit delay (TX_OFFSET = 0),
+// so use a one-BCLK FSYNC pulse and no Philips shift.
+static esp_err_t i2s_setup_tdm(void) {
+    i2s_tdm_slot_config_t slot_cfg = I2S_TDM_PHILIPS_SLOT_DEFAULT_CONFIG(
+        I2S_DATA_BIT_WIDTH_24BIT,
+        I2S_SLOT_MODE_STEREO,
+        (i2s_tdm_slot_mask_t)((1u << s_geo.ch_count) - 1)
+    );
+    // Same 24-in-32 layout as stereo mode, so everything downstream sees identical words
+    slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+    slot_cfg.ws_width       = 1;
+    slot_cfg.bit_shift      = false;
+    slot_cfg.total_slot     = s_geo.frame_slots;
+
+    // MCLK = 2x BCLK: 256fs for 4 slots (128fs BCLK) up to 1024fs for 16
+    i2s_tdm_clk_config_t clk_cfg = I2S_TDM_CLK_DEFAULT_CONFIG(s_geo.sample_rate_hz);
+    clk_cfg.mclk_multiple = (i2s_mclk_multiple_t)(s_geo.frame_slots * 32 * 2);
+    clk_cfg.bclk_div      = 2;
+
+    i2s_tdm_config_t tdm_cfg = {
+        .clk_cfg  = clk_cfg,
+        .slot_cfg = slot_cfg,
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,     //  MCLK unused; ESP will output BCLK/WS as master
+            .bclk = s_cfg.gpio_bclk,
+            .ws   = s_cfg.gpio_ws,
+            .dout = I2S_GPIO_UNUSED,
+            .din  = s_cfg.gpio_din,
+        },
+    };
+    return i2s_channel_init_tdm_mode(s_rx_chan, &tdm_cfg);
+}
+
+static esp_err_t i2s_setup(void) {
+    esp_err_t err = ESP_OK;
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(s_cfg.i2s_port, I2S_ROLE_MASTER);
+    // One DMA buffer == one ring block (e.g. 512B = 64 frames x 2 slots x 4 bytes
+    // at 8 kHz / 8 ms), so each on_recv interrupt delivers exactly one block.
+    // TLV_I2S_DMA_DESC_NUM buffers give the ISR that many blocks of slack.
+    chan_cfg.dma_frame_num = s_geo.block_frames;
+    chan_cfg.dma_desc_num  = TLV_I2S_DMA_DESC_NUM;
 
-    err = i2s_channel_init_std_mode(s_rx_chan, &std_cfg);
+    err = i2s_new_channel(&chan_cfg, NULL, &s_rx_chan); // RX only
+    if (err) return err;
+
+    if (s_tdm) {
+        err = i2s_setup_tdm();
+    } else {
+        err = i2s_setup_std();
+    }
     if (err) {
         LOG_ERR(TAG, err, "I2S initialization failed: ");
         return err;
     }
 
-    LOG_INFO(TAG, "I2S RX configured (MASTER @ %lu Hz, 24/32-bit)", s_cfg.sample_rate_hz);
+    // Callbacks must be registered while the channel is still disabled
+    i2s_event_callbacks_t cbs = {
+        .on_recv = on_dma_recv,
+        .on_recv_q_ovf = on_dma_recv_q_ovf,
+    };
+    err = i2s_channel_register_event_callback(s_rx_chan, &cbs, NULL);
+    if (err) {
+        LOG_ERR(TAG, err, "I2S callback registration failed: ");
+        return err;
+    }
+
+    LOG_INFO(TAG, "I2S RX configured (MASTER @ %lu Hz, %s, %lu of %lu slots, 24/32-bit, BCLK %lu Hz, %lu frames/DMA buffer)", 
+        s_geo.sample_rate_hz, s_tdm ? "TDM" : "stereo", s_geo.ch_count, s_geo.frame_slots,
+        s_geo.sample_rate_hz * s_geo.frame_slots * 32, s_geo.block_frames);
     return ESP_OK;
 }
 
-
-// ---------------- DMA reader task ----------------
-static TaskHandle_t s_reader = NULL;
-// static void reader_task(void *arg) {
-//     LOG_INFO(TAG, "reader_task started");
-//     size_t bytes_read = 0;
-//     uint32_t ok = 0; /* TODO: Remove after debug */
-//     while (1) {
-//         // Read exactly one DMA frame (512 bytes) every time we're called
-//         esp_err_t r = i2s_channel_read(s_rx_chan, s_ring.dma_buf[s_ring.wr_idx], 
-//             TLV_DMA_BUF_SZ, &bytes_read, pdMS_TO_TICKS(200));
-
-//         if (r == ESP_OK && bytes_read == TLV_DMA_BUF_SZ) {
-//             s_ring.wr_idx = (s_ring.wr_idx + 1) % TLV_DMA_BUF_COUNT;
-            
-//             if ((++ok % 100) == 0) { /* TODO: Remove after debug */
-//                 LOG_INFO(TAG, "reader: %lu blocks read", ok);
-//             }
-//             taskYIELD();
-//         } else {
-//             LOG_WARN(TAG, r, "i2s read err=%d bytes=%u", r, (unsigned)bytes_read);
-//             taskYIELD();
-//         }
-//     }
-// }
-
-static void reader_task(void *arg) {
-    LOG_INFO(TAG, "reader_task started");
-    uint32_t ok = 0;
-    static uint32_t verbose_left = 30; // print the next 30 read results verbosely
-    static uint32_t sanity_reads = 30;
-
-    for (;;) {
-        
-        // --- HEARTBEAT so we know the loop is running ---
-        static uint32_t hb = 0;
-        if (((++hb) % 200) == 0) {  // every ~200 iterations
-            LOG_INFO(TAG, "reader hb=%lu", hb);
-        }
-
-        size_t filled = 0;
-        uint8_t *dst = s_ring.dma_buf[s_ring.wr_idx];
-
-        // Gather exactly one 512B ring frame by accumulating partial reads
-        while (filled < TLV_DMA_BUF_SZ) {
-            size_t bytes_read = 0;
-            esp_err_t r = i2s_channel_read(s_rx_chan,
-                dst + filled,
-                TLV_DMA_BUF_SZ - filled,
-                &bytes_read,
-                pdMS_TO_TICKS(200)
-            ); // keep 50–200ms as you prefer
-
-            // if (verbose_left > 0) {
-            //     LOG_INFO(TAG, "read r=%d bytes=%u need=%u filled=%u",
-            //         r, (unsigned)bytes_read,
-            //         (unsigned)(TLV_DMA_BUF_SZ - filled),
-            //         (unsigned)filled
-            //     );
-            //     verbose_left--;
-            // }
-
-            if (r == ESP_OK && bytes_read > 0) {
-                filled += bytes_read;
-            } else { // Yield and retry; allow other tasks to run
-                taskYIELD();
+// ---------------- Synthetic source ----------------
+// Stands in for the DMA ISR: fills ring blocks from dsp_synth on a schedule of
+// synth_x blocks per block period, so the rest of the system (pipeline, MQTT)
+// can be pushed past real time to find where it saturates. Blocks the ring
+// cannot take are dropped and counted exactly as DMA overruns would be.
+#define TLV_SYNTH_PRIO          6       // above the publisher and the lanes, as the ISR it replaces
+
+static TaskHandle_t s_synth_task = NULL;
+static dsp_synth_t s_synth;
+
+static void synth_task(void *arg) {
+    const int64_t t0 = esp_timer_get_time();
+    uint64_t made = 0;
+    while (1) {
+        const uint64_t due = (uint64_t)(esp_timer_get_time() - t0) * s_cfg.synth_x / s_geo.block_us;
+        for (; made < due; ++made) {
+            uint8_t *slot = ring_write_begin(&s_ring.ring);
+            if (slot) {
+                // stamp the block when it was due, as the DMA would have
+                s_ring.blk_us[(slot - s_ring.dma_buf) / s_geo.block_bytes] =
+                    t0 + (int64_t)((made + 1) * s_geo.block_us / s_cfg.synth_x);
+                dsp_synth_fill(&s_synth, slot, s_geo.sample_bytes, s_geo.block_frames);
+                ring_write_commit(&s_ring.ring);
+            } else {
+                dsp_synth_skip(&s_synth, s_geo.block_frames);
             }
+            if (s_consumer) xTaskNotifyGive(s_consumer);
         }
+        vTaskDelay(1);
+    }
+}
 
-        // if (filled == TLV_DMA_BUF_SZ
-        // &&  sanity_reads > 0
-        // ) {
-        //     uint32_t *w = (uint32_t *)s_ring.dma_buf[s_ring.wr_idx];
-        //     LOG_INFO(TAG, "first words: %08lx %08lx %08lx %08lx", w[0], w[1], w[2], w[3]);
-        //     sanity_reads--;
-        // }
-
-        // We have 512 bytes assembled — advance write index
-        s_ring.wr_idx = (s_ring.wr_idx + 1) % TLV_DMA_BUF_COUNT;
-        if (((++ok) % 100) == 0) {
-            LOG_INFO(TAG, "reader: %lu blocks read", ok);
+bool tlv320adc5120_rate_supported(uint32_t sample_rate_hz) {
+    for (size_t i = 0; i < sizeof(s_rates_hz) / sizeof(s_rates_hz[0]); ++i) {
+        if (s_rates_hz[i] == sample_rate_hz) return true;
+    }
+    return false;
+}
+
+size_t tlv320adc5120_rates(const uint32_t **rates) {
+    if (rates) *rates = s_rates_hz;
+    return sizeof(s_rates_hz) / sizeof(s_rates_hz[0]);
+}
+
+void tlv320adc5120_get_geometry(tlv320adc5120_geometry_t *out) {
+    if (out) *out = s_geo;
+}
+
+esp_err_t tlv320adc5120_slot_alloc(const tlv320adc5120_bus_cfg_t *cfg, uint8_t slot0[TLV_MAX_DEVS], uint32_t *frame_slots) {
+    if (!cfg) return ESP_ERR_INVALID_ARG;
+    switch (tlv320adc5120_slot_plan(cfg->dev_count, cfg->dev_ch, cfg->ch_count, cfg->sample_rate_hz, slot0, frame_slots)) {
+    case TLV_SLOTS_OK:          return ESP_OK;
+    case TLV_SLOTS_BAD_COUNT:   return ESP_ERR_INVALID_SIZE;
+    case TLV_SLOTS_BCLK:        return ESP_ERR_NOT_SUPPORTED;
+    default:                    return ESP_ERR_INVALID_ARG;
+    }
+}
+
+// Derive block size and ring depth from the sample rate and target block duration
+static esp_err_t geometry_setup(void) {
+    if (!tlv320adc5120_rate_supported(s_cfg.sample_rate_hz)) {
+        LOG_ERR(TAG, ESP_ERR_NOT_SUPPORTED, "unsupported sample rate %lu Hz", s_cfg.sample_rate_hz);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    uint8_t slot0[TLV_MAX_DEVS];
+    uint32_t frame_slots = 0;
+    esp_err_t err = tlv320adc5120_slot_alloc(&s_cfg, slot0, &frame_slots);
+    if (err) {
+        LOG_ERR(TAG, err, "no slot layout for %lu ch from %lu device(s) at %lu Hz (max %u slots, BCLK %u Hz)",
+            s_cfg.ch_count, s_cfg.dev_count, s_cfg.sample_rate_hz, TLV_MAX_CH, TLV_BCLK_MAX_HZ);
+        return err;
+    }
+    tlv320adc5120_geometry_t g = {
+        .sample_rate_hz = s_cfg.sample_rate_hz,
+        .ch_count       = s_cfg.ch_count,
+        .sample_bytes   = s_cfg.pack24 ? 3 : 4,
+        .dev_count      = s_cfg.dev_count,
+        .frame_slots    = frame_slots,
+    };
+    s_tdm = (frame_slots != 2);
+    s_dev_count = s_cfg.dev_count;
+    for (uint32_t i = 0; i < s_dev_count; ++i) {
+        tlv_dev_t *d = &s_devs[i];
+        memset(d, 0, sizeof(*d));
+        d->addr  = s_cfg.i2c_addr[i];
+        d->slot0 = slot0[i];
+        d->ch    = s_tdm ? s_cfg.dev_ch[i] : 2;
+        shadow_invalidate(d);
+        tlv_dev_table(d, s_dev_cfg[i]);
+        for (uint32_t k = 0; k < d->ch; ++k) {
+            g.chan[d->slot0 + k] = (tlv320adc5120_chan_t){
+                .dev = (uint8_t)i, .addr = d->addr, .adc_ch = (uint8_t)(k + 1), .slot = (uint8_t)(d->slot0 + k),
+            };
         }
-        taskYIELD();
     }
+    g.frame_bytes = g.ch_count * g.sample_bytes;
+    const uint32_t dma_frame_bytes = g.ch_count * (uint32_t)(s_cfg.slot_bits / 8);
+
+    uint32_t block_ms = s_cfg.block_ms ? s_cfg.block_ms : 8;
+    g.block_frames = (g.sample_rate_hz * block_ms) / 1000;
+    uint32_t max_frames = TLV_BLOCK_MAX_SZ / dma_frame_bytes;
+    if (g.block_frames > max_frames) g.block_frames = max_frames;
+    g.block_frames &= ~3u; // keeps packed slots word-aligned so the pack kernel takes its fast path
+    if (g.block_frames < 8) g.block_frames = 8;
+    g.block_bytes = g.block_frames * g.frame_bytes;
+    g.dma_bytes   = g.block_frames * dma_frame_bytes;
+    g.block_us    = (uint32_t)(((uint64_t)g.block_frames * 1000000) / g.sample_rate_hz);
+
+    // Smallest power of two covering the backlog target, within the memory budget
+    uint32_t want = (TLV_RING_BACKLOG_MS * 1000) / g.block_us;
+    g.ring_count = TLV_RING_MIN_COUNT;
+    while (g.ring_count < want 
+    &&     (g.ring_count * 2) * g.block_bytes <= TLV_RING_MAX_BYTES
+    ) {
+        g.ring_count *= 2;
+    }
+
+    s_geo = g;
+    return ESP_OK;
+}
+
+static esp_err_t ring_setup(void) {
+    free(s_ring.dma_buf);
+    free(s_ring.blk_seq);
+    free(s_ring.blk_us);
+    memset(&s_ring, 0, sizeof(s_ring));
+
+    s_ring.dma_buf = malloc((size_t)s_geo.ring_count * s_geo.block_bytes);
+    s_ring.blk_seq = calloc(s_geo.ring_count, sizeof(uint32_t));
+    s_ring.blk_us  = calloc(s_geo.ring_count, sizeof(int64_t));
+    if (!s_ring.dma_buf || !s_ring.blk_seq || !s_ring.blk_us) {
+        LOG_ERR(TAG, ESP_ERR_NO_MEM, "ring alloc failed (%lu x %lu B)", 
+            s_geo.ring_count, s_geo.block_bytes);
+        return ESP_ERR_NO_MEM;
+    }
+    if (!ring_init(&s_ring.ring, s_ring.dma_buf, s_ring.blk_seq,
+            s_geo.ring_count, s_geo.block_bytes, s_cfg.overrun)) {
+        LOG_ERR(TAG, ESP_ERR_INVALID_SIZE, "ring init failed (count must be a power of two)");
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
 }
 
 esp_err_t tlv320adc5120_init(const tlv320adc5120_bus_cfg_t *cfg) {
     if (!cfg) return ESP_ERR_INVALID_ARG;
     s_cfg = *cfg;
-    memset(&s_ring, 0, sizeof(s_ring));
+    if (!s_lock) s_lock = xSemaphoreCreateMutexStatic(&s_lock_buf);
 
-    LOG_INFO(TAG, "ring config: COUNT=%d SZ=%d", /* TODO: Remove after debug */
-        TLV_DMA_BUF_COUNT, TLV_DMA_BUF_SZ);
-    LOG_INFO(TAG, "ring idx init: rd=%d wr=%d",  /* TODO: Remove after debug */
-        (int)s_ring.rd_idx, (int)s_ring.wr_idx);
+    ESP_RETURN_ON_ERROR(geometry_setup(), TAG, "geometry");
+    ESP_RETURN_ON_ERROR(ring_setup(), TAG, "ring");
+
+    LOG_INFO(TAG, "ring config: %lu Hz x %lu ch x %lu B (%lu B/s), COUNT=%lu SZ=%lu (%lu us/block) policy=%s",
+        s_geo.sample_rate_hz, s_geo.ch_count, s_geo.sample_bytes, s_geo.sample_rate_hz * s_geo.frame_bytes,
+        s_geo.ring_count, s_geo.block_bytes, s_geo.block_us,
+        s_cfg.overrun == RING_OVERWRITE_OLDEST ? "overwrite-oldest" : "drop-newest");
+
+    if (s_cfg.synth_x) {
+        ESP_RETURN_ON_FALSE(dsp_synth_init(&s_synth, s_geo.ch_count, s_geo.sample_rate_hz, 0),
+            ESP_ERR_INVALID_ARG, TAG, "synth init");
+        LOG_INFO(TAG, "synthetic source at %lux real time; no I2C / I2S", s_cfg.synth_x);
+        return ESP_OK;
+    }
 
     // I2C master config (pins are configurable; ESP32-S3 routes via GPIO matrix) [7](https://embeddedexplorer.com/esp32-i2c-tutorial/)[3](https://docs.espressif.com/projects/esp-idf/en/stable/esp32s3/api-reference/peripherals/gpio.html)
     i2c_config_t i2c = {
@@ -538,9 +889,23 @@ esp_err_t tlv320adc5120_init(const tlv320adc5120_bus_cfg_t *cfg) {
     ESP_RETURN_ON_ERROR(i2c_param_config(s_cfg.i2c_port, &i2c), TAG, "i2c_param_config");
     ESP_RETURN_ON_ERROR(i2c_driver_install(s_cfg.i2c_port, I2C_MODE_MASTER, 0, 0, 0), TAG, "i2c_driver_install");
 
-    ESP_RETURN_ON_ERROR(tlv_reset_device_pg0(), TAG, "ADC page 0 reset");
-    ESP_RETURN_ON_ERROR(tlv_cfg_device(), TAG, "ADC cfg");
-    tlv_dump_status();
+    esp_err_t err = ESP_OK;
+    drv_lock();
+    for (uint32_t i = 0; i < s_dev_count; ++i) {
+        err = tlv_reset_device_pg0(&s_devs[i]);
+        if (err != ESP_OK) {
+            LOG_ERR(TAG, err, "ADC page 0 reset");
+            break;
+        }
+        err = tlv_cfg_device(i, true);
+        if (err != ESP_OK) {
+            LOG_ERR(TAG, err, "ADC cfg");
+            break;
+        }
+        tlv_dump_status(&s_devs[i]);
+    }
+    drv_unlock();
+    if (err != ESP_OK) return err;
 
     ESP_RETURN_ON_ERROR(i2s_setup(), TAG, "i2s setup");
 
@@ -549,54 +914,315 @@ esp_err_t tlv320adc5120_init(const tlv320adc5120_bus_cfg_t *cfg) {
 }
 
 esp_err_t tlv320adc5120_start(void) {
+    if (s_cfg.synth_x) {
+        ESP_RETURN_ON_FALSE(xTaskCreate(synth_task, "tlv_synth", 3072, NULL, TLV_SYNTH_PRIO, &s_synth_task) == pdPASS,
+            ESP_ERR_NO_MEM, TAG, "synth task");
+        LOG_INFO(TAG, "driver start OK (synthetic)");
+        return ESP_OK;
+    }
     ESP_RETURN_ON_ERROR(i2s_channel_enable(s_rx_chan), TAG, "i2s_channel_enable");
     
     LOG_INFO(TAG, "I2S RX enabled; waiting for DMA...");
     vTaskDelay(pdMS_TO_TICKS(500));
-    tlv_dump_status();  // after clocks are flowing
+    drv_lock();
+    for (uint32_t i = 0; i < s_dev_count; ++i) tlv_dump_status(&s_devs[i]); // after clocks are flowing
+    drv_unlock();
 
-    // if (!s_reader) xTaskCreate(reader_task, "tlv_reader", 4096, NULL, 5, &s_reader);
-    // xTaskCreatePinnedToCore(reader_task, "tlv_reader", 4096, NULL, 1, &s_reader, /*core*/ 0);
-    xTaskCreatePinnedToCore(reader_task, "tlv_reader", 4096, NULL, 3, &s_reader, /*core*/ 0);
-    
     LOG_INFO(TAG, "driver start OK");
     return ESP_OK;
 }
 
 esp_err_t tlv320adc5120_stop(void) {
-    if (s_reader) { vTaskDelete(s_reader); s_reader = NULL; }
+    if (s_synth_task) { vTaskDelete(s_synth_task); s_synth_task = NULL; }
     if (s_rx_chan) ESP_RETURN_ON_ERROR(i2s_channel_disable(s_rx_chan), TAG, "i2s_channel_disable");
     LOG_INFO(TAG, "driver stopped");
     return ESP_OK;
 }
 
 esp_err_t tlv320adc5120_deinit(void) {
+    if (s_synth_task) { vTaskDelete(s_synth_task); s_synth_task = NULL; }
     if (s_rx_chan) { i2s_del_channel(s_rx_chan); s_rx_chan = NULL; }
-    i2c_driver_delete(s_cfg.i2c_port);
+    if (!s_cfg.synth_x) i2c_driver_delete(s_cfg.i2c_port);
+    free(s_ring.dma_buf);
+    free(s_ring.blk_seq);
+    free(s_ring.blk_us);
+    memset(&s_ring, 0, sizeof(s_ring));
     LOG_INFO(TAG, "driver deinit OK");
     return ESP_OK;
 }
 
-// Pop one 512B buffer if available
-bool tlv320adc5120_pop(uint8_t out[TLV_DMA_BUF_SZ]) {
-    if (s_ring.rd_idx == s_ring.wr_idx) {
-        // static uint32_t empty_cnt = 0;
-        // if ((++empty_cnt % 200) == 0) {
-        //     LOG_INFO(TAG, "pop: empty (rd=%d wr=%d)", (int)s_ring.rd_idx, (int)s_ring.wr_idx);
-        // }
+// Lease the next block in place if available
+bool tlv320adc5120_acquire(tlv320adc5120_block_t *out) {
+    ring_block_t blk;
+    if (!out || !ring_acquire(&s_ring.ring, &blk)) {
         return false;
     }
-    memcpy(out, s_ring.dma_buf[s_ring.rd_idx], TLV_DMA_BUF_SZ);
-    s_ring.rd_idx = (s_ring.rd_idx + 1) % TLV_DMA_BUF_COUNT;
+    out->data = blk.data;
+    out->seq  = blk.seq;
+    out->t_us = s_ring.blk_us[(blk.data - s_ring.dma_buf) / s_geo.block_bytes];
+    return true;
+}
+
+// Hand the oldest leased block back to the ring
+void tlv320adc5120_release(const tlv320adc5120_block_t *blk) {
+    if (!blk) {
+        return;
+    }
+    ring_release(&s_ring.ring);
+}
+
+// Task to notify (xTaskNotifyGive) each time a block lands in the ring
+void tlv320adc5120_set_consumer(TaskHandle_t task) {
+    s_consumer = task;
+}
+
+void tlv320adc5120_get_ring_stats(ring_stats_t *out) {
+    if (out) {
+        ring_get_stats(&s_ring.ring, out);
+    }
+}
 
-    static uint32_t got_cnt = 0;
-    if ((++got_cnt % 100) == 0) {
-        LOG_INFO(TAG, "pop: got (rd=%d wr=%d)", (int)s_ring.rd_idx, (int)s_ring.wr_idx);
+// Pop one block if available (copying wrapper around acquire/release)
+bool tlv320adc5120_pop(uint8_t *out, size_t len) {
+    tlv320adc5120_block_t blk;
+    if (!out || len < s_geo.block_bytes || !tlv320adc5120_acquire(&blk)) {
+        return false;
     }
+    memcpy(out, blk.data, s_geo.block_bytes);
+    tlv320adc5120_release(&blk);
     return true;
 }
 
 
+static tlv_dev_t *dev_get(uint32_t dev) {
+    return (dev < s_dev_count && !s_cfg.synth_x) ? &s_devs[dev] : NULL;
+}
+
+esp_err_t tlv320adc5120_write_regs(uint32_t dev, uint8_t page, uint8_t reg, const uint8_t *data, size_t len) {
+    tlv_dev_t *d = dev_get(dev);
+    if (!d || !data || !len) return ESP_ERR_INVALID_ARG;
+    drv_lock();
+    const esp_err_t err = tlv_write(d, page, reg, data, len, true);
+    drv_unlock();
+    return err;
+}
+
+esp_err_t tlv320adc5120_read_regs(uint32_t dev, uint8_t page, uint8_t reg, uint8_t *data, size_t len) {
+    tlv_dev_t *d = dev_get(dev);
+    if (!d || !data || !len) return ESP_ERR_INVALID_ARG;
+    drv_lock();
+    const esp_err_t err = tlv_read(d, page, reg, data, len);
+    drv_unlock();
+    return err;
+}
+
+esp_err_t tlv320adc5120_apply_regs(uint32_t dev, const tlv320adc5120_reg_t *regs, size_t n) {
+    tlv_dev_t *d = dev_get(dev);
+    if (!d || !regs) return ESP_ERR_INVALID_ARG;
+    drv_lock();
+    const esp_err_t err = tlv_apply(d, regs, n, false);
+    drv_unlock();
+    return err;
+}
+
+static bool s_vad_idle = false;
+
+// The tables power the channels up, which must not happen while VAD idle runs without clocks
+esp_err_t tlv320adc5120_reconfigure(void) {
+    if (s_cfg.synth_x) return ESP_OK;
+    esp_err_t err = ESP_OK;
+    drv_lock();
+    if (s_vad_idle) err = ESP_ERR_INVALID_STATE;
+    for (uint32_t i = 0; i < s_dev_count && err == ESP_OK; ++i) {
+        err = tlv_cfg_device(i, false);
+        if (err != ESP_OK) LOG_ERR(TAG, err, "reconfigure 0x%02X", s_devs[i].addr);
+    }
+    drv_unlock();
+    return err;
+}
+
+/* Biquad b (0-based) sits at page 2 + b / 6, 20 bytes per biquad from 0x08, and
+   filters channel b % 4 + 1 (BIQUAD_CFG: biquads 1/5/9 -> CH1, 2/6/10 -> CH2, ...).
+   The coefficient RAM is written with the enabled channels powered down, so the
+   filters never run on a half-written set; restarting them costs a few ms of
+   output (the ADC's power-up settling), so this is not for per-block use. */
+static esp_err_t dev_set_filters(tlv_dev_t *d, const int32_t iir1[3], uint32_t per_ch, const int32_t (*bq)[5]) {
+    /* 0x75 - PWR_CFG bit 6: power up all enabled ADC channels */
+    uint8_t pwr = 0;
+    const bool powered = shadow_get(d, 0, 0x75, &pwr) && (pwr & 0x40);
+    if (powered) {
+        const uint8_t off = pwr & (uint8_t)~0x40;
+        ESP_RETURN_ON_ERROR(tlv_write(d, 0, 0x75, &off, 1, true), TAG, "channel power-down");
+    }
+
+    esp_err_t err = ESP_OK;
+    for (uint32_t b = 0; b < per_ch * 4 && err == ESP_OK; ++b) {
+        uint8_t buf[20];
+        for (uint32_t k = 0; k < 5; ++k) dsp_coef_be(bq[b][k], buf + 4 * k);
+        err = tlv_write(d, (uint8_t)(2 + b / 6), (uint8_t)(0x08 + (b % 6) * 20), buf, sizeof(buf), true);
+    }
+    if (err == ESP_OK && iir1) {
+        /* P4 0x48-0x53 - first-order IIR N0, N1, D1 (DSP_CFG0 HPF_SEL = 00 selects it) */
+        uint8_t buf[12];
+        for (uint32_t k = 0; k < 3; ++k) dsp_coef_be(iir1[k], buf + 4 * k);
+        err = tlv_write(d, 4, 0x48, buf, sizeof(buf), true);
+    }
+    if (err == ESP_OK) {
+        /* 0x6C - DSP_CFG1 6-5: BIQUAD_CFG, biquads per channel (reset value 0x40: two) */
+        uint8_t cfg1 = 0x40;
+        shadow_get(d, 0, 0x6C, &cfg1);
+        cfg1 = (uint8_t)((cfg1 & ~0x60) | (per_ch << 5));
+        err = tlv_write(d, 0, 0x6C, &cfg1, 1, true);
+    }
+
+    if (powered) {
+        // restore power even after a failed write, so acquisition keeps running
+        esp_err_t perr = tlv_write(d, 0, 0x75, &pwr, 1, true);
+        if (err == ESP_OK) err = perr;
+    }
+    return err;
+}
+
+esp_err_t tlv320adc5120_set_filters(const int32_t iir1[3], uint32_t per_ch, const int32_t (*bq)[5]) {
+    if (per_ch > TLV_BIQUAD_MAX_PER_CH || (per_ch && !bq)) return ESP_ERR_INVALID_ARG;
+    if (s_cfg.synth_x) return ESP_ERR_NOT_SUPPORTED;
+
+    drv_lock();
+    if (s_vad_idle) {
+        // restoring PWR_CFG would power the channels up with no clocks running
+        drv_unlock();
+        LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "filters not applied: ADCs are in VAD idle");
+        return ESP_ERR_INVALID_STATE;
+    }
+    const int64_t t0 = esp_timer_get_time();
+    const uint32_t x0 = s_i2c_xfers;
+
+    esp_err_t err = ESP_OK;
+    for (uint32_t i = 0; i < s_dev_count && err == ESP_OK; ++i) {
+        err = dev_set_filters(&s_devs[i], iir1, per_ch, bq);
+    }
+    drv_unlock();
+    if (err == ESP_OK) {
+        LOG_INFO(TAG, "filters applied to %lu device(s): %lu biquad(s) per channel, first-order IIR %s (%lu I2C transactions, %lu us)",
+            s_dev_count, per_ch, iir1 ? "set" : "unchanged", s_i2c_xfers - x0, (uint32_t)(esp_timer_get_time() - t0));
+    } else {
+        LOG_ERR(TAG, err, "filter coefficient write failed");
+    }
+    return err;
+}
+
+/* ---------------- VAD idle ----------------
+   While idle the ESP generates no BCLK/FSYNC, so the ASI is unused and SDOUT
+   can carry the ADC's interrupt (VAD_CFG2 SDOUT_INT_CFG). SDOUT is already
+   wired to the I2S DIN pin, whose input path also reaches the GPIO interrupt
+   logic, so the wake-up needs no extra wiring and no pin re-routing. */
+#define TLV_INT_VAD_PWRUP       0x02    // INT_MASK0 / INT_LTCH0 bit 1: VAD power-up detect
+static TaskHandle_t s_vad_notify = NULL;
+static tlv_dev_t *s_vad_dev = NULL;     // device whose VAD is watching
+
+static IRAM_ATTR void on_vad_irq(void *arg) {
+    BaseType_t hp_task_woken = pdFALSE;
+    gpio_intr_disable((gpio_num_t)s_cfg.gpio_din);  // one edge per idle period
+    if (s_vad_notify) {
+        vTaskNotifyGiveFromISR(s_vad_notify, &hp_task_woken);
+    }
+    portYIELD_FROM_ISR(hp_task_woken);
+}
+
+static esp_err_t vad_idle_locked(uint32_t ch, TaskHandle_t notify) {
+    if (s_vad_idle) return ESP_ERR_INVALID_STATE;
+    tlv_dev_t *vd = &s_devs[s_geo.chan[ch].dev];
+    const uint32_t adc_ch = s_geo.chan[ch].adc_ch - 1u;
+
+    ESP_RETURN_ON_ERROR(i2s_channel_disable(s_rx_chan), TAG, "i2s_channel_disable");
+    s_vad_idle = true;                          // from here a failure is undone by vad_resume()
+    s_vad_dev = vd;
+
+    // Every other device just powers its channels and PLL down (no clocks while idle)
+    for (uint32_t i = 0; i < s_dev_count; ++i) {
+        if (!shadow_get(&s_devs[i], 0, 0x75, &s_devs[i].pwr_run)) s_devs[i].pwr_run = 0xE0;
+    }
+    for (uint32_t i = 0; i < s_dev_count; ++i) {
+        tlv_dev_t *d = &s_devs[i];
+        if (d == vd) continue;
+        const uint8_t down = d->pwr_run & (uint8_t)~0x60;
+        ESP_RETURN_ON_ERROR(tlv_write(d, 0, 0x75, &down, 1, true), TAG, "idle power-down 0x%02X", d->addr);
+    }
+
+    /* Page 0: 0x28 - INT_CFG 7: INT_POL 1 = active high (SDOUT idles low like ASI data)
+               0x33 - INT_MASK0 1 = masked; unmask VAD power-up detect only */
+    const tlv320adc5120_reg_t idle[] = {
+        { 0, 0x28, 0x80, 0 },
+        { 0, 0x33, (uint8_t)~TLV_INT_VAD_PWRUP, 0 },
+        /* 0x75 - PWR_CFG: ADC channels and PLL down (no clocks), bit 0 VAD enabled */
+        { 0, 0x75, (uint8_t)((vd->pwr_run & ~0x60) | 0x01), 0 },
+        /* Page 1: 0x1E - VAD_CFG1 7-6 00 user-initiated power-up (the ESP wakes the ADC),
+                                5-4 monitored channel, 3-2 00 internal oscillator
+                   0x1F - VAD_CFG2 6: SDOUT carries the interrupt while the ASI is unused */
+        { 1, 0x1E, (uint8_t)(adc_ch << 4), 0 },
+        { 1, 0x1F, 0x40, 0 },
+    };
+    ESP_RETURN_ON_ERROR(tlv_apply(vd, idle, sizeof(idle) / sizeof(idle[0]), false), TAG, "VAD idle config");
+
+    uint8_t ltch;
+    tlv_read(vd, 0, 0x36, &ltch, 1);                // INT_LTCH0: clear anything latched before idle
+    ulTaskNotifyTake(pdTRUE, 0);                // drop DMA wake-ups still pending for the caller
+
+    esp_err_t err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err; // already installed is fine
+    s_vad_notify = notify;
+    gpio_set_intr_type((gpio_num_t)s_cfg.gpio_din, GPIO_INTR_POSEDGE);
+    ESP_RETURN_ON_ERROR(gpio_isr_handler_add((gpio_num_t)s_cfg.gpio_din, on_vad_irq, NULL), TAG, "VAD irq");
+    gpio_intr_enable((gpio_num_t)s_cfg.gpio_din);
+
+    LOG_INFO(TAG, "VAD idle: I2S stopped, ADCs down, 0x%02X watching CH%lu", vd->addr, adc_ch + 1);
+    return ESP_OK;
+}
+
+esp_err_t tlv320adc5120_vad_idle(uint32_t ch, TaskHandle_t notify) {
+    if (ch >= s_geo.ch_count || !notify) return ESP_ERR_INVALID_ARG;
+    if (s_cfg.synth_x) return ESP_ERR_NOT_SUPPORTED;
+    drv_lock();
+    const esp_err_t err = vad_idle_locked(ch, notify);
+    drv_unlock();
+    return err;
+}
+
+static esp_err_t vad_resume_locked(void) {
+    if (!s_vad_idle) return ESP_OK;
+    const int64_t t0 = esp_timer_get_time();
+    gpio_intr_disable((gpio_num_t)s_cfg.gpio_din);
+    gpio_isr_handler_remove((gpio_num_t)s_cfg.gpio_din);
+    gpio_set_intr_type((gpio_num_t)s_cfg.gpio_din, GPIO_INTR_DISABLE);
+
+    tlv_dev_t *vd = s_vad_dev;
+    uint8_t ltch = 0;
+    tlv_read(vd, 0, 0x36, &ltch, 1);
+    const tlv320adc5120_reg_t run[] = {
+        { 0, 0x75, vd->pwr_run, 0 },            // channels and PLL back up, VAD off
+        { 1, 0x1F, 0x00, 0 },                   // SDOUT back to ASI data
+    };
+    ESP_RETURN_ON_ERROR(tlv_apply(vd, run, sizeof(run) / sizeof(run[0]), false), TAG, "VAD resume config");
+    for (uint32_t i = 0; i < s_dev_count; ++i) {
+        tlv_dev_t *d = &s_devs[i];
+        if (d == vd) continue;
+        ESP_RETURN_ON_ERROR(tlv_write(d, 0, 0x75, &d->pwr_run, 1, true), TAG, "resume power-up 0x%02X", d->addr);
+    }
+    ESP_RETURN_ON_ERROR(i2s_channel_enable(s_rx_chan), TAG, "i2s_channel_enable");
+    s_vad_idle = false;
+
+    LOG_INFO(TAG, "VAD wake (INT_LTCH0 0x%02X): streaming again after %lu us", ltch, (uint32_t)(esp_timer_get_time() - t0));
+    return ESP_OK;
+}
+
+esp_err_t tlv320adc5120_vad_resume(void) {
+    if (s_cfg.synth_x) return ESP_OK;
+    drv_lock();
+    const esp_err_t err = vad_resume_locked();
+    drv_unlock();
+    return err;
+}
+
 esp_err_t tlv320adc5120_read_id(uint8_t *out_id) {
     // TODO: read an ID/version register defined by TI
     uint8_t id = 0;
@@ -3,7 +3,12 @@
 
 #include "esp_err.h"
 
+#include "driver_TLV320ADC5120_slots.h"
+#include "util_ring.h"
+
 #include "driver/i2c.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -12,17 +17,72 @@ extern "C" {
 #endif
 
 
-// DMA ring: 8 buffers x 512B, matches 125Hz read cadence (8ms per buffer)
-#define TLV_DMA_BUF_SZ     512
-#define TLV_DMA_BUF_COUNT  8
+// Block / ring geometry is derived from the sample rate at init (see tlv320adc5120_geometry_t).
+// A block is one I2S DMA buffer; the ring is the only sample buffer, since consumers
+// lease blocks in place rather than copying them, so it must absorb publisher stalls.
+#define TLV_BLOCK_MAX_SZ        4092    // I2S DMA buffer limit (bytes)
+#define TLV_RING_BACKLOG_MS     512     // target ring depth in time
+#define TLV_RING_MIN_COUNT      8
+#define TLV_RING_MAX_BYTES      (64 * 1024)
+// I2S DMA descriptors; each one is sized to exactly one ring block
+#define TLV_I2S_DMA_DESC_NUM    4
+
+// Device / slot limits (TLV_MAX_DEVS, TLV_DEV_CH, TLV_MAX_CH, TLV_BCLK_MAX_HZ) are in
+// driver_TLV320ADC5120_slots.h
+#define TLV_I2C_ADDR_DEFAULT    0x4E
 
 typedef struct {
-    // ring buffer for raw bytes read from I2S
-    uint8_t   dma_buf[TLV_DMA_BUF_COUNT][TLV_DMA_BUF_SZ];
-    volatile int wr_idx;    // written by reader task
-    volatile int rd_idx;    // consumed by tlv320adc5120_pop()
+    // ring buffer for raw bytes read from I2S; indices live in the SPSC ring
+    uint8_t  *dma_buf;      // ring_count x block_bytes, allocated at init
+    uint32_t *blk_seq;      // sequence number of the block in each slot
+    int64_t  *blk_us;       // DMA-completion time (esp_timer) of the block in each slot
+    ring_t    ring;         // I2S on_recv ISR produces, tlv320adc5120_acquire()/release() consume
 } tlv320adc5120_dma_ring_t;
 
+// Where one ring channel comes from
+typedef struct {
+    uint8_t dev;             // index into the bus config's devices
+    uint8_t addr;            // that device's I2C address
+    uint8_t adc_ch;          // 1..4 on that device
+    uint8_t slot;            // TDM slot
+} tlv320adc5120_chan_t;
+
+// Acquisition geometry as actually configured
+typedef struct {
+    uint32_t sample_rate_hz; // frames per second
+    uint32_t ch_count;       // slots per frame
+    uint32_t sample_bytes;   // bytes per sample in the ring: 4 (24-in-32 slot) or 3 (packed)
+    uint32_t frame_bytes;    // ch_count x sample_bytes
+    uint32_t block_frames;   // frames per block (one DMA buffer)
+    uint32_t block_bytes;    // block_frames x frame_bytes (ring slot)
+    uint32_t dma_bytes;      // block_frames x ch_count x slot bytes (I2S DMA buffer)
+    uint32_t block_us;       // duration of one block
+    uint32_t ring_count;     // blocks in the ring (power of two)
+    uint32_t dev_count;      // ADCs on the data line
+    uint32_t frame_slots;    // slots per frame on the wire (>= ch_count)
+    tlv320adc5120_chan_t chan[TLV_MAX_CH]; // source of each channel, in ring order
+} tlv320adc5120_geometry_t;
+
+// Read-only lease on one ring block. Pass it around by value (it is four words),
+// and give it back with tlv320adc5120_release() once the data has been consumed.
+typedef struct {
+    const uint8_t *data;   // geometry.block_bytes bytes; valid until released
+    uint32_t seq;          // running block sequence number
+    int64_t  t_us;         // esp_timer when the DMA completed, i.e. the block's last frame landed
+} tlv320adc5120_block_t;
+
+
+// One entry of a register table. Keep tables grouped by page and in ascending
+// register order so neighbouring registers can be merged into one burst.
+typedef struct {
+    uint8_t page;
+    uint8_t reg;
+    uint8_t val;
+    uint8_t flags;          // TLV_REG_*
+} tlv320adc5120_reg_t;
+
+#define TLV_REG_VOLATILE    0x01    // command / self-clearing register: always written, never cached
+
 
 // ---- I2C + I2S pin/map config ----
 typedef struct {
@@ -31,7 +91,9 @@ typedef struct {
     int gpio_sda;          // e.g., 8
     int gpio_scl;          // e.g., 9
     uint32_t i2c_freq_hz;  // e.g., 400000
-    uint8_t i2c_addr;      // 7-bit TLV320ADC5120 address
+    uint32_t dev_count;                 // ADCs on the bus / data line, 1..TLV_MAX_DEVS
+    uint8_t  i2c_addr[TLV_MAX_DEVS];    // 7-bit addresses, in slot order
+    uint8_t  dev_ch[TLV_MAX_DEVS];      // TDM: channels used per device (CH1..CHn), 1..4
 
     // I2S RX (ESP as slave, ADC provides BCLK/FSYNC)
     int i2s_port;          // I2S_NUM_0 / I2S_NUM_1
@@ -40,9 +102,19 @@ typedef struct {
     int gpio_din;          // e.g., 35  (SDOUT from ADC)
 
     // Audio config
-    uint32_t sample_rate_hz; // 8000
+    uint32_t ch_count;       // 2 = I2S stereo (one device, CH1/CH2); else TDM, the sum of dev_ch
+    uint32_t sample_rate_hz; // 8000 - 96000; must be a rate the ADC supports
+    uint32_t block_ms;       // target block duration; rounded to whole frames, capped by TLV_BLOCK_MAX_SZ
     int word_bits;           // 24 (ADC word length)
     int slot_bits;           // 32 (I2S slot width on ESP RX; use 32 for alignment)
+    bool pack24;             // store samples packed (3 bytes) in the ring; packed in the DMA ISR
+
+    // Ring behaviour when the consumer falls behind
+    ring_overrun_t overrun;  // RING_DROP_NEWEST (default) / RING_OVERWRITE_OLDEST
+
+    // Synthetic source (dsp_synth) instead of the ADCs: no I2C / I2S, blocks are
+    // generated at synth_x times real time. 0 = off.
+    uint32_t synth_x;
 } tlv320adc5120_bus_cfg_t;
 
 // Public API
@@ -51,22 +123,51 @@ esp_err_t tlv320adc5120_init(const tlv320adc5120_bus_cfg_t *cfg);
 esp_err_t tlv320adc5120_start(void);
 esp_err_t tlv320adc5120_stop(void);
 esp_err_t tlv320adc5120_deinit(void);
-
-// const uint8_t ADDR = 0x4E; 
-#define TLV_I2C_ADDR 0x4E
-// Helper to write one register
-#define TLV_WR(reg, val) \
-    i2c_master_write_to_device( \
-        s_cfg.i2c_port, \
-        TLV_I2C_ADDR, \
-        (uint8_t[]){ (reg), (val) }, \
-        2, \
-        pdMS_TO_TICKS(20) \
-    )
+bool tlv320adc5120_rate_supported(uint32_t sample_rate_hz);
+size_t tlv320adc5120_rates(const uint32_t **rates); // supported rates, ascending; returns the count
+void tlv320adc5120_get_geometry(tlv320adc5120_geometry_t *out);
+
+// TDM slot allocator: packs each device's CH1..CHn into consecutive slots, in
+// device order (tlv320adc5120_slot_plan). ESP_ERR_INVALID_ARG for a bad device
+// list, ESP_ERR_INVALID_SIZE if ch_count doesn't match it or exceeds TLV_MAX_CH
+// slots, ESP_ERR_NOT_SUPPORTED above TLV_BCLK_MAX_HZ.
+esp_err_t tlv320adc5120_slot_alloc(const tlv320adc5120_bus_cfg_t *cfg, uint8_t slot0[TLV_MAX_DEVS], uint32_t *frame_slots);
+
+// Register access on device dev (index into the bus config). Every call that touches the
+// bus holds the driver lock, so these are safe from any task. The driver caches every
+// register it writes or reads (pages 0..4) per device, so repeated page selects and
+// writes of unchanged values never reach the bus. Consecutive registers are sent
+// as one auto-increment burst.
+esp_err_t tlv320adc5120_write_regs(uint32_t dev, uint8_t page, uint8_t reg, const uint8_t *data, size_t len);
+esp_err_t tlv320adc5120_read_regs(uint32_t dev, uint8_t page, uint8_t reg, uint8_t *data, size_t len); // always hits the device
+esp_err_t tlv320adc5120_apply_regs(uint32_t dev, const tlv320adc5120_reg_t *regs, size_t n); // writes only what changed
+esp_err_t tlv320adc5120_reconfigure(void); // re-apply the driver's own tables to every device (diff only); INVALID_STATE in VAD idle
+
+// Programmable filters. iir1: first-order IIR N0, N1, D1 (NULL leaves it as is);
+// bq: per_ch x 4 biquads N0, N1, N2, D1, D2 in device order (bq[b] filters CH(b % 4 + 1)).
+// Register values come from dsp_biquad. Applied to every device. Runtime-safe:
+// enabled channels are powered down around the write. per_ch = 0 bypasses the biquads.
+// ESP_ERR_INVALID_STATE while the ADCs are in VAD idle (apply again after the wake).
+#define TLV_BIQUAD_MAX_PER_CH   3
+esp_err_t tlv320adc5120_set_filters(const int32_t iir1[3], uint32_t per_ch, const int32_t (*bq)[5]);
+
+// Low-duty idle: I2S/DMA stopped, ADC channels and PLL down, the VAD of the device
+// carrying ring channel ch (0-based) watching it on its internal oscillator. Activity raises
+// SDOUT and notifies the task; it then calls tlv320adc5120_vad_resume().
+// Call from the notify task (its pending notifications are dropped). On error,
+// call tlv320adc5120_vad_resume() to undo a partial idle.
+esp_err_t tlv320adc5120_vad_idle(uint32_t ch, TaskHandle_t notify);
+esp_err_t tlv320adc5120_vad_resume(void);
 
 
 // Ring access
-bool tlv320adc5120_pop(uint8_t out[TLV_DMA_BUF_SZ]); // copy one 512B block if available
+bool tlv320adc5120_pop(uint8_t *out, size_t len); // copy one block (len >= block_bytes) if available
+
+// Zero-copy ring access. Leases must be released in the order they were acquired.
+bool tlv320adc5120_acquire(tlv320adc5120_block_t *out); // lease the next block if available
+void tlv320adc5120_release(const tlv320adc5120_block_t *blk); // return the oldest lease to the ring
+void tlv320adc5120_get_ring_stats(ring_stats_t *out); // overrun / occupancy counters
+void tlv320adc5120_set_consumer(TaskHandle_t task); // notified from the DMA ISR per block
 
 
 
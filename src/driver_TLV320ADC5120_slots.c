@@ -0,0 +1,27 @@
+#include "driver_TLV320ADC5120_slots.h"
+
+#include <stddef.h>
+
+tlv320adc5120_slots_t tlv320adc5120_slot_plan(uint32_t dev_count, const uint8_t *dev_ch, uint32_t ch_count,
+    uint32_t sample_rate_hz, uint8_t slot0[TLV_MAX_DEVS], uint32_t *frame_slots
+) {
+    if (!dev_ch || dev_count == 0 || dev_count > TLV_MAX_DEVS) return TLV_SLOTS_BAD_DEV;
+    if (ch_count == 0 || ch_count > TLV_MAX_CH) return TLV_SLOTS_BAD_COUNT;
+
+    if (ch_count == 2 && dev_count == 1) {
+        // I2S stereo: CH1 left, CH2 right
+        slot0[0] = 0;
+        *frame_slots = 2;
+    } else {
+        uint32_t next = 0;
+        for (uint32_t i = 0; i < dev_count; ++i) {
+            if (dev_ch[i] == 0 || dev_ch[i] > TLV_DEV_CH) return TLV_SLOTS_BAD_DEV;
+            slot0[i] = (uint8_t)next;
+            next += dev_ch[i];
+        }
+        if (next != ch_count) return TLV_SLOTS_BAD_COUNT;
+        *frame_slots = (next + 3) & ~3u; // whole 4-slot groups keep MCLK a standard multiple
+    }
+    if ((uint64_t)sample_rate_hz * *frame_slots * 32 > TLV_BCLK_MAX_HZ) return TLV_SLOTS_BCLK;
+    return TLV_SLOTS_OK;
+}
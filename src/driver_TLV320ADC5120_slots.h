@@ -0,0 +1,44 @@
+#ifndef DRIVER_TLV320ADC5120_SLOTS_H
+#define DRIVER_TLV320ADC5120_SLOTS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* TDM slot planning for several TLV320ADC5120s on one data line.
+
+ Each device drives its CH1..CHn in consecutive slots, in device order, so the
+ ring's channel order is device by device with each device's inputs ascending.
+ The gain merge relies on that: CH1 / CH2 and CH3 / CH4 of one device land in
+ adjacent ring channels whenever every device runs an even channel count.
+
+ No ESP-IDF dependencies; builds on Linux. tlv320adc5120_slot_alloc() wraps it
+ for the driver and maps the result to esp_err_t. */
+
+// Several ADCs can share the I2C bus and one TDM data line (SDOUTs tied together),
+// each driving its own run of slots. Addresses are strap-selected, 0x4C..0x4F.
+#define TLV_MAX_DEVS            4
+#define TLV_DEV_CH              4           // ADC channels per device
+#define TLV_MAX_CH              16          // ESP32-S3 TDM slot limit
+#define TLV_BCLK_MAX_HZ         24576000    // ADC ASI limit: fs x frame slots x 32
+
+typedef enum {
+    TLV_SLOTS_OK = 0,
+    TLV_SLOTS_BAD_DEV,      // no devices, too many, or a device with 0 / more than TLV_DEV_CH channels
+    TLV_SLOTS_BAD_COUNT,    // ch_count isn't the sum of dev_ch, or exceeds TLV_MAX_CH
+    TLV_SLOTS_BCLK,         // fs x frame slots x 32 above TLV_BCLK_MAX_HZ
+} tlv320adc5120_slots_t;
+
+/* One device with ch_count 2 is I2S stereo (CH1 left, CH2 right, 2 slots);
+   otherwise TDM, with the frame rounded up to whole 4-slot groups.
+   slot0[i]: first slot of device i; frame_slots: slots per frame on the wire. */
+tlv320adc5120_slots_t tlv320adc5120_slot_plan(uint32_t dev_count, const uint8_t *dev_ch, uint32_t ch_count,
+    uint32_t sample_rate_hz, uint8_t slot0[TLV_MAX_DEVS], uint32_t *frame_slots);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRIVER_TLV320ADC5120_SLOTS_H
@@ -0,0 +1,101 @@
+#include "dsp_biquad.h"
+
+#include <math.h>
+#include <string.h>
+
+#define Q31         2147483648.0
+#define Q31_MAX     (2147483647.0 / Q31)
+
+bool dsp_biquad_design(dsp_biquad_t *bq, dsp_bq_type_t type, double fs, double f0, double q) {
+    if (!bq) return false;
+    memset(bq, 0, sizeof(*bq));
+    if (type == DSP_BQ_ALLPASS) {
+        bq->b0 = 1.0;
+        return true;
+    }
+    if (!(fs > 0.0) || !(f0 > 0.0) || !(f0 < fs / 2) || !(q > 0.0)) {
+        return false;
+    }
+    const double w0 = 2.0 * M_PI * f0 / fs;
+    const double cw = cos(w0), alpha = sin(w0) / (2.0 * q);
+    const double a0 = 1.0 + alpha;
+    switch (type) {
+    case DSP_BQ_LPF:
+        bq->b0 = (1.0 - cw) / 2.0;
+        bq->b1 =  1.0 - cw;
+        bq->b2 = (1.0 - cw) / 2.0;
+        break;
+    case DSP_BQ_HPF:
+        bq->b0 =  (1.0 + cw) / 2.0;
+        bq->b1 = -(1.0 + cw);
+        bq->b2 =  (1.0 + cw) / 2.0;
+        break;
+    case DSP_BQ_NOTCH:
+        bq->b0 = 1.0;
+        bq->b1 = -2.0 * cw;
+        bq->b2 = 1.0;
+        break;
+    default:
+        return false;
+    }
+    bq->b0 /= a0;
+    bq->b1 /= a0;
+    bq->b2 /= a0;
+    bq->a1 = -2.0 * cw / a0;
+    bq->a2 = (1.0 - alpha) / a0;
+    return true;
+}
+
+/* Bilinear first-order high-pass with prewarped corner */
+bool dsp_iir1_hpf(dsp_iir1_t *f, double fs, double fc) {
+    if (!f || !(fs > 0.0) || fc < 0.0 || !(fc < fs / 2)) return false;
+    if (fc == 0.0) {
+        f->b0 = 1.0;
+        f->b1 = 0.0;
+        f->a1 = 0.0;
+        return true;
+    }
+    const double k = tan(M_PI * fc / fs);
+    f->b0 =  1.0 / (1.0 + k);
+    f->b1 = -f->b0;
+    f->a1 = (k - 1.0) / (k + 1.0);
+    return true;
+}
+
+static int32_t q31(double v) {
+    double r = round(v * Q31);
+    if (r > 2147483647.0) r = 2147483647.0;
+    if (r < -2147483648.0) r = -2147483648.0;
+    return (int32_t)r;
+}
+
+double dsp_biquad_regs(const dsp_biquad_t *bq, int32_t out[DSP_BQ_COEFS]) {
+    // N1 holds b1 / 2, so b1 may reach +-2
+    double peak = fmax(fabs(bq->b0), fmax(fabs(bq->b1) / 2.0, fabs(bq->b2)));
+    double k = (peak > Q31_MAX) ? Q31_MAX / peak : 1.0;
+    out[0] = q31(bq->b0 * k);
+    out[1] = q31(bq->b1 * k / 2.0);
+    out[2] = q31(bq->b2 * k);
+    out[3] = q31(-bq->a1 / 2.0);
+    out[4] = q31(-bq->a2);
+    return k;
+}
+
+double dsp_iir1_regs(const dsp_iir1_t *f, int32_t out[DSP_IIR1_COEFS]) {
+    double peak = fmax(fabs(f->b0), fabs(f->b1));
+    double k = (peak > Q31_MAX) ? Q31_MAX / peak : 1.0;
+    out[0] = q31(f->b0 * k);
+    out[1] = q31(f->b1 * k);
+    out[2] = q31(-f->a1);
+    return k;
+}
+
+double dsp_biquad_regs_mag(const int32_t r[DSP_BQ_COEFS], double fs, double f) {
+    const double w = 2.0 * M_PI * f / fs;
+    const double c1 = cos(w), s1 = sin(w), c2 = cos(2 * w), s2 = sin(2 * w);
+    const double n0 = r[0] / Q31, n1 = 2.0 * r[1] / Q31, n2 = r[2] / Q31;
+    const double d1 = -2.0 * r[3] / Q31, d2 = -(double)r[4] / Q31;
+    const double nr = n0 + n1 * c1 + n2 * c2, ni = -(n1 * s1 + n2 * s2);
+    const double dr = 1.0 + d1 * c1 + d2 * c2, di = -(d1 * s1 + d2 * s2);
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
@@ -0,0 +1,70 @@
+#ifndef DSP_BIQUAD_H
+#define DSP_BIQUAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Coefficient generator for the TLV320ADC5120/5140 programmable filters.
+
+ Designs are the RBJ audio-EQ cookbook forms, normalised so a0 = 1:
+    H(z) = (b0 + b1 z^-1 + b2 z^-2) / (1 + a1 z^-1 + a2 z^-2)
+
+ The ADC's biquads (12, pages 2-3) take five 32-bit two's-complement Q31
+ values, big-endian in the registers:
+    H(z) = (N0 + 2 N1 z^-1 + N2 z^-2) / (2^31 - 2 D1 z^-1 - D2 z^-2)
+    N0 = b0, N1 = b1 / 2, N2 = b2, D1 = -a1 / 2, D2 = -a2     (x 2^31)
+ and the first-order IIR (page 4, 0x48-0x53) three:
+    H(z) = (N0 + N1 z^-1) / (2^31 - D1 z^-1)
+
+ A numerator that does not fit Q31 is scaled down as a whole; the gain that
+ costs is returned so the caller can log or compensate it. Design in double,
+ so the same code serves as a host-side generator. No ESP-IDF dependencies;
+ builds on Linux. */
+
+#define DSP_BQ_COEFS        5
+#define DSP_IIR1_COEFS      3
+
+typedef enum {
+    DSP_BQ_ALLPASS = 0,     // N0 = 0x7FFFFFFF, rest 0: the ADC's reset value
+    DSP_BQ_LPF,
+    DSP_BQ_HPF,
+    DSP_BQ_NOTCH,
+} dsp_bq_type_t;
+
+typedef struct {
+    double b0, b1, b2, a1, a2;
+} dsp_biquad_t;
+
+typedef struct {
+    double b0, b1, a1;      // H(z) = (b0 + b1 z^-1) / (1 + a1 z^-1)
+} dsp_iir1_t;
+
+// f0: corner / centre (Hz), q: quality (0.7071 for Butterworth LPF / HPF)
+bool dsp_biquad_design(dsp_biquad_t *bq, dsp_bq_type_t type, double fs, double f0, double q);
+// First-order high-pass (DC removal); fc = 0 gives the all-pass reset value
+bool dsp_iir1_hpf(dsp_iir1_t *f, double fs, double fc);
+
+// Register values (N0, N1, N2, D1, D2 / N0, N1, D1); returns the numerator scale applied (1.0 if none)
+double dsp_biquad_regs(const dsp_biquad_t *bq, int32_t out[DSP_BQ_COEFS]);
+double dsp_iir1_regs(const dsp_iir1_t *f, int32_t out[DSP_IIR1_COEFS]);
+
+// |H(f)| of the quantised register values, for checks and logs
+double dsp_biquad_regs_mag(const int32_t regs[DSP_BQ_COEFS], double fs, double f);
+
+static inline void dsp_coef_be(int32_t v, uint8_t out[4]) {
+    const uint32_t u = (uint32_t)v;
+    out[0] = (uint8_t)(u >> 24);
+    out[1] = (uint8_t)(u >> 16);
+    out[2] = (uint8_t)(u >> 8);
+    out[3] = (uint8_t)u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_BIQUAD_H
@@ -0,0 +1,37 @@
+#include "dsp_charge.h"
+
+#include <string.h>
+
+bool dsp_charge_init(dsp_charge_t *q, uint32_t ch, uint32_t fs) {
+    if (!q || ch == 0 || ch > DSP_CHARGE_MAX_CH || fs == 0) {
+        return false;
+    }
+    memset(q, 0, sizeof(*q));
+    q->ch = ch;
+    q->fs = fs;
+    return true;
+}
+
+static inline void fold(dsp_charge_acc_t *a, int64_t sum, uint32_t fs) {
+    a->part  += sum;
+    a->whole += a->part / fs;
+    a->part  %= fs;
+}
+
+/* Channel-major so both running sums stay in registers; the positive half is a
+   select, not a branch, so the loop cost does not depend on the signal. */
+void dsp_charge_accumulate(dsp_charge_t *q, const int32_t *in, uint32_t frames) {
+    const uint32_t ch = q->ch;
+    for (uint32_t c = 0; c < ch; ++c) {
+        const int32_t *x = in + c;
+        int64_t sum = 0, pos = 0;
+        for (uint32_t i = 0; i < frames; ++i, x += ch) {
+            const int32_t v = *x;
+            sum += v;
+            pos += v > 0 ? v : 0;
+        }
+        fold(&q->net[c], sum, q->fs);
+        fold(&q->fwd[c], pos, q->fs);
+    }
+    q->frames += frames;
+}
@@ -0,0 +1,53 @@
+#ifndef DSP_CHARGE_H
+#define DSP_CHARGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exact charge integrators over interleaved 24-bit int32 samples.
+
+ Charge is kept in ADC counts x seconds as a whole part plus a remainder in
+ counts x samples, so nothing is ever rounded:
+
+    Q = whole + part / fs       (|part| < fs)
+    coulombs = Q * amps_per_lsb
+
+ A block sum is at most 2^23 x frames, and the remainder is folded into the
+ whole part once per block, so neither int64 can overflow: at full scale the
+ whole part takes ~35000 years to wrap. Alongside the net charge, the positive
+ half (forward charge) is integrated the same way; reverse = forward - net.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_CHARGE_MAX_CH   16
+
+typedef struct {
+    int64_t whole;          // counts x s
+    int64_t part;           // counts x samples, |part| < fs
+} dsp_charge_acc_t;
+
+typedef struct {
+    uint32_t ch;
+    uint32_t fs;            // samples per second
+    uint64_t frames;        // frames integrated
+    dsp_charge_acc_t net[DSP_CHARGE_MAX_CH];
+    dsp_charge_acc_t fwd[DSP_CHARGE_MAX_CH];   // positive samples only
+} dsp_charge_t;
+
+bool dsp_charge_init(dsp_charge_t *q, uint32_t ch, uint32_t fs);
+void dsp_charge_accumulate(dsp_charge_t *q, const int32_t *in, uint32_t frames);
+
+// counts x s; multiply by amps_per_lsb for coulombs
+static inline double dsp_charge_value(const dsp_charge_t *q, const dsp_charge_acc_t *a) {
+    return (double)a->whole + (double)a->part / q->fs;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_CHARGE_H
@@ -0,0 +1,180 @@
+#include "dsp_cic.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t dsp_cic_max_order(uint32_t ratio, uint32_t order) {
+    if (ratio == 0) {
+        return 0;
+    }
+    // Register growth: order * log2(ratio) bits on top of the 24-bit input
+    int64_t gain = 1;
+    uint32_t k = 0;
+    for (; k < order; ++k) {
+        if (gain > (INT64_MAX >> 24) / ratio) break;
+        gain *= ratio;
+    }
+    return k;
+}
+
+bool dsp_cic_init(dsp_cic_t *c, uint32_t ratio, uint32_t order, uint32_t ch, uint64_t *state) {
+    if (!c || !state || ratio == 0 || ch == 0 || order == 0 || order > DSP_CIC_MAX_ORDER
+    ||  dsp_cic_max_order(ratio, order) < order
+    ) {
+        return false;
+    }
+    int64_t gain = 1;
+    for (uint32_t k = 0; k < order; ++k) {
+        gain *= ratio;
+    }
+    c->ratio = ratio;
+    c->order = order;
+    c->ch    = ch;
+    c->gain  = gain;
+    c->integ = state;
+    c->comb  = state + (size_t)ch * order;
+    dsp_cic_reset(c);
+    return true;
+}
+
+void dsp_cic_reset(dsp_cic_t *c) {
+    memset(c->integ, 0, dsp_cic_state_len(c->order, c->ch) * sizeof(uint64_t));
+    c->phase = 0;
+}
+
+static inline int32_t div_round_sat24(int64_t y, int64_t g) {
+    int64_t q = (y >= 0 ? y + g / 2 : y - g / 2) / g;
+    if (q >  0x7FFFFF) q =  0x7FFFFF;
+    if (q < -0x800000) q = -0x800000;
+    return (int32_t)q;
+}
+
+uint32_t dsp_cic_process(dsp_cic_t *c, const int32_t *in, uint32_t in_frames, int32_t *out) {
+    const uint32_t N  = c->order;
+    const uint32_t ch = c->ch;
+    uint32_t produced = 0;
+
+    // Channel-major so each channel's integrators stay in registers across the block
+    for (uint32_t k = 0; k < ch; ++k) {
+        uint64_t integ[DSP_CIC_MAX_ORDER];
+        uint64_t *comb = c->comb + (size_t)k * N;
+        memcpy(integ, c->integ + (size_t)k * N, N * sizeof(uint64_t));
+
+        uint32_t phase = c->phase;
+        produced = 0;
+        for (uint32_t i = 0; i < in_frames; ++i) {
+            uint64_t x = (uint64_t)(int64_t)in[(size_t)i * ch + k];
+            for (uint32_t s = 0; s < N; ++s) {
+                integ[s] += x;
+                x = integ[s];
+            }
+            if (phase == 0) {
+                for (uint32_t s = 0; s < N; ++s) {
+                    uint64_t prev = comb[s];
+                    comb[s] = x;
+                    x -= prev;
+                }
+                out[(size_t)produced * ch + k] = div_round_sat24((int64_t)x, c->gain);
+                produced++;
+                phase = c->ratio;
+            }
+            phase--;
+        }
+
+        memcpy(c->integ + (size_t)k * N, integ, N * sizeof(uint64_t));
+        if (k == ch - 1) c->phase = phase;
+    }
+    return produced;
+}
+
+
+/* ---------- CIC + compensation FIR chain ---------- */
+
+static uint32_t chain_fir_ratio(uint32_t ratio) {
+    if (ratio <= 8) return ratio;
+    return (ratio % 4 == 0) ? 4 : (ratio % 2 == 0) ? 2 : 1;
+}
+
+bool dsp_decim_chain_valid(uint32_t ratio, uint32_t ch, uint32_t cic_order, uint32_t ntaps, float fc) {
+    if (ratio == 0 || ch == 0 || ntaps == 0) {
+        return false;
+    }
+    // The FIR's cutoff is relative to its own input rate
+    const float fir_fc = fc / chain_fir_ratio(ratio);
+    if (!(fir_fc > 0.0f && fir_fc < 0.5f)) {
+        return false;
+    }
+    return ratio <= 8 || (cic_order > 0 && cic_order <= DSP_CIC_MAX_ORDER);
+}
+
+bool dsp_decim_chain_create(dsp_decim_chain_t *d, uint32_t ratio, uint32_t ch,
+    uint32_t cic_order, uint32_t ntaps, float fc, uint32_t max_in_frames
+) {
+    if (!d || max_in_frames == 0 || !dsp_decim_chain_valid(ratio, ch, cic_order, ntaps, fc)) {
+        return false;
+    }
+    memset(d, 0, sizeof(*d));
+    d->ratio = ratio;
+    d->ch    = ch;
+    d->fir_ratio  = chain_fir_ratio(ratio);
+    d->cic_ratio  = ratio / d->fir_ratio;
+    if (d->cic_ratio > 1) {
+        // Fewer stages at very high ratios rather than overflow the integrators
+        cic_order = dsp_cic_max_order(d->cic_ratio, cic_order);
+    }
+    d->mid_frames = (d->cic_ratio > 1) ? max_in_frames / d->cic_ratio + 2 : 0;
+
+    // One allocation: taps | FIR delay lines | CIC output scratch | CIC state (8-byte aligned last)
+    size_t n32 = ntaps + dsp_fir_decim_state_len(ntaps, ch) + (size_t)d->mid_frames * ch;
+    n32 += n32 & 1;
+    size_t n64 = (d->cic_ratio > 1) ? dsp_cic_state_len(cic_order, ch) : 0;
+    d->mem = malloc(n32 * sizeof(int32_t) + n64 * sizeof(uint64_t));
+    if (!d->mem) {
+        return false;
+    }
+    int32_t *p = d->mem;
+    d->taps = p;  p += ntaps;
+    int32_t *dl = p;  p += dsp_fir_decim_state_len(ntaps, ch);
+    d->mid  = p;
+    uint64_t *cic_state = (uint64_t *)((int32_t *)d->mem + n32);
+
+    // The FIR sees the CIC output rate: fc (of the final rate) is fc / fir_ratio there
+    bool ok = (d->cic_ratio > 1)
+        ? dsp_cic_init(&d->cic, d->cic_ratio, cic_order, ch, cic_state)
+          && dsp_fir_design_cic_comp(d->taps, ntaps, fc / d->fir_ratio, d->cic_ratio, cic_order)
+        : dsp_fir_design_lowpass(d->taps, ntaps, fc / d->fir_ratio);
+    ok = ok && dsp_fir_decim_init(&d->fir, d->taps, ntaps, d->fir_ratio, ch, dl);
+    if (!ok) {
+        dsp_decim_chain_destroy(d);
+        return false;
+    }
+    return true;
+}
+
+void dsp_decim_chain_destroy(dsp_decim_chain_t *d) {
+    if (!d) return;
+    free(d->mem);
+    memset(d, 0, sizeof(*d));
+}
+
+void dsp_decim_chain_reset(dsp_decim_chain_t *d) {
+    if (d->cic_ratio > 1) dsp_cic_reset(&d->cic);
+    dsp_fir_decim_reset(&d->fir);
+}
+
+uint32_t dsp_decim_chain_process(dsp_decim_chain_t *d, const int32_t *in, uint32_t in_frames, int32_t *out) {
+    if (d->cic_ratio == 1) {
+        return dsp_fir_decim_process(&d->fir, in, in_frames, out);
+    }
+    uint32_t produced = 0;
+    // Chunk so the CIC output (at most ceil(n / cic_ratio) frames) always fits the scratch
+    const uint32_t chunk = (d->mid_frames - 1) * d->cic_ratio;
+    while (in_frames) {
+        uint32_t n = in_frames < chunk ? in_frames : chunk;
+        uint32_t m = dsp_cic_process(&d->cic, in, n, d->mid);
+        produced += dsp_fir_decim_process(&d->fir, d->mid, m, out + (size_t)produced * d->ch);
+        in += (size_t)n * d->ch;
+        in_frames -= n;
+    }
+    return produced;
+}
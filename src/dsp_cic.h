@@ -0,0 +1,94 @@
+#ifndef DSP_CIC_H
+#define DSP_CIC_H
+
+#include "dsp_fir_decim.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cascaded integrator-comb decimator (differential delay 1) for interleaved
+ multi-channel int32 samples, plus a decimation chain that follows it with a
+ droop-compensating FIR.
+
+ The CIC has no multiplies: order additions per input sample and order
+ subtractions per output. Registers are 64-bit and wrap modulo 2^64 (which the
+ comb stages undo), so order * log2(ratio) + 24 must fit in 63 bits, e.g.
+ order 4 up to ratio 861, order 3 up to 8191. The output is divided by the DC
+ gain ratio^order, so it is unity-gain 24-bit like the input.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_CIC_MAX_ORDER   6
+
+typedef struct {
+    uint32_t ratio;
+    uint32_t order;
+    uint32_t ch;
+    uint32_t phase;         // input frames until the next output (0 = next frame emits)
+    int64_t  gain;          // ratio^order
+    uint64_t *integ;        // ch x order integrators
+    uint64_t *comb;         // ch x order comb delays
+} dsp_cic_t;
+
+// uint64 words needed for integrator + comb state
+static inline size_t dsp_cic_state_len(uint32_t order, uint32_t ch) {
+    return (size_t)ch * order * 2;
+}
+
+// Highest order <= order whose register growth at ratio fits; 0 if ratio is 0
+uint32_t dsp_cic_max_order(uint32_t ratio, uint32_t order);
+
+bool dsp_cic_init(dsp_cic_t *c, uint32_t ratio, uint32_t order, uint32_t ch, uint64_t *state);
+void dsp_cic_reset(dsp_cic_t *c);
+
+// in: in_frames x ch, out: room for ceil(in_frames / ratio) frames. Returns frames written.
+uint32_t dsp_cic_process(dsp_cic_t *c, const int32_t *in, uint32_t in_frames, int32_t *out);
+
+
+/* ---------- CIC + compensation FIR chain ---------- */
+
+typedef struct {
+    uint32_t ratio;         // total = cic_ratio x fir_ratio
+    uint32_t cic_ratio;     // 1 = no CIC stage (short ratios go straight to the FIR)
+    uint32_t fir_ratio;
+    uint32_t ch;
+    dsp_cic_t       cic;
+    dsp_fir_decim_t fir;
+    int32_t  *taps;
+    int32_t  *mid;          // CIC output scratch
+    uint32_t  mid_frames;   // capacity of mid, in frames
+    void     *mem;          // single allocation backing all of the above
+} dsp_decim_chain_t;
+
+/* Split ratio into CIC x FIR stages and allocate. Ratios up to 8 use the FIR
+   alone; above that the CIC takes all but the last 4:1 (or 2:1) so the FIR runs
+   at no more than 4x the output rate. fc is the -6 dB point as a fraction of the
+   output rate; max_in_frames bounds the input frames per process() call.
+   cic_order is an upper bound: a CIC ratio too large for its registers at that
+   order runs at dsp_cic_max_order() instead (cic.order has the order used).
+   Returns false on a bad design (see dsp_decim_chain_valid) or allocation failure. */
+bool dsp_decim_chain_create(dsp_decim_chain_t *d, uint32_t ratio, uint32_t ch,
+    uint32_t cic_order, uint32_t ntaps, float fc, uint32_t max_in_frames);
+
+// Whether create() can build this chain, short of memory; no allocation
+bool dsp_decim_chain_valid(uint32_t ratio, uint32_t ch, uint32_t cic_order, uint32_t ntaps, float fc);
+void dsp_decim_chain_destroy(dsp_decim_chain_t *d);
+void dsp_decim_chain_reset(dsp_decim_chain_t *d);
+
+// Upper bound on output frames for in_frames input frames
+static inline uint32_t dsp_decim_chain_max_out(const dsp_decim_chain_t *d, uint32_t in_frames) {
+    return in_frames / d->ratio + 1;
+}
+
+uint32_t dsp_decim_chain_process(dsp_decim_chain_t *d, const int32_t *in, uint32_t in_frames, int32_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_CIC_H
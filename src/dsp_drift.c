@@ -0,0 +1,97 @@
+#include "dsp_drift.h"
+
+#include <math.h>
+#include <string.h>
+
+static void gains(double bw_hz, double T, double *b, double *c) {
+    double w = 2.0 * M_PI * bw_hz * T;
+    if (w > 0.5) w = 0.5; // keep the loop well damped for long blocks
+    *b = sqrt(2.0) * w;
+    *c = w * w;
+}
+
+bool dsp_drift_init(dsp_drift_t *d, uint32_t fs, uint32_t block_frames, float bw_hz) {
+    if (!d || fs == 0 || block_frames == 0 || !(bw_hz > 0.0f) || bw_hz > DSP_DRIFT_WIDE_HZ) {
+        return false;
+    }
+    memset(d, 0, sizeof(*d));
+    d->fs           = fs;
+    d->block_frames = block_frames;
+    d->nominal      = 1e6 * block_frames / fs;
+    d->settle       = (uint32_t)((uint64_t)DSP_DRIFT_SETTLE_S * fs / block_frames);
+    d->origin       = INT64_MIN; // set by the first block
+    gains(bw_hz, d->nominal * 1e-6, &d->b_narrow, &d->c_narrow);
+    dsp_drift_reset(d);
+    return true;
+}
+
+void dsp_drift_reset(dsp_drift_t *d) {
+    gains(DSP_DRIFT_WIDE_HZ, d->nominal * 1e-6, &d->b, &d->c);
+    d->blocks  = 0;
+    d->skipped = 0;
+}
+
+static void seed(dsp_drift_t *d, int64_t t_us) {
+    if (d->origin == INT64_MIN) {
+        d->origin = t_us;
+    }
+    // Keep a period learned before a reset; it is closer than nominal
+    if (!(d->period > 0.5 * d->nominal && d->period < 1.5 * d->nominal)) {
+        d->period = d->nominal;
+    }
+    d->t0 = (double)(t_us - d->origin);
+    d->t1 = d->t0 + d->period;
+    d->blocks  = 1;
+    d->skipped = 0;
+}
+
+void dsp_drift_update(dsp_drift_t *d, uint32_t blocks, int64_t t_us) {
+    if (blocks == 0) return;
+    d->frames += (uint64_t)blocks * d->block_frames;
+    if (d->blocks == 0) {
+        seed(d, t_us);
+        return;
+    }
+    // Blocks that never arrived: step the prediction over them
+    d->t1 += (double)(blocks - 1) * d->period;
+
+    const double e = (double)(t_us - d->origin) - d->t1;
+    if (fabs(e) > 0.5 * d->nominal) {
+        d->outliers++;
+        if (++d->skipped >= DSP_DRIFT_MAX_SKIP) {
+            d->reseeds++;
+            dsp_drift_reset(d);
+            seed(d, t_us);
+            return;
+        }
+        d->t0  = d->t1;
+        d->t1 += d->period;
+        return;
+    }
+    d->skipped = 0;
+    d->t0      = d->t1;
+    d->t1     += d->b * e + d->period;
+    d->period += d->c * e;
+
+    if (++d->blocks == d->settle + 1) {
+        d->b = d->b_narrow;
+        d->c = d->c_narrow;
+    }
+}
+
+double dsp_drift_rate_hz(const dsp_drift_t *d) {
+    return d->period > 0.0 ? 1e6 * d->block_frames / d->period : (double)d->fs;
+}
+
+int32_t dsp_drift_ppb(const dsp_drift_t *d) {
+    if (!(d->period > 0.0)) return 0;
+    double ppb = (d->nominal / d->period - 1.0) * 1e9;
+    if (ppb >  INT32_MAX) ppb =  INT32_MAX;
+    if (ppb < -INT32_MAX) ppb = -INT32_MAX;
+    return (int32_t)lrint(ppb);
+}
+
+int64_t dsp_drift_time_us(const dsp_drift_t *d, uint64_t frame) {
+    const double df = (double)(int64_t)(frame - d->frames);
+    return d->origin + (int64_t)llrint(d->t0 + df * d->period / d->block_frames);
+}
@@ -0,0 +1,84 @@
+#ifndef DSP_DRIFT_H
+#define DSP_DRIFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Effective sample rate from block arrival times: a second-order delay-locked
+ loop (F. Adriaensen, "Using a DLL to filter time") fed one timestamp per block.
+
+    e   = t - t1            error against the predicted arrival
+    t0  = t1                filtered time of this block
+    t1 += b e + period      predicted time of the next block
+    period += c e           filtered block period
+
+ with w = 2 pi B T (B loop bandwidth, T nominal block period), b = sqrt(2) w,
+ c = w^2. The loop starts wide (DSP_DRIFT_WIDE_HZ) to pull in quickly and
+ narrows to the configured bandwidth after DSP_DRIFT_SETTLE_S; arrival jitter
+ is attenuated by the loop, so the period (and hence the rate) resolves far
+ below one timestamp tick.
+
+ Arrivals more than half a block off the prediction (a backlog drained late,
+ a scheduling stall) are not fed to the loop, which coasts on its prediction;
+ DSP_DRIFT_MAX_SKIP of them in a row reseed it. Blocks that never arrived
+ (ring drops) are passed as the block count so the frame count stays exact.
+
+ The rate is in frames per second of whatever clock stamps the blocks; the
+ caller converts that to a disciplined time base.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_DRIFT_WIDE_HZ   1.0     // pull-in bandwidth
+#define DSP_DRIFT_SETTLE_S  10      // seconds at the pull-in bandwidth
+#define DSP_DRIFT_MAX_SKIP  32      // consecutive outliers before reseeding
+
+typedef struct {
+    uint32_t fs;            // nominal frames per second
+    uint32_t block_frames;
+    double   nominal;       // nominal block period, us
+    double   b, c;          // loop gains in use
+    double   b_narrow, c_narrow;
+    uint32_t settle;        // blocks until the loop narrows
+
+    int64_t  origin;        // timestamps are kept relative to the first one, us
+    double   t0;            // filtered time of the last block
+    double   t1;            // predicted time of the next block
+    double   period;        // filtered block period, us
+    uint64_t frames;        // frames up to the end of the last block
+    uint32_t blocks;        // blocks since (re)seeding
+    uint32_t skipped;       // consecutive outliers
+    uint32_t outliers;      // outliers since init
+    uint32_t reseeds;       // reseeds since init
+} dsp_drift_t;
+
+bool dsp_drift_init(dsp_drift_t *d, uint32_t fs, uint32_t block_frames, float bw_hz);
+
+// Forget the phase and start pulling in again (after the stream stopped)
+void dsp_drift_reset(dsp_drift_t *d);
+
+// A block completed at t_us; blocks = blocks since the previous call (> 1 across drops)
+void dsp_drift_update(dsp_drift_t *d, uint32_t blocks, int64_t t_us);
+
+// The loop has narrowed; rate and ppb are meaningful
+static inline bool dsp_drift_locked(const dsp_drift_t *d) {
+    return d->blocks > d->settle;
+}
+
+// Frames per second of the timestamp clock
+double dsp_drift_rate_hz(const dsp_drift_t *d);
+
+// Rate error against nominal, parts per billion
+int32_t dsp_drift_ppb(const dsp_drift_t *d);
+
+// Filtered time at which a frame (counted from the first block) completed
+int64_t dsp_drift_time_us(const dsp_drift_t *d, uint64_t frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_DRIFT_H
@@ -0,0 +1,155 @@
+#include "dsp_fft.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static float window_at(dsp_window_t win, uint32_t i, uint32_t n) {
+    const double t = 2.0 * M_PI * i / n; // periodic form, right for overlapped frames
+    switch (win) {
+    case DSP_WIN_HANN:     return (float)(0.5 - 0.5 * cos(t));
+    case DSP_WIN_HAMMING:  return (float)(0.54 - 0.46 * cos(t));
+    case DSP_WIN_BLACKMAN: return (float)(0.42 - 0.5 * cos(t) + 0.08 * cos(2.0 * t));
+    case DSP_WIN_RECT:
+    default:               return 1.0f;
+    }
+}
+
+bool dsp_rfft_create(dsp_rfft_t *f, uint32_t n, dsp_window_t win) {
+    if (!f || n < DSP_FFT_MIN_N || n > DSP_FFT_MAX_N || (n & (n - 1)) != 0) {
+        return false;
+    }
+    memset(f, 0, sizeof(*f));
+    const uint32_t m = n / 2;
+    const uint32_t ntw = 3 * n / 4; // radix-4 passes reach W^3k, k < N/4
+    f->mem = malloc((size_t)ntw * 2 * sizeof(float) + (size_t)n * sizeof(float) + (size_t)m * sizeof(uint16_t));
+    if (!f->mem) {
+        return false;
+    }
+    f->n   = n;
+    f->tw  = (float *)f->mem;
+    f->win = f->tw + 2 * ntw;
+    f->rev = (uint16_t *)(f->win + n);
+
+    uint32_t bits = 0;
+    while ((1u << bits) < m) bits++;
+    f->log2_half = bits;
+
+    for (uint32_t k = 0; k < ntw; ++k) {
+        f->tw[2 * k + 0] = (float)cos(2.0 * M_PI * k / n);
+        f->tw[2 * k + 1] = (float)-sin(2.0 * M_PI * k / n);
+    }
+    for (uint32_t k = 0; k < m; ++k) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; ++b) r |= ((k >> b) & 1u) << (bits - 1 - b);
+        f->rev[k] = (uint16_t)r;
+    }
+    double pow = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        f->win[i] = window_at(win, i, n);
+        pow += (double)f->win[i] * f->win[i];
+    }
+    f->win_pow = (float)pow;
+    return true;
+}
+
+void dsp_rfft_destroy(dsp_rfft_t *f) {
+    free(f->mem);
+    memset(f, 0, sizeof(*f));
+}
+
+/* z holds m = N/2 complex points in bit-reversed order on entry.
+   W_L^k = tw[k * (N / L)], since tw is e^(-2 pi i k / N). */
+void dsp_cfft_radix4(const dsp_rfft_t *f, float *z) {
+    const uint32_t m = f->n / 2;
+    const float *tw = f->tw;
+    uint32_t len = 1;
+
+    if (f->log2_half & 1) {
+        for (uint32_t i = 0; i < m; i += 2) {
+            float *a = z + 2 * i, *b = a + 2;
+            const float br = b[0], bi = b[1];
+            b[0] = a[0] - br; b[1] = a[1] - bi;
+            a[0] += br;       a[1] += bi;
+        }
+        len = 2;
+    }
+
+    /* Radix-4 pass: four sub-blocks of size q = len in bit-reversed order hold
+       residues 0, 2, 1, 3 (mod 4) of the new block of size L = 4q:
+        X[k]    = (A0 + W^2k A1) + (W^k A2 + W^3k A3)
+        X[k+2q] = (A0 + W^2k A1) - (W^k A2 + W^3k A3)
+        X[k+q]  = (A0 - W^2k A1) - j (W^k A2 - W^3k A3)
+        X[k+3q] = (A0 - W^2k A1) + j (W^k A2 - W^3k A3) */
+    for (; len < m; len *= 4) {
+        const uint32_t q = len, L = 4 * q;
+        const uint32_t step = f->n / L; // tw index stride for W_L^1
+        for (uint32_t base = 0; base < m; base += L) {
+            float *p0 = z + 2 * base;
+            float *p1 = p0 + 2 * q, *p2 = p1 + 2 * q, *p3 = p2 + 2 * q;
+            for (uint32_t k = 0; k < q; ++k) {
+                const float *w1 = tw + 2 * (k * step);
+                const float *w2 = tw + 2 * (2 * k * step);
+                const float *w3 = tw + 2 * (3 * k * step);
+
+                const float a0r = p0[2 * k], a0i = p0[2 * k + 1];
+                const float x1r = p1[2 * k], x1i = p1[2 * k + 1];
+                const float x2r = p2[2 * k], x2i = p2[2 * k + 1];
+                const float x3r = p3[2 * k], x3i = p3[2 * k + 1];
+
+                // t1 = W^2k A1, t2 = W^k A2, t3 = W^3k A3
+                const float t1r = x1r * w2[0] - x1i * w2[1], t1i = x1r * w2[1] + x1i * w2[0];
+                const float t2r = x2r * w1[0] - x2i * w1[1], t2i = x2r * w1[1] + x2i * w1[0];
+                const float t3r = x3r * w3[0] - x3i * w3[1], t3i = x3r * w3[1] + x3i * w3[0];
+
+                const float s0r = a0r + t1r, s0i = a0i + t1i;
+                const float d0r = a0r - t1r, d0i = a0i - t1i;
+                const float s1r = t2r + t3r, s1i = t2i + t3i;
+                const float d1r = t2r - t3r, d1i = t2i - t3i;
+
+                p0[2 * k] = s0r + s1r; p0[2 * k + 1] = s0i + s1i;
+                p2[2 * k] = s0r - s1r; p2[2 * k + 1] = s0i - s1i;
+                // -j * d1 = (d1i, -d1r); +j * d1 = (-d1i, d1r)
+                p1[2 * k] = d0r + d1i; p1[2 * k + 1] = d0i - d1r;
+                p3[2 * k] = d0r - d1i; p3[2 * k + 1] = d0i + d1r;
+            }
+        }
+    }
+}
+
+void dsp_rfft_power(const dsp_rfft_t *f, const float *x, float *work, float *out) {
+    const uint32_t n = f->n, m = n / 2;
+    const float *w = f->win;
+
+    // Pack even/odd samples as one complex sequence, windowed and bit-reversed
+    for (uint32_t i = 0; i < m; ++i) {
+        const uint32_t r = f->rev[i];
+        work[2 * r + 0] = x[2 * i + 0] * w[2 * i + 0];
+        work[2 * r + 1] = x[2 * i + 1] * w[2 * i + 1];
+    }
+    dsp_cfft_radix4(f, work);
+
+    /* Split: X[k] = E[k] + W_N^k O[k], with
+       E = (Z[k] + conj Z[m-k]) / 2,  O = (Z[k] - conj Z[m-k]) / 2j
+       One-sided power, doubled except at DC and Nyquist, over N * sum(w^2). */
+    const float scale = 1.0f / ((float)n * f->win_pow);
+    const float z0r = work[0], z0i = work[1];
+    out[0] = (z0r + z0i) * (z0r + z0i) * scale;
+    out[m] = (z0r - z0i) * (z0r - z0i) * scale;
+    for (uint32_t k = 1; k < m; ++k) {
+        const float zr = work[2 * k], zi = work[2 * k + 1];
+        const float cr = work[2 * (m - k)], ci = -work[2 * (m - k) + 1];
+        const float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);
+        const float dr = 0.5f * (zr - cr), di = 0.5f * (zi - ci);
+        // O = d / j = (di, -dr)
+        const float or_ = di, oi = -dr;
+        const float twr = f->tw[2 * k], twi = f->tw[2 * k + 1];
+        const float xr = er + or_ * twr - oi * twi;
+        const float xi = ei + or_ * twi + oi * twr;
+        out[k] = 2.0f * (xr * xr + xi * xi) * scale;
+    }
+}
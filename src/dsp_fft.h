@@ -0,0 +1,60 @@
+#ifndef DSP_FFT_H
+#define DSP_FFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Real FFT (N = 256 .. 4096, power of two) built on an N/2-point complex
+ radix-4 FFT plus the standard split step.
+
+ The complex FFT is iterative decimation-in-time on bit-reversed input; every
+ pair of radix-2 stages is done as one radix-4 pass (3 complex multiplies per
+ 4 points instead of 4). When log2(N/2) is odd, one radix-2 pass goes first.
+ One table of e^(-2 pi i k / N), k < 3N/4, serves both the complex passes and
+ the split.
+
+ Float32 throughout: the S3 has a single-precision FPU with fused multiply-add
+ but no float SIMD, so this is scalar C and the same code runs on Linux.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_FFT_MIN_N   256
+#define DSP_FFT_MAX_N   4096
+
+typedef enum {
+    DSP_WIN_RECT = 0,
+    DSP_WIN_HANN,
+    DSP_WIN_HAMMING,
+    DSP_WIN_BLACKMAN,
+} dsp_window_t;
+
+typedef struct {
+    uint32_t n;
+    uint32_t log2_half;     // log2(N / 2)
+    float   *tw;            // 3N/4 complex twiddles (re, im interleaved)
+    uint16_t *rev;          // bit-reversal permutation of N/2
+    float   *win;           // N window samples
+    float    win_pow;       // sum of window^2
+    void    *mem;           // single allocation backing all of the above
+} dsp_rfft_t;
+
+bool dsp_rfft_create(dsp_rfft_t *f, uint32_t n, dsp_window_t win);
+void dsp_rfft_destroy(dsp_rfft_t *f);
+
+/* Windowed real FFT of x (N samples, not modified).
+   work: N floats. out: N/2 + 1 one-sided powers, scaled so that their sum is
+   the mean square of the windowed-normalised input (Parseval). */
+void dsp_rfft_power(const dsp_rfft_t *f, const float *x, float *work, float *out);
+
+// In-place N/2-point complex FFT (exposed for benchmarking)
+void dsp_cfft_radix4(const dsp_rfft_t *f, float *z);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_FFT_H
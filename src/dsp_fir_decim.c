@@ -0,0 +1,159 @@
+#include "dsp_fir_decim.h"
+
+#include <math.h>
+#include <string.h>
+
+bool dsp_fir_decim_init(dsp_fir_decim_t *f, const int32_t *taps, uint32_t ntaps,
+    uint32_t ratio, uint32_t ch, int32_t *state
+) {
+    if (!f || !taps || !state || ntaps == 0 || ratio == 0 || ch == 0) {
+        return false;
+    }
+    f->taps  = taps;
+    f->ntaps = ntaps;
+    f->ratio = ratio;
+    f->ch    = ch;
+    f->dl    = state;
+    dsp_fir_decim_reset(f);
+    return true;
+}
+
+void dsp_fir_decim_reset(dsp_fir_decim_t *f) {
+    memset(f->dl, 0, dsp_fir_decim_state_len(f->ntaps, f->ch) * sizeof(int32_t));
+    f->pos   = 0;
+    f->phase = 0;
+}
+
+static inline int32_t round_sat24(int64_t acc) {
+    acc = (acc + (1LL << 30)) >> 31;
+    if (acc >  0x7FFFFF) acc =  0x7FFFFF;
+    if (acc < -0x800000) acc = -0x800000;
+    return (int32_t)acc;
+}
+
+/* x: ntaps samples, oldest first; h: taps in the same order (time-reversed
+   impulse response; symmetric designs are their own reverse).
+   Unrolled by 4: the S3 has no wide 32x32 MAC (PIE lanes are 8/16-bit), so
+   this is MULL/MULSH pairs feeding two independent accumulators. */
+static int64_t dot_q31(const int32_t *x, const int32_t *h, uint32_t n) {
+    int64_t a0 = 0, a1 = 0;
+    uint32_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        a0 += (int64_t)x[i + 0] * h[i + 0];
+        a1 += (int64_t)x[i + 1] * h[i + 1];
+        a0 += (int64_t)x[i + 2] * h[i + 2];
+        a1 += (int64_t)x[i + 3] * h[i + 3];
+    }
+    for (; i < n; ++i) {
+        a0 += (int64_t)x[i] * h[i];
+    }
+    return a0 + a1;
+}
+
+uint32_t dsp_fir_decim_process(dsp_fir_decim_t *f, const int32_t *in, uint32_t in_frames, int32_t *out) {
+    const uint32_t N  = f->ntaps;
+    const uint32_t ch = f->ch;
+    uint32_t produced = 0;
+
+    for (uint32_t i = 0; i < in_frames; ++i) {
+        // Each sample goes in twice (pos and pos + N), so the newest N samples are
+        // always contiguous at dl[pos + 1 .. pos + N] without any wrap handling.
+        uint32_t pos = f->pos;
+        for (uint32_t c = 0; c < ch; ++c) {
+            int32_t *dl = f->dl + (size_t)c * 2 * N;
+            dl[pos] = dl[pos + N] = in[(size_t)i * ch + c];
+        }
+        f->pos = (pos + 1 == N) ? 0 : pos + 1;
+
+        if (f->phase == 0) {
+            for (uint32_t c = 0; c < ch; ++c) {
+                const int32_t *win = f->dl + (size_t)c * 2 * N + pos + 1; // oldest .. newest
+                out[(size_t)produced * ch + c] = round_sat24(dot_q31(win, f->taps, N));
+            }
+            produced++;
+            f->phase = f->ratio;
+        }
+        f->phase--;
+    }
+    return produced;
+}
+
+static double blackman(uint32_t i, uint32_t ntaps) {
+    const double PI = 3.14159265358979323846;
+    if (ntaps == 1) return 1.0;
+    double x = (double)i / (ntaps - 1);
+    return 0.42 - 0.5 * cos(2.0 * PI * x) + 0.08 * cos(4.0 * PI * x);
+}
+
+/* Normalise a prototype to unity DC gain and quantise to Q31. The rounding
+   residue goes on the centre tap so the taps sum to exactly 1.0 (no DC gain
+   error on the shunt signal). Init-time only; the prototype is evaluated twice
+   rather than buffered to keep it off the stack. */
+typedef double (*proto_fn_t)(uint32_t i, uint32_t ntaps, const void *ctx);
+
+static void quantise_unity_dc(int32_t *taps, uint32_t ntaps, proto_fn_t proto, const void *ctx) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < ntaps; ++i) {
+        sum += proto(i, ntaps, ctx);
+    }
+    int64_t qsum = 0;
+    for (uint32_t i = 0; i < ntaps; ++i) {
+        taps[i] = (int32_t)lrint(proto(i, ntaps, ctx) / sum * 2147483648.0);
+        qsum += taps[i];
+    }
+    taps[ntaps / 2] += (int32_t)((1LL << 31) - qsum);
+}
+
+static double lowpass_proto(uint32_t i, uint32_t ntaps, const void *ctx) {
+    const double PI = 3.14159265358979323846;
+    const double fc = *(const float *)ctx;
+    double t = i - (ntaps - 1) / 2.0;
+    double sinc = (t == 0.0) ? 2.0 * fc : sin(2.0 * PI * fc * t) / (PI * t);
+    return sinc * blackman(i, ntaps);
+}
+
+bool dsp_fir_design_lowpass(int32_t *taps, uint32_t ntaps, float fc) {
+    if (!taps || ntaps == 0 || !(fc > 0.0f && fc < 0.5f)) {
+        return false;
+    }
+    quantise_unity_dc(taps, ntaps, lowpass_proto, &fc);
+    return true;
+}
+
+typedef struct {
+    double   fc;
+    uint32_t cic_ratio;
+    uint32_t cic_order;
+} cic_comp_ctx_t;
+
+// CIC magnitude at f (fraction of the CIC output rate)
+static double cic_mag(double f, uint32_t R, uint32_t N) {
+    const double PI = 3.14159265358979323846;
+    if (f == 0.0) return 1.0;
+    return pow(fabs(sin(PI * f) / (R * sin(PI * f / R))), N);
+}
+
+/* Windowed inverse transform of D(f) = 1 / H_cic(f) on [0, fc], 0 above:
+   h(t) = 2 * integral_0^fc D(f) cos(2 pi f t) df, by the midpoint rule */
+static double cic_comp_proto(uint32_t i, uint32_t ntaps, const void *ctx) {
+    const double PI = 3.14159265358979323846;
+    const cic_comp_ctx_t *c = ctx;
+    const int steps = 128;
+    const double df = c->fc / steps;
+    double t = i - (ntaps - 1) / 2.0;
+    double acc = 0.0;
+    for (int k = 0; k < steps; ++k) {
+        double f = (k + 0.5) * df;
+        acc += cos(2.0 * PI * f * t) / cic_mag(f, c->cic_ratio, c->cic_order);
+    }
+    return 2.0 * acc * df * blackman(i, ntaps);
+}
+
+bool dsp_fir_design_cic_comp(int32_t *taps, uint32_t ntaps, float fc, uint32_t cic_ratio, uint32_t cic_order) {
+    if (!taps || ntaps == 0 || !(fc > 0.0f && fc < 0.5f) || cic_ratio == 0 || cic_order == 0) {
+        return false;
+    }
+    cic_comp_ctx_t ctx = { .fc = fc, .cic_ratio = cic_ratio, .cic_order = cic_order };
+    quantise_unity_dc(taps, ntaps, cic_comp_proto, &ctx);
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef DSP_FIR_DECIM_H
+#define DSP_FIR_DECIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Streaming FIR decimator for interleaved multi-channel int32 samples.
+
+ Polyphase in the computational sense: the filter is only evaluated at the
+ retained output instants, so each output costs ntaps MACs (ntaps / ratio per
+ input sample) and nothing is computed for discarded samples. Filter state and
+ decimation phase carry across calls, so blocks can be any length and block
+ boundaries are invisible in the output.
+
+ Taps are Q31, inputs are sign-extended 24-bit values in int32; the inner loop
+ accumulates in 64 bits and rounds back to 24 bits with saturation.
+
+ No ESP-IDF dependencies; builds on Linux as the reference implementation. */
+
+typedef struct {
+    const int32_t *taps;    // ntaps Q31 coefficients (caller-owned)
+    uint32_t ntaps;
+    uint32_t ratio;         // keep 1 of every ratio input frames
+    uint32_t ch;            // interleaved channels
+    uint32_t phase;         // input frames until the next output (0 = next frame emits)
+    uint32_t pos;           // delay-line write index, 0..ntaps-1
+    int32_t *dl;            // ch x 2*ntaps delay lines (caller-owned, see dsp_fir_decim_state_len)
+} dsp_fir_decim_t;
+
+// int32 words needed for the delay lines
+static inline size_t dsp_fir_decim_state_len(uint32_t ntaps, uint32_t ch) {
+    return (size_t)ch * 2 * ntaps;
+}
+
+bool dsp_fir_decim_init(dsp_fir_decim_t *f, const int32_t *taps, uint32_t ntaps,
+    uint32_t ratio, uint32_t ch, int32_t *state);
+void dsp_fir_decim_reset(dsp_fir_decim_t *f);
+
+// Upper bound on output frames for in_frames input frames
+static inline uint32_t dsp_fir_decim_max_out(const dsp_fir_decim_t *f, uint32_t in_frames) {
+    return (in_frames + f->ratio - 1) / f->ratio;
+}
+
+// in: in_frames x ch, out: room for dsp_fir_decim_max_out() frames. Returns frames written.
+uint32_t dsp_fir_decim_process(dsp_fir_decim_t *f, const int32_t *in, uint32_t in_frames, int32_t *out);
+
+/* Windowed-sinc (Blackman) low-pass, unity DC gain, Q31.
+   fc: -6 dB cutoff as a fraction of the input rate (0 < fc < 0.5).
+   Blackman gives ~74 dB stopband; transition width is about 5.5 / ntaps. */
+bool dsp_fir_design_lowpass(int32_t *taps, uint32_t ntaps, float fc);
+
+/* Low-pass that also flattens the passband droop of a preceding CIC stage
+   (order cic_order, ratio cic_ratio). fc is relative to the CIC output rate,
+   which is this filter's input rate. */
+bool dsp_fir_design_cic_comp(int32_t *taps, uint32_t ntaps, float fc, uint32_t cic_ratio, uint32_t cic_order);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_FIR_DECIM_H
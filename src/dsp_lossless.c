@@ -0,0 +1,384 @@
+#include "dsp_lossless.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+enum { KIND_FIXED = 0, KIND_LPC = 1, KIND_VERBATIM = 2 };
+
+#define SAMPLE_BITS     24
+#define LPC_PREC        14      // coefficient bits
+#define RICE_ESCAPE     31
+#define RESID_LIMIT     (1 << 30)
+
+/* ---------- bit I/O ---------- */
+
+typedef struct {
+    uint8_t *p;
+    uint64_t acc;
+    uint32_t n;
+} bw_t;
+
+static inline void bw_put(bw_t *b, uint32_t v, uint32_t bits) {
+    if (bits == 0) return;
+    b->acc = (b->acc << bits) | (bits < 32 ? (v & ((1u << bits) - 1)) : v);
+    b->n += bits;
+    while (b->n >= 8) {
+        b->n -= 8;
+        *b->p++ = (uint8_t)(b->acc >> b->n);
+    }
+}
+
+static inline void bw_unary(bw_t *b, uint32_t q) {
+    while (q >= 32) { bw_put(b, 0, 32); q -= 32; }
+    bw_put(b, 1, q + 1);
+}
+
+static void bw_flush(bw_t *b) {
+    if (b->n) bw_put(b, 0, 8 - b->n);
+}
+
+typedef struct {
+    const uint8_t *p, *end;
+    uint64_t acc;
+    uint32_t n;
+    bool err;
+} br_t;
+
+static inline uint32_t br_get(br_t *b, uint32_t bits) {
+    if (bits == 0) return 0;
+    while (b->n < bits) {
+        if (b->p == b->end) { b->err = true; return 0; }
+        b->acc = (b->acc << 8) | *b->p++;
+        b->n += 8;
+    }
+    b->n -= bits;
+    uint32_t v = (uint32_t)(b->acc >> b->n) & (bits < 32 ? ((1u << bits) - 1) : 0xFFFFFFFFu);
+    b->acc &= ((uint64_t)1 << b->n) - 1;
+    return v;
+}
+
+static inline int32_t br_signed(br_t *b, uint32_t bits) {
+    uint32_t v = br_get(b, bits);
+    if (bits == 0) return 0;
+    return (int32_t)(v << (32 - bits)) >> (32 - bits);
+}
+
+static inline uint32_t br_unary(br_t *b) {
+    uint32_t q = 0;
+    while (!b->err && br_get(b, 1) == 0) q++;
+    return q;
+}
+
+static inline uint32_t zigzag(int32_t r) { return ((uint32_t)r << 1) ^ (uint32_t)(r >> 31); }
+static inline int32_t unzigzag(uint32_t u) { return (int32_t)(u >> 1) ^ -(int32_t)(u & 1); }
+
+/* ---------- predictors ---------- */
+
+static void fixed_residual(const int32_t *x, uint32_t n, uint32_t order, int32_t *r) {
+    for (uint32_t i = order; i < n; ++i) {
+        int64_t p;
+        switch (order) {
+        case 0:  p = 0; break;
+        case 1:  p = x[i - 1]; break;
+        case 2:  p = 2 * (int64_t)x[i - 1] - x[i - 2]; break;
+        case 3:  p = 3 * (int64_t)x[i - 1] - 3 * (int64_t)x[i - 2] + x[i - 3]; break;
+        default: p = 4 * (int64_t)x[i - 1] - 6 * (int64_t)x[i - 2] + 4 * (int64_t)x[i - 3] - x[i - 4]; break;
+        }
+        r[i] = (int32_t)(x[i] - p);
+    }
+}
+
+static void fixed_restore(int32_t *x, uint32_t n, uint32_t order) {
+    for (uint32_t i = order; i < n; ++i) {
+        int64_t p;
+        switch (order) {
+        case 0:  p = 0; break;
+        case 1:  p = x[i - 1]; break;
+        case 2:  p = 2 * (int64_t)x[i - 1] - x[i - 2]; break;
+        case 3:  p = 3 * (int64_t)x[i - 1] - 3 * (int64_t)x[i - 2] + x[i - 3]; break;
+        default: p = 4 * (int64_t)x[i - 1] - 6 * (int64_t)x[i - 2] + 4 * (int64_t)x[i - 3] - x[i - 4]; break;
+        }
+        x[i] = (int32_t)(x[i] + p); // x[i] holds the residual on entry
+    }
+}
+
+static inline int64_t lpc_predict(const int32_t *x, uint32_t i, const int32_t *q, uint32_t order, uint32_t shift) {
+    int64_t acc = 0;
+    for (uint32_t j = 0; j < order; ++j) acc += (int64_t)q[j] * x[i - 1 - j];
+    return acc >> shift;
+}
+
+// false if a residual would not fit the coder
+static bool lpc_residual(const int32_t *x, uint32_t n, const int32_t *q, uint32_t order, uint32_t shift, int32_t *r) {
+    for (uint32_t i = order; i < n; ++i) {
+        int64_t e = x[i] - lpc_predict(x, i, q, order, shift);
+        if (e >= RESID_LIMIT || e <= -RESID_LIMIT) return false;
+        r[i] = (int32_t)e;
+    }
+    return true;
+}
+
+/* Levinson-Durbin on the block autocorrelation, snapshotting the order 2, 4
+   and 8 solutions. Single precision on purpose: the S3 FPU has no doubles, and
+   the coefficients are quantised to LPC_PREC bits anyway. Returns the number
+   of usable orders (lpc[i] has order 2 << i). */
+static uint32_t lpc_analyze(const int32_t *x, uint32_t n, float lpc[3][DSP_LL_MAX_LPC]) {
+    float ac[DSP_LL_MAX_LPC + 1];
+    const float norm = 1.0f / (float)(1 << 23);
+    for (uint32_t l = 0; l <= DSP_LL_MAX_LPC; ++l) {
+        float s = 0.0f;
+        for (uint32_t i = l; i < n; ++i) s += ((float)x[i] * norm) * ((float)x[i - l] * norm);
+        ac[l] = s;
+    }
+    if (ac[0] <= 0.0f) return 0;
+    ac[0] *= 1.0f + 1e-5f; // white-noise floor keeps the recursion stable on near-singular blocks
+
+    float a[DSP_LL_MAX_LPC + 1] = {0}, tmp[DSP_LL_MAX_LPC + 1];
+    float err = ac[0];
+    uint32_t found = 0;
+    for (uint32_t m = 1; m <= DSP_LL_MAX_LPC; ++m) {
+        float k = ac[m];
+        for (uint32_t j = 1; j < m; ++j) k -= a[j] * ac[m - j];
+        k /= err;
+        memcpy(tmp, a, sizeof(a));
+        a[m] = k;
+        for (uint32_t j = 1; j < m; ++j) a[j] = tmp[j] - k * tmp[m - j];
+        err *= 1.0f - k * k;
+        if (!(err > 0.0f)) break;
+        if ((m & (m - 1)) == 0 && m >= 2) {
+            memcpy(lpc[found++], a + 1, m * sizeof(float));
+        }
+    }
+    return found;
+}
+
+// Quantise to LPC_PREC-bit Q(shift) coefficients; false if they cannot be represented
+static bool lpc_quantise(const float *a, uint32_t order, int32_t *q, uint32_t *shift) {
+    float amax = 0.0f;
+    for (uint32_t j = 0; j < order; ++j) if (fabsf(a[j]) > amax) amax = fabsf(a[j]);
+    if (amax == 0.0f) return false;
+    int sh = (int)(LPC_PREC - 1) - (int)ceilf(log2f(amax));
+    if (sh < 0) return false;
+    if (sh > 31) sh = 31;
+    const int32_t qmax = (1 << (LPC_PREC - 1)) - 1;
+    for (uint32_t j = 0; j < order; ++j) {
+        long v = lroundf(a[j] * (float)(1u << sh));
+        if (v > qmax) v = qmax;
+        if (v < -qmax - 1) v = -qmax - 1;
+        q[j] = (int32_t)v;
+    }
+    *shift = (uint32_t)sh;
+    return true;
+}
+
+/* ---------- Rice ---------- */
+
+static inline uint32_t rice_k(uint64_t sum, uint32_t n) {
+    uint32_t k = 0;
+    if (n == 0) return 0;
+    while (k < RICE_ESCAPE - 1 && ((uint64_t)n << (k + 1)) <= sum) k++;
+    return k;
+}
+
+static inline uint64_t rice_bits_est(uint64_t sum, uint32_t n, uint32_t k) {
+    return (uint64_t)n * (k + 1) + (sum >> k);
+}
+
+static uint64_t rice_bits_exact(const int32_t *r, uint32_t n, uint32_t k) {
+    uint64_t bits = (uint64_t)n * (k + 1);
+    for (uint32_t i = 0; i < n; ++i) bits += zigzag(r[i]) >> k;
+    return bits;
+}
+
+static uint32_t signed_width(const int32_t *r, uint32_t n) {
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; ++i) m |= (uint32_t)(r[i] ^ (r[i] >> 31));
+    uint32_t w = 0;
+    while (m) { w++; m >>= 1; }
+    return w ? w + 1 : 0;
+}
+
+// Estimated residual bits for r[order..n) at the best partition order
+static uint64_t residual_cost(const int32_t *r, uint32_t n, uint32_t order, uint32_t *part_order) {
+    uint32_t max_po = 0;
+    while (max_po < DSP_LL_MAX_PART && (n & ((2u << max_po) - 1)) == 0 && (n >> (max_po + 1)) > order) max_po++;
+
+    // zigzag sums at the finest partitioning, then pairwise merged for each coarser order
+    uint64_t sum[1u << DSP_LL_MAX_PART];
+    const uint32_t parts = 1u << max_po, ps = n >> max_po;
+    for (uint32_t p = 0; p < parts; ++p) {
+        const uint32_t lo = p == 0 ? order : p * ps, hi = (p + 1) * ps;
+        uint64_t s = 0;
+        for (uint32_t i = lo; i < hi; ++i) s += zigzag(r[i]);
+        sum[p] = s;
+    }
+
+    uint64_t best = UINT64_MAX;
+    for (int po = (int)max_po; po >= 0; --po) {
+        const uint32_t np = 1u << po, len = n >> po;
+        uint64_t bits = 3;
+        for (uint32_t p = 0; p < np; ++p) {
+            const uint32_t cnt = p == 0 ? len - order : len;
+            bits += 5 + rice_bits_est(sum[p], cnt, rice_k(sum[p], cnt));
+        }
+        if (bits <= best) { best = bits; *part_order = (uint32_t)po; }
+        for (uint32_t p = 0; p < np / 2; ++p) sum[p] = sum[2 * p] + sum[2 * p + 1];
+    }
+    return best;
+}
+
+static void residual_write(bw_t *b, const int32_t *r, uint32_t n, uint32_t order, uint32_t po) {
+    const uint32_t ps = n >> po;
+    bw_put(b, po, 3);
+    for (uint32_t p = 0; p < (1u << po); ++p) {
+        const uint32_t lo = p == 0 ? order : p * ps, hi = (p + 1) * ps, cnt = hi - lo;
+        uint64_t sum = 0;
+        for (uint32_t i = lo; i < hi; ++i) sum += zigzag(r[i]);
+
+        // exact cost for the estimate and its neighbours, against a flat escape
+        uint32_t k0 = rice_k(sum, cnt), best_k = RICE_ESCAPE;
+        const uint32_t w = signed_width(r + lo, cnt);
+        uint64_t best = 5 + (uint64_t)cnt * w;
+        for (uint32_t k = k0 ? k0 - 1 : 0; k <= k0 + 1 && k < RICE_ESCAPE; ++k) {
+            uint64_t bits = rice_bits_exact(r + lo, cnt, k);
+            if (bits < best) { best = bits; best_k = k; }
+        }
+
+        bw_put(b, best_k, 5);
+        if (best_k == RICE_ESCAPE) {
+            bw_put(b, w, 5);
+            for (uint32_t i = lo; i < hi; ++i) bw_put(b, (uint32_t)r[i], w);
+            continue;
+        }
+        for (uint32_t i = lo; i < hi; ++i) {
+            const uint32_t u = zigzag(r[i]);
+            bw_unary(b, u >> best_k);
+            bw_put(b, u, best_k);
+        }
+    }
+}
+
+/* ---------- encoder ---------- */
+
+size_t dsp_ll_encode(const int32_t *in, uint32_t frames, uint32_t ch, int32_t *scratch, uint8_t *out) {
+    bw_t b = { .p = out };
+    int32_t *x = scratch, *r = scratch + frames;
+
+    for (uint32_t c = 0; c < ch; ++c) {
+        for (uint32_t i = 0; i < frames; ++i) x[i] = in[i * ch + c];
+
+        // Fixed orders: pick the smallest residual magnitude (FLAC's heuristic)
+        uint32_t kind = KIND_VERBATIM, order = 0, po = 0, shift = 0;
+        int32_t q[DSP_LL_MAX_LPC];
+        uint64_t best = (uint64_t)frames * SAMPLE_BITS;
+        const uint32_t max_fixed = frames > DSP_LL_MAX_FIXED ? DSP_LL_MAX_FIXED : (frames ? frames - 1 : 0);
+        uint32_t fo = 0;
+        uint64_t fsum = UINT64_MAX;
+        for (uint32_t o = 0; o <= max_fixed; ++o) {
+            fixed_residual(x, frames, o, r);
+            uint64_t s = 0;
+            for (uint32_t i = max_fixed; i < frames; ++i) s += (uint64_t)(r[i] < 0 ? -(int64_t)r[i] : r[i]);
+            if (s < fsum) { fsum = s; fo = o; }
+        }
+        fixed_residual(x, frames, fo, r);
+        uint32_t fpo = 0;
+        uint64_t fbits = 3 + fo * SAMPLE_BITS + residual_cost(r, frames, fo, &fpo);
+        if (fbits < best) { best = fbits; kind = KIND_FIXED; order = fo; po = fpo; }
+
+        // LPC at orders 2, 4, 8; keep it only when it beats the fixed predictor
+        uint32_t best_lpc_order = 0, best_lpc_po = 0, best_lpc_shift = 0;
+        int32_t best_q[DSP_LL_MAX_LPC];
+        float lpc[3][DSP_LL_MAX_LPC];
+        const uint32_t n_lpc = frames > 4 * DSP_LL_MAX_LPC ? lpc_analyze(x, frames, lpc) : 0;
+        for (uint32_t li = 0; li < n_lpc; ++li) {
+            const uint32_t o = 2u << li;
+            uint32_t sh, lpo = 0;
+            if (!lpc_quantise(lpc[li], o, q, &sh) || !lpc_residual(x, frames, q, o, sh, r)) continue;
+            uint64_t bits = 3 + 4 + 5 + o * LPC_PREC + o * SAMPLE_BITS + residual_cost(r, frames, o, &lpo);
+            if (bits < best) {
+                best = bits; kind = KIND_LPC;
+                best_lpc_order = o; best_lpc_po = lpo; best_lpc_shift = sh;
+                memcpy(best_q, q, o * sizeof(int32_t));
+            }
+        }
+
+        bw_put(&b, kind, 2);
+        if (kind == KIND_VERBATIM) {
+            for (uint32_t i = 0; i < frames; ++i) bw_put(&b, (uint32_t)x[i], SAMPLE_BITS);
+            continue;
+        }
+        if (kind == KIND_FIXED) {
+            bw_put(&b, order, 3);
+            fixed_residual(x, frames, order, r);
+        } else {
+            order = best_lpc_order; po = best_lpc_po; shift = best_lpc_shift;
+            bw_put(&b, order - 1, 3);
+            bw_put(&b, LPC_PREC - 1, 4);
+            bw_put(&b, shift, 5);
+            for (uint32_t j = 0; j < order; ++j) bw_put(&b, (uint32_t)best_q[j], LPC_PREC);
+            lpc_residual(x, frames, best_q, order, shift, r);
+        }
+        for (uint32_t i = 0; i < order; ++i) bw_put(&b, (uint32_t)x[i], SAMPLE_BITS);
+        residual_write(&b, r, frames, order, po);
+    }
+    bw_flush(&b);
+    return (size_t)(b.p - out);
+}
+
+/* ---------- decoder ---------- */
+
+size_t dsp_ll_decode(const uint8_t *in, size_t len, uint32_t frames, uint32_t ch, int32_t *scratch, int32_t *out) {
+    br_t b = { .p = in, .end = in + len };
+    int32_t *x = scratch;
+
+    for (uint32_t c = 0; c < ch && !b.err; ++c) {
+        uint32_t kind = br_get(&b, 2), order = 0, shift = 0;
+        int32_t q[DSP_LL_MAX_LPC];
+
+        if (kind == KIND_VERBATIM) {
+            for (uint32_t i = 0; i < frames; ++i) x[i] = br_signed(&b, SAMPLE_BITS);
+        } else {
+            if (kind == KIND_FIXED) {
+                order = br_get(&b, 3);
+                if (order > DSP_LL_MAX_FIXED) return 0;
+            } else if (kind == KIND_LPC) {
+                order = br_get(&b, 3) + 1;
+                uint32_t prec = br_get(&b, 4) + 1;
+                shift = br_get(&b, 5);
+                for (uint32_t j = 0; j < order; ++j) q[j] = br_signed(&b, prec);
+            } else {
+                return 0;
+            }
+            if (order > frames) return 0;
+            for (uint32_t i = 0; i < order; ++i) x[i] = br_signed(&b, SAMPLE_BITS);
+
+            const uint32_t po = br_get(&b, 3), ps = frames >> po;
+            if ((frames & ((1u << po) - 1)) != 0 || ps < order) return 0;
+            for (uint32_t p = 0; p < (1u << po) && !b.err; ++p) {
+                const uint32_t lo = p == 0 ? order : p * ps, hi = (p + 1) * ps;
+                const uint32_t k = br_get(&b, 5);
+                if (k == RICE_ESCAPE) {
+                    const uint32_t w = br_get(&b, 5);
+                    for (uint32_t i = lo; i < hi; ++i) x[i] = br_signed(&b, w);
+                } else {
+                    for (uint32_t i = lo; i < hi && !b.err; ++i) {
+                        uint32_t u = br_unary(&b) << k;
+                        x[i] = unzigzag(u | br_get(&b, k));
+                    }
+                }
+            }
+
+            if (kind == KIND_FIXED) {
+                fixed_restore(x, frames, order);
+            } else {
+                for (uint32_t i = order; i < frames; ++i) {
+                    x[i] = (int32_t)(x[i] + lpc_predict(x, i, q, order, shift));
+                }
+            }
+        }
+        for (uint32_t i = 0; i < frames; ++i) out[i * ch + c] = x[i];
+    }
+    if (b.err) return 0;
+    return (size_t)(b.p - in);
+}
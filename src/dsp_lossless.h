@@ -0,0 +1,56 @@
+#ifndef DSP_LOSSLESS_H
+#define DSP_LOSSLESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* FLAC-style lossless coding of 24-bit sample blocks: per-channel linear
+ prediction and partitioned, adaptive Rice-coded residuals.
+
+ Every block is self-contained (predictor warm-up samples are sent verbatim),
+ so any block decodes without the ones before it. Bitstream, MSB first, one
+ sub-block per channel, padded to a byte at the end of the block:
+
+    kind            2   0 fixed, 1 LPC, 2 verbatim
+    fixed:  order   3   0..4 (FLAC fixed polynomials)
+    LPC:    order-1 3   1..8
+            prec    4   coefficient bits - 1
+            shift   5   coefficients are Q(shift)
+            coefs       order x prec, two's complement
+    verbatim:           frames x 24 bits, nothing else
+    warm-up             order x 24 bits
+    part_order      3   2^p partitions of frames >> p (first one short by order)
+    per partition:
+            k       5   Rice parameter, 31 = escape
+            escape:  w  5, then n x w-bit two's complement residuals
+            rice:        zigzag(r) = q:unary(0...01) r:k bits
+
+ Samples must be in [-2^23, 2^23). No ESP-IDF dependencies; builds on Linux
+ (the decoder is the round-trip check). */
+
+#define DSP_LL_MAX_CH       16
+#define DSP_LL_MAX_FIXED    4
+#define DSP_LL_MAX_LPC      8
+#define DSP_LL_MAX_PART     6
+
+// Worst-case encoded bytes for one block
+static inline size_t dsp_ll_max_bytes(uint32_t frames, uint32_t ch) {
+    return (size_t)ch * ((size_t)frames * 4 + 64) + 8;
+}
+
+/* in: frames x ch interleaved, out: at least dsp_ll_max_bytes(). scratch:
+   2 x frames int32. Returns encoded bytes. */
+size_t dsp_ll_encode(const int32_t *in, uint32_t frames, uint32_t ch, int32_t *scratch, uint8_t *out);
+
+// scratch: frames int32. Returns bytes consumed, or 0 on a malformed or truncated block
+size_t dsp_ll_decode(const uint8_t *in, size_t len, uint32_t frames, uint32_t ch, int32_t *scratch, int32_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_LOSSLESS_H
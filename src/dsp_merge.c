@@ -0,0 +1,96 @@
+#include "dsp_merge.h"
+
+#include <math.h>
+#include <string.h>
+
+#define M_MAX   ((1 << 22) - 1)
+#define M_MIN   (-(1 << 22))
+
+bool dsp_merge_init(dsp_merge_t *m, uint32_t pairs, const float *nominal, uint32_t hold_frames) {
+    if (!m || !nominal || pairs == 0 || pairs > DSP_MERGE_MAX_PAIRS) {
+        return false;
+    }
+    memset(m, 0, sizeof(*m));
+    m->pairs = pairs;
+    m->hold_frames = hold_frames;
+    for (uint32_t k = 0; k < pairs; ++k) {
+        if (!(nominal[k] >= 1.0f)) return false;
+        m->p[k].nominal = nominal[k];
+        m->p[k].gain    = nominal[k];
+    }
+    return true;
+}
+
+void dsp_merge_detect(dsp_merge_t *m, const int32_t *in, uint32_t frames) {
+    const uint32_t ch = 2 * m->pairs;
+    for (uint32_t k = 0; k < m->pairs; ++k) {
+        dsp_merge_pair_t *p = &m->p[k];
+        const int32_t *hi = in + 2 * k + 1;
+        uint32_t hold = p->hold;
+        bool lo = hold > 0;
+        for (uint32_t i = 0; i < frames; ++i, hi += ch) {
+            int32_t a = *hi < 0 ? -*hi : *hi;
+            if (a >= DSP_MERGE_ENTER || (hold && a >= DSP_MERGE_EXIT)) {
+                hold = m->hold_frames;
+                lo = true;
+            } else if (hold) {
+                hold--;
+            }
+        }
+        p->hold = hold;
+        p->lo_block = lo;
+    }
+}
+
+static void cal_fold(dsp_merge_pair_t *p) {
+    const double n = p->n;
+    const double mx = p->sx / n, my = p->sy / n;
+    const double vxx = p->sxx / n - mx * mx;
+    double g = p->gain;
+    // Gain only when the low channel moved well clear of its noise; offset always
+    if (vxx > (double)DSP_MERGE_CAL_MIN_LO * DSP_MERGE_CAL_MIN_LO) {
+        double fit = (p->sxy / n - mx * my) / vxx;
+        if (fit > p->nominal * 1.1) fit = p->nominal * 1.1;
+        if (fit < p->nominal * 0.9) fit = p->nominal * 0.9;
+        g += (fit - g) / 8.0;
+    }
+    p->gain = (float)g;
+    p->offset += (float)(((my - g * mx) - p->offset) / 8.0);
+    p->n = 0;
+    p->sx = p->sy = p->sxx = p->sxy = 0.0;
+}
+
+static inline int32_t clamp_m(float v) {
+    int32_t m = (int32_t)lrintf(v);
+    if (m > M_MAX) m = M_MAX;
+    if (m < M_MIN) m = M_MIN;
+    return m;
+}
+
+void dsp_merge_process(dsp_merge_t *m, const int32_t *in, uint32_t frames, int32_t *out) {
+    const uint32_t ch = 2 * m->pairs;
+    for (uint32_t k = 0; k < m->pairs; ++k) {
+        dsp_merge_pair_t *p = &m->p[k];
+        const int32_t *x = in + 2 * k;
+        int32_t *o = out + k;
+        if (p->lo_block) {
+            const float scale = p->gain / (2.0f * p->nominal);
+            const float off   = p->offset / (2.0f * p->nominal);
+            for (uint32_t i = 0; i < frames; ++i, x += ch, o += m->pairs) {
+                *o = (int32_t)((uint32_t)clamp_m(x[0] * scale + off) << 1) | 1;
+            }
+            continue;
+        }
+        for (uint32_t i = 0; i < frames; ++i, x += ch, o += m->pairs) {
+            const int32_t lo = x[0], hi = x[1];
+            *o = (int32_t)((uint32_t)clamp_m(hi * 0.5f) << 1);
+            if (lo >= DSP_MERGE_CAL_MIN_LO || lo <= -DSP_MERGE_CAL_MIN_LO) {
+                p->sx  += lo;
+                p->sy  += hi;
+                p->sxx += (double)lo * lo;
+                p->sxy += (double)lo * hi;
+                if (++p->n == DSP_MERGE_CAL_N) cal_fold(p);
+            }
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef DSP_MERGE_H
+#define DSP_MERGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Auto-ranging merge of dual-gain channel pairs into one 24-bit word.
+
+ Pair p is (ch 2p = low gain, ch 2p + 1 = high gain) on the same shunt, e.g.
+ CH1 INA213 (50 V/V) and CH2 INA212 (1000 V/V). Nominal gain G = hi / lo gain.
+
+    word = (m << 1) | range         (24-bit signed word, range in bit 0)
+    range 0: current = m * 2     high-gain LSBs
+    range 1: current = m * 2 * G high-gain LSBs
+
+ Range 0 drops the high-gain LSB (below the ADC noise floor); range 1 carries
+ low-gain samples matched to the high-gain channel (tracked gain and offset) and
+ quantised on the nominal G grid, so consumers only need G.
+
+ Range selection runs at the input rate, ahead of any decimation filter:
+    |hi| >= enter          -> low range, hold for hold_frames
+    exit <= |hi| < enter   -> stays low if already low (hysteresis)
+ hold_frames should cover the decimator's impulse response so no filtered
+ output ever includes a clipped high-gain input.
+
+ Matching uses clean pairs only (high range, |lo| above noise): a running
+ least-squares fit hi = gain * lo + offset, folded in every DSP_MERGE_CAL_N
+ pairs with a 1/8 EMA and gain clamped to +-10% of nominal.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_MERGE_MAX_PAIRS     8
+#define DSP_MERGE_ENTER         (((1 << 23) / 10) * 9)  // 90% FS on the high-gain channel
+#define DSP_MERGE_EXIT          (((1 << 23) / 10) * 8)  // 80% FS
+#define DSP_MERGE_CAL_N         4096
+#define DSP_MERGE_CAL_MIN_LO    64                      // low-gain LSBs; smaller pairs are noise
+
+typedef struct {
+    float    nominal;       // G from the amplifier gains
+    float    gain;          // matched hi / lo gain
+    float    offset;        // matched offset, high-gain LSBs
+    uint32_t hold;          // input frames left in low range
+    bool     lo_block;      // low range seen since the last dsp_merge_detect()
+    // least-squares accumulators
+    uint32_t n;
+    double   sx, sy, sxx, sxy;
+} dsp_merge_pair_t;
+
+typedef struct {
+    uint32_t pairs;
+    uint32_t hold_frames;
+    dsp_merge_pair_t p[DSP_MERGE_MAX_PAIRS];
+} dsp_merge_t;
+
+// nominal: pairs gains G (hi / lo)
+bool dsp_merge_init(dsp_merge_t *m, uint32_t pairs, const float *nominal, uint32_t hold_frames);
+
+/* Input-rate range detection over in (frames x 2 * pairs, interleaved).
+   Afterwards p[k].lo_block tells whether pair k was in low range at any frame. */
+void dsp_merge_detect(dsp_merge_t *m, const int32_t *in, uint32_t frames);
+
+/* Merge filtered pairs (frames x 2 * pairs) into out (frames x pairs words),
+   taking the range for the whole call from lo_block. */
+void dsp_merge_process(dsp_merge_t *m, const int32_t *in, uint32_t frames, int32_t *out);
+
+// Decode a merged word to high-gain LSBs (nominal grid)
+static inline float dsp_merge_decode(int32_t word, float nominal) {
+    int32_t w = (int32_t)((uint32_t)word << 8) >> 8;
+    return (float)(w >> 1) * 2.0f * ((w & 1) ? nominal : 1.0f);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_MERGE_H
@@ -0,0 +1,57 @@
+#include "dsp_pack24.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#endif
+
+// Runs inside the I2S DMA ISR, so it must live in IRAM
+IRAM_ATTR void dsp_pack24(const uint32_t *in, uint8_t *out, size_t n) {
+    size_t i = 0;
+
+    if (((uintptr_t)out & 3) == 0) {
+        uint32_t *o = (uint32_t *)out;
+        for (; i + 4 <= n; i += 4) {
+            uint32_t a = in[i + 0] & 0x00FFFFFF;
+            uint32_t b = in[i + 1] & 0x00FFFFFF;
+            uint32_t c = in[i + 2] & 0x00FFFFFF;
+            uint32_t d = in[i + 3] & 0x00FFFFFF;
+            o[0] = a         | (b << 24);
+            o[1] = (b >> 8)  | (c << 16);
+            o[2] = (c >> 16) | (d << 8);
+            o += 3;
+        }
+        out = (uint8_t *)o;
+    }
+
+    for (; i < n; ++i) {
+        uint32_t v = in[i];
+        out[0] = (uint8_t)v;
+        out[1] = (uint8_t)(v >> 8);
+        out[2] = (uint8_t)(v >> 16);
+        out += 3;
+    }
+}
+
+void dsp_unpack24(const uint8_t *in, int32_t *out, size_t n) {
+    size_t i = 0;
+
+    if (((uintptr_t)in & 3) == 0) {
+        const uint32_t *w = (const uint32_t *)in;
+        for (; i + 4 <= n; i += 4) {
+            uint32_t w0 = w[0], w1 = w[1], w2 = w[2];
+            out[i + 0] = (int32_t)(w0 << 8) >> 8;
+            out[i + 1] = (int32_t)(((w0 >> 24) << 8)  | (w1 << 16)) >> 8;
+            out[i + 2] = (int32_t)(((w1 >> 16) << 8)  | (w2 << 24)) >> 8;
+            out[i + 3] = (int32_t)w2 >> 8;
+            w += 3;
+        }
+        in = (const uint8_t *)w;
+    }
+
+    for (; i < n; ++i) {
+        out[i] = dsp_ld24(in);
+        in += 3;
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef DSP_PACK24_H
+#define DSP_PACK24_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 24-bit sample packing.
+
+ Slot layout:   one sample per 32-bit little-endian word, value in bits 23..0
+                (bits 31..24 are padding and ignored)
+ Packed layout: one sample per 3 bytes, little-endian, no padding
+
+ Both kernels take a 4-samples-per-3-words fast path when the packed side is
+ 32-bit aligned and fall back to byte moves otherwise. Little-endian only
+ (ESP32-S3, x86, ARM hosts).
+
+ No ESP-IDF dependencies; the same source builds into host-side decoders. */
+
+// n samples: slots -> packed (3n bytes written)
+void dsp_pack24(const uint32_t *in, uint8_t *out, size_t n);
+
+// n samples: packed -> sign-extended int32
+void dsp_unpack24(const uint8_t *in, int32_t *out, size_t n);
+
+// Single-sample helpers for kernels that walk packed data directly
+static inline int32_t dsp_ld24(const uint8_t *p) {
+    uint32_t v = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+    return (int32_t)(v << 8) >> 8;
+}
+static inline void dsp_st24(uint8_t *p, int32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_PACK24_H
@@ -0,0 +1,103 @@
+#include "dsp_resample.h"
+
+#include <math.h>
+#include <string.h>
+
+#define HALF    (DSP_RS_TAPS / 2)
+
+/* Row p holds the kernel for a read position p / DSP_RS_PHASES past input
+   frame i0; tap k multiplies frame i0 - (HALF - 1) + k. */
+void dsp_rs_design(float *coef) {
+    for (uint32_t p = 0; p <= DSP_RS_PHASES; ++p) {
+        const double mu = (double)p / DSP_RS_PHASES;
+        float *h = coef + p * DSP_RS_TAPS;
+        double sum = 0.0;
+        for (uint32_t k = 0; k < DSP_RS_TAPS; ++k) {
+            const double t = (double)k - (HALF - 1) - mu; // -HALF < t <= HALF
+            const double s = fabs(t) < 1e-12 ? 1.0 : sin(M_PI * t) / (M_PI * t);
+            const double x = (t + HALF) / DSP_RS_TAPS;    // window spans t = -HALF .. HALF
+            const double w = 0.42 - 0.5 * cos(2.0 * M_PI * x) + 0.08 * cos(4.0 * M_PI * x);
+            h[k] = (float)(s * w);
+            sum += s * w;
+        }
+        // unity DC gain at every offset
+        for (uint32_t k = 0; k < DSP_RS_TAPS; ++k) h[k] = (float)(h[k] / sum);
+    }
+}
+
+bool dsp_rs_init(dsp_rs_t *r, const float *coef, uint32_t ch, uint32_t max_in, float *state) {
+    if (!r || !coef || !state || ch == 0 || max_in == 0) {
+        return false;
+    }
+    r->coef   = coef;
+    r->ch     = ch;
+    r->max_in = max_in;
+    r->buf    = state;
+    dsp_rs_reset(r);
+    return true;
+}
+
+// Prime with silence so the first output lands on input frame 0
+void dsp_rs_reset(dsp_rs_t *r) {
+    memset(r->buf, 0, (size_t)(HALF - 1) * r->ch * sizeof(float));
+    r->fill = HALF - 1;
+    r->pos  = HALF - 1;
+    r->base = -(HALF - 1);
+}
+
+static inline int32_t round_sat24(float v) {
+    int32_t x = (int32_t)lrintf(v);
+    if (x >  0x7FFFFF) x =  0x7FFFFF;
+    if (x < -0x800000) x = -0x800000;
+    return x;
+}
+
+uint32_t dsp_rs_process(dsp_rs_t *r, const int32_t *in, uint32_t in_frames, double step, int32_t *out) {
+    const uint32_t ch = r->ch;
+    if (in_frames > r->max_in) in_frames = r->max_in;
+    if (step > 1.0 + DSP_RS_MAX_DEV) step = 1.0 + DSP_RS_MAX_DEV;
+    if (step < 1.0 - DSP_RS_MAX_DEV) step = 1.0 - DSP_RS_MAX_DEV;
+
+    float *w = r->buf + (size_t)r->fill * ch;
+    for (uint32_t i = 0; i < in_frames * ch; ++i) w[i] = (float)in[i];
+    r->fill += in_frames;
+
+    float h[DSP_RS_TAPS];
+    uint32_t n = 0;
+    for (;;) {
+        const uint32_t i0 = (uint32_t)r->pos;
+        if (i0 + HALF >= r->fill) break;    // newest tap not in yet
+
+        const float ph = (float)(r->pos - i0) * DSP_RS_PHASES;
+        uint32_t p0 = (uint32_t)ph;
+        float a = ph - (float)p0;
+        if (p0 >= DSP_RS_PHASES) { p0 = DSP_RS_PHASES - 1; a = 1.0f; } // pos - i0 rounded up to 1.0f
+        const float *h0 = r->coef + p0 * DSP_RS_TAPS;
+        const float *h1 = h0 + DSP_RS_TAPS;
+        for (uint32_t k = 0; k < DSP_RS_TAPS; ++k) h[k] = h0[k] + a * (h1[k] - h0[k]);
+
+        const float *x = r->buf + (size_t)(i0 - (HALF - 1)) * ch;
+        for (uint32_t c = 0; c < ch; ++c) {
+            const float *xc = x + c;
+            float a0 = 0.0f, a1 = 0.0f;
+            for (uint32_t k = 0; k < DSP_RS_TAPS; k += 2) {
+                a0 += h[k]     * xc[(k)     * ch];
+                a1 += h[k + 1] * xc[(k + 1) * ch];
+            }
+            out[(size_t)n * ch + c] = round_sat24(a0 + a1);
+        }
+        n++;
+        r->pos += step;
+    }
+
+    // Drop what no future output reaches; at most DSP_RS_TAPS - 1 frames stay
+    uint32_t drop = (uint32_t)r->pos - (HALF - 1);
+    if (drop > r->fill) drop = r->fill;
+    if (drop) {
+        r->fill -= drop;
+        memmove(r->buf, r->buf + (size_t)drop * ch, (size_t)r->fill * ch * sizeof(float));
+        r->pos  -= drop;
+        r->base += drop;
+    }
+    return n;
+}
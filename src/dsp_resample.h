@@ -0,0 +1,79 @@
+#ifndef DSP_RESAMPLE_H
+#define DSP_RESAMPLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Polyphase fractional resampler for interleaved multi-channel int32 samples,
+ for ratios within DSP_RS_MAX_DEV of 1: it turns a stream whose true rate is a
+ few ppm off nominal into one at exactly nominal rate.
+
+ Each output is a DSP_RS_TAPS-tap windowed sinc (Blackman, cutoff at Nyquist)
+ centred on a fractional input position. The kernel is tabulated at
+ DSP_RS_PHASES + 1 sub-sample offsets and interpolated linearly between the two
+ nearest, so any offset costs one table blend plus DSP_RS_TAPS MACs per
+ channel. At offset 0 the kernel is a unit impulse: step 1.0 passes the input
+ through untouched, output n being input frame n. An output is emitted once the
+ DSP_RS_TAPS / 2 frames after its position are in, so the output trails the
+ input by that many frames.
+
+ The caller advances the read position by `step` input frames per output
+ (1 + rate error, e.g. 1 + 40e-9 for a clock 40 ppb fast) and may change step
+ between calls. Passband is flat to about 0.4 of the rate; decimated streams
+ are already band-limited below that (DS_CUTOFF).
+
+ Inputs are sign-extended 24-bit values; outputs are rounded and saturated to
+ 24 bits. No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_RS_TAPS     32
+#define DSP_RS_PHASES   64
+#define DSP_RS_MAX_DEV  1e-3        // |step - 1| is clamped to this (1000 ppm)
+
+typedef struct {
+    const float *coef;  // (DSP_RS_PHASES + 1) x DSP_RS_TAPS (caller-owned, see dsp_rs_design)
+    uint32_t ch;
+    uint32_t max_in;    // most input frames per call
+    uint32_t fill;      // frames held in buf
+    double   pos;       // buf position of the next output
+    int64_t  base;      // input frame index of buf[0]
+    float   *buf;       // see dsp_rs_state_len (caller-owned)
+} dsp_rs_t;
+
+// Coefficient table size, floats
+#define DSP_RS_COEF_LEN ((DSP_RS_PHASES + 1) * DSP_RS_TAPS)
+
+// floats needed for the history buffer
+static inline size_t dsp_rs_state_len(uint32_t ch, uint32_t max_in) {
+    return (size_t)ch * (DSP_RS_TAPS + max_in);
+}
+
+// Upper bound on output frames for in_frames input frames
+static inline uint32_t dsp_rs_max_out(uint32_t in_frames) {
+    return in_frames + in_frames / 512 + 2;
+}
+
+// Fill the shared kernel table; any number of resamplers may use one table
+void dsp_rs_design(float *coef);
+
+bool dsp_rs_init(dsp_rs_t *r, const float *coef, uint32_t ch, uint32_t max_in, float *state);
+void dsp_rs_reset(dsp_rs_t *r);
+
+// in: in_frames x ch (in_frames <= max_in), out: room for dsp_rs_max_out() frames.
+// Returns frames written.
+uint32_t dsp_rs_process(dsp_rs_t *r, const int32_t *in, uint32_t in_frames, double step, int32_t *out);
+
+// Input frame index (fractional, counted from the first input) the next output is taken at
+static inline double dsp_rs_next_in(const dsp_rs_t *r) {
+    return (double)r->base + r->pos;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_RESAMPLE_H
@@ -0,0 +1,81 @@
+#include "dsp_sdt.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+void dsp_sdt_init(dsp_sdt_t *s, float dev, uint32_t hb) {
+    memset(s, 0, sizeof(*s));
+    s->dev = dev;
+    s->hb  = hb;
+}
+
+void dsp_sdt_reset(dsp_sdt_t *s) {
+    s->started = false;
+}
+
+static inline void open_doors(dsp_sdt_t *s) {
+    s->slope_lo = -FLT_MAX;
+    s->slope_hi = FLT_MAX;
+}
+
+// Point at t on the anchor line, slope clamped into the doors still open
+static dsp_sdt_point_t on_doors(const dsp_sdt_t *s, uint32_t t, int32_t v) {
+    const float dt = (float)(t - s->t0);
+    float slope = (float)(v - s->v0) / dt;
+    if (slope < s->slope_lo) slope = s->slope_lo;
+    if (slope > s->slope_hi) slope = s->slope_hi;
+    dsp_sdt_point_t p = { .t = t, .v = s->v0 + (int32_t)lrintf(slope * dt) };
+    return p;
+}
+
+static inline void anchor(dsp_sdt_t *s, dsp_sdt_point_t p) {
+    s->t0 = p.t;
+    s->v0 = p.v;
+    open_doors(s);
+}
+
+static inline void narrow(dsp_sdt_t *s, uint32_t t, int32_t v, float *lo, float *hi) {
+    const float dt = (float)(t - s->t0);
+    const float d = (float)(v - s->v0);
+    *lo = (d - s->dev) / dt;
+    *hi = (d + s->dev) / dt;
+}
+
+uint32_t dsp_sdt_push(dsp_sdt_t *s, uint32_t t, int32_t v, dsp_sdt_point_t out[2]) {
+    uint32_t n = 0;
+    if (!s->started) {
+        s->started = true;
+        dsp_sdt_point_t p = { .t = t, .v = v };
+        anchor(s, p);
+        s->t_prev = t;
+        s->v_prev = v;
+        out[n++] = p;
+        return n;
+    }
+
+    float lo, hi;
+    narrow(s, t, v, &lo, &hi);
+    lo = fmaxf(lo, s->slope_lo);
+    hi = fminf(hi, s->slope_hi);
+
+    if (lo > hi) {
+        // doors crossed: archive the previous sample on the feasible line
+        dsp_sdt_point_t p = on_doors(s, s->t_prev, s->v_prev);
+        out[n++] = p;
+        anchor(s, p);
+        narrow(s, t, v, &s->slope_lo, &s->slope_hi);
+    } else {
+        s->slope_lo = lo;
+        s->slope_hi = hi;
+    }
+    s->t_prev = t;
+    s->v_prev = v;
+
+    if (s->hb && t - s->t0 >= s->hb) {
+        dsp_sdt_point_t p = on_doors(s, t, v);
+        out[n++] = p;
+        anchor(s, p);
+    }
+    return n;
+}
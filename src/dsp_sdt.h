@@ -0,0 +1,54 @@
+#ifndef DSP_SDT_H
+#define DSP_SDT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Swinging-door trending: report-by-exception compression of one channel.
+
+ Archived points, joined by straight lines, reproduce every input sample to
+ within dev counts (+ 0.5 LSB rounding). From the last archived point (the
+ anchor) two doors pivot: the upper door through each sample's v + dev, the
+ lower through v - dev. While the steepest lower slope stays below the
+ shallowest upper slope one line still fits every sample since the anchor;
+ when a sample makes them cross, the previous sample is archived, with its
+ value moved onto the feasible slope so the guarantee holds exactly.
+
+ A heartbeat archives the current sample once hb samples pass without a
+ point, so a flat trace still proves the device is alive.
+
+ Time is the caller's sample index (wraps at 2^32). No ESP-IDF dependencies;
+ builds on Linux. */
+
+typedef struct {
+    uint32_t t;
+    int32_t  v;
+} dsp_sdt_point_t;
+
+typedef struct {
+    float    dev;           // tolerance, counts
+    uint32_t hb;            // heartbeat, samples (0 = none)
+    bool     started;
+    uint32_t t0;            // anchor
+    int32_t  v0;            // kept exact; slopes work on v - v0, which float holds near full scale
+    float    slope_lo;      // steepest lower-door slope so far
+    float    slope_hi;      // shallowest upper-door slope so far
+    uint32_t t_prev;        // last sample seen
+    int32_t  v_prev;
+} dsp_sdt_t;
+
+void dsp_sdt_init(dsp_sdt_t *s, float dev, uint32_t hb);
+void dsp_sdt_reset(dsp_sdt_t *s);
+
+// Feed one sample; writes 0..2 archived points to out and returns the count
+uint32_t dsp_sdt_push(dsp_sdt_t *s, uint32_t t, int32_t v, dsp_sdt_point_t out[2]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_SDT_H
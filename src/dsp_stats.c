@@ -0,0 +1,70 @@
+#include "dsp_stats.h"
+
+#include <math.h>
+#include <string.h>
+
+bool dsp_stats_init(dsp_stats_t *s, uint32_t ch, uint32_t window_frames) {
+    if (!s || ch == 0 || ch > DSP_STATS_MAX_CH || window_frames == 0 || window_frames > DSP_STATS_MAX_FRAMES) {
+        return false;
+    }
+    memset(s, 0, sizeof(*s));
+    s->ch     = ch;
+    s->window = window_frames;
+    dsp_stats_reset(s);
+    return true;
+}
+
+void dsp_stats_reset(dsp_stats_t *s) {
+    s->count = 0;
+    for (uint32_t c = 0; c < s->ch; ++c) {
+        dsp_stats_acc_t *a = &s->acc[c];
+        a->min   = INT32_MAX;
+        a->max   = INT32_MIN;
+        a->sum   = 0;
+        a->sumsq = 0;
+        a->clips = 0;
+    }
+}
+
+/* Channel-major over the chunk so each channel's accumulators live in registers */
+uint32_t dsp_stats_accumulate(dsp_stats_t *s, const int32_t *in, uint32_t frames) {
+    const uint32_t ch = s->ch;
+    uint32_t n = s->window - s->count;
+    if (n > frames) n = frames;
+
+    for (uint32_t c = 0; c < ch; ++c) {
+        const int32_t *x = in + c;
+        int32_t  mn = s->acc[c].min, mx = s->acc[c].max;
+        int64_t  sum = 0;
+        uint64_t sq = 0;
+        uint32_t clips = 0;
+        for (uint32_t i = 0; i < n; ++i, x += ch) {
+            const int32_t v = *x;
+            if (v < mn) mn = v;
+            if (v > mx) mx = v;
+            sum += v;
+            sq  += (uint64_t)((int64_t)v * v);
+            clips += (v >= DSP_STATS_CLIP_LEVEL) | (v <= -DSP_STATS_CLIP_LEVEL);
+        }
+        s->acc[c].min    = mn;
+        s->acc[c].max    = mx;
+        s->acc[c].sum   += sum;
+        s->acc[c].sumsq += sq;
+        s->acc[c].clips += clips;
+    }
+    s->count += n;
+    return n;
+}
+
+void dsp_stats_result(const dsp_stats_t *s, uint32_t c, dsp_stats_result_t *out) {
+    const dsp_stats_acc_t *a = &s->acc[c];
+    if (s->count == 0) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    out->min   = a->min;
+    out->max   = a->max;
+    out->mean  = (double)a->sum / s->count;
+    out->rms   = sqrt((double)a->sumsq / s->count);
+    out->clips = a->clips;
+}
@@ -0,0 +1,71 @@
+#ifndef DSP_STATS_H
+#define DSP_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Single-pass windowed statistics over interleaved 24-bit int32 samples.
+
+ Per channel: min, max, sum, sum of squares and clip count, all exact integer
+ accumulators. A window closes after a fixed number of frames; blocks need not
+ line up with windows, the caller just keeps feeding:
+
+    while (frames) {
+        n = dsp_stats_accumulate(&s, in, frames);
+        in += n * ch; frames -= n;
+        if (dsp_stats_ready(&s)) { dsp_stats_result(&s, c, &r); ...; dsp_stats_reset(&s); }
+    }
+
+ Sum of squares is uint64: (2^23)^2 * DSP_STATS_MAX_FRAMES = 2^63 still fits.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_STATS_MAX_CH        16
+#define DSP_STATS_MAX_FRAMES    (1u << 17)          // 1.36 s at 96 kHz
+#define DSP_STATS_CLIP_LEVEL    ((1 << 23) - 8192)  // |x| at or above ~99.9% FS counts as clipped
+
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    int64_t  sum;
+    uint64_t sumsq;
+    uint32_t clips;
+} dsp_stats_acc_t;
+
+typedef struct {
+    uint32_t ch;
+    uint32_t window;        // frames per window
+    uint32_t count;         // frames in the current window
+    dsp_stats_acc_t acc[DSP_STATS_MAX_CH];
+} dsp_stats_t;
+
+// Window results in counts; scale by LSB size for engineering units
+typedef struct {
+    int32_t  min;
+    int32_t  max;
+    double   mean;
+    double   rms;           // includes DC; AC RMS = sqrt(rms^2 - mean^2)
+    uint32_t clips;
+} dsp_stats_result_t;
+
+bool dsp_stats_init(dsp_stats_t *s, uint32_t ch, uint32_t window_frames);
+void dsp_stats_reset(dsp_stats_t *s);
+
+// Consumes up to the end of the current window; returns frames consumed
+uint32_t dsp_stats_accumulate(dsp_stats_t *s, const int32_t *in, uint32_t frames);
+
+static inline bool dsp_stats_ready(const dsp_stats_t *s) {
+    return s->count == s->window;
+}
+
+void dsp_stats_result(const dsp_stats_t *s, uint32_t c, dsp_stats_result_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_STATS_H
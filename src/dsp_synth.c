@@ -0,0 +1,53 @@
+#include "dsp_synth.h"
+#include "dsp_pack24.h"
+
+#include <math.h>
+#include <string.h>
+
+#define FS24    (1 << 23)
+
+bool dsp_synth_init(dsp_synth_t *s, uint32_t ch, uint32_t fs, uint32_t seed) {
+    if (!s || ch == 0 || ch > DSP_SYNTH_MAX_CH || fs == 0) {
+        return false;
+    }
+    memset(s, 0, sizeof(*s));
+    s->ch = ch;
+    s->noise = seed ? seed : 0x9E3779B9u;
+    for (uint32_t i = 0; i < DSP_SYNTH_TAB; ++i) {
+        s->sine[i] = (int32_t)lrint(FS24 / 4 * sin(2.0 * M_PI * i / DSP_SYNTH_TAB));
+    }
+    for (uint32_t c = 0; c < ch; ++c) {
+        s->step[c] = (uint32_t)(((uint64_t)(c + 1) * DSP_SYNTH_BASE_HZ << 32) / fs);
+        s->dc[c]   = ((int32_t)c - (int32_t)(ch / 2)) * (FS24 / 32);
+    }
+    return true;
+}
+
+static inline int32_t next_sample(dsp_synth_t *s, uint32_t c) {
+    uint32_t r = s->noise;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    s->noise = r;
+    const int32_t v = s->dc[c] + s->sine[s->phase[c] >> 22] + (int32_t)(r >> 24) - 128;
+    s->phase[c] += s->step[c];
+    return v;
+}
+
+void dsp_synth_fill(dsp_synth_t *s, uint8_t *out, uint32_t sb, uint32_t frames) {
+    const uint32_t ch = s->ch;
+    if (sb == 3) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            for (uint32_t c = 0; c < ch; ++c, out += 3) dsp_st24(out, next_sample(s, c));
+        }
+        return;
+    }
+    uint32_t *w = (uint32_t *)out;
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) *w++ = (uint32_t)next_sample(s, c) & 0x00FFFFFFu;
+    }
+}
+
+void dsp_synth_skip(dsp_synth_t *s, uint32_t frames) {
+    for (uint32_t c = 0; c < s->ch; ++c) s->phase[c] += s->step[c] * frames;
+}
@@ -0,0 +1,51 @@
+#ifndef DSP_SYNTH_H
+#define DSP_SYNTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Synthetic multichannel source in ring layout, for throughput measurements
+ without ADCs (and on a host).
+
+ Channel c carries a DC level, a sine at (c + 1) x DSP_SYNTH_BASE_HZ and a few
+ LSBs of white noise, so every channel is distinct and the lossless coder, the
+ triggers and the statistics all see realistic, non-constant data:
+
+    x[c] = (c - ch/2) x FS/32  +  FS/4 sin(2 pi (c + 1) f0 t)  +  U(-128, 127)
+
+ The sine comes from a 1024-entry table and a 32-bit phase accumulator; noise
+ is xorshift32, seeded per source so runs are reproducible. Output is the ring
+ layout: sb = 4, one sample per 32-bit word in bits 23..0; sb = 3, packed.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_SYNTH_MAX_CH    16
+#define DSP_SYNTH_BASE_HZ   50
+#define DSP_SYNTH_TAB       1024
+
+typedef struct {
+    uint32_t ch;
+    uint32_t noise;                         // xorshift32 state
+    uint32_t phase[DSP_SYNTH_MAX_CH];
+    uint32_t step[DSP_SYNTH_MAX_CH];
+    int32_t  dc[DSP_SYNTH_MAX_CH];
+    int32_t  sine[DSP_SYNTH_TAB];
+} dsp_synth_t;
+
+bool dsp_synth_init(dsp_synth_t *s, uint32_t ch, uint32_t fs, uint32_t seed);
+
+// frames x ch samples into out (frames x ch x sb bytes)
+void dsp_synth_fill(dsp_synth_t *s, uint8_t *out, uint32_t sb, uint32_t frames);
+
+// Advance as if frames had been generated (a dropped block)
+void dsp_synth_skip(dsp_synth_t *s, uint32_t frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_SYNTH_H
@@ -0,0 +1,79 @@
+#include "dsp_trigger.h"
+
+#include <string.h>
+
+bool dsp_trig_init(dsp_trig_t *t, dsp_trig_kind_t kind, uint32_t ch, int32_t a, int32_t b, int32_t hyst, uint32_t span) {
+    memset(t, 0, sizeof(*t));
+    if (hyst < 0) return false;
+    switch (kind) {
+    case DSP_TRIG_LEVEL:  if (a <= 0) return false; break;
+    case DSP_TRIG_SLOPE:  if (a <= 0 || span == 0 || span > DSP_TRIG_MAX_SPAN) return false; break;
+    case DSP_TRIG_WINDOW: if (b <= a) return false; break;
+    default: return false;
+    }
+    t->kind  = kind;
+    t->ch    = ch;
+    t->a     = a;
+    t->b     = b;
+    t->hyst  = hyst;
+    t->span  = span;
+    t->armed = true;
+    return true;
+}
+
+static inline int32_t iabs(int32_t x) { return x < 0 ? -x : x; }
+
+// One sample; true when the trigger fires on it
+static inline bool step(dsp_trig_t *t, int32_t x) {
+    bool hit, clear;
+    switch (t->kind) {
+    case DSP_TRIG_LEVEL:
+        t->last = iabs(x);
+        hit   = t->last >= t->a;
+        clear = t->last < t->a - t->hyst;
+        break;
+    case DSP_TRIG_SLOPE: {
+        int32_t d = 0;
+        if (t->seen >= t->span) {
+            d = iabs(x - t->hist[t->pos]);
+        } else {
+            t->seen++;
+        }
+        t->hist[t->pos] = x;
+        if (++t->pos == t->span) t->pos = 0;
+        t->last = d;
+        hit   = d >= t->a;
+        clear = d < t->a - t->hyst;
+        break;
+    }
+    case DSP_TRIG_WINDOW:
+        t->last = x;
+        hit   = x < t->a || x > t->b;
+        clear = x >= t->a + t->hyst && x <= t->b - t->hyst;
+        break;
+    default:
+        return false;
+    }
+    if (t->armed) {
+        if (hit) {
+            t->armed = false;
+            return true;
+        }
+    } else if (clear) {
+        t->armed = true;
+    }
+    return false;
+}
+
+uint32_t dsp_trig_scan(dsp_trig_t *t, uint32_t n_trig, const int32_t *in, uint32_t ch, uint32_t frames, int *fired) {
+    *fired = -1;
+    for (uint32_t i = 0; i < frames; ++i) {
+        const int32_t *f = in + (size_t)i * ch;
+        for (uint32_t k = 0; k < n_trig; ++k) {
+            // every trigger sees the frame, so slope history and hysteresis stay exact
+            if (step(&t[k], f[t[k].ch]) && *fired < 0) *fired = (int)k;
+        }
+        if (*fired >= 0) return i + 1;
+    }
+    return frames;
+}
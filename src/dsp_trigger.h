@@ -0,0 +1,56 @@
+#ifndef DSP_TRIGGER_H
+#define DSP_TRIGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Level / slope / window triggers with hysteresis over interleaved int32 frames.
+
+    level:  fires when |x| >= a;                 re-arms when |x| < a - hyst
+    slope:  fires when |x[n] - x[n-span]| >= a;  re-arms when it drops below a - hyst
+    window: fires when x < a or x > b;           re-arms when a + hyst <= x <= b - hyst
+
+ A trigger fires once, then stays disarmed until its condition clears by the
+ hysteresis, so a sustained fault is one event, not one per sample.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_TRIG_MAX        4
+#define DSP_TRIG_MAX_SPAN   128
+
+typedef enum {
+    DSP_TRIG_NONE = 0,
+    DSP_TRIG_LEVEL,
+    DSP_TRIG_SLOPE,
+    DSP_TRIG_WINDOW,
+} dsp_trig_kind_t;
+
+typedef struct {
+    dsp_trig_kind_t kind;
+    uint32_t ch;            // 0-based channel
+    int32_t  a, b;          // thresholds, counts (b: window upper bound)
+    int32_t  hyst;
+    uint32_t span;          // slope: samples between compared points
+    bool     armed;
+    int32_t  last;          // what the last sample was tested as: |x|, the slope difference, or x
+    uint32_t seen;          // slope: samples in hist
+    uint32_t pos;           // slope: next hist slot
+    int32_t  hist[DSP_TRIG_MAX_SPAN];
+} dsp_trig_t;
+
+bool dsp_trig_init(dsp_trig_t *t, dsp_trig_kind_t kind, uint32_t ch, int32_t a, int32_t b, int32_t hyst, uint32_t span);
+
+/* Scan frames (x ch interleaved) through every trigger until one fires.
+   Returns frames consumed: all of them, or up to and including the firing
+   frame, with *fired set to the trigger's index (-1 when none fired). */
+uint32_t dsp_trig_scan(dsp_trig_t *t, uint32_t n_trig, const int32_t *in, uint32_t ch, uint32_t frames, int *fired);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_TRIGGER_H
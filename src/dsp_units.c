@@ -0,0 +1,84 @@
+#include "dsp_units.h"
+
+#include "dsp_pack24.h"
+
+#include <math.h>
+#include <string.h>
+
+bool dsp_units_init(dsp_units_t *u, uint32_t ch, float fs_volts, float shunt_ohms, const float *gain) {
+    if (!u) {
+        return false;
+    }
+    memset(u, 0, sizeof(*u));
+    if (!gain || ch == 0 || ch > DSP_UNITS_MAX_CH || !(fs_volts > 0.0f) || !(shunt_ohms > 0.0f)) {
+        return false;
+    }
+    // Built aside and copied out whole, so a rejected gain never leaves u half valid
+    dsp_units_t t;
+    memset(&t, 0, sizeof(t));
+    t.ch = ch;
+    for (uint32_t c = 0; c < ch; ++c) {
+        if (!(gain[c] > 0.0f)) return false;
+        double a = (double)fs_volts / (8388608.0 * gain[c] * shunt_ohms);
+        t.amps_per_lsb[c] = (float)a;
+
+        // Largest shift that keeps nA/LSB * 2^shift in int32: best precision, no overflow
+        double na = a * 1e9;
+        if (!(na < 2147483647.0)) return false; // above 2^31 nA/LSB: unrepresentable
+        uint32_t shift = 0;
+        while (shift < 31 && na * (double)(1u << (shift + 1)) < 2147483647.0) shift++;
+        if (na * (double)(1u << shift) < 1.0) return false; // below 1 nA/LSB x 2^31: unrepresentable
+        t.q_mult[c]  = (int32_t)llround(na * (double)(1u << shift));
+        t.q_shift[c] = shift;
+    }
+    *u = t;
+    return true;
+}
+
+static inline int32_t ld_sample(const uint8_t *in, uint32_t sb, uint32_t i) {
+    if (sb == 3) return dsp_ld24(in + 3 * i);
+    return (int32_t)(((const uint32_t *)in)[i] << 8) >> 8;
+}
+
+/* Frames outer, channels inner, with the per-channel scale hoisted into locals.
+   The S3 FPU is scalar (PIE has no float lanes), so this is one FMUL per sample
+   with loads/stores overlapped by the compiler. */
+void dsp_units_amps_f32(const dsp_units_t *u, const uint8_t *in, uint32_t sb, uint32_t frames, float *out) {
+    const uint32_t ch = u->ch;
+    if (ch == 2) {
+        const float k0 = u->amps_per_lsb[0], k1 = u->amps_per_lsb[1];
+        for (uint32_t i = 0; i < frames; ++i) {
+            out[2 * i + 0] = (float)ld_sample(in, sb, 2 * i + 0) * k0;
+            out[2 * i + 1] = (float)ld_sample(in, sb, 2 * i + 1) * k1;
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) {
+            out[i * ch + c] = (float)ld_sample(in, sb, i * ch + c) * u->amps_per_lsb[c];
+        }
+    }
+}
+
+static inline int32_t scale_q(int32_t x, int32_t mult, uint32_t shift) {
+    const int64_t half = shift ? (int64_t)1 << (shift - 1) : 0;   // shift is 0 for >= 2^30 nA/LSB
+    return (int32_t)(((int64_t)x * mult + half) >> shift);
+}
+
+void dsp_units_amps_q(const dsp_units_t *u, const uint8_t *in, uint32_t sb, uint32_t frames, int32_t *out_na) {
+    const uint32_t ch = u->ch;
+    if (ch == 2) {
+        const int32_t  m0 = u->q_mult[0],  m1 = u->q_mult[1];
+        const uint32_t s0 = u->q_shift[0], s1 = u->q_shift[1];
+        for (uint32_t i = 0; i < frames; ++i) {
+            out_na[2 * i + 0] = scale_q(ld_sample(in, sb, 2 * i + 0), m0, s0);
+            out_na[2 * i + 1] = scale_q(ld_sample(in, sb, 2 * i + 1), m1, s1);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) {
+            out_na[i * ch + c] = scale_q(ld_sample(in, sb, i * ch + c), u->q_mult[c], u->q_shift[c]);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef DSP_UNITS_H
+#define DSP_UNITS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block conversion of raw ADC samples to shunt current.
+
+ Each channel is a shunt amplifier (INA21x) into one ADC input:
+    Vout = gain * I * R_shunt,   Vout = counts / 2^23 * fs_volts
+    I    = counts * fs_volts / (2^23 * gain * R_shunt)
+
+ The kernels read the ring layout directly (sb = 4: 24-in-32 slot words,
+ sb = 3: packed) and sign-extend, scale and store in one pass:
+    float  variant: amps
+    Q      variant: nanoamps in int32 (±2.1 A), out = (counts * mult + round) >> shift
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define DSP_UNITS_MAX_CH    16
+
+typedef struct {
+    uint32_t ch;
+    float    amps_per_lsb[DSP_UNITS_MAX_CH];
+    int32_t  q_mult[DSP_UNITS_MAX_CH];      // nA per LSB in Q(q_shift)
+    uint32_t q_shift[DSP_UNITS_MAX_CH];
+} dsp_units_t;
+
+/* gain: ch amplifier gains (V/V). Returns false on a non-positive gain / shunt / full
+   scale or a scale that doesn't fit the Q variant; u is then cleared (ch = 0). */
+bool dsp_units_init(dsp_units_t *u, uint32_t ch, float fs_volts, float shunt_ohms, const float *gain);
+
+// in: frames x ch samples in ring layout; out: frames x ch interleaved
+void dsp_units_amps_f32(const dsp_units_t *u, const uint8_t *in, uint32_t sb, uint32_t frames, float *out);
+void dsp_units_amps_q(const dsp_units_t *u, const uint8_t *in, uint32_t sb, uint32_t frames, int32_t *out_na);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DSP_UNITS_H
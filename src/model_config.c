@@ -38,6 +38,54 @@ esp_err_t cfg_get(cfg_t *out) {
     FLASH_CHECK(s_cfg_nvs, "mqtt_port", &out->mqtt_port); // int
     FLASH_CHECK(s_cfg_nvs, "mqtt_pass", out->mqtt_pass);
 
+    FLASH_CHECK(s_cfg_nvs, "sample_rate_hz", &out->sample_rate_hz); // uint32
+    FLASH_CHECK(s_cfg_nvs, "block_ms", &out->block_ms); // uint32
+    FLASH_CHECK(s_cfg_nvs, "ch_count", &out->ch_count); // uint32
+    FLASH_CHECK(s_cfg_nvs, "pack24", &out->pack24); // bool
+    FLASH_CHECK(s_cfg_nvs, "ds_rates", out->ds_rates);
+    FLASH_CHECK(s_cfg_nvs, "ds_taps", &out->ds_taps); // uint32
+    FLASH_CHECK(s_cfg_nvs, "compress", &out->compress); // bool
+    FLASH_CHECK(s_cfg_nvs, "sdt", &out->sdt); // bool
+    FLASH_CHECK(s_cfg_nvs, "sdt_dev_a", &out->sdt_dev_a); // float
+    FLASH_CHECK(s_cfg_nvs, "sdt_hb_s", &out->sdt_hb_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "trig", out->trig);
+    FLASH_CHECK(s_cfg_nvs, "trig_pre_ms", &out->trig_pre_ms); // uint32
+    FLASH_CHECK(s_cfg_nvs, "trig_post_ms", &out->trig_post_ms); // uint32
+    FLASH_CHECK(s_cfg_nvs, "trig_hyst_pct", &out->trig_hyst_pct); // uint32
+    FLASH_CHECK(s_cfg_nvs, "trig_hb_s", &out->trig_hb_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "charge", &out->charge); // bool
+    FLASH_CHECK(s_cfg_nvs, "qc_pub_s", &out->qc_pub_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "qc_persist_s", &out->qc_persist_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "pipe", out->pipe);
+    FLASH_CHECK(s_cfg_nvs, "pipe_report_s", &out->pipe_report_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "adc_flt", out->adc_flt);
+    FLASH_CHECK(s_cfg_nvs, "rate_auto", &out->rate_auto); // bool
+    FLASH_CHECK(s_cfg_nvs, "raw_min_hz", &out->raw_min_hz); // uint32
+    FLASH_CHECK(s_cfg_nvs, "vad", &out->vad); // bool
+    FLASH_CHECK(s_cfg_nvs, "vad_ch", &out->vad_ch); // uint32
+    FLASH_CHECK(s_cfg_nvs, "vad_quiet_a", &out->vad_quiet_a); // float
+    FLASH_CHECK(s_cfg_nvs, "vad_hold_s", &out->vad_hold_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "adcs", out->adcs);
+    FLASH_CHECK(s_cfg_nvs, "synth_x", &out->synth_x); // uint32
+    FLASH_CHECK(s_cfg_nvs, "ntp", out->ntp);
+    FLASH_CHECK(s_cfg_nvs, "resample", &out->resample); // bool
+    FLASH_CHECK(s_cfg_nvs, "lat_probe_s", &out->lat_probe_s); // uint32
+    FLASH_CHECK(s_cfg_nvs, "lat_slo_ms", &out->lat_slo_ms); // uint32
+    FLASH_CHECK(s_cfg_nvs, "merge_gain", &out->merge_gain); // bool
+    FLASH_CHECK(s_cfg_nvs, "stats_ms", out->stats_ms);
+    FLASH_CHECK(s_cfg_nvs, "fft_n", &out->fft_n); // uint32
+    FLASH_CHECK(s_cfg_nvs, "fft_overlap", &out->fft_overlap); // uint32
+    FLASH_CHECK(s_cfg_nvs, "fft_window", &out->fft_window); // uint32
+    FLASH_CHECK(s_cfg_nvs, "fft_bands", out->fft_bands);
+    FLASH_CHECK(s_cfg_nvs, "fft_peaks", &out->fft_peaks); // uint32
+
+    FLASH_CHECK(s_cfg_nvs, "shunt_ohms", &out->shunt_ohms); // float
+    FLASH_CHECK(s_cfg_nvs, "adc_fs_v", &out->adc_fs_v); // float
+    FLASH_CHECK(s_cfg_nvs, "ina_gain1", &out->ina_gain[0]); // float
+    FLASH_CHECK(s_cfg_nvs, "ina_gain2", &out->ina_gain[1]); // float
+    FLASH_CHECK(s_cfg_nvs, "ina_gain3", &out->ina_gain[2]); // float
+    FLASH_CHECK(s_cfg_nvs, "ina_gain4", &out->ina_gain[3]); // float
+
     return ESP_OK;
 }
 
@@ -59,6 +107,54 @@ esp_err_t cfg_set(const cfg_t *in) {
     FLASH_TRY_SET(s_cfg_nvs, "mqtt_port", in->mqtt_port); 
     FLASH_TRY_SET(s_cfg_nvs, "mqtt_pass", in->mqtt_pass);
 
+    FLASH_TRY_SET(s_cfg_nvs, "sample_rate_hz", in->sample_rate_hz);
+    FLASH_TRY_SET(s_cfg_nvs, "block_ms", in->block_ms);
+    FLASH_TRY_SET(s_cfg_nvs, "ch_count", in->ch_count);
+    FLASH_TRY_SET(s_cfg_nvs, "pack24", in->pack24);
+    FLASH_TRY_SET(s_cfg_nvs, "ds_rates", in->ds_rates);
+    FLASH_TRY_SET(s_cfg_nvs, "ds_taps", in->ds_taps);
+    FLASH_TRY_SET(s_cfg_nvs, "compress", in->compress);
+    FLASH_TRY_SET(s_cfg_nvs, "sdt", in->sdt);
+    FLASH_TRY_SET(s_cfg_nvs, "sdt_dev_a", in->sdt_dev_a);
+    FLASH_TRY_SET(s_cfg_nvs, "sdt_hb_s", in->sdt_hb_s);
+    FLASH_TRY_SET(s_cfg_nvs, "trig", in->trig);
+    FLASH_TRY_SET(s_cfg_nvs, "trig_pre_ms", in->trig_pre_ms);
+    FLASH_TRY_SET(s_cfg_nvs, "trig_post_ms", in->trig_post_ms);
+    FLASH_TRY_SET(s_cfg_nvs, "trig_hyst_pct", in->trig_hyst_pct);
+    FLASH_TRY_SET(s_cfg_nvs, "trig_hb_s", in->trig_hb_s);
+    FLASH_TRY_SET(s_cfg_nvs, "charge", in->charge);
+    FLASH_TRY_SET(s_cfg_nvs, "qc_pub_s", in->qc_pub_s);
+    FLASH_TRY_SET(s_cfg_nvs, "qc_persist_s", in->qc_persist_s);
+    FLASH_TRY_SET(s_cfg_nvs, "pipe", in->pipe);
+    FLASH_TRY_SET(s_cfg_nvs, "pipe_report_s", in->pipe_report_s);
+    FLASH_TRY_SET(s_cfg_nvs, "adc_flt", in->adc_flt);
+    FLASH_TRY_SET(s_cfg_nvs, "rate_auto", in->rate_auto);
+    FLASH_TRY_SET(s_cfg_nvs, "raw_min_hz", in->raw_min_hz);
+    FLASH_TRY_SET(s_cfg_nvs, "vad", in->vad);
+    FLASH_TRY_SET(s_cfg_nvs, "vad_ch", in->vad_ch);
+    FLASH_TRY_SET(s_cfg_nvs, "vad_quiet_a", in->vad_quiet_a);
+    FLASH_TRY_SET(s_cfg_nvs, "vad_hold_s", in->vad_hold_s);
+    FLASH_TRY_SET(s_cfg_nvs, "adcs", in->adcs);
+    FLASH_TRY_SET(s_cfg_nvs, "synth_x", in->synth_x);
+    FLASH_TRY_SET(s_cfg_nvs, "ntp", in->ntp);
+    FLASH_TRY_SET(s_cfg_nvs, "resample", in->resample);
+    FLASH_TRY_SET(s_cfg_nvs, "lat_probe_s", in->lat_probe_s);
+    FLASH_TRY_SET(s_cfg_nvs, "lat_slo_ms", in->lat_slo_ms);
+    FLASH_TRY_SET(s_cfg_nvs, "merge_gain", in->merge_gain);
+    FLASH_TRY_SET(s_cfg_nvs, "stats_ms", in->stats_ms);
+    FLASH_TRY_SET(s_cfg_nvs, "fft_n", in->fft_n);
+    FLASH_TRY_SET(s_cfg_nvs, "fft_overlap", in->fft_overlap);
+    FLASH_TRY_SET(s_cfg_nvs, "fft_window", in->fft_window);
+    FLASH_TRY_SET(s_cfg_nvs, "fft_bands", in->fft_bands);
+    FLASH_TRY_SET(s_cfg_nvs, "fft_peaks", in->fft_peaks);
+
+    FLASH_TRY_SET(s_cfg_nvs, "shunt_ohms", in->shunt_ohms);
+    FLASH_TRY_SET(s_cfg_nvs, "adc_fs_v", in->adc_fs_v);
+    FLASH_TRY_SET(s_cfg_nvs, "ina_gain1", in->ina_gain[0]);
+    FLASH_TRY_SET(s_cfg_nvs, "ina_gain2", in->ina_gain[1]);
+    FLASH_TRY_SET(s_cfg_nvs, "ina_gain3", in->ina_gain[2]);
+    FLASH_TRY_SET(s_cfg_nvs, "ina_gain4", in->ina_gain[3]);
+
     LOG_INFO(TAG, "commiting cfg->serial: %s", in->serial);
     return flash_commit(s_cfg_nvs);
 }
@@ -80,6 +176,53 @@ void cfg_defaults(cfg_t *cfg) {
     cfg->mqtt_port = DEF_MQTT_PORT;
     strncpy(cfg->mqtt_user, DEF_MQTT_USER, sizeof(cfg->mqtt_user));
     strncpy(cfg->mqtt_pass, DEF_MQTT_PASS, sizeof(cfg->mqtt_pass));
+
+    cfg->sample_rate_hz = DEF_SAMPLE_RATE_HZ;
+    cfg->block_ms = DEF_BLOCK_MS;
+    cfg->ch_count = DEF_CH_COUNT;
+    cfg->pack24 = DEF_PACK24;
+    strncpy(cfg->ds_rates, DEF_DS_RATES, sizeof(cfg->ds_rates));
+    cfg->ds_taps = DEF_DS_TAPS;
+    cfg->compress = DEF_COMPRESS;
+    cfg->sdt = DEF_SDT;
+    cfg->sdt_dev_a = DEF_SDT_DEV_A;
+    cfg->sdt_hb_s = DEF_SDT_HB_S;
+    strncpy(cfg->trig, DEF_TRIG, sizeof(cfg->trig));
+    cfg->trig_pre_ms = DEF_TRIG_PRE_MS;
+    cfg->trig_post_ms = DEF_TRIG_POST_MS;
+    cfg->trig_hyst_pct = DEF_TRIG_HYST_PCT;
+    cfg->trig_hb_s = DEF_TRIG_HB_S;
+    cfg->charge = DEF_CHARGE;
+    cfg->qc_pub_s = DEF_QC_PUB_S;
+    cfg->qc_persist_s = DEF_QC_PERSIST_S;
+    strncpy(cfg->pipe, DEF_PIPE, sizeof(cfg->pipe));
+    cfg->pipe_report_s = DEF_PIPE_REPORT_S;
+    strncpy(cfg->adc_flt, DEF_ADC_FLT, sizeof(cfg->adc_flt));
+    cfg->rate_auto = DEF_RATE_AUTO;
+    cfg->raw_min_hz = DEF_RAW_MIN_HZ;
+    cfg->vad = DEF_VAD;
+    cfg->vad_ch = DEF_VAD_CH;
+    cfg->vad_quiet_a = DEF_VAD_QUIET_A;
+    cfg->vad_hold_s = DEF_VAD_HOLD_S;
+    strncpy(cfg->adcs, DEF_ADCS, sizeof(cfg->adcs));
+    cfg->synth_x = DEF_SYNTH_X;
+    strncpy(cfg->ntp, DEF_NTP, sizeof(cfg->ntp));
+    cfg->resample = DEF_RESAMPLE;
+    cfg->lat_probe_s = DEF_LAT_PROBE_S;
+    cfg->lat_slo_ms = DEF_LAT_SLO_MS;
+    cfg->merge_gain = DEF_MERGE_GAIN;
+    strncpy(cfg->stats_ms, DEF_STATS_MS, sizeof(cfg->stats_ms));
+    cfg->fft_n = DEF_FFT_N;
+    cfg->fft_overlap = DEF_FFT_OVERLAP;
+    cfg->fft_window = DEF_FFT_WINDOW;
+    strncpy(cfg->fft_bands, DEF_FFT_BANDS, sizeof(cfg->fft_bands));
+    cfg->fft_peaks = DEF_FFT_PEAKS;
+
+    cfg->shunt_ohms = DEF_SHUNT_OHMS;
+    cfg->adc_fs_v = DEF_ADC_FS_V;
+    for (int i = 0; i < 4; ++i) {
+        cfg->ina_gain[i] = (i & 1) ? DEF_INA_GAIN_HI : DEF_INA_GAIN_LO;
+    }
 }
 
 esp_err_t cfg_validate(cfg_t *cfg) {
@@ -95,6 +238,68 @@ esp_err_t cfg_validate(cfg_t *cfg) {
         LOG_INFO(TAG, "config loaded successfully");
     }
 
+    // Configs written before acquisition settings existed read back as 0
+    if (cfg->sample_rate_hz == 0 || cfg->block_ms == 0 || cfg->ch_count == 0
+    ||  cfg->ds_rates[0] == '\0' || cfg->ds_taps == 0 || cfg->stats_ms[0] == '\0'
+    ||  cfg->fft_bands[0] == '\0' || cfg->trig_post_ms == 0 || cfg->trig_hb_s == 0
+    ||  cfg->qc_pub_s == 0 || cfg->qc_persist_s == 0 || cfg->pipe[0] == '\0' || cfg->pipe_report_s == 0
+    ||  cfg->vad_ch == 0 || cfg->vad_hold_s == 0 || cfg->lat_slo_ms == 0
+    ) {
+        LOG_INFO(TAG, "no acquisition config found; using defaults");
+        if (cfg->sample_rate_hz == 0) cfg->sample_rate_hz = DEF_SAMPLE_RATE_HZ;
+        if (cfg->block_ms == 0) cfg->block_ms = DEF_BLOCK_MS;
+        if (cfg->ch_count == 0) cfg->ch_count = DEF_CH_COUNT;
+        if (cfg->ds_rates[0] == '\0') strncpy(cfg->ds_rates, DEF_DS_RATES, sizeof(cfg->ds_rates));
+        if (cfg->ds_taps == 0) cfg->ds_taps = DEF_DS_TAPS;
+        if (cfg->stats_ms[0] == '\0') strncpy(cfg->stats_ms, DEF_STATS_MS, sizeof(cfg->stats_ms));
+        if (cfg->fft_bands[0] == '\0') {
+            // 0 is a valid overlap, window and peak count, so the spectrum settings go as a set
+            cfg->fft_n = DEF_FFT_N;
+            cfg->fft_overlap = DEF_FFT_OVERLAP;
+            cfg->fft_window = DEF_FFT_WINDOW;
+            strncpy(cfg->fft_bands, DEF_FFT_BANDS, sizeof(cfg->fft_bands));
+            cfg->fft_peaks = DEF_FFT_PEAKS;
+        }
+        if (cfg->trig_post_ms == 0) {
+            cfg->trig_pre_ms = DEF_TRIG_PRE_MS;
+            cfg->trig_post_ms = DEF_TRIG_POST_MS;
+            cfg->trig_hyst_pct = DEF_TRIG_HYST_PCT;
+        }
+        if (cfg->trig_hb_s == 0) cfg->trig_hb_s = DEF_TRIG_HB_S;
+        if (cfg->qc_pub_s == 0) {
+            cfg->charge = DEF_CHARGE;
+            cfg->qc_pub_s = DEF_QC_PUB_S;
+        }
+        if (cfg->qc_persist_s == 0) cfg->qc_persist_s = DEF_QC_PERSIST_S;
+        if (cfg->pipe[0] == '\0') strncpy(cfg->pipe, DEF_PIPE, sizeof(cfg->pipe));
+        if (cfg->pipe_report_s == 0) cfg->pipe_report_s = DEF_PIPE_REPORT_S;
+        if (cfg->vad_ch == 0) cfg->vad_ch = DEF_VAD_CH;
+        if (cfg->vad_hold_s == 0) cfg->vad_hold_s = DEF_VAD_HOLD_S;
+        if (cfg->lat_slo_ms == 0) {
+            cfg->lat_probe_s = DEF_LAT_PROBE_S;
+            cfg->lat_slo_ms = DEF_LAT_SLO_MS;
+        }
+        ESP_RETURN_ON_ERROR(cfg_set(cfg), TAG, "failed to write acquisition config");
+    }
+
+    // Same for the engineering-unit scaling; a non-positive value is never valid
+    bool units_patched = false;
+    if (!(cfg->shunt_ohms > 0.0f)) { cfg->shunt_ohms = DEF_SHUNT_OHMS; units_patched = true; }
+    if (!(cfg->adc_fs_v > 0.0f)) { cfg->adc_fs_v = DEF_ADC_FS_V; units_patched = true; }
+    if (!(cfg->sdt_dev_a > 0.0f)) { cfg->sdt_dev_a = DEF_SDT_DEV_A; units_patched = true; }
+    if (!(cfg->vad_quiet_a > 0.0f)) { cfg->vad_quiet_a = DEF_VAD_QUIET_A; units_patched = true; }
+    if (cfg->sdt_hb_s == 0) { cfg->sdt_hb_s = DEF_SDT_HB_S; units_patched = true; }
+    for (int i = 0; i < 4; ++i) {
+        if (!(cfg->ina_gain[i] > 0.0f)) {
+            cfg->ina_gain[i] = (i & 1) ? DEF_INA_GAIN_HI : DEF_INA_GAIN_LO;
+            units_patched = true;
+        }
+    }
+    if (units_patched) {
+        LOG_INFO(TAG, "no unit scaling config found; using defaults");
+        ESP_RETURN_ON_ERROR(cfg_set(cfg), TAG, "failed to write unit scaling config");
+    }
+
     return ESP_OK;
 }
 
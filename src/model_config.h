@@ -4,6 +4,7 @@
 #include "esp_err.h"
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +25,52 @@ extern "C" {
 #define DEF_MQTT_USER "JaQCAPI"
 #define DEF_MQTT_PASS "im2#1*2n2"
 
+#define DEF_SAMPLE_RATE_HZ (uint32_t)8000
+#define DEF_BLOCK_MS (uint32_t)8
+#define DEF_CH_COUNT (uint32_t)2
+#define DEF_PACK24 false
+#define DEF_DS_RATES "1000"
+#define DEF_DS_TAPS (uint32_t)96
+#define DEF_STATS_MS "10,100,1000"
+#define DEF_MERGE_GAIN false
+#define DEF_COMPRESS false
+#define DEF_SDT false
+#define DEF_SDT_DEV_A 1e-6f             // 1 uA
+#define DEF_SDT_HB_S (uint32_t)60
+#define DEF_TRIG ""                     // "" = trigger engine off
+#define DEF_TRIG_PRE_MS (uint32_t)100
+#define DEF_TRIG_POST_MS (uint32_t)400
+#define DEF_TRIG_HYST_PCT (uint32_t)10
+#define DEF_TRIG_HB_S (uint32_t)60
+#define DEF_CHARGE true
+#define DEF_QC_PUB_S (uint32_t)10
+#define DEF_QC_PERSIST_S (uint32_t)600   // flash wear: ~50k commits over 1 year at 10 min
+#define DEF_PIPE "0:charge,ds,stats,fft,trig"
+#define DEF_PIPE_REPORT_S (uint32_t)10
+#define DEF_ADC_FLT ""                  // "" = on-chip filters all-pass
+#define DEF_RATE_AUTO true
+#define DEF_RAW_MIN_HZ (uint32_t)0      // 0 = sample_rate_hz while stats / triggers / charge are on, else any rate
+#define DEF_VAD false
+#define DEF_VAD_CH (uint32_t)1
+#define DEF_VAD_QUIET_A 0.0005f
+#define DEF_VAD_HOLD_S (uint32_t)30
+#define DEF_ADCS ""                     // "" = one ADC at 0x4E, ch_count channels
+#define DEF_SYNTH_X (uint32_t)0         // 0 = real ADCs
+#define DEF_NTP "pool.ntp.org"          // "" = no SNTP; clock error is against the crystal
+#define DEF_RESAMPLE false
+#define DEF_LAT_PROBE_S 10
+#define DEF_LAT_SLO_MS 250
+#define DEF_FFT_N (uint32_t)0           // 0 = spectrum off
+#define DEF_FFT_OVERLAP (uint32_t)50
+#define DEF_FFT_WINDOW (uint32_t)1      // dsp_window_t: 0 rect, 1 Hann, 2 Hamming, 3 Blackman
+#define DEF_FFT_BANDS "0-100,100-500,500-2000,2000-4000"
+#define DEF_FFT_PEAKS (uint32_t)3
+
+#define DEF_SHUNT_OHMS 2.0f
+#define DEF_ADC_FS_V 1.414f         // 1 VRMS single-ended full scale, as peak volts
+#define DEF_INA_GAIN_LO 50.0f       // INA213
+#define DEF_INA_GAIN_HI 1000.0f     // INA212
+
 typedef struct {
     char serial[11];
     char hw_class[4];
@@ -40,7 +87,50 @@ typedef struct {
     char mqtt_user[64];
     char mqtt_pass[64];
 
-    uint32_t sample_rate_hz;
+    uint32_t sample_rate_hz;    // ADC / I2S frame rate (8000 - 96000); with rate_auto, the fallback
+    uint32_t block_ms;          // target duration of one DMA block; trades latency for per-block overhead
+    uint32_t ch_count;          // 2 = I2S stereo, 4 = TDM (CH1..CH4); with adcs set, derived from it
+    bool pack24;                // packed 3-byte samples (JQMB slot_bits=24) instead of 32-bit slots
+    char ds_rates[48];          // published output rates in Hz, comma separated (e.g. "2000,500,100,10")
+    uint32_t ds_taps;           // anti-alias / CIC compensation FIR length
+    bool compress;              // lossless-code decimated payloads (linear prediction + Rice)
+    bool sdt;                   // publish swinging-door points instead of sample blocks
+    float sdt_dev_a;            // swinging-door tolerance, amps
+    uint32_t sdt_hb_s;          // swinging-door heartbeat, seconds
+    char trig[96];              // triggers, "ch:level:A", "ch:slope:A_per_ms", "ch:window:lo_A:hi_A", comma separated
+    uint32_t trig_pre_ms;       // history published ahead of the trigger
+    uint32_t trig_post_ms;      // capture length from the trigger on
+    uint32_t trig_hyst_pct;     // re-arm hysteresis, percent of the threshold
+    uint32_t trig_hb_s;         // heartbeat while no capture is published
+    bool charge;                // full-rate coulomb counters, persisted to NVS
+    uint32_t qc_pub_s;          // charge counter publish period
+    uint32_t qc_persist_s;      // charge counter NVS save period; at most this much is lost on power failure
+    char pipe[64];              // stage placement, "core:stage,stage;core:stage,..."
+    uint32_t pipe_report_s;     // per-stage cycle / latency report period
+    char adc_flt[48];           // on-chip filter chain, e.g. "hpf1:1,lpf:2000,notch:60:30"
+    bool rate_auto;             // capture at the lowest native rate the consumers need (else sample_rate_hz)
+    uint32_t raw_min_hz;        // lowest full rate stats / triggers / charge accept (0: sample_rate_hz if any is on)
+    bool vad;                   // idle in the ADC's voice-activity detector while the signal is quiet
+    uint32_t vad_ch;            // channel the VAD and the quiet test watch, 1-based
+    float vad_quiet_a;          // per-block peak-to-peak below which a block counts as quiet
+    uint32_t vad_hold_s;        // quiet time before going idle
+    char adcs[32];              // ADCs on the TDM line, "addr:channels,..." in hex, e.g. "4C:4,4D:4"
+    uint32_t synth_x;           // synthetic source at this multiple of real time instead of the ADCs; 0 = off
+    char ntp[48];               // SNTP server disciplining the time base the sample clock is measured against
+    bool resample;              // resample decimated streams to exactly their nominal rate
+    uint32_t lat_probe_s;       // latency probe period, 0 = off
+    uint32_t lat_slo_ms;        // ADC-to-subscriber latency the p99 must stay under
+    bool merge_gain;            // publish CH1/CH2 (and CH3/CH4) as one auto-ranged channel each
+    char stats_ms[32];          // statistics windows in ms, comma separated ("0" = none)
+    uint32_t fft_n;             // real FFT points (256 - 4096), 0 = spectrum off
+    uint32_t fft_overlap;       // percent (0 - 90)
+    uint32_t fft_window;        // 0 rect, 1 Hann, 2 Hamming, 3 Blackman
+    char fft_bands[64];         // band power ranges in Hz, "lo-hi" comma separated
+    uint32_t fft_peaks;         // spectral peaks reported per channel (0 - 8)
+
+    float shunt_ohms;           // current shunt shared by all channels
+    float adc_fs_v;             // ADC input volts at digital full scale (2^23 counts)
+    float ina_gain[4];          // shunt amplifier gain (V/V) per channel: CH1 INA213, CH2 INA212, ...
 
 } cfg_t;
 
@@ -150,6 +150,17 @@ esp_err_t flash_get_str(nvs_handle_t handle, const char *key, char *dest, size_t
     return ESP_OK;
 }
 
+// Missing key: zero-filled, like the scalar getters
+esp_err_t flash_get_blob(nvs_handle_t handle, const char *key, void *dest, size_t size) {
+    size_t required_size = size;
+    esp_err_t err = nvs_get_blob(handle, key, dest, &required_size);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        memset(dest, 0, size);
+        return ESP_OK;
+    }
+    return err;
+}
+
 
 // === SETTERS ===
 
@@ -165,6 +176,10 @@ esp_err_t flash_set_i32(nvs_handle_t handle, const char *key, int32_t value) {
     return nvs_set_i32(handle, key, value);
 }
 
+esp_err_t flash_set_u32(nvs_handle_t handle, const char *key, uint32_t value) {
+    return nvs_set_u32(handle, key, value);
+}
+
 esp_err_t flash_set_float(nvs_handle_t handle, const char *key, float value) {
     return nvs_set_blob(handle, key, &value, sizeof(float));
 }
@@ -172,3 +187,7 @@ esp_err_t flash_set_float(nvs_handle_t handle, const char *key, float value) {
 esp_err_t flash_set_str(nvs_handle_t handle, const char *key, const char *value) {
     return nvs_set_str(handle, key, value);
 }
+
+esp_err_t flash_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t size) {
+    return nvs_set_blob(handle, key, value, size);
+}
@@ -79,6 +79,7 @@ esp_err_t flash_set_u8      (nvs_handle_t,  const char*,    uint8_t);
 esp_err_t flash_set_u32     (nvs_handle_t,  const char*,    uint32_t);
 esp_err_t flash_set_float   (nvs_handle_t,  const char*,    float);
 esp_err_t flash_set_str     (nvs_handle_t,  const char*,    const char*);
+esp_err_t flash_set_blob    (nvs_handle_t,  const char*,    const void*, size_t);
 
 // Generic setter macro dispatcher using _Generic
 #define FLASH_SET(handle, key, value) _Generic((value), \
@@ -87,7 +88,7 @@ esp_err_t flash_set_str     (nvs_handle_t,  const char*,    const char*);
     int8_t *:           flash_set_i8,       \
     int32_t:            flash_set_i32,      \
     uint8_t *:          flash_set_u8,       \
-    uint32_t *:         flash_set_u32,      \
+    uint32_t:           flash_set_u32,      \
     float:              flash_set_float,    \
     char *:             flash_set_str,      \
     const char *:       flash_set_str       \
@@ -0,0 +1,55 @@
+#include "util_hist.h"
+
+#include <string.h>
+
+void hist_reset(hist_t *h) {
+    memset(h, 0, sizeof(*h));
+}
+
+/* Bucket of v: values below HIST_SUB map to themselves; otherwise the octave
+   (position of the top bit above the sub-bucket bits) picks a row and the
+   HIST_SUB_BITS bits under the top bit pick the column. */
+static uint32_t bucket_of(uint32_t v) {
+    if (v < HIST_SUB) return v;
+    const uint32_t top = 31 - (uint32_t)__builtin_clz(v);     // >= HIST_SUB_BITS
+    const uint32_t shift = top - HIST_SUB_BITS;
+    return HIST_SUB * (shift + 1) + ((v >> shift) & (HIST_SUB - 1));
+}
+
+// Largest value that maps to bucket b
+static uint32_t bucket_top(uint32_t b) {
+    if (b < HIST_SUB) return b;
+    const uint32_t shift = b / HIST_SUB - 1;
+    const uint64_t lo = (uint64_t)(HIST_SUB + b % HIST_SUB) << shift;
+    const uint64_t hi = lo + ((uint64_t)1 << shift) - 1;
+    return hi > UINT32_MAX ? UINT32_MAX : (uint32_t)hi;
+}
+
+void hist_add(hist_t *h, uint32_t v) {
+    h->bucket[bucket_of(v)]++;
+    h->count++;
+    h->sum += v;
+    if (v > h->max) h->max = v;
+}
+
+uint32_t hist_percentile(const hist_t *h, float p) {
+    if (h->count == 0) return 0;
+    uint64_t want = (uint64_t)((double)p * h->count / 100.0 + 0.999999);
+    if (want < 1) want = 1;
+    if (want > h->count) want = h->count;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < HIST_BUCKETS; ++b) {
+        seen += h->bucket[b];
+        if (seen >= want) {
+            const uint32_t top = bucket_top(b);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+uint32_t hist_count_above(const hist_t *h, uint32_t v) {
+    uint32_t n = 0;
+    for (uint32_t b = bucket_of(v) + 1; b < HIST_BUCKETS; ++b) n += h->bucket[b];
+    return n; // values sharing v's bucket count as not above
+}
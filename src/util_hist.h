@@ -0,0 +1,46 @@
+#ifndef UTIL_HIST_H
+#define UTIL_HIST_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Fixed-memory log-linear histogram of microsecond latencies, for percentiles
+ without keeping samples.
+
+ Values below HIST_SUB land in their own bucket; above that every power of two
+ is split into HIST_SUB buckets, so a reported percentile is within 1 / HIST_SUB
+ (~3 %) of the true value, from 1 us up to about 70 minutes. Percentiles report
+ the bucket's upper edge, never below the true value. Recording is a few
+ instructions and no allocation.
+
+ No ESP-IDF dependencies; builds on Linux. */
+
+#define HIST_SUB_BITS   5
+#define HIST_SUB        (1u << HIST_SUB_BITS)
+#define HIST_OCTAVES    (32 - HIST_SUB_BITS)
+#define HIST_BUCKETS    (HIST_SUB * (HIST_OCTAVES + 1))
+
+typedef struct {
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bucket[HIST_BUCKETS];
+} hist_t;
+
+void hist_reset(hist_t *h);
+void hist_add(hist_t *h, uint32_t v);
+
+// Smallest value v with at least p percent of the samples <= v (0 when empty)
+uint32_t hist_percentile(const hist_t *h, float p);
+
+// Samples above v
+uint32_t hist_count_above(const hist_t *h, uint32_t v);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_HIST_H
@@ -267,6 +267,11 @@ esp_err_t util_mqtt_publish_bytes(const char *topic, const uint8_t *data, size_t
     return (msg_id >= 0) ? ESP_OK : ESP_FAIL;
 }
 
+int util_mqtt_publish_bytes_id(const char *topic, const uint8_t *data, size_t len, int qos, bool retain) {
+    if (!s_client || !s_connected) return -1;
+    return esp_mqtt_client_publish(s_client, topic, (const char *)data, (int)len, qos, retain);
+}
+
 // int util_mqtt_enqueue_bytes(const char *topic, const uint8_t *data, size_t len, int qos, bool retain) {
 //     if (!s_client || !s_connected) return -1;
 //     // enqueue: always queues to outbox; returns msg_id or -1
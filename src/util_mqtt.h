@@ -61,6 +61,8 @@ int util_mqtt_publish(const char *topic, const void *payload, int len, int qos,
 int util_mqtt_publish_str(const char *topic, const char *str, int qos, bool retain);
 int util_mqtt_publish_json(const char *topic, cJSON *obj, int qos, bool retain);
 esp_err_t util_mqtt_publish_bytes(const char *topic, const uint8_t *data, size_t len, int qos, bool retain);
+// As util_mqtt_publish_bytes, returning the msg_id (QoS > 0: NET_EVENT_MQTT_PUBLISHED carries it on PUBACK), or -1
+int util_mqtt_publish_bytes_id(const char *topic, const uint8_t *data, size_t len, int qos, bool retain);
 
 int util_mqtt_enqueue_bytes(const char *topic, const uint8_t *data, size_t len, int qos, bool retain);
 
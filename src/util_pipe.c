@@ -0,0 +1,157 @@
+#include "util_pipe.h"
+#include "util_err.h"
+
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "UTIL_PIPE";
+
+esp_err_t pipe_init(pipe_t *p, uint32_t depth, uint32_t frames, uint32_t ch) {
+    if (!p || depth == 0 || frames == 0 || ch == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(p, 0, sizeof(*p));
+    p->depth  = depth;
+    p->bufs   = calloc(depth, sizeof(pipe_buf_t));
+    p->mem    = malloc((size_t)depth * frames * ch * sizeof(int32_t));
+    p->free_q = xQueueCreate(depth, sizeof(pipe_buf_t *));
+    if (!p->bufs || !p->mem || !p->free_q) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint32_t i = 0; i < depth; ++i) {
+        pipe_buf_t *b = &p->bufs[i];
+        b->data   = p->mem + (size_t)i * frames * ch;
+        b->frames = frames;
+        atomic_init(&b->refs, 0);
+        xQueueSend(p->free_q, &b, 0);
+    }
+    p->pool_bytes = (size_t)depth * (sizeof(pipe_buf_t) + (size_t)frames * ch * sizeof(int32_t) + sizeof(pipe_buf_t *));
+    return ESP_OK;
+}
+
+int pipe_add_lane(pipe_t *p, int core) {
+    if (p->n_lanes == PIPE_MAX_LANES) {
+        return -1;
+    }
+    pipe_lane_t *l = &p->lanes[p->n_lanes];
+    memset(l, 0, sizeof(*l));
+    l->core = core;
+    l->pipe = p;
+    l->in   = xQueueCreate(p->depth, sizeof(pipe_buf_t *));
+    if (!l->in) {
+        return -1;
+    }
+    p->pool_bytes += (size_t)p->depth * sizeof(pipe_buf_t *);
+    return (int)p->n_lanes++;
+}
+
+esp_err_t pipe_add_stage(pipe_t *p, uint32_t lane, const char *name, pipe_stage_fn_t fn, void *ctx) {
+    if (lane >= p->n_lanes || !fn) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pipe_lane_t *l = &p->lanes[lane];
+    if (l->n_stages == PIPE_MAX_STAGES) {
+        return ESP_ERR_NO_MEM;
+    }
+    pipe_stage_t *s = &l->stages[l->n_stages++];
+    memset(s, 0, sizeof(*s));
+    strncpy(s->name, name, sizeof(s->name) - 1);
+    s->fn  = fn;
+    s->ctx = ctx;
+    return ESP_OK;
+}
+
+/* Cycle counts are per core; a lane is pinned, so a stage never straddles two
+   counters. Preemption by higher-priority work (Wi-Fi, lwIP) is charged to the
+   stage it interrupts, so max_cycles is an upper bound. */
+static void lane_task(void *arg) {
+    pipe_lane_t *l = (pipe_lane_t *)arg;
+    pipe_buf_t *b;
+    while (1) {
+        if (xQueueReceive(l->in, &b, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        const uint32_t backlog = (uint32_t)uxQueueMessagesWaiting(l->in) + 1;
+        if (backlog > l->backlog) l->backlog = backlog;
+        for (uint32_t k = 0; k < l->n_stages; ++k) {
+            pipe_stage_t *s = &l->stages[k];
+            const uint32_t c0 = esp_cpu_get_cycle_count();
+            s->fn(s->ctx, b);
+            const uint32_t dc = esp_cpu_get_cycle_count() - c0;
+            const uint32_t lat = (uint32_t)(esp_timer_get_time() - b->t_us);
+            s->calls++;
+            s->cycles += dc;
+            if (dc > s->max_cycles) s->max_cycles = dc;
+            if (lat > s->max_latency_us) s->max_latency_us = lat;
+        }
+        pipe_release(l->pipe, b);
+    }
+}
+
+esp_err_t pipe_start(pipe_t *p, UBaseType_t prio, uint32_t stack) {
+    if (p->n_lanes == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    for (uint32_t i = 0; i < p->n_lanes; ++i) {
+        pipe_lane_t *l = &p->lanes[i];
+        char name[16];
+        snprintf(name, sizeof(name), "pipe_l%lu", i);
+        if (xTaskCreatePinnedToCore(lane_task, name, stack, l, prio, &l->task, l->core) != pdPASS) {
+            LOG_ERR(TAG, ESP_ERR_NO_MEM, "failed to start lane %lu on core %d", i, l->core);
+            return ESP_ERR_NO_MEM;
+        }
+        LOG_INFO(TAG, "lane %lu: core %d, %lu stages", i, l->core, l->n_stages);
+    }
+    return ESP_OK;
+}
+
+pipe_buf_t *pipe_get(pipe_t *p) {
+    pipe_buf_t *b;
+    if (xQueueReceive(p->free_q, &b, 0) != pdTRUE) {
+        p->waits++;
+        xQueueReceive(p->free_q, &b, portMAX_DELAY);
+    }
+    const uint32_t in_flight = p->depth - (uint32_t)uxQueueMessagesWaiting(p->free_q);
+    if (in_flight > p->high_water) p->high_water = in_flight;
+    return b;
+}
+
+/* Lane queues hold depth entries and a buffer sits in each at most once, so the sends never wait */
+void pipe_submit(pipe_t *p, pipe_buf_t *b) {
+    atomic_store_explicit(&b->refs, p->n_lanes, memory_order_relaxed);
+    for (uint32_t i = 0; i < p->n_lanes; ++i) {
+        xQueueSend(p->lanes[i].in, &b, portMAX_DELAY);
+    }
+}
+
+void pipe_hold(const pipe_buf_t *b) {
+    atomic_fetch_add_explicit(&((pipe_buf_t *)b)->refs, 1, memory_order_relaxed);
+}
+
+/* acq_rel: every holder's reads happen before the buffer goes back for refill */
+void pipe_release(pipe_t *p, const pipe_buf_t *b) {
+    pipe_buf_t *m = (pipe_buf_t *)b;
+    if (atomic_fetch_sub_explicit(&m->refs, 1, memory_order_acq_rel) == 1) {
+        xQueueSend(p->free_q, &m, portMAX_DELAY);
+    }
+}
+
+// Counters are written by the lane tasks; a reset racing a stage loses at most one sample
+void pipe_stats_reset(pipe_t *p) {
+    for (uint32_t i = 0; i < p->n_lanes; ++i) {
+        for (uint32_t k = 0; k < p->lanes[i].n_stages; ++k) {
+            pipe_stage_t *s = &p->lanes[i].stages[k];
+            s->calls = 0;
+            s->cycles = 0;
+            s->max_cycles = 0;
+            s->max_latency_us = 0;
+        }
+        p->lanes[i].backlog = 0;
+    }
+    p->high_water = 0;
+    p->waits = 0;
+}
@@ -0,0 +1,112 @@
+#ifndef UTIL_PIPE_H
+#define UTIL_PIPE_H
+
+#include "esp_err.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Block pipeline: stages grouped into lanes, one pinned task per lane. Every
+ lane is a consumer of every block; they share one buffer, never a copy.
+
+                            +--> lane 0 --+
+    source --(pipe_submit)--+--> lane 1 --+--(last release)--> free pool --(pipe_get)--> source
+                            +--> ...    --+
+
+ A fixed pool of depth buffers circulates. pipe_submit() sets a buffer's
+ reference count to the number of lanes and queues it to each; a lane drops its
+ reference after its last stage, and whichever drops the last one returns the
+ buffer to the pool. A stage that needs a block past its call (a recorder or
+ live view handing it to another task) takes another reference with
+ pipe_hold() and gives it back with pipe_release(). Lanes run side by side, so
+ a slow lane holds buffers longer but does not delay the others.
+
+ When every buffer is in flight the source blocks in pipe_get(), which backs
+ pressure up into whatever feeds it (here the DMA ring, which counts what it
+ drops). Stages within a lane run in order on the lane's core. Each stage
+ records CPU cycles per call, the worst call, and the worst latency from
+ buffer arrival to stage done; the pool records how many buffers were out at
+ once and each lane how many were waiting on it. */
+
+#define PIPE_MAX_LANES      4
+#define PIPE_MAX_STAGES     8       // per lane
+#define PIPE_NAME_MAX       12
+
+typedef struct {
+    int32_t *data;          // frames x ch, sign-extended
+    uint32_t frames;
+    uint32_t seq;           // source block sequence
+    uint32_t lost;          // source blocks lost between the previous buffer and this one
+    int64_t  t_us;          // when the source produced the block (esp_timer); stage latency counts from here
+    int32_t  clk_ppb;       // source clock error vs nominal, ppb, as the source measures it
+    atomic_uint refs;       // lanes and holds not yet released
+} pipe_buf_t;
+
+typedef void (*pipe_stage_fn_t)(void *ctx, const pipe_buf_t *b);
+
+typedef struct {
+    char     name[PIPE_NAME_MAX];
+    pipe_stage_fn_t fn;
+    void    *ctx;
+
+    // accounting, since the last pipe_stats_reset()
+    uint32_t calls;
+    uint64_t cycles;
+    uint32_t max_cycles;
+    uint32_t max_latency_us;
+} pipe_stage_t;
+
+typedef struct {
+    int          core;
+    pipe_stage_t stages[PIPE_MAX_STAGES];
+    uint32_t     n_stages;
+    QueueHandle_t in;
+    uint32_t     backlog;   // most buffers queued here at once, the one in work included
+    TaskHandle_t task;
+    struct pipe *pipe;
+} pipe_lane_t;
+
+typedef struct pipe {
+    pipe_lane_t   lanes[PIPE_MAX_LANES];
+    uint32_t      n_lanes;
+    pipe_buf_t   *bufs;
+    int32_t      *mem;
+    uint32_t      depth;
+    size_t        pool_bytes;   // buffers, sample memory and queue storage
+    QueueHandle_t free_q;
+    uint32_t      high_water;   // most buffers in flight at once
+    uint32_t      waits;        // pipe_get() calls that found the pool empty
+} pipe_t;
+
+// depth buffers of frames x ch int32
+esp_err_t pipe_init(pipe_t *p, uint32_t depth, uint32_t frames, uint32_t ch);
+// Returns the new lane's index, or -1
+int pipe_add_lane(pipe_t *p, int core);
+esp_err_t pipe_add_stage(pipe_t *p, uint32_t lane, const char *name, pipe_stage_fn_t fn, void *ctx);
+// Starts one task per lane
+esp_err_t pipe_start(pipe_t *p, UBaseType_t prio, uint32_t stack);
+
+// Source side
+pipe_buf_t *pipe_get(pipe_t *p);                // free buffer; blocks until one is back
+void pipe_submit(pipe_t *p, pipe_buf_t *b);     // to every lane
+
+// Stage side: keep b past the stage call; every hold needs one release
+void pipe_hold(const pipe_buf_t *b);
+void pipe_release(pipe_t *p, const pipe_buf_t *b);
+
+void pipe_stats_reset(pipe_t *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_PIPE_H
@@ -0,0 +1,119 @@
+#include "util_ring.h"
+
+#include <stddef.h>
+
+static inline uint8_t *slot_ptr(ring_t *r, uint32_t idx) {
+    return r->buf + (size_t)(idx & r->mask) * r->slot_sz;
+}
+
+bool ring_init(ring_t *r, uint8_t *buf, uint32_t *seq,
+    uint32_t count, uint32_t slot_sz, ring_overrun_t policy
+) {
+    if (!r || !buf || !seq || count < 2 || (count & (count - 1)) != 0 || slot_sz == 0) {
+        return false;
+    }
+    r->buf     = buf;
+    r->seq     = seq;
+    r->slot_sz = slot_sz;
+    r->mask    = count - 1;
+    r->policy  = policy;
+    ring_reset(r);
+    return true;
+}
+
+// Only call while neither side is running
+void ring_reset(ring_t *r) {
+    atomic_store(&r->head, 0);
+    atomic_store(&r->lease, 0);
+    atomic_store(&r->tail, 0);
+    atomic_store(&r->dropped, 0);
+    atomic_store(&r->overwritten, 0);
+    atomic_store(&r->high_water, 0);
+}
+
+/* ---------- producer ---------- */
+
+uint8_t *ring_write_begin(ring_t *r) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    // Acquire pairs with ring_release(): the consumer is done reading the slot we may reuse
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    if (head - tail <= r->mask) {
+        return slot_ptr(r, head);
+    }
+
+    if (r->policy == RING_OVERWRITE_OLDEST) {
+        // The oldest block can only be discarded if the consumer has not leased it.
+        // Claim it by moving the lease index past it; if the consumer wins the race
+        // (or already holds it) we fall back to dropping the incoming block.
+        uint32_t oldest = tail;
+        if (atomic_compare_exchange_strong_explicit(&r->lease, &oldest, tail + 1,
+                memory_order_acq_rel, memory_order_relaxed)) {
+            atomic_fetch_add_explicit(&r->tail, 1, memory_order_release);
+            atomic_fetch_add_explicit(&r->overwritten, 1, memory_order_relaxed);
+            return slot_ptr(r, head);
+        }
+    }
+
+    atomic_fetch_add_explicit(&r->dropped, 1, memory_order_relaxed);
+    return NULL;
+}
+
+void ring_write_commit(ring_t *r) {
+    uint32_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    r->seq[head & r->mask] = head;
+
+    // Release: slot contents and seq are visible before the consumer can see the new head
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+
+    uint32_t fill = head + 1 - atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (fill > atomic_load_explicit(&r->high_water, memory_order_relaxed)) {
+        atomic_store_explicit(&r->high_water, fill, memory_order_relaxed);
+    }
+}
+
+/* ---------- consumer ---------- */
+
+bool ring_acquire(ring_t *r, ring_block_t *out) {
+    uint32_t idx = atomic_load_explicit(&r->lease, memory_order_acquire);
+    for (;;) {
+        // Acquire pairs with ring_write_commit(): slot contents are complete
+        uint32_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+        if (idx == head) {
+            return false;
+        }
+        // CAS only contends with the producer's overwrite-oldest path
+        if (atomic_compare_exchange_weak_explicit(&r->lease, &idx, idx + 1,
+                memory_order_acq_rel, memory_order_acquire)) {
+            break;
+        }
+    }
+    out->data = slot_ptr(r, idx);
+    out->seq  = r->seq[idx & r->mask];
+    return true;
+}
+
+void ring_release(ring_t *r) {
+    uint32_t tail  = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t lease = atomic_load_explicit(&r->lease, memory_order_relaxed);
+    if (tail == lease) {
+        return; // nothing leased
+    }
+    // Release: our reads of the slot complete before the producer may refill it
+    atomic_fetch_add_explicit(&r->tail, 1, memory_order_release);
+}
+
+/* ---------- stats ---------- */
+
+void ring_get_stats(ring_t *r, ring_stats_t *out) {
+    uint32_t tail  = atomic_load_explicit(&r->tail, memory_order_acquire);
+    uint32_t lease = atomic_load_explicit(&r->lease, memory_order_acquire);
+    uint32_t head  = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    out->produced    = head;
+    out->pending     = head - lease;
+    out->leased      = lease - tail;
+    out->dropped     = atomic_load_explicit(&r->dropped, memory_order_relaxed);
+    out->overwritten = atomic_load_explicit(&r->overwritten, memory_order_relaxed);
+    out->high_water  = atomic_load_explicit(&r->high_water, memory_order_relaxed);
+}
@@ -0,0 +1,80 @@
+#ifndef UTIL_RING_H
+#define UTIL_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lock-free single-producer / single-consumer ring of fixed-size blocks.
+
+ The producer fills a slot in place (ring_write_begin / ring_write_commit).
+ The consumer leases filled slots in place (ring_acquire) and hands them back
+ in the same order (ring_release). Indices are free-running 32-bit counters;
+ slot = index & mask, so the slot count must be a power of two.
+
+    tail <= lease <= head,  head - tail <= count
+    [tail, lease)  leased to the consumer; never overwritten
+    [lease, head)  filled, waiting to be leased
+
+ No ESP-IDF dependencies; builds on Linux for unit / stress testing. */
+
+typedef enum {
+    RING_DROP_NEWEST = 0,   // ring full: discard the incoming block
+    RING_OVERWRITE_OLDEST,  // ring full: discard the oldest un-leased block
+} ring_overrun_t;
+
+typedef struct {
+    uint32_t produced;      // blocks committed by the producer
+    uint32_t pending;       // filled blocks waiting to be leased
+    uint32_t leased;        // blocks currently leased to the consumer
+    uint32_t dropped;       // incoming blocks discarded because the ring was full
+    uint32_t overwritten;   // oldest pending blocks discarded to make room
+    uint32_t high_water;    // max pending + leased ever observed
+} ring_stats_t;
+
+typedef struct {
+    const uint8_t *data;    // slot_sz bytes; valid until released
+    uint32_t seq;           // producer sequence number of this block
+} ring_block_t;
+
+typedef struct {
+    uint8_t        *buf;    // count * slot_sz bytes
+    uint32_t       *seq;    // count entries
+    uint32_t        slot_sz;
+    uint32_t        mask;   // count - 1
+    ring_overrun_t  policy;
+
+    _Atomic uint32_t head;  // next index to fill      (producer)
+    _Atomic uint32_t lease; // next index to lease     (consumer; producer under overwrite)
+    _Atomic uint32_t tail;  // oldest unreleased index (consumer; producer under overwrite)
+
+    _Atomic uint32_t dropped;
+    _Atomic uint32_t overwritten;
+    _Atomic uint32_t high_water;
+} ring_t;
+
+// Storage is owned by the caller. Returns false unless count is a power of two.
+bool ring_init(ring_t *r, uint8_t *buf, uint32_t *seq,
+    uint32_t count, uint32_t slot_sz, ring_overrun_t policy);
+void ring_reset(ring_t *r);
+
+// Producer
+uint8_t *ring_write_begin(ring_t *r); // slot to fill, or NULL if the block must be dropped
+void ring_write_commit(ring_t *r);    // publish the slot returned by ring_write_begin()
+
+// Consumer
+bool ring_acquire(ring_t *r, ring_block_t *out); // lease the oldest filled block
+void ring_release(ring_t *r);                    // return the oldest lease
+
+// Either side
+void ring_get_stats(ring_t *r, ring_stats_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_RING_H
@@ -0,0 +1,146 @@
+#include "util_time.h"
+#include "util_err.h"
+#include "util_net_events.h"
+
+#include "esp_netif_sntp.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+
+#include <string.h>
+#include <sys/time.h>
+
+static const char *TAG = "UTIL_TIME";
+
+#define TIME_STEP_PPM   500     // a fit further off than this means the server stepped
+
+typedef struct {
+    int64_t timer_us;
+    int64_t utc_us;
+} sync_pt_t;
+
+static char s_server[64];
+static bool s_started = false;
+
+// Only the SNTP callback (lwIP task) writes the history
+static sync_pt_t s_pts[TIME_SYNC_POINTS];
+static uint32_t  s_n_pts = 0;
+
+// What readers see; swapped under s_lock
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static sync_pt_t s_anchor;              // latest sync
+static double    s_slope = 1.0;         // UTC us per esp_timer us
+static bool      s_synced = false;
+static bool      s_disciplined = false;
+
+/* Least-squares slope of UTC against esp_timer over the held syncs, about the
+   newest one so the sums stay small */
+static double fit_slope(const sync_pt_t *now, uint32_t n, int64_t *span_us) {
+    double mx = 0.0, my = 0.0;
+    int64_t span = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const int64_t dx = s_pts[i].timer_us - now->timer_us;
+        mx += (double)dx;
+        my += (double)(s_pts[i].utc_us - now->utc_us);
+        if (-dx > span) span = -dx;
+    }
+    mx /= n;
+    my /= n;
+    double sxx = 0.0, sxy = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const double dx = (double)(s_pts[i].timer_us - now->timer_us) - mx;
+        const double dy = (double)(s_pts[i].utc_us - now->utc_us) - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+    }
+    *span_us = span;
+    return sxx > 0.0 ? sxy / sxx : 1.0;
+}
+
+static void on_time_sync(struct timeval *tv) {
+    const sync_pt_t pt = {
+        .timer_us = esp_timer_get_time(),
+        .utc_us   = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec,
+    };
+    s_pts[s_n_pts % TIME_SYNC_POINTS] = pt;
+    s_n_pts++;
+
+    const uint32_t n = s_n_pts < TIME_SYNC_POINTS ? s_n_pts : TIME_SYNC_POINTS;
+    int64_t span = 0;
+    double slope = n >= 3 ? fit_slope(&pt, n, &span) : 1.0;
+    if (slope > 1.0 + TIME_STEP_PPM * 1e-6 || slope < 1.0 - TIME_STEP_PPM * 1e-6) {
+        LOG_WARN(TAG, ESP_ERR_INVALID_STATE, "SNTP time stepped (fit %.1f ppm); restarting the rate fit",
+            (slope - 1.0) * 1e6);
+        s_pts[0] = pt;
+        s_n_pts = 1;
+        slope = 1.0;
+        span = 0;
+    }
+    const bool disciplined = n >= 3 && span >= (int64_t)TIME_FIT_MIN_S * 1000000;
+
+    taskENTER_CRITICAL(&s_lock);
+    s_anchor      = pt;
+    s_slope       = disciplined ? slope : 1.0;
+    s_synced      = true;
+    s_disciplined = disciplined;
+    taskEXIT_CRITICAL(&s_lock);
+
+    LOG_INFO(TAG, "SNTP sync %lu: %lu points over %lu s, esp_timer %+.3f ppm%s", s_n_pts, n,
+        (uint32_t)(span / 1000000), disciplined ? (1.0 / slope - 1.0) * 1e6 : 0.0, disciplined ? "" : " (not yet fitted)");
+    esp_event_post(NET_EVENT, NET_EVENT_TIME_SYNC_OK, NULL, 0, 0);
+}
+
+static void on_wifi_sta_got_ip(void *arg, esp_event_base_t base, int32_t id, void *data) {
+    if (s_started) return; // SNTP keeps polling across reconnects
+
+    esp_sntp_config_t cfg = ESP_NETIF_SNTP_DEFAULT_CONFIG(s_server);
+    cfg.sync_cb = on_time_sync;
+    sntp_set_sync_interval(TIME_SYNC_INTERVAL_MS);
+    esp_err_t err = esp_netif_sntp_init(&cfg);
+    if (err) {
+        LOG_ERR(TAG, err, "SNTP start failed (%s)", s_server);
+        esp_event_post(NET_EVENT, NET_EVENT_TIME_SYNC_FAIL, NULL, 0, 0);
+        return;
+    }
+    s_started = true;
+    LOG_INFO(TAG, "SNTP started (%s, every %d s)", s_server, TIME_SYNC_INTERVAL_MS / 1000);
+}
+
+esp_err_t time_sync_init(const char *server) {
+    if (!server || server[0] == '\0') {
+        LOG_INFO(TAG, "no SNTP server; sample clock is measured against the local crystal");
+        return ESP_OK;
+    }
+    strncpy(s_server, server, sizeof(s_server) - 1);
+    esp_err_t err = net_events_subscribe(NET_EVENT_WIFI_STA_GOT_IP, on_wifi_sta_got_ip, NULL);
+    if (err) return err;
+    if (net_events_wifi_has_ip()) {
+        on_wifi_sta_got_ip(NULL, NET_EVENT, NET_EVENT_WIFI_STA_GOT_IP, NULL);
+    }
+    return ESP_OK;
+}
+
+bool time_is_synced(void) {
+    return s_synced;
+}
+
+bool time_is_disciplined(void) {
+    return s_disciplined;
+}
+
+int32_t time_timer_ppb(void) {
+    taskENTER_CRITICAL(&s_lock);
+    const double slope = s_slope;
+    taskEXIT_CRITICAL(&s_lock);
+    return (int32_t)((1.0 / slope - 1.0) * 1e9);
+}
+
+int64_t time_utc_us(int64_t timer_us) {
+    taskENTER_CRITICAL(&s_lock);
+    const sync_pt_t a = s_anchor;
+    const double slope = s_slope;
+    const bool synced = s_synced;
+    taskEXIT_CRITICAL(&s_lock);
+    if (!synced) return 0;
+    return a.utc_us + (int64_t)((double)(timer_us - a.timer_us) * slope);
+}
@@ -0,0 +1,47 @@
+#ifndef UTIL_TIME_H
+#define UTIL_TIME_H
+
+#include "esp_err.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SNTP-disciplined time base.
+
+ SNTP starts on the first NET_EVENT_WIFI_STA_GOT_IP and resyncs every
+ TIME_SYNC_INTERVAL_MS. Each sync pairs the server's time with esp_timer;
+ a least-squares line through the last TIME_SYNC_POINTS pairs gives the
+ crystal's rate error against UTC and maps esp_timer readings to UTC.
+
+ esp_timer (SYSTIMER) and the I2S clock both divide the same 40 MHz crystal,
+ so a sample rate measured against esp_timer only shows the I2S divider's
+ error; the crystal's own error comes from here. */
+
+#define TIME_SYNC_INTERVAL_MS   (5 * 60 * 1000)
+#define TIME_SYNC_POINTS        16      // ~80 min of syncs in the fit
+#define TIME_FIT_MIN_S          900     // span before the rate error is trusted
+
+// Subscribe to IP events; server "" leaves SNTP off
+esp_err_t time_sync_init(const char *server);
+
+// At least one SNTP sync since boot
+bool time_is_synced(void);
+
+// The rate fit spans TIME_FIT_MIN_S; time_timer_ppb() is meaningful
+bool time_is_disciplined(void);
+
+// esp_timer rate error against UTC, ppb (positive: esp_timer runs fast); 0 until disciplined
+int32_t time_timer_ppb(void);
+
+// esp_timer microseconds -> UTC microseconds since the epoch; 0 until synced
+int64_t time_utc_us(int64_t timer_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UTIL_TIME_H
@@ -0,0 +1,45 @@
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+/* Timing for the benchmark tests, on the host and on the S3.
+
+ bench_now_us() is a monotonic microsecond clock. bench_report() prints time
+ per item and, on target, CPU cycles per item at the configured clock, as a
+ Unity message so it lands in the test log next to the pass / fail lines. */
+
+#include "unity.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+#include "sdkconfig.h"
+
+static inline int64_t bench_now_us(void) {
+    return esp_timer_get_time();
+}
+#else
+#include <time.h>
+
+static inline int64_t bench_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+#endif
+
+// us spent on items things, e.g. "pack24 512 samples", per "sample"
+static inline void bench_report(const char *what, int64_t us, double items, const char *unit) {
+    char line[160];
+    const double ns = items > 0 ? 1000.0 * (double)us / items : 0.0;
+#ifdef ESP_PLATFORM
+    snprintf(line, sizeof(line), "%s: %.1f ns/%s, %.1f cycles/%s @ %d MHz",
+        what, ns, unit, ns * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ / 1000.0, unit, CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ);
+#else
+    snprintf(line, sizeof(line), "%s: %.2f ns/%s (host)", what, ns, unit);
+#endif
+    TEST_MESSAGE(line);
+}
+
+#endif // TEST_BENCH_H
@@ -0,0 +1,159 @@
+/* dsp_biquad: the RBJ designs give the textbook response once quantised to the
+   ADC's Q31 register form (-3 dB corners, notch depth, unity pass band), the
+   register values for a few fixed designs stay put, the all-pass designs are
+   the ADC's reset values, an over-range numerator is scaled as a whole, and
+   the coefficients go out big-endian. */
+
+#include "unity.h"
+#include "dsp_biquad.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#define PI      3.14159265358979323846
+#define FS      48000.0
+#define Q31     2147483648.0
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Golden values, to within the last bit of the target's libm
+static void assert_regs(const int32_t *want, const int32_t *r, int n) {
+    for (int k = 0; k < n; ++k) TEST_ASSERT_INT32_WITHIN(1, want[k], r[k]);
+}
+
+static void design(int32_t r[DSP_BQ_COEFS], dsp_bq_type_t type, double f0, double q) {
+    dsp_biquad_t bq;
+    TEST_ASSERT_TRUE(dsp_biquad_design(&bq, type, FS, f0, q));
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, dsp_biquad_regs(&bq, r));
+}
+
+// |H(f)| of the first-order IIR registers: (N0 + N1 z^-1) / (1 - D1 z^-1), Q31
+static double iir1_mag(const int32_t r[DSP_IIR1_COEFS], double f) {
+    const double w = 2.0 * PI * f / FS;
+    const double n0 = r[0] / Q31, n1 = r[1] / Q31, d1 = r[2] / Q31;
+    const double nr = n0 + n1 * cos(w), ni = -n1 * sin(w);
+    const double dr = 1.0 - d1 * cos(w), di = d1 * sin(w);
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+static void test_rejects_bad_designs(void) {
+    dsp_biquad_t bq;
+    dsp_iir1_t f;
+    TEST_ASSERT_FALSE(dsp_biquad_design(NULL, DSP_BQ_LPF, FS, 1000, 0.7071));
+    TEST_ASSERT_FALSE(dsp_biquad_design(&bq, DSP_BQ_LPF, 0, 1000, 0.7071));
+    TEST_ASSERT_FALSE(dsp_biquad_design(&bq, DSP_BQ_LPF, FS, 0, 0.7071));
+    TEST_ASSERT_FALSE(dsp_biquad_design(&bq, DSP_BQ_LPF, FS, FS / 2, 0.7071));
+    TEST_ASSERT_FALSE(dsp_biquad_design(&bq, DSP_BQ_NOTCH, FS, 60, 0));
+    TEST_ASSERT_FALSE(dsp_iir1_hpf(&f, FS, -1));
+    TEST_ASSERT_FALSE(dsp_iir1_hpf(&f, FS, FS / 2));
+}
+
+// fc = 0 / ALLPASS are what the ADC holds after reset: N0 = 0x7FFFFFFF, rest 0
+static void test_allpass_is_reset_value(void) {
+    dsp_biquad_t bq;
+    dsp_iir1_t f;
+    int32_t r[DSP_BQ_COEFS], ri[DSP_IIR1_COEFS];
+    TEST_ASSERT_TRUE(dsp_biquad_design(&bq, DSP_BQ_ALLPASS, FS, 0, 0));
+    dsp_biquad_regs(&bq, r);
+    TEST_ASSERT_EQUAL_HEX32(0x7FFFFFFF, r[0]);
+    for (int k = 1; k < DSP_BQ_COEFS; ++k) TEST_ASSERT_EQUAL_INT32(0, r[k]);
+    TEST_ASSERT_TRUE(dsp_iir1_hpf(&f, FS, 0));
+    dsp_iir1_regs(&f, ri);
+    TEST_ASSERT_EQUAL_HEX32(0x7FFFFFFF, ri[0]);
+    TEST_ASSERT_EQUAL_INT32(0, ri[1]);
+    TEST_ASSERT_EQUAL_INT32(0, ri[2]);
+}
+
+// 2 kHz Butterworth low-pass at 48 kHz: unity at DC, -3 dB at fc, 0.0012 at 20 kHz
+static void test_lpf(void) {
+    static const int32_t want[DSP_BQ_COEFS] = { 30926812, 30926812, 30926812, 1753410455, -1483044509 };
+    int32_t r[DSP_BQ_COEFS];
+    design(r, DSP_BQ_LPF, 2000, 0.7071);
+    assert_regs(want, r, DSP_BQ_COEFS);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 1.0, dsp_biquad_regs_mag(r, FS, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 0.7071, dsp_biquad_regs_mag(r, FS, 2000));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 0.0012, dsp_biquad_regs_mag(r, FS, 20000));
+}
+
+// 100 Hz high-pass: -3 dB at fc, unity at Nyquist, nothing at DC
+static void test_hpf(void) {
+    static const int32_t want[DSP_BQ_COEFS] = { 2127698045, -2127698045, 2127698045, 2127606899, -2108094736 };
+    int32_t r[DSP_BQ_COEFS];
+    design(r, DSP_BQ_HPF, 100, 0.7071);
+    assert_regs(want, r, DSP_BQ_COEFS);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 0.7071, dsp_biquad_regs_mag(r, FS, 100));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 1.0, dsp_biquad_regs_mag(r, FS, FS / 2));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 0.0, dsp_biquad_regs_mag(r, FS, 0));
+}
+
+// 60 Hz, Q 30 notch: 80 dB deep at 60 Hz, flat a few bandwidths away
+static void test_notch(void) {
+    static const int32_t want[DSP_BQ_COEFS] = { 2147202583, -2147136358, 2147202583, 2147136358, -2146921517 };
+    int32_t r[DSP_BQ_COEFS];
+    design(r, DSP_BQ_NOTCH, 60, 30);
+    assert_regs(want, r, DSP_BQ_COEFS);
+    TEST_ASSERT_LESS_THAN_DOUBLE(1e-4, dsp_biquad_regs_mag(r, FS, 60));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 1.0, dsp_biquad_regs_mag(r, FS, 0));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 1.0, dsp_biquad_regs_mag(r, FS, 1000));
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.7071, dsp_biquad_regs_mag(r, FS, 61));    // bandwidth fc / Q = 2 Hz
+}
+
+// 1 Hz DC removal on the first-order IIR: -3 dB at 1 Hz, unity by 100 Hz
+static void test_iir1_hpf(void) {
+    static const int32_t want[DSP_IIR1_COEFS] = { 2147343105, -2147343105, 2147202561 };
+    dsp_iir1_t f;
+    int32_t r[DSP_IIR1_COEFS];
+    TEST_ASSERT_TRUE(dsp_iir1_hpf(&f, FS, 1));
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, dsp_iir1_regs(&f, r));
+    assert_regs(want, r, DSP_IIR1_COEFS);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 0.7071, iir1_mag(r, 1));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-4, 1.0, iir1_mag(r, 100));
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 0.0, iir1_mag(r, 0));
+}
+
+// A numerator past Q31 is scaled down as a whole; the poles are untouched
+static void test_numerator_scaled(void) {
+    const dsp_biquad_t bq = { .b0 = 2.0, .b1 = -1.0, .b2 = 0.5, .a1 = -0.5, .a2 = 0.25 };
+    int32_t r[DSP_BQ_COEFS];
+    const double k = dsp_biquad_regs(&bq, r);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0.5, k);
+    TEST_ASSERT_EQUAL_HEX32(0x7FFFFFFF, r[0]);
+    TEST_ASSERT_EQUAL_INT32(-(1 << 29), r[1]);     // b1 k / 2 = -0.25
+    TEST_ASSERT_EQUAL_INT32(1 << 29, r[2]);        // b2 k = 0.25
+    TEST_ASSERT_EQUAL_INT32(1 << 29, r[3]);        // -a1 / 2
+    TEST_ASSERT_EQUAL_INT32(-(1 << 29), r[4]);     // -a2
+}
+
+static void test_coef_big_endian(void) {
+    uint8_t b[4];
+    dsp_coef_be((int32_t)0x81234567, b);
+    TEST_ASSERT_EQUAL_HEX8(0x81, b[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x23, b[1]);
+    TEST_ASSERT_EQUAL_HEX8(0x45, b[2]);
+    TEST_ASSERT_EQUAL_HEX8(0x67, b[3]);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_designs);
+    RUN_TEST(test_allpass_is_reset_value);
+    RUN_TEST(test_lpf);
+    RUN_TEST(test_hpf);
+    RUN_TEST(test_notch);
+    RUN_TEST(test_iir1_hpf);
+    RUN_TEST(test_numerator_scaled);
+    RUN_TEST(test_coef_big_endian);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
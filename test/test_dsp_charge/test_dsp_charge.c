@@ -0,0 +1,158 @@
+/* dsp_charge: the whole + remainder split is exact. Folds carry at fs, negative
+   sums keep |part| < fs with the sign of the running total, and random
+   full-scale data split into random blocks matches an exact sum of every
+   sample, for net and forward charge, including far from zero. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_charge.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define FS          8000
+#define CH          4
+#define MAX_BLOCK   256
+#define REF_BLOCKS  20000
+#define BENCH_BLOCK 64
+#define BENCH_REPS  20000
+
+static dsp_charge_t s_q;
+static int32_t s_in[MAX_BLOCK * CH];
+
+static uint32_t s_rng = 0x1F2E3D4Cu;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(dsp_charge_init(&s_q, 1, FS));
+}
+
+void tearDown(void) {}
+
+static void feed(int32_t v, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i) s_in[i] = v;
+    dsp_charge_accumulate(&s_q, s_in, frames);
+}
+
+static void assert_acc(int64_t whole, int64_t part, const dsp_charge_acc_t *a) {
+    TEST_ASSERT_TRUE(a->whole == whole);
+    TEST_ASSERT_TRUE(a->part == part);
+}
+
+static void test_init_rejects_bad_args(void) {
+    TEST_ASSERT_FALSE(dsp_charge_init(NULL, 1, FS));
+    TEST_ASSERT_FALSE(dsp_charge_init(&s_q, 0, FS));
+    TEST_ASSERT_FALSE(dsp_charge_init(&s_q, DSP_CHARGE_MAX_CH + 1, FS));
+    TEST_ASSERT_FALSE(dsp_charge_init(&s_q, 1, 0));
+}
+
+// 15000 counts x samples is 1 s plus 7000 / fs; another 1000 carries exactly
+static void test_fold_carries_at_fs(void) {
+    feed(5000, 3);
+    assert_acc(1, 7000, &s_q.net[0]);
+    assert_acc(1, 7000, &s_q.fwd[0]);
+    feed(1000, 1);
+    assert_acc(2, 0, &s_q.net[0]);
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, dsp_charge_value(&s_q, &s_q.net[0]));
+    TEST_ASSERT_TRUE(s_q.frames == 4);
+}
+
+// Net goes negative, the remainder follows its sign; forward only ever grows
+static void test_negative_sums(void) {
+    feed(-5000, 3);
+    assert_acc(-1, -7000, &s_q.net[0]);
+    assert_acc(0, 0, &s_q.fwd[0]);
+    TEST_ASSERT_EQUAL_DOUBLE(-1.875, dsp_charge_value(&s_q, &s_q.net[0]));
+
+    feed(5000, 3);
+    feed(5000, 3);
+    feed(-16000, 1);
+    assert_acc(0, -1000, &s_q.net[0]);      // -15000 + 30000 - 16000
+    assert_acc(3, 6000, &s_q.fwd[0]);       // 30000
+    TEST_ASSERT_EQUAL_DOUBLE(-0.125, dsp_charge_value(&s_q, &s_q.net[0]));
+}
+
+/* Full-scale random samples in random block sizes (0 and 1 included) against a
+   plain sum of every sample; net and forward, every channel. */
+static void test_matches_exact_sum(void) {
+    int64_t net[CH] = { 0 }, fwd[CH] = { 0 };
+    uint64_t frames = 0;
+    TEST_ASSERT_TRUE(dsp_charge_init(&s_q, CH, FS));
+    for (uint32_t b = 0; b < REF_BLOCKS; ++b) {
+        const uint32_t n = rnd() % (MAX_BLOCK + 1);
+        for (uint32_t i = 0; i < n * CH; ++i) {
+            // the last channel sits at negative full scale to push the remainder one way
+            const int32_t v = (i % CH == CH - 1) ? -0x800000 + (int32_t)(rnd() & 0xF) : (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+            s_in[i] = v;
+            net[i % CH] += v;
+            fwd[i % CH] += v > 0 ? v : 0;
+        }
+        dsp_charge_accumulate(&s_q, s_in, n);
+        frames += n;
+    }
+    TEST_ASSERT_TRUE(s_q.frames == frames);
+    for (uint32_t c = 0; c < CH; ++c) {
+        TEST_ASSERT_TRUE(s_q.net[c].whole * FS + s_q.net[c].part == net[c]);
+        TEST_ASSERT_TRUE(s_q.fwd[c].whole * FS + s_q.fwd[c].part == fwd[c]);
+        TEST_ASSERT_TRUE(llabs(s_q.net[c].part) < FS);
+        TEST_ASSERT_TRUE(s_q.fwd[c].part >= 0 && s_q.fwd[c].part < FS);
+    }
+}
+
+#ifdef __SIZEOF_INT128__
+/* Years into a deployment whole x fs no longer fits an int64; check against a
+   128-bit total that nothing is lost from counters that large. */
+static void test_large_totals(void) {
+    const int64_t start = 4000000000000000LL;       // ~15 years at full scale, counts x s
+    __int128 ref = (__int128)start * FS;
+    TEST_ASSERT_TRUE(dsp_charge_init(&s_q, 1, FS));
+    s_q.net[0].whole = start;
+    for (uint32_t b = 0; b < REF_BLOCKS; ++b) {
+        const uint32_t n = rnd() % (MAX_BLOCK + 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            s_in[i] = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+            ref += s_in[i];
+        }
+        dsp_charge_accumulate(&s_q, s_in, n);
+    }
+    TEST_ASSERT_TRUE((__int128)s_q.net[0].whole * FS + s_q.net[0].part == ref);
+}
+#endif
+
+static void test_bench(void) {
+    TEST_ASSERT_TRUE(dsp_charge_init(&s_q, 2, FS));
+    for (uint32_t i = 0; i < BENCH_BLOCK * 2; ++i) s_in[i] = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+    const int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_REPS; ++r) dsp_charge_accumulate(&s_q, s_in, BENCH_BLOCK);
+    bench_report("charge 2 ch", bench_now_us() - t0, (double)BENCH_REPS * BENCH_BLOCK * 2, "sample");
+    TEST_ASSERT_TRUE(s_q.frames == (uint64_t)BENCH_REPS * BENCH_BLOCK);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_fold_carries_at_fs);
+    RUN_TEST(test_negative_sums);
+    RUN_TEST(test_matches_exact_sum);
+#ifdef __SIZEOF_INT128__
+    RUN_TEST(test_large_totals);
+#endif
+    RUN_TEST(test_bench);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
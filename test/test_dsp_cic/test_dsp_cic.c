@@ -0,0 +1,324 @@
+/* dsp_cic and the CIC + compensation FIR chain: tone gain and CPU load.
+
+   The CIC's tone gain is checked against the analytic |sin(pi f R) / (R sin(pi f))|^N,
+   and the chain's against that times the compensation FIR's own response, for
+   the app's ratios from 8 kHz and for 96 kHz -> 10 Hz, whose 2400:1 CIC only
+   fits its registers at order 3. The benchmark reports CPU load per ratio. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_cic.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI          3.14159265358979323846
+#define CH          2
+#define ORDER       4                       // DS_CIC_ORDER
+#define NTAPS       96                      // DEF_DS_TAPS
+#define FC          0.4f                    // DS_CUTOFF
+#define AMP         4194304.0               // -6 dBFS in 24 bits
+#define BLOCK       64                      // frames per DMA block
+#define MEASURE     256                     // settled outputs per tone
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static double db(double g) {
+    return 20.0 * log10(g + 1e-30);
+}
+
+// f: fraction of the CIC input rate
+static double cic_ref(double f, uint32_t R, uint32_t N) {
+    const double s = sin(PI * f);
+    if (fabs(s) < 1e-12) return 1.0;
+    return pow(fabs(sin(PI * f * R) / (R * s)), N);
+}
+
+// f: fraction of the FIR input rate
+static double fir_ref(const int32_t *taps, uint32_t ntaps, double f) {
+    double re = 0.0, im = 0.0;
+    for (uint32_t i = 0; i < ntaps; ++i) {
+        re += taps[i] / 2147483648.0 * cos(2.0 * PI * f * i);
+        im -= taps[i] / 2147483648.0 * sin(2.0 * PI * f * i);
+    }
+    return sqrt(re * re + im * im);
+}
+
+/* Least-squares fit of a sinusoid at a known phase step per output sample, so the
+   measured amplitude doesn't depend on how many whole cycles were captured */
+typedef struct {
+    double ss, cc, sc, ys, yc;
+} fit_t;
+
+static void fit_add(fit_t *ft, double step, uint32_t k, double y) {
+    const double s = sin(fmod(step * k, 2.0 * PI)), c = cos(fmod(step * k, 2.0 * PI));
+    ft->ss += s * s;  ft->cc += c * c;  ft->sc += s * c;
+    ft->ys += y * s;  ft->yc += y * c;
+}
+
+static double fit_amp(const fit_t *ft) {
+    const double det = ft->ss * ft->cc - ft->sc * ft->sc;
+    const double a = (ft->ys * ft->cc - ft->yc * ft->sc) / det;
+    const double b = (ft->yc * ft->ss - ft->ys * ft->sc) / det;
+    return sqrt(a * a + b * b);
+}
+
+// One DMA block of a tone at f (fraction of the input rate) on every channel, starting at frame n0
+static void tone_block(int32_t *blk, double f, uint64_t n0) {
+    for (uint32_t n = 0; n < BLOCK; ++n) {
+        const int32_t v = (int32_t)lrint(AMP * sin(2.0 * PI * fmod(f * (double)(n0 + n), 1.0) + 0.3));
+        for (uint32_t c = 0; c < CH; ++c) blk[n * CH + c] = v;
+    }
+}
+
+static void test_max_order(void) {
+    // order * log2(ratio) + 24 <= 63
+    TEST_ASSERT_EQUAL_UINT32(0, dsp_cic_max_order(0, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(4, dsp_cic_max_order(2, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(4, dsp_cic_max_order(861, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(3, dsp_cic_max_order(862, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(3, dsp_cic_max_order(2400, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(3, dsp_cic_max_order(8191, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(2, dsp_cic_max_order(8192, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_cic_max_order(UINT32_MAX, ORDER));
+    TEST_ASSERT_EQUAL_UINT32(2, dsp_cic_max_order(100, 2));
+}
+
+static void test_init_rejects_overflow(void) {
+    static uint64_t state[CH * ORDER * 2];
+    dsp_cic_t c;
+    TEST_ASSERT_TRUE(dsp_cic_init(&c, 861, ORDER, CH, state));
+    TEST_ASSERT_FALSE(dsp_cic_init(&c, 2400, ORDER, CH, state));
+    TEST_ASSERT_TRUE(dsp_cic_init(&c, 2400, 3, CH, state));
+    TEST_ASSERT_FALSE(dsp_cic_init(&c, 16, 0, CH, state));
+    TEST_ASSERT_FALSE(dsp_cic_init(&c, 16, DSP_CIC_MAX_ORDER + 1, CH, state));
+    TEST_ASSERT_FALSE(dsp_cic_init(&c, 16, ORDER, 0, state));
+}
+
+// Full-scale DC in both signs comes out exactly, at the largest ratio the order allows
+static void test_dc_exact(void) {
+    static uint64_t state[CH * 3 * 2];
+    static int32_t in[BLOCK * CH], out[BLOCK * CH];
+    const int32_t dc[CH] = { 0x7FFFFF, -0x800000 };
+    dsp_cic_t c;
+    TEST_ASSERT_TRUE(dsp_cic_init(&c, 8191, 3, CH, state));
+    for (uint32_t n = 0; n < BLOCK; ++n) {
+        for (uint32_t k = 0; k < CH; ++k) in[n * CH + k] = dc[k];
+    }
+    uint32_t m = 0;
+    for (uint32_t b = 0; b < 5 * 8191 / BLOCK; ++b) {
+        const uint32_t got = dsp_cic_process(&c, in, BLOCK, out);
+        if (got && ++m > 3) {
+            TEST_ASSERT_EQUAL_INT32(dc[0], out[0]);
+            TEST_ASSERT_EQUAL_INT32(dc[1], out[1]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, m);
+}
+
+// CIC alone: tone gain against sinc^N, including the aliasing lobes
+static void test_cic_response(void) {
+    enum { R = 16, FRAMES = (MEASURE + ORDER + 1) * R };
+    static uint64_t state[CH * ORDER * 2];
+    static int32_t blk[BLOCK * CH], out[(BLOCK / R + 1) * CH];
+    const double tones[] = { 0.0031, 0.0217, 0.0409, 0.0733, 0.1291, 0.2113, 0.3377 };
+    dsp_cic_t c;
+    TEST_ASSERT_TRUE(dsp_cic_init(&c, R, ORDER, CH, state));
+
+    for (size_t t = 0; t < sizeof(tones) / sizeof(tones[0]); ++t) {
+        dsp_cic_reset(&c);
+        fit_t ft = { 0 };
+        uint32_t m = 0;
+        for (uint64_t n0 = 0; n0 < FRAMES; n0 += BLOCK) {
+            tone_block(blk, tones[t], n0);
+            const uint32_t got = dsp_cic_process(&c, blk, BLOCK, out);
+            for (uint32_t k = 0; k < got; ++k, ++m) {
+                TEST_ASSERT_EQUAL_INT32(out[k * CH], out[k * CH + 1]);
+                if (m > ORDER) fit_add(&ft, 2.0 * PI * tones[t] * R, m, out[k * CH]);
+            }
+        }
+        const double gain = db(fit_amp(&ft) / AMP), want = db(cic_ref(tones[t], R, ORDER));
+        char msg[96];
+        snprintf(msg, sizeof(msg), "CIC 16:1 N=4, f = %.4f fs: %.2f dB (sinc^4 %.2f dB)", tones[t], gain, want);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_DOUBLE_WITHIN(want > -60.0 ? 0.01 : 1.0, want, gain);
+    }
+}
+
+// Same output whatever the block sizes
+static void test_cic_block_boundaries(void) {
+    enum { R = 24, FRAMES = 3001 };
+    static uint64_t state[CH * ORDER * 2];
+    static int32_t in[FRAMES * CH], one[(FRAMES / R + 1) * CH], split[(FRAMES / R + 1) * CH];
+    dsp_cic_t c;
+    srand(11);
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) in[i] = (rand() & 0xFFFFFF) - 0x800000;
+
+    TEST_ASSERT_TRUE(dsp_cic_init(&c, R, ORDER, CH, state));
+    const uint32_t m1 = dsp_cic_process(&c, in, FRAMES, one);
+    dsp_cic_reset(&c);
+    uint32_t m2 = 0;
+    for (uint32_t n = 0; n < FRAMES; ) {
+        uint32_t len = (uint32_t)(rand() % 70);
+        if (len > FRAMES - n) len = FRAMES - n;
+        m2 += dsp_cic_process(&c, in + n * CH, len, split + m2 * CH);
+        n += len;
+    }
+    TEST_ASSERT_EQUAL_UINT32(m1, m2);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(one, split, m1 * CH);
+}
+
+static void test_chain_valid(void) {
+    TEST_ASSERT_TRUE(dsp_decim_chain_valid(9600, CH, ORDER, NTAPS, FC));
+    TEST_ASSERT_TRUE(dsp_decim_chain_valid(4, CH, 0, NTAPS, FC));      // FIR only: order unused
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(0, CH, ORDER, NTAPS, FC));
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(800, 0, ORDER, NTAPS, FC));
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(800, CH, ORDER, 0, FC));
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(800, CH, 0, NTAPS, FC));
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(800, CH, DSP_CIC_MAX_ORDER + 1, NTAPS, FC));
+    TEST_ASSERT_FALSE(dsp_decim_chain_valid(4, CH, ORDER, NTAPS, 2.0f));   // cutoff past the FIR's Nyquist
+}
+
+/* Chain tone gain against |H_cic(f)| x |H_fir(f x cic_ratio)|. out_f is a fraction
+   of the output rate; tones past 0.5 alias and must be rejected. */
+static void chain_response(uint32_t ratio, uint32_t want_order) {
+    dsp_decim_chain_t d;
+    static int32_t blk[BLOCK * CH], out[(BLOCK + 1) * CH];
+    const double tones[] = { 0.0613, 0.2119, 0.3307, 0.4421, 0.6137, 1.3713 };
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&d, ratio, CH, ORDER, NTAPS, FC, BLOCK));
+    TEST_ASSERT_EQUAL_UINT32(ratio, d.cic_ratio * d.fir_ratio);
+    TEST_ASSERT_EQUAL_UINT32(want_order, d.cic_ratio > 1 ? d.cic.order : 0);
+
+    const uint32_t settle = (d.cic.order + NTAPS) * d.cic_ratio / ratio + 2;
+    for (size_t t = 0; t < sizeof(tones) / sizeof(tones[0]); ++t) {
+        const double f = tones[t] / ratio;
+        dsp_decim_chain_reset(&d);
+        fit_t ft = { 0 };
+        uint32_t m = 0, used = 0;
+        for (uint64_t n0 = 0; used < MEASURE; n0 += BLOCK) {
+            tone_block(blk, f, n0);
+            const uint32_t got = dsp_decim_chain_process(&d, blk, BLOCK, out);
+            TEST_ASSERT_LESS_OR_EQUAL_UINT32(dsp_decim_chain_max_out(&d, BLOCK), got);
+            for (uint32_t k = 0; k < got; ++k, ++m) {
+                if (m >= settle && used < MEASURE) { fit_add(&ft, 2.0 * PI * tones[t], m, out[k * CH]); used++; }
+            }
+        }
+        double want = fir_ref(d.taps, d.fir.ntaps, f * d.cic_ratio);
+        if (d.cic_ratio > 1) want *= cic_ref(f, d.cic_ratio, d.cic.order);
+        const double gain = db(fit_amp(&ft) / AMP);
+        char msg[112];
+        snprintf(msg, sizeof(msg), "chain %lu:1 (CIC %lu N=%lu x FIR %lu), f = %.4f fout: %.3f dB (reference %.3f dB)",
+            (unsigned long)ratio, (unsigned long)d.cic_ratio, (unsigned long)d.cic.order, (unsigned long)d.fir_ratio,
+            tones[t], gain, db(want));
+        TEST_MESSAGE(msg);
+        if (db(want) > -50.0) {
+            TEST_ASSERT_DOUBLE_WITHIN(0.01, db(want), gain);
+        } else {
+            TEST_ASSERT_LESS_THAN_DOUBLE(-50.0, gain);
+        }
+        // Compensated passband: flat to 0.1 dB up to a third of the output Nyquist
+        if (tones[t] < 0.5 / 3) TEST_ASSERT_DOUBLE_WITHIN(0.1, 0.0, gain);
+    }
+    dsp_decim_chain_destroy(&d);
+}
+
+// 8 kHz -> 2000, 500, 100 and 10 Hz (the app's default streams)
+static void test_chain_response_8k(void) {
+    chain_response(4, 0);
+    chain_response(16, ORDER);
+    chain_response(80, ORDER);
+    chain_response(800, ORDER);
+}
+
+// 96 kHz -> 10 Hz: CIC 2400:1 overflows at order 4, so the chain drops to order 3
+static void test_chain_response_96k_to_10(void) {
+    chain_response(9600, 3);
+}
+
+// Chunking through the CIC scratch is invisible: one call per block vs many tiny ones
+static void test_chain_block_boundaries(void) {
+    enum { RATIO = 80, FRAMES = 20011 };
+    static int32_t in[FRAMES * CH], one[(FRAMES / RATIO + 1) * CH], split[(FRAMES / RATIO + 1) * CH];
+    dsp_decim_chain_t a, b;
+    srand(5);
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) in[i] = (rand() & 0xFFFFFF) - 0x800000;
+
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&a, RATIO, CH, ORDER, NTAPS, FC, FRAMES));
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&b, RATIO, CH, ORDER, NTAPS, FC, 40));
+    const uint32_t m1 = dsp_decim_chain_process(&a, in, FRAMES, one);
+    uint32_t m2 = 0;
+    for (uint32_t n = 0; n < FRAMES; ) {
+        uint32_t len = (uint32_t)(rand() % 41);
+        if (len > FRAMES - n) len = FRAMES - n;
+        m2 += dsp_decim_chain_process(&b, in + n * CH, len, split + m2 * CH);
+        n += len;
+    }
+    TEST_ASSERT_EQUAL_UINT32(m1, m2);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(one, split, m1 * CH);
+    dsp_decim_chain_destroy(&a);
+    dsp_decim_chain_destroy(&b);
+}
+
+/* CPU load per output stream: time per input frame in 64-frame blocks, as a
+   share of one core at 8 kHz and 96 kHz input */
+static void bench_ratio(uint32_t ratio) {
+    enum { BLOCKS = 4000 };
+    static int32_t blk[BLOCK * CH], out[(BLOCK + 1) * CH];
+    dsp_decim_chain_t d;
+    for (uint32_t i = 0; i < BLOCK * CH; ++i) blk[i] = (int32_t)(i * 2654435761u) >> 8;
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&d, ratio, CH, ORDER, NTAPS, FC, BLOCK));
+
+    const int64_t t0 = bench_now_us();
+    for (int b = 0; b < BLOCKS; ++b) {
+        const uint32_t got = dsp_decim_chain_process(&d, blk, BLOCK, out);
+        blk[b % (BLOCK * CH)] ^= got ? out[0] : 1;
+    }
+    const int64_t us = bench_now_us() - t0;
+    const double frames = (double)BLOCKS * BLOCK;
+
+    char what[64], msg[112];
+    snprintf(what, sizeof(what), "chain %lu:1 x %d ch", (unsigned long)ratio, CH);
+    bench_report(what, us, frames, "frame");
+    snprintf(msg, sizeof(msg), "chain %lu:1 x %d ch: %.3f%% of a core at 8 kHz, %.2f%% at 96 kHz",
+        (unsigned long)ratio, CH, 100.0 * us / (frames / 8000.0 * 1e6), 100.0 * us / (frames / 96000.0 * 1e6));
+    TEST_MESSAGE(msg);
+    dsp_decim_chain_destroy(&d);
+}
+
+static void test_bench_load_per_ratio(void) {
+    bench_ratio(4);
+    bench_ratio(16);
+    bench_ratio(80);
+    bench_ratio(800);
+    bench_ratio(9600);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_max_order);
+    RUN_TEST(test_init_rejects_overflow);
+    RUN_TEST(test_dc_exact);
+    RUN_TEST(test_cic_response);
+    RUN_TEST(test_cic_block_boundaries);
+    RUN_TEST(test_chain_valid);
+    RUN_TEST(test_chain_response_8k);
+    RUN_TEST(test_chain_response_96k_to_10);
+    RUN_TEST(test_chain_block_boundaries);
+    RUN_TEST(test_bench_load_per_ratio);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
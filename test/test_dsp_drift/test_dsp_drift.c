@@ -0,0 +1,167 @@
+/* dsp_drift: the DLL locks to a known sample clock offset from block
+   timestamps with ISR jitter, ring drops and late stamps; a stall long enough
+   to reseed it keeps the learned period; the frame count stays exact across
+   all of it, and the filtered time of a frame tracks the true one. */
+
+#include "unity.h"
+#include "dsp_drift.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FS          8000
+#define BLOCK       64                      // 8 ms, DEF_BLOCK_MS
+#define BW_HZ       0.02f                   // CLK_BW_HZ
+#define RUN_S       600
+#define JITTER_US   100                     // stamps land 0 .. this late (ISR entry)
+#define T0_US       123456789LL
+
+static dsp_drift_t s_d;
+
+static uint32_t s_rng = 0x3C6EF372u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(dsp_drift_init(&s_d, FS, BLOCK, BW_HZ));
+}
+
+void tearDown(void) {}
+
+// Completion time of block k (0-based) for a clock ppm off nominal, us
+static double block_end(uint32_t k, double ppm) {
+    return T0_US + (double)(k + 1) * BLOCK * 1e6 / (FS * (1.0 + ppm * 1e-6));
+}
+
+typedef struct {
+    int32_t  max_err_ppb;       // worst |ppb - truth| once locked for a minute
+    int64_t  max_err_us;        // worst |filtered time - true time| over the same span
+    uint32_t drops;             // blocks never fed
+    uint32_t late;              // stamps pushed past half a block
+} run_t;
+
+/* RUN_S of blocks: every stamp late by 0 .. JITTER_US, about one call in 500
+   after 1-3 dropped blocks, and about one in 700 stamped 6 ms late for 1-3
+   blocks in a row (a backlog drained after a scheduling stall). */
+static run_t run(double ppm, bool impair) {
+    run_t r = { 0 };
+    const uint32_t blocks = RUN_S * FS / BLOCK;
+    const uint32_t check_from = (DSP_DRIFT_SETTLE_S + 60) * FS / BLOCK;
+    uint32_t pending = 1, late = 0;
+    for (uint32_t k = 0; k < blocks; ++k) {
+        if (impair && k > 0 && rnd() % 500 == 0) {
+            const uint32_t n = 1 + rnd() % 3;
+            pending += n;
+            r.drops += n;
+            k += n;
+        }
+        if (impair && late == 0 && rnd() % 700 == 0) late = 1 + rnd() % 3;
+        double t = block_end(k, ppm);
+        if (impair) t += rnd() % (JITTER_US + 1);
+        if (late) {
+            t += 6000.0;
+            late--;
+            r.late++;
+        }
+        dsp_drift_update(&s_d, pending, (int64_t)llround(t));
+        pending = 1;
+
+        if (k >= check_from) {
+            TEST_ASSERT_TRUE(dsp_drift_locked(&s_d));
+            const int32_t e = dsp_drift_ppb(&s_d) - (int32_t)lround(ppm * 1000.0);
+            if (abs(e) > r.max_err_ppb) r.max_err_ppb = abs(e);
+            // the frame at the end of this block, against its true (jitter-free) time
+            const int64_t dt = dsp_drift_time_us(&s_d, (uint64_t)(k + 1) * BLOCK) - (int64_t)llround(block_end(k, ppm));
+            if (llabs(dt) > r.max_err_us) r.max_err_us = llabs(dt);
+        }
+    }
+    TEST_ASSERT_TRUE(s_d.frames == (uint64_t)blocks * BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(0, s_d.reseeds);
+
+    char line[128];
+    snprintf(line, sizeof(line), "%+.1f ppm: worst %ld ppb, %lld us; %lu dropped, %lu late, %lu outliers",
+        ppm, (long)r.max_err_ppb, (long long)r.max_err_us,
+        (unsigned long)r.drops, (unsigned long)r.late, (unsigned long)s_d.outliers);
+    TEST_MESSAGE(line);
+    return r;
+}
+
+static void test_init_rejects_bad_args(void) {
+    dsp_drift_t d;
+    TEST_ASSERT_FALSE(dsp_drift_init(NULL, FS, BLOCK, BW_HZ));
+    TEST_ASSERT_FALSE(dsp_drift_init(&d, 0, BLOCK, BW_HZ));
+    TEST_ASSERT_FALSE(dsp_drift_init(&d, FS, 0, BW_HZ));
+    TEST_ASSERT_FALSE(dsp_drift_init(&d, FS, BLOCK, 0.0f));
+    TEST_ASSERT_FALSE(dsp_drift_init(&d, FS, BLOCK, DSP_DRIFT_WIDE_HZ * 2));
+}
+
+// Clean 1 us stamps: the rate resolves to a few ppb, the time to the stamp tick
+static void test_locks_clean(void) {
+    TEST_ASSERT_FALSE(dsp_drift_locked(&s_d));
+    const run_t r = run(-50.0, false);
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(20, r.max_err_ppb);
+    TEST_ASSERT_TRUE(r.max_err_us <= 1);
+    TEST_ASSERT_EQUAL_UINT32(0, s_d.outliers);
+    TEST_ASSERT_DOUBLE_WITHIN(FS * 20e-9, FS * (1.0 - 50e-6), dsp_drift_rate_hz(&s_d));
+}
+
+// Jitter, drops and late stamps: still within a fraction of a ppm, the late ones all rejected
+static void test_locks_impaired(void) {
+    const run_t r = run(37.5, true);
+    TEST_ASSERT_TRUE(r.drops > 0 && r.late > 0);
+    TEST_ASSERT_EQUAL_UINT32(r.late, s_d.outliers);
+    TEST_ASSERT_LESS_OR_EQUAL_INT32(300, r.max_err_ppb);
+    // the mean ISR delay (JITTER_US / 2) is part of every stamp; the spread around it is filtered
+    TEST_ASSERT_TRUE(llabs(r.max_err_us - JITTER_US / 2) <= JITTER_US / 2);
+}
+
+/* DSP_DRIFT_MAX_SKIP late stamps in a row reseed the phase; the period learned
+   before is kept, so the rate is still right straight after. */
+static void test_stall_reseeds(void) {
+    const double ppm = 20.0;
+    const uint32_t lock = (DSP_DRIFT_SETTLE_S + 60) * FS / BLOCK;
+    uint32_t k = 0;
+    for (; k < lock; ++k) dsp_drift_update(&s_d, 1, (int64_t)llround(block_end(k, ppm)));
+    TEST_ASSERT_INT32_WITHIN(20, 20000, dsp_drift_ppb(&s_d));
+
+    // every stamp from here on is 100 ms behind
+    for (uint32_t i = 0; i < DSP_DRIFT_MAX_SKIP; ++i, ++k) {
+        dsp_drift_update(&s_d, 1, (int64_t)llround(block_end(k, ppm) + 100000.0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, s_d.reseeds);
+    TEST_ASSERT_EQUAL_UINT32(DSP_DRIFT_MAX_SKIP, s_d.outliers);
+    TEST_ASSERT_FALSE(dsp_drift_locked(&s_d));
+    TEST_ASSERT_INT32_WITHIN(20, 20000, dsp_drift_ppb(&s_d));
+
+    for (uint32_t i = 0; i < FS / BLOCK; ++i, ++k) {
+        dsp_drift_update(&s_d, 1, (int64_t)llround(block_end(k, ppm) + 100000.0));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, s_d.reseeds);
+    TEST_ASSERT_INT32_WITHIN(50, 20000, dsp_drift_ppb(&s_d));    // a second on the wide loop
+    TEST_ASSERT_TRUE(s_d.frames == (uint64_t)k * BLOCK);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_locks_clean);
+    RUN_TEST(test_locks_impaired);
+    RUN_TEST(test_stall_reseeds);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
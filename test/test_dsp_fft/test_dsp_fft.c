@@ -0,0 +1,167 @@
+/* dsp_fft: the windowed one-sided power spectrum of every size from 256 to
+   4096 matches a double-precision DFT of the same windowed input, the bins
+   sum to the windowed mean square (Parseval), a bin-centred tone lands in
+   its own bin, and the time per FFT and FFTs per second at each size. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_fft.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PI          3.14159265358979323846
+#define BENCH_MS    200                     // per size
+
+#ifdef ESP_PLATFORM
+#define DFT_STRIDE  29                      // soft double on the S3: check a spread of bins, not all
+#else
+#define DFT_STRIDE  1
+#endif
+
+static float  s_x[DSP_FFT_MAX_N];
+static float  s_work[DSP_FFT_MAX_N];
+static float  s_out[DSP_FFT_MAX_N / 2 + 1];
+static double s_cos[DSP_FFT_MAX_N];
+
+static uint32_t s_rng = 0x6A09E667u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Two tones off bin centre plus white noise, roughly unit scale like amps
+static void fill(uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        const double noise = ((double)(rnd() & 0xFFFF) / 65536.0 - 0.5) * 0.01;
+        s_x[i] = (float)(0.8 * sin(2.0 * PI * 0.0713 * i) + 0.05 * cos(2.0 * PI * 0.3101 * i + 1.0) + 0.2 + noise);
+    }
+}
+
+// Same window, same normalisation as dsp_rfft_power, in double
+static double dft_bin(const dsp_rfft_t *f, uint32_t k) {
+    const uint32_t n = f->n;
+    double re = 0.0, im = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const double v = (double)s_x[i] * f->win[i];
+        const uint32_t j = (uint32_t)(((uint64_t)k * i) % n);
+        re += v * s_cos[j];
+        im -= v * s_cos[(j + 3 * n / 4) % n];     // sin(t) = cos(t - pi / 2)
+    }
+    const double p = (re * re + im * im) / ((double)n * f->win_pow);
+    return (k == 0 || k == n / 2) ? p : 2.0 * p;
+}
+
+static void check_size(uint32_t n, dsp_window_t win) {
+    char msg[96];
+    dsp_rfft_t f;
+    TEST_ASSERT_TRUE(dsp_rfft_create(&f, n, win));
+    for (uint32_t i = 0; i < n; ++i) s_cos[i] = cos(2.0 * PI * i / n);
+    fill(n);
+    dsp_rfft_power(&f, s_x, s_work, s_out);
+
+    // Parseval: bins sum to sum (x w)^2 / sum w^2
+    double ms = 0.0, sum = 0.0, peak = 0.0;
+    for (uint32_t i = 0; i < n; ++i) ms += (double)s_x[i] * f.win[i] * s_x[i] * f.win[i];
+    ms /= f.win_pow;
+    for (uint32_t k = 0; k <= n / 2; ++k) {
+        sum += s_out[k];
+        if (s_out[k] > peak) peak = s_out[k];
+    }
+    snprintf(msg, sizeof(msg), "N = %lu, window %d: Parseval", (unsigned long)n, (int)win);
+    TEST_ASSERT_DOUBLE_WITHIN_MESSAGE(ms * 1e-5, ms, sum, msg);
+
+    // Every (checked) bin against the DFT, relative to the spectrum's peak; Nyquist always
+    double worst = fabs(dft_bin(&f, n / 2) - s_out[n / 2]) / peak;
+    for (uint32_t k = 0; k < n / 2; k += DFT_STRIDE) {
+        const double d = fabs(dft_bin(&f, k) - s_out[k]) / peak;
+        if (d > worst) worst = d;
+    }
+    snprintf(msg, sizeof(msg), "N = %lu, window %d: worst bin %.2e of peak", (unsigned long)n, (int)win, worst);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_DOUBLE_MESSAGE(2e-6, worst, msg);
+    dsp_rfft_destroy(&f);
+}
+
+static void test_create_rejects_bad_sizes(void) {
+    dsp_rfft_t f;
+    TEST_ASSERT_FALSE(dsp_rfft_create(&f, DSP_FFT_MIN_N / 2, DSP_WIN_HANN));
+    TEST_ASSERT_FALSE(dsp_rfft_create(&f, DSP_FFT_MAX_N * 2, DSP_WIN_HANN));
+    TEST_ASSERT_FALSE(dsp_rfft_create(&f, 1000, DSP_WIN_HANN));
+    TEST_ASSERT_FALSE(dsp_rfft_create(NULL, 1024, DSP_WIN_HANN));
+}
+
+// Both parities of log2(N/2): the leading radix-2 pass and pure radix-4
+static void test_matches_dft(void) {
+    for (uint32_t n = DSP_FFT_MIN_N; n <= DSP_FFT_MAX_N; n *= 2) check_size(n, DSP_WIN_HANN);
+}
+
+static void test_windows(void) {
+    check_size(1024, DSP_WIN_RECT);
+    check_size(1024, DSP_WIN_HAMMING);
+    check_size(2048, DSP_WIN_BLACKMAN);
+}
+
+// Rectangular window, tone on bin 37: all of its power in bin 37, A^2 / 2
+static void test_bin_centred_tone(void) {
+    const uint32_t n = 512, k0 = 37;
+    dsp_rfft_t f;
+    TEST_ASSERT_TRUE(dsp_rfft_create(&f, n, DSP_WIN_RECT));
+    for (uint32_t i = 0; i < n; ++i) s_x[i] = (float)(0.5 * cos(2.0 * PI * k0 * i / n));
+    dsp_rfft_power(&f, s_x, s_work, s_out);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 0.125, s_out[k0]);
+    for (uint32_t k = 0; k <= n / 2; ++k) {
+        if (k != k0) TEST_ASSERT_LESS_THAN_DOUBLE(1e-9, s_out[k]);
+    }
+    dsp_rfft_destroy(&f);
+}
+
+static void test_bench(void) {
+    fill(DSP_FFT_MAX_N);
+    for (uint32_t n = DSP_FFT_MIN_N; n <= DSP_FFT_MAX_N; n *= 2) {
+        dsp_rfft_t f;
+        TEST_ASSERT_TRUE(dsp_rfft_create(&f, n, DSP_WIN_HANN));
+        uint32_t runs = 0;
+        const int64_t t0 = bench_now_us();
+        int64_t us;
+        do {
+            for (int r = 0; r < 16; ++r) dsp_rfft_power(&f, s_x, s_work, s_out);
+            runs += 16;
+            us = bench_now_us() - t0;
+        } while (us < BENCH_MS * 1000);
+        char what[48], line[64];
+        snprintf(what, sizeof(what), "rfft power N = %lu", (unsigned long)n);
+        bench_report(what, us, runs, "FFT");
+        snprintf(line, sizeof(line), "N = %lu: %.0f FFT/s", (unsigned long)n, runs * 1e6 / us);
+        TEST_MESSAGE(line);
+        dsp_rfft_destroy(&f);
+    }
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_create_rejects_bad_sizes);
+    RUN_TEST(test_matches_dft);
+    RUN_TEST(test_windows);
+    RUN_TEST(test_bin_centred_tone);
+    RUN_TEST(test_bench);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
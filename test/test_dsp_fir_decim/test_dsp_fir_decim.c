@@ -0,0 +1,256 @@
+/* dsp_fir_decim against a double-precision reference.
+
+   The reference is the same Blackman windowed-sinc written out in double
+   precision here, so both the Q31 design and the streaming Q31 decimator are
+   checked against it: tap response, tone gain through the decimator across
+   pass and stop band, sample-by-sample output, block-boundary invariance,
+   and cycles per input sample at the app's settings. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_fir_decim.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI          3.14159265358979323846
+#define NTAPS       96                      // DEF_DS_TAPS
+#define RATIO       8
+#define FC          (0.4f / RATIO)          // DS_CUTOFF of the output rate, at the input rate
+#define CH          2
+#define AMP         4194304.0               // -6 dBFS in 24 bits
+#define TONE_FRAMES 16384
+#define BENCH_BLOCK 64                      // frames per DMA block
+#define BENCH_REPS  2000
+
+static int32_t s_taps[NTAPS];
+static double  s_ref[NTAPS];
+static int32_t s_state[CH * 2 * NTAPS];
+static dsp_fir_decim_t s_fir;
+
+static void reference_design(double *h, uint32_t n, double fc) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < n; ++i) {
+        const double t = i - (n - 1) / 2.0;
+        const double x = (double)i / (n - 1);
+        const double w = 0.42 - 0.5 * cos(2.0 * PI * x) + 0.08 * cos(4.0 * PI * x);
+        h[i] = (t == 0.0 ? 2.0 * fc : sin(2.0 * PI * fc * t) / (PI * t)) * w;
+        sum += h[i];
+    }
+    for (uint32_t i = 0; i < n; ++i) h[i] /= sum;
+}
+
+static double mag_ref(double f) {
+    double re = 0.0, im = 0.0;
+    for (uint32_t i = 0; i < NTAPS; ++i) {
+        re += s_ref[i] * cos(2.0 * PI * f * i);
+        im -= s_ref[i] * sin(2.0 * PI * f * i);
+    }
+    return sqrt(re * re + im * im);
+}
+
+static double mag_q31(double f) {
+    double re = 0.0, im = 0.0;
+    for (uint32_t i = 0; i < NTAPS; ++i) {
+        re += s_taps[i] / 2147483648.0 * cos(2.0 * PI * f * i);
+        im -= s_taps[i] / 2147483648.0 * sin(2.0 * PI * f * i);
+    }
+    return sqrt(re * re + im * im);
+}
+
+static double db(double g) {
+    return 20.0 * log10(g + 1e-30);
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(dsp_fir_design_lowpass(s_taps, NTAPS, FC));
+    reference_design(s_ref, NTAPS, FC);
+    TEST_ASSERT_TRUE(dsp_fir_decim_init(&s_fir, s_taps, NTAPS, RATIO, CH, s_state));
+}
+
+void tearDown(void) {}
+
+static void test_init_rejects_bad_args(void) {
+    dsp_fir_decim_t f;
+    TEST_ASSERT_FALSE(dsp_fir_decim_init(&f, NULL, NTAPS, RATIO, CH, s_state));
+    TEST_ASSERT_FALSE(dsp_fir_decim_init(&f, s_taps, 0, RATIO, CH, s_state));
+    TEST_ASSERT_FALSE(dsp_fir_decim_init(&f, s_taps, NTAPS, 0, CH, s_state));
+    TEST_ASSERT_FALSE(dsp_fir_decim_init(&f, s_taps, NTAPS, RATIO, 0, s_state));
+    TEST_ASSERT_FALSE(dsp_fir_design_lowpass(s_taps, NTAPS, 0.0f));
+    TEST_ASSERT_FALSE(dsp_fir_design_lowpass(s_taps, NTAPS, 0.5f));
+}
+
+// Exact unity DC gain, linear phase, and the Q31 response within quantisation of the reference
+static void test_design_matches_reference(void) {
+    int64_t sum = 0;
+    for (uint32_t i = 0; i < NTAPS; ++i) {
+        sum += s_taps[i];
+        // the rounding residue lands on the centre tap, which has no mirror when NTAPS is even
+        if (i != NTAPS / 2 && NTAPS - 1 - i != NTAPS / 2) {
+            TEST_ASSERT_EQUAL_INT32(s_taps[i], s_taps[NTAPS - 1 - i]);
+        }
+    }
+    TEST_ASSERT_TRUE(sum == (1LL << 31));
+
+    double worst = 0.0;
+    for (int k = 0; k <= 1000; ++k) {
+        const double f = 0.5 * k / 1000;
+        const double d = fabs(mag_q31(f) - mag_ref(f));
+        if (d > worst) worst = d;
+    }
+    TEST_ASSERT_LESS_THAN_DOUBLE(1e-7, worst);
+
+    // Blackman: flat to 0.01 dB well inside fc, -6 dB at fc, >= 74 dB stopband past the transition
+    for (int k = 0; k <= 40; ++k) {
+        const double f = 0.4 * FC * k / 40;
+        TEST_ASSERT_DOUBLE_WITHIN(0.01, 0.0, db(mag_q31(f)));
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(0.1, -6.02, db(mag_q31(FC)));
+    for (int k = 0; k <= 400; ++k) {
+        const double f = FC + 3.0 / NTAPS + (0.5 - FC - 3.0 / NTAPS) * k / 400;
+        TEST_ASSERT_LESS_THAN_DOUBLE(-74.0, db(mag_q31(f)));
+    }
+}
+
+static int32_t tone(double f, uint32_t n, double phase) {
+    return (int32_t)lrint(AMP * sin(2.0 * PI * f * n + phase));
+}
+
+/* Streams two tones (one per channel) through the decimator in DMA-sized blocks.
+   Every output must match the double-precision filter evaluated at the same
+   instant to within rounding, and the steady-state gain must match |H(f)|. */
+static void run_tones(double f0, double f1) {
+    static int32_t in[TONE_FRAMES * CH];
+    static int32_t out[(TONE_FRAMES / RATIO + 1) * CH];
+    const double f[CH] = { f0, f1 };
+    for (uint32_t n = 0; n < TONE_FRAMES; ++n) {
+        for (uint32_t c = 0; c < CH; ++c) in[n * CH + c] = tone(f[c], n, 0.3 + c);
+    }
+
+    dsp_fir_decim_reset(&s_fir);
+    uint32_t m = 0;
+    for (uint32_t n = 0; n < TONE_FRAMES; n += BENCH_BLOCK) {
+        m += dsp_fir_decim_process(&s_fir, in + n * CH, BENCH_BLOCK, out + m * CH);
+    }
+    TEST_ASSERT_EQUAL_UINT32(TONE_FRAMES / RATIO, m);
+
+    // Output m is the filter over the NTAPS frames ending at input frame m * RATIO
+    const uint32_t settle = NTAPS / RATIO + 1;
+    for (uint32_t c = 0; c < CH; ++c) {
+        double sq = 0.0;
+        for (uint32_t k = 0; k < m; ++k) {
+            double y = 0.0;
+            for (uint32_t j = 0; j < NTAPS; ++j) {
+                const int64_t n = (int64_t)k * RATIO - (NTAPS - 1) + j;
+                if (n >= 0) y += s_ref[j] * in[n * CH + c];
+            }
+            TEST_ASSERT_DOUBLE_WITHIN(1.0, y, (double)out[k * CH + c]);
+            if (k >= settle) sq += (double)out[k * CH + c] * out[k * CH + c];
+        }
+        const double gain = sqrt(2.0 * sq / (m - settle)) / AMP;
+        const double want = mag_ref(f[c]);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "f = %.4f fs: %.3f dB (reference %.3f dB)", f[c], db(gain), db(want));
+        TEST_MESSAGE(msg);
+        if (want > 1e-3) {
+            TEST_ASSERT_DOUBLE_WITHIN(0.02, db(want), db(gain));
+        } else {
+            TEST_ASSERT_LESS_THAN_DOUBLE(-74.0, db(gain));
+        }
+    }
+}
+
+static void test_tones_passband(void) {
+    run_tones(0.0037, 0.0191);
+}
+
+static void test_tones_transition(void) {
+    run_tones(0.0413, 0.0571);
+}
+
+static void test_tones_stopband(void) {
+    run_tones(0.0893, 0.2317);
+}
+
+// Same output whatever the block sizes, including 1-frame and empty calls
+static void test_block_boundaries_invisible(void) {
+    enum { FRAMES = 4001 };
+    static int32_t in[FRAMES * CH];
+    static int32_t one[(FRAMES / RATIO + 1) * CH];
+    static int32_t split[(FRAMES / RATIO + 1) * CH];
+    srand(7);
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) in[i] = (rand() & 0xFFFFFF) - 0x800000;
+
+    dsp_fir_decim_reset(&s_fir);
+    const uint32_t m1 = dsp_fir_decim_process(&s_fir, in, FRAMES, one);
+
+    dsp_fir_decim_reset(&s_fir);
+    uint32_t m2 = 0;
+    for (uint32_t n = 0; n < FRAMES; ) {
+        uint32_t len = (uint32_t)(rand() % 38);
+        if (len > FRAMES - n) len = FRAMES - n;
+        const uint32_t m = dsp_fir_decim_process(&s_fir, in + n * CH, len, split + m2 * CH);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(dsp_fir_decim_max_out(&s_fir, len), m);
+        m2 += m;
+        n += len;
+    }
+    TEST_ASSERT_EQUAL_UINT32(m1, m2);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(one, split, m1 * CH);
+}
+
+// Full-scale square wave: rounding back to 24 bits saturates rather than wrapping
+static void test_saturates(void) {
+    enum { FRAMES = 512 };
+    static int32_t in[FRAMES * CH];
+    static int32_t out[(FRAMES / RATIO + 1) * CH];
+    for (uint32_t n = 0; n < FRAMES; ++n) {
+        const int32_t v = ((n / 12) & 1) ? -0x800000 : 0x7FFFFF;
+        for (uint32_t c = 0; c < CH; ++c) in[n * CH + c] = v;
+    }
+    dsp_fir_decim_reset(&s_fir);
+    const uint32_t m = dsp_fir_decim_process(&s_fir, in, FRAMES, out);
+    for (uint32_t i = 0; i < m * CH; ++i) {
+        TEST_ASSERT_LESS_OR_EQUAL(0x7FFFFF, out[i]);
+        TEST_ASSERT_GREATER_OR_EQUAL(-0x800000, out[i]);
+    }
+}
+
+static void test_bench(void) {
+    static int32_t in[BENCH_BLOCK * CH];
+    static int32_t out[(BENCH_BLOCK / RATIO + 1) * CH];
+    for (uint32_t i = 0; i < BENCH_BLOCK * CH; ++i) in[i] = (int32_t)(i * 2654435761u) >> 8;
+
+    dsp_fir_decim_reset(&s_fir);
+    const int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        dsp_fir_decim_process(&s_fir, in, BENCH_BLOCK, out);
+        in[r % (BENCH_BLOCK * CH)] ^= out[0];
+    }
+    bench_report("fir_decim 96 taps 8:1", bench_now_us() - t0, (double)BENCH_REPS * BENCH_BLOCK * CH, "sample");
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_design_matches_reference);
+    RUN_TEST(test_tones_passband);
+    RUN_TEST(test_tones_transition);
+    RUN_TEST(test_tones_stopband);
+    RUN_TEST(test_block_boundaries_invisible);
+    RUN_TEST(test_saturates);
+    RUN_TEST(test_bench);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
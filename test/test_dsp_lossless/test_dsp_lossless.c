@@ -0,0 +1,118 @@
+/* dsp_lossless round trip: every input shape the coder treats differently
+   (noise, smooth, full-scale alternating, silence) at frame counts that hit the
+   short-block and partition edges, 1 to 4 channels. Encoded size stays within
+   dsp_ll_max_bytes() and a block cut short anywhere is rejected. */
+
+#include "unity.h"
+#include "dsp_lossless.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI          3.14159265358979323846
+#define MAX_FRAMES  512
+#define MAX_CH      4
+#define FS_MAX      0x7FFFFF
+#define FS_MIN      (-0x800000)
+
+typedef enum { SIG_RANDOM, SIG_SINE, SIG_ALTERNATE, SIG_ZERO, SIG_COUNT } sig_t;
+
+static const char *const SIG_NAME[SIG_COUNT] = { "random", "sine", "alternating", "zero" };
+
+// 1, 2, 3 and odd counts, powers of two, and the app's 64-frame ds block
+static const uint32_t FRAMES[] = { 1, 2, 3, 5, 7, 31, 33, 64, 127, 128, 255, 256, 512 };
+
+static int32_t s_in[MAX_FRAMES * MAX_CH];
+static int32_t s_out[MAX_FRAMES * MAX_CH];
+static int32_t s_scratch[2 * MAX_FRAMES];
+static uint8_t s_enc[MAX_CH * (MAX_FRAMES * 4 + 64) + 8];
+
+static uint32_t s_rng = 0x9E3779B9u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void fill(sig_t sig, uint32_t frames, uint32_t ch) {
+    for (uint32_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) {
+            int32_t v = 0;
+            switch (sig) {
+            case SIG_RANDOM:    v = (int32_t)(rnd() & 0xFFFFFF) - 0x800000; break;
+            case SIG_SINE:      v = (int32_t)lrint(FS_MAX * 0.9 * sin(2.0 * PI * (i + 7 * c) / (19.0 + c))); break;
+            case SIG_ALTERNATE: v = ((i + c) & 1) ? FS_MIN : FS_MAX; break;
+            default:            v = 0; break;
+            }
+            s_in[i * ch + c] = v;
+        }
+    }
+}
+
+static size_t round_trip(sig_t sig, uint32_t frames, uint32_t ch) {
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%s, %lu frames x %lu ch", SIG_NAME[sig], (unsigned long)frames, (unsigned long)ch);
+    fill(sig, frames, ch);
+    memset(s_enc, 0xEE, sizeof(s_enc));
+    memset(s_out, 0, sizeof(s_out));
+
+    const size_t n = dsp_ll_encode(s_in, frames, ch, s_scratch, s_enc);
+    TEST_ASSERT_GREATER_THAN_MESSAGE(0, n, msg);
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(dsp_ll_max_bytes(frames, ch), n, msg);
+    TEST_ASSERT_EQUAL_size_t_MESSAGE(n, dsp_ll_decode(s_enc, n, frames, ch, s_scratch, s_out), msg);
+    TEST_ASSERT_EQUAL_INT32_ARRAY_MESSAGE(s_in, s_out, frames * ch, msg);
+    return n;
+}
+
+static void test_round_trip(void) {
+    for (sig_t sig = 0; sig < SIG_COUNT; ++sig) {
+        for (size_t f = 0; f < sizeof(FRAMES) / sizeof(FRAMES[0]); ++f) {
+            for (uint32_t ch = 1; ch <= MAX_CH; ++ch) round_trip(sig, FRAMES[f], ch);
+        }
+    }
+}
+
+// Silence and tones must actually compress (against packed 24-bit); noise may not, but stays in bound
+static void test_ratio(void) {
+    const size_t raw = (size_t)MAX_FRAMES * 2 * 3;
+    TEST_ASSERT_LESS_THAN(raw / 20, round_trip(SIG_ZERO, MAX_FRAMES, 2));
+    TEST_ASSERT_LESS_THAN(raw * 3 / 4, round_trip(SIG_SINE, MAX_FRAMES, 2));
+}
+
+// Every strict prefix of a block is rejected, not decoded from stale bytes
+static void test_truncated_rejected(void) {
+    for (sig_t sig = 0; sig < SIG_COUNT; ++sig) {
+        const uint32_t frames = 64, ch = 2;
+        const size_t n = round_trip(sig, frames, ch);
+        for (size_t len = 0; len < n; ++len) {
+            TEST_ASSERT_EQUAL_size_t_MESSAGE(0, dsp_ll_decode(s_enc, len, frames, ch, s_scratch, s_out), SIG_NAME[sig]);
+        }
+    }
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_ratio);
+    RUN_TEST(test_truncated_rejected);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,178 @@
+/* dsp_merge: range selection (enter / exit hysteresis, hold_frames carried
+   across calls), dsp_merge_decode on both ranges and signs, and the gain /
+   offset match. For the last, the low-gain channel is simulated with a true
+   gain of 19.6 and a 300 LSB offset against a nominal 20: the fit converges,
+   high-range words are within 1 LSB of the input, low-range words are within
+   1.5 of the 40 LSB grid steps of the true current, and no block with a
+   clipped high-gain sample comes out in high range. */
+
+#include "unity.h"
+#include "dsp_merge.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PI          3.14159265358979323846
+#define FS_HI       ((1 << 23) - 1)
+#define NOMINAL     20.0f
+#define TRUE_GAIN   19.6
+#define TRUE_OFF    300.0
+#define HOLD        10
+#define BLOCK       64
+#define SIM_BLOCKS  20000                   // 1.28 M frames, ~300 calibration folds
+
+static dsp_merge_t s_m;
+static int32_t s_in[BLOCK * 2];
+static int32_t s_out[BLOCK];
+
+static uint32_t s_rng = 0x9B05688Cu;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    const float g = NOMINAL;
+    TEST_ASSERT_TRUE(dsp_merge_init(&s_m, 1, &g, HOLD));
+}
+
+void tearDown(void) {}
+
+// frames of one pair, hi channel at v (lo follows at v / G)
+static bool detect(int32_t v, uint32_t frames) {
+    for (uint32_t i = 0; i < frames; ++i) {
+        s_in[2 * i]     = (int32_t)(v / NOMINAL);
+        s_in[2 * i + 1] = v;
+    }
+    dsp_merge_detect(&s_m, s_in, frames);
+    return s_m.p[0].lo_block;
+}
+
+static void test_init_rejects_bad_args(void) {
+    const float g[2] = { 20.0f, 0.5f };
+    TEST_ASSERT_FALSE(dsp_merge_init(NULL, 1, g, HOLD));
+    TEST_ASSERT_FALSE(dsp_merge_init(&s_m, 0, g, HOLD));
+    TEST_ASSERT_FALSE(dsp_merge_init(&s_m, DSP_MERGE_MAX_PAIRS + 1, g, HOLD));
+    TEST_ASSERT_FALSE(dsp_merge_init(&s_m, 1, NULL, HOLD));
+    TEST_ASSERT_FALSE(dsp_merge_init(&s_m, 2, g, HOLD));      // G < 1
+    TEST_ASSERT_TRUE(dsp_merge_init(&s_m, 1, g, HOLD));
+    TEST_ASSERT_EQUAL_FLOAT(20.0f, s_m.p[0].gain);
+}
+
+// Low range from ENTER; between EXIT and ENTER it depends on where it came from
+static void test_hysteresis(void) {
+    TEST_ASSERT_FALSE(detect(DSP_MERGE_ENTER - 1, 4));
+    TEST_ASSERT_FALSE(detect(DSP_MERGE_EXIT, 4));
+    TEST_ASSERT_TRUE(detect(DSP_MERGE_ENTER, 1));
+    TEST_ASSERT_EQUAL_UINT32(HOLD, s_m.p[0].hold);
+    // back between the thresholds: stays low, hold kept full
+    for (int k = 0; k < 20; ++k) TEST_ASSERT_TRUE(detect(DSP_MERGE_EXIT, 4));
+    TEST_ASSERT_EQUAL_UINT32(HOLD, s_m.p[0].hold);
+    // negative full scale counts the same
+    TEST_ASSERT_TRUE(detect(-DSP_MERGE_ENTER, 1));
+}
+
+/* Below EXIT the hold counts down frame by frame, across calls; the call the
+   hold runs out in is still low, the next one is not */
+static void test_hold_frames(void) {
+    TEST_ASSERT_TRUE(detect(DSP_MERGE_ENTER, 1));
+    TEST_ASSERT_TRUE(detect(DSP_MERGE_EXIT - 1, 4));
+    TEST_ASSERT_EQUAL_UINT32(HOLD - 4, s_m.p[0].hold);
+    TEST_ASSERT_TRUE(detect(1000, 4));
+    TEST_ASSERT_EQUAL_UINT32(HOLD - 8, s_m.p[0].hold);
+    TEST_ASSERT_TRUE(detect(1000, 4));
+    TEST_ASSERT_EQUAL_UINT32(0, s_m.p[0].hold);
+    TEST_ASSERT_FALSE(detect(1000, 4));
+    // once out, EXIT alone doesn't bring it back
+    TEST_ASSERT_FALSE(detect(DSP_MERGE_EXIT, 4));
+}
+
+static void test_decode(void) {
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, dsp_merge_decode(0, NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(2468.0f, dsp_merge_decode(1234 << 1, NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(-2468.0f, dsp_merge_decode((int32_t)((uint32_t)-1234 << 1), NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(1234 * 2 * NOMINAL, dsp_merge_decode((1234 << 1) | 1, NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(-1234 * 2 * NOMINAL, dsp_merge_decode((int32_t)((uint32_t)-1234 << 1) | 1, NOMINAL));
+    // only the low 24 bits are the word: anything above is sign extension
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f * NOMINAL, dsp_merge_decode(0x00FFFFFF, NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(-2.0f, dsp_merge_decode(0x7FFFFFFE, NOMINAL));
+    // extremes of the 23-bit mantissa
+    TEST_ASSERT_EQUAL_FLOAT(((1 << 22) - 1) * 2.0f, dsp_merge_decode(0x7FFFFE, NOMINAL));
+    TEST_ASSERT_EQUAL_FLOAT(-(1 << 22) * 2.0f * NOMINAL, dsp_merge_decode(0x800001, NOMINAL));
+}
+
+/* A slow sine reaching 1.6x the high-gain full scale, plus a little noise on
+   both channels. hi clips; lo = (current - 300) / 19.6. */
+static void test_gain_offset_match(void) {
+    double worst_hi = 0.0, worst_lo = 0.0;
+    uint32_t clipped_blocks = 0;
+    for (uint32_t b = 0; b < SIM_BLOCKS; ++b) {
+        double cur[BLOCK];
+        bool clipped = false;
+        for (uint32_t i = 0; i < BLOCK; ++i) {
+            const double t = (double)(b * BLOCK + i);
+            cur[i] = 1.6 * FS_HI * sin(2.0 * PI * t / 9000.0) + (double)(rnd() % 5) - 2.0;
+            const double lo = (cur[i] - TRUE_OFF) / TRUE_GAIN + ((double)(rnd() % 3) - 1.0);
+            double hi = round(cur[i]);
+            if (hi >  FS_HI) { hi =  FS_HI;     clipped = true; }
+            if (hi < -FS_HI - 1) { hi = -FS_HI - 1; clipped = true; }
+            s_in[2 * i]     = (int32_t)lrint(lo);
+            s_in[2 * i + 1] = (int32_t)hi;
+        }
+        dsp_merge_detect(&s_m, s_in, BLOCK);
+        dsp_merge_process(&s_m, s_in, BLOCK, s_out);
+        if (clipped) {
+            clipped_blocks++;
+            TEST_ASSERT_TRUE(s_m.p[0].lo_block);
+        }
+        if (b < SIM_BLOCKS * 3 / 4) continue;   // converging: the gain starts 2 % off
+
+        for (uint32_t i = 0; i < BLOCK; ++i) {
+            const double v = dsp_merge_decode(s_out[i], NOMINAL);
+            TEST_ASSERT_EQUAL_INT(s_m.p[0].lo_block ? 1 : 0, s_out[i] & 1);
+            if (s_out[i] & 1) {
+                const double e = fabs(v - cur[i]);
+                if (e > worst_lo) worst_lo = e;
+            } else {
+                const double e = fabs(v - s_in[2 * i + 1]);
+                if (e > worst_hi) worst_hi = e;
+            }
+        }
+    }
+    char line[128];
+    snprintf(line, sizeof(line), "gain %.6f, offset %.1f; worst high-range %.1f LSB, low-range %.1f LSB (%.2f steps)",
+        s_m.p[0].gain, s_m.p[0].offset, worst_hi, worst_lo, worst_lo / (2.0 * NOMINAL));
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_TRUE(clipped_blocks > 0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, TRUE_GAIN, s_m.p[0].gain);
+    TEST_ASSERT_DOUBLE_WITHIN(1.0, TRUE_OFF, s_m.p[0].offset);
+    TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(1.0, worst_hi);
+    // half a grid step of rounding, plus the low channel's own LSB and noise, x 19.6
+    TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(1.5 * 2.0 * NOMINAL, worst_lo);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_hysteresis);
+    RUN_TEST(test_hold_frames);
+    RUN_TEST(test_decode);
+    RUN_TEST(test_gain_offset_match);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
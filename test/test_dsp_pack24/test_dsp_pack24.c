@@ -0,0 +1,140 @@
+/* dsp_pack24: slot -> packed -> int32 round trip for every alignment of the
+   packed buffer and every tail length of the 4-sample fast path, sign
+   extension at the 24-bit limits, and the pack kernel's time per sample on
+   the S3 and the host. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_pack24.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define MAX_N       67                      // covers 16 fast-path groups plus every tail
+#define BENCH_N     512                     // one TLV_DMA_BUF_SZ block: 64 frames x 2 ch
+#define BENCH_REPS  4000
+
+static uint32_t s_rng = 0x2545F491u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static int32_t sext24(uint32_t v) {
+    return (int32_t)(v << 8) >> 8;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Padding bits in the slot must be ignored and the guard bytes around the packed data untouched
+static void round_trip(size_t align, size_t n) {
+    uint32_t in[MAX_N];
+    int32_t  out[MAX_N];
+    static uint8_t packed[3 * MAX_N + 8];
+    for (size_t i = 0; i < n; ++i) in[i] = rnd();
+    memset(packed, 0xA5, sizeof(packed));
+    memset(out, 0, sizeof(out));
+
+    dsp_pack24(in, packed + align, n);
+    for (size_t i = 0; i < align; ++i) TEST_ASSERT_EQUAL_HEX8(0xA5, packed[i]);
+    for (size_t i = align + 3 * n; i < sizeof(packed); ++i) TEST_ASSERT_EQUAL_HEX8(0xA5, packed[i]);
+
+    dsp_unpack24(packed + align, out, n);
+    for (size_t i = 0; i < n; ++i) {
+        TEST_ASSERT_EQUAL_INT32(sext24(in[i]), out[i]);
+        TEST_ASSERT_EQUAL_INT32(sext24(in[i]), dsp_ld24(packed + align + 3 * i));
+    }
+}
+
+static void test_round_trip_all_alignments(void) {
+    for (size_t align = 0; align < 4; ++align) {
+        for (size_t n = 0; n <= MAX_N; ++n) round_trip(align, n);
+    }
+}
+
+static void test_sign_extension(void) {
+    static const uint32_t slot[8] = {
+        0x00000000, 0x00000001, 0x007FFFFF, 0x00800000,
+        0x00FFFFFF, 0xFF800000, 0x12345678, 0xFFFFFFFF,
+    };
+    static const int32_t expect[8] = {
+        0, 1, 8388607, -8388608,
+        -1, -8388608, 0x345678, -1,
+    };
+    uint32_t words[3 * 8 / 4 + 1];          // word-aligned, so the fast path runs
+    uint8_t *packed = (uint8_t *)words;
+    int32_t out[8];
+
+    dsp_pack24(slot, packed, 8);
+    dsp_unpack24(packed, out, 8);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(expect, out, 8);
+
+    dsp_unpack24(packed + 0, out, 0);       // n == 0 touches nothing
+    TEST_ASSERT_EQUAL_INT32_ARRAY(expect, out, 8);
+}
+
+static void test_st24_ld24(void) {
+    uint8_t p[3];
+    const int32_t v[] = { 0, 1, -1, 8388607, -8388608, 123456, -654321 };
+    for (size_t i = 0; i < sizeof(v) / sizeof(v[0]); ++i) {
+        dsp_st24(p, v[i]);
+        TEST_ASSERT_EQUAL_INT32(v[i], dsp_ld24(p));
+    }
+}
+
+static void bench_pack(size_t align, const char *what) {
+    static uint32_t in[BENCH_N];
+    static uint32_t words[3 * BENCH_N / 4 + 1];
+    uint8_t *packed = (uint8_t *)words + align;
+    for (size_t i = 0; i < BENCH_N; ++i) in[i] = rnd();
+
+    const int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        dsp_pack24(in, packed, BENCH_N);
+        in[r % BENCH_N] ^= packed[r % (3 * BENCH_N)];   // keep the loop from folding
+    }
+    bench_report(what, bench_now_us() - t0, (double)BENCH_REPS * BENCH_N, "sample");
+}
+
+static void test_bench_pack(void) {
+    bench_pack(0, "pack24 aligned");
+    bench_pack(1, "pack24 unaligned");
+}
+
+static void test_bench_unpack(void) {
+    static uint32_t words[3 * BENCH_N / 4];
+    static int32_t out[BENCH_N];
+    for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i) words[i] = rnd();
+
+    const int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        dsp_unpack24((const uint8_t *)words, out, BENCH_N);
+        words[r % (3 * BENCH_N / 4)] += (uint32_t)out[r % BENCH_N];
+    }
+    bench_report("unpack24 aligned", bench_now_us() - t0, (double)BENCH_REPS * BENCH_N, "sample");
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_all_alignments);
+    RUN_TEST(test_sign_extension);
+    RUN_TEST(test_st24_ld24);
+    RUN_TEST(test_bench_pack);
+    RUN_TEST(test_bench_unpack);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,136 @@
+/* dsp_resample: step 1.0 passes the input through bit for bit with output n
+   on input frame n, DSP_RS_TAPS / 2 frames behind the newest input; a sine
+   resampled at +-50 ppm matches the ideal sine at the new positions to a
+   given SNR; the read position tracks n x step across blocks. */
+
+#include "unity.h"
+#include "dsp_resample.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define PI          3.14159265358979323846
+#define CH          2
+#define MAX_IN      128
+#define FRAMES      8000                    // one second at the app default; 128 KB of buffers on the S3
+#define AMP         4194304.0               // -6 dBFS in 24 bits
+#define SNR_DB      80.0                    // host: 88.6 dB at both offsets
+
+static float   s_coef[DSP_RS_COEF_LEN];
+static float   s_state[CH * (DSP_RS_TAPS + MAX_IN)];
+static int32_t s_in[FRAMES * CH];
+static int32_t s_out[(FRAMES + FRAMES / 512 + 2 + MAX_IN) * CH];
+static dsp_rs_t s_rs;
+
+static uint32_t s_rng = 0xBB67AE85u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    dsp_rs_design(s_coef);
+    TEST_ASSERT_TRUE(dsp_rs_init(&s_rs, s_coef, CH, MAX_IN, s_state));
+}
+
+void tearDown(void) {}
+
+// Everything in s_in through the resampler in random blocks (0 included); returns frames out
+static uint32_t run(double step) {
+    uint32_t in = 0, out = 0;
+    while (in < FRAMES) {
+        uint32_t n = rnd() % (MAX_IN + 1);
+        if (n > FRAMES - in) n = FRAMES - in;
+        const uint32_t m = dsp_rs_process(&s_rs, s_in + (size_t)in * CH, n, step, s_out + (size_t)out * CH);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(dsp_rs_max_out(n), m);
+        in  += n;
+        out += m;
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6, out * step, dsp_rs_next_in(&s_rs));
+    }
+    return out;
+}
+
+static void test_init_rejects_bad_args(void) {
+    dsp_rs_t r;
+    TEST_ASSERT_FALSE(dsp_rs_init(NULL, s_coef, CH, MAX_IN, s_state));
+    TEST_ASSERT_FALSE(dsp_rs_init(&r, NULL, CH, MAX_IN, s_state));
+    TEST_ASSERT_FALSE(dsp_rs_init(&r, s_coef, 0, MAX_IN, s_state));
+    TEST_ASSERT_FALSE(dsp_rs_init(&r, s_coef, CH, 0, s_state));
+    TEST_ASSERT_FALSE(dsp_rs_init(&r, s_coef, CH, MAX_IN, NULL));
+}
+
+// Unit impulse at every integer position: the kernel's first row
+static void test_zero_offset_kernel(void) {
+    for (uint32_t k = 0; k < DSP_RS_TAPS; ++k) {
+        if (k == DSP_RS_TAPS / 2 - 1) TEST_ASSERT_EQUAL_FLOAT(1.0f, s_coef[k]);
+        else TEST_ASSERT_FLOAT_WITHIN(1e-9f, 0.0f, s_coef[k]);
+    }
+}
+
+/* Full-scale noise, step 1.0: every output equals its input, the first on
+   input frame 0, and the last DSP_RS_TAPS / 2 frames are still held back. */
+static void test_unit_step_passes_through(void) {
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) s_in[i] = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+    const uint32_t out = run(1.0);
+    TEST_ASSERT_EQUAL_UINT32(FRAMES - DSP_RS_TAPS / 2, out);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(s_in, s_out, out * CH);
+}
+
+/* A sine at a quarter of the rate on one channel and at a tenth on the other,
+   resampled at step 1 + ppm: output n against the same sine evaluated at
+   input position n x step. */
+static double snr_db(double ppm, double f0, double f1) {
+    const double step = 1.0 + ppm * 1e-6;
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        s_in[i * CH]     = (int32_t)lrint(AMP * sin(2.0 * PI * f0 * i));
+        s_in[i * CH + 1] = (int32_t)lrint(AMP * sin(2.0 * PI * f1 * i + 1.0));
+    }
+    const uint32_t out = run(step);
+    TEST_ASSERT_UINT32_WITHIN(2, (uint32_t)((FRAMES - DSP_RS_TAPS / 2) / step), out);
+
+    double sig = 0.0, err = 0.0;
+    for (uint32_t n = DSP_RS_TAPS; n < out; ++n) {       // past the silence the history was primed with
+        const double x = n * step;
+        const double e0 = s_out[n * CH]     - AMP * sin(2.0 * PI * f0 * x);
+        const double e1 = s_out[n * CH + 1] - AMP * sin(2.0 * PI * f1 * x + 1.0);
+        sig += 2.0 * AMP * AMP / 2.0;
+        err += e0 * e0 + e1 * e1;
+    }
+    const double snr = 10.0 * log10(sig / err);
+    char line[96];
+    snprintf(line, sizeof(line), "%+.0f ppm, f = %.2f / %.2f of rate: SNR %.1f dB", ppm, f0, f1, snr);
+    TEST_MESSAGE(line);
+    return snr;
+}
+
+static void test_sine_snr_plus_50ppm(void) {
+    TEST_ASSERT_GREATER_THAN_DOUBLE(SNR_DB, snr_db(50.0, 0.25, 0.1));
+}
+
+static void test_sine_snr_minus_50ppm(void) {
+    TEST_ASSERT_GREATER_THAN_DOUBLE(SNR_DB, snr_db(-50.0, 0.25, 0.1));
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_zero_offset_kernel);
+    RUN_TEST(test_unit_step_passes_through);
+    RUN_TEST(test_sine_snr_plus_50ppm);
+    RUN_TEST(test_sine_snr_minus_50ppm);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,172 @@
+/* dsp_sdt: lines between archived points reproduce every input sample to
+   within dev + 0.5 LSB (noisy sine, random walk with steps, across the 2^32
+   wrap of the sample index); the heartbeat archives a flat trace every hb
+   samples and never lets a gap grow past it; and a quiet hour of a 1 kHz
+   stream (noise, slow drift, a few load steps) keeps under 5 % of its
+   samples. */
+
+#include "unity.h"
+#include "dsp_sdt.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PI          3.14159265358979323846
+#define PEND        16384                   // samples since the last point, > any hb used here
+#define RATE_HZ     1000
+#define HOUR        (3600u * RATE_HZ)
+#define HB          (10u * RATE_HZ)         // 10 s heartbeat
+
+static dsp_sdt_t s_sdt;
+static int32_t s_v[PEND];                   // input by t % PEND
+
+typedef struct {
+    bool     have;
+    dsp_sdt_point_t last;
+    uint32_t points;
+    uint32_t max_gap;       // longest span between points, samples
+    double   worst;         // worst |line - sample|
+} check_t;
+
+static check_t s_chk;
+
+static uint32_t s_rng = 0xA54FF53Au;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    memset(&s_chk, 0, sizeof(s_chk));
+}
+
+void tearDown(void) {}
+
+/* Every sample in (last point, p] against the line from the last point to p;
+   points come in time order and never more than PEND apart */
+static void check_point(dsp_sdt_point_t p, float dev) {
+    s_chk.points++;
+    if (!s_chk.have) {
+        TEST_ASSERT_EQUAL_INT32(s_v[p.t % PEND], p.v);
+        s_chk.have = true;
+        s_chk.last = p;
+        return;
+    }
+    const uint32_t span = p.t - s_chk.last.t;
+    TEST_ASSERT_TRUE(span > 0 && span < PEND);
+    if (span > s_chk.max_gap) s_chk.max_gap = span;
+    for (uint32_t k = 1; k <= span; ++k) {
+        const uint32_t t = s_chk.last.t + k;
+        const double line = s_chk.last.v + (double)(p.v - s_chk.last.v) * k / span;
+        const double e = fabs(line - s_v[t % PEND]);
+        if (e > s_chk.worst) s_chk.worst = e;
+        if (e > dev + 0.5 + 1e-3) {
+            char msg[96];
+            snprintf(msg, sizeof(msg), "t %lu: sample %ld, line %.2f", (unsigned long)t, (long)s_v[t % PEND], line);
+            TEST_FAIL_MESSAGE(msg);
+        }
+    }
+    s_chk.last = p;
+}
+
+static void push(uint32_t t, int32_t v, float dev) {
+    dsp_sdt_point_t pt[2];
+    s_v[t % PEND] = v;
+    const uint32_t n = dsp_sdt_push(&s_sdt, t, v, pt);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, n);
+    for (uint32_t j = 0; j < n; ++j) check_point(pt[j], dev);
+}
+
+// Noisy sine at a tight tolerance: many points, every one of them checked
+static void test_reconstruct_sine(void) {
+    const float dev = 2.5f;
+    dsp_sdt_init(&s_sdt, dev, 0);
+    for (uint32_t t = 0; t < 200000; ++t) {
+        const double v = 40000.0 * sin(2.0 * PI * t / 3000.0) + (double)(rnd() % 9) - 4.0;
+        push(t, (int32_t)lrint(v), dev);
+    }
+    char line[96];
+    snprintf(line, sizeof(line), "sine, dev %.1f: %lu points, worst %.2f LSB", dev, (unsigned long)s_chk.points, s_chk.worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(s_chk.points > 1000);
+}
+
+// Random walk with occasional full-scale steps, sample index wrapping through 2^32
+static void test_reconstruct_walk_across_wrap(void) {
+    const float dev = 10.0f;
+    dsp_sdt_init(&s_sdt, dev, 0);
+    int32_t v = 0;
+    uint32_t t = UINT32_MAX - 50000;
+    for (uint32_t i = 0; i < 100000; ++i, ++t) {
+        v += (int32_t)(rnd() % 41) - 20;
+        if (rnd() % 5000 == 0) v = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+        push(t, v, dev);
+    }
+    char line[96];
+    snprintf(line, sizeof(line), "walk, dev %.1f: %lu points, worst %.2f LSB", dev, (unsigned long)s_chk.points, s_chk.worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(s_chk.last.t < 100000);     // points made it past the wrap
+}
+
+// A flat trace: the first sample, then exactly one point every hb samples
+static void test_heartbeat(void) {
+    const uint32_t hb = 100;
+    dsp_sdt_init(&s_sdt, 5.0f, hb);
+    for (uint32_t t = 0; t < 10 * hb; ++t) push(t, 1234, 5.0f);
+    TEST_ASSERT_EQUAL_UINT32(10, s_chk.points);
+    TEST_ASSERT_EQUAL_UINT32(hb, s_chk.max_gap);
+    TEST_ASSERT_EQUAL_UINT32(9 * hb, s_chk.last.t);
+    TEST_ASSERT_EQUAL_INT32(1234, s_chk.last.v);
+
+    // no heartbeat: nothing past the first point
+    memset(&s_chk, 0, sizeof(s_chk));
+    dsp_sdt_init(&s_sdt, 5.0f, 0);
+    for (uint32_t t = 0; t < 10 * hb; ++t) push(t, 1234, 5.0f);
+    TEST_ASSERT_EQUAL_UINT32(1, s_chk.points);
+}
+
+/* One hour at 1 kHz: +-3 LSB of noise on a slow drift, dev 10 LSB, a 10 s
+   heartbeat, and a load step every ten minutes. */
+static void test_quiet_hour(void) {
+    const float dev = 10.0f;
+    dsp_sdt_init(&s_sdt, dev, HB);
+    for (uint32_t t = 0; t < HOUR; ++t) {
+        const double drift = 200.0 * sin(2.0 * PI * t / (HOUR / 3.0));
+        const double load  = ((t / (600u * RATE_HZ)) % 2) ? 5000.0 : 0.0;
+        const double v = 20000.0 + drift + load + (double)(rnd() % 7) - 3.0;
+        push(t, (int32_t)lrint(v), dev);
+    }
+    const double kept = 100.0 * s_chk.points / HOUR;
+    char line[128];
+    snprintf(line, sizeof(line), "quiet hour: %lu points for %lu samples (%.3f %% kept), longest gap %lu, worst %.2f LSB",
+        (unsigned long)s_chk.points, (unsigned long)HOUR, kept, (unsigned long)s_chk.max_gap, s_chk.worst);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(HB, s_chk.max_gap);
+    TEST_ASSERT_TRUE(s_chk.points >= HOUR / HB);
+    TEST_ASSERT_LESS_THAN_DOUBLE(5.0, kept);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_reconstruct_sine);
+    RUN_TEST(test_reconstruct_walk_across_wrap);
+    RUN_TEST(test_heartbeat);
+    RUN_TEST(test_quiet_hour);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,198 @@
+/* dsp_stats: every window's min, max, mean, RMS and clip count match a
+   brute-force pass over the same frames, whatever block sizes the input
+   arrives in (windows shorter and longer than a block, closing mid-block);
+   clip counting starts exactly at +-DSP_STATS_CLIP_LEVEL; and a full-scale
+   window of DSP_STATS_MAX_FRAMES doesn't overflow the sum of squares. */
+
+#include "unity.h"
+#include "dsp_stats.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CH          3
+#define FRAMES      8000                    // 96 KB of input on the S3
+#define MAX_BLOCK   300
+
+static dsp_stats_t s_st;
+static int32_t s_in[FRAMES * CH];
+
+static uint32_t s_rng = 0x3C6EF372u;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Channel 0 full-scale noise, 1 a slow random walk, 2 either side of the clip level
+static void fill(void) {
+    int32_t w = 1000;
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        w += (int32_t)(rnd() % 201) - 100;
+        s_in[i * CH]     = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+        s_in[i * CH + 1] = w;
+        s_in[i * CH + 2] = (rnd() & 1 ? 1 : -1) * (DSP_STATS_CLIP_LEVEL - 4 + (int32_t)(rnd() % 8));
+    }
+}
+
+// The window [first, first + n) of channel c, the slow way
+static void reference(uint32_t first, uint32_t n, uint32_t c, dsp_stats_result_t *r) {
+    int32_t mn = INT32_MAX, mx = INT32_MIN;
+    double sum = 0.0, sq = 0.0;
+    uint32_t clips = 0;
+    for (uint32_t i = first; i < first + n; ++i) {
+        const int32_t v = s_in[i * CH + c];
+        if (v < mn) mn = v;
+        if (v > mx) mx = v;
+        sum += v;
+        sq  += (double)v * v;
+        if (v >= DSP_STATS_CLIP_LEVEL || v <= -DSP_STATS_CLIP_LEVEL) clips++;
+    }
+    r->min   = mn;
+    r->max   = mx;
+    r->mean  = sum / n;
+    r->rms   = sqrt(sq / n);
+    r->clips = clips;
+}
+
+static void check_window(uint32_t first, uint32_t n) {
+    for (uint32_t c = 0; c < CH; ++c) {
+        dsp_stats_result_t got, want;
+        dsp_stats_result(&s_st, c, &got);
+        reference(first, n, c, &want);
+        TEST_ASSERT_EQUAL_INT32(want.min, got.min);
+        TEST_ASSERT_EQUAL_INT32(want.max, got.max);
+        TEST_ASSERT_EQUAL_UINT32(want.clips, got.clips);
+        TEST_ASSERT_DOUBLE_WITHIN(1e-9 * 0x800000, want.mean, got.mean);
+        TEST_ASSERT_DOUBLE_WITHIN(1e-9 * want.rms, want.rms, got.rms);
+    }
+}
+
+/* Feeds FRAMES in random blocks of 0 .. MAX_BLOCK frames, checking each window
+   as it closes; returns the number of windows */
+static uint32_t run(uint32_t window) {
+    TEST_ASSERT_TRUE(dsp_stats_init(&s_st, CH, window));
+    uint32_t pos = 0, start = 0, windows = 0;
+    while (pos < FRAMES) {
+        uint32_t len = rnd() % (MAX_BLOCK + 1);
+        if (len > FRAMES - pos) len = FRAMES - pos;
+        const int32_t *in = s_in + (size_t)pos * CH;
+        while (len) {
+            const uint32_t n = dsp_stats_accumulate(&s_st, in, len);
+            TEST_ASSERT_TRUE(n > 0 && n <= len);
+            in += n * CH; len -= n; pos += n;
+            if (dsp_stats_ready(&s_st)) {
+                TEST_ASSERT_EQUAL_UINT32(window, pos - start);
+                check_window(start, window);
+                dsp_stats_reset(&s_st);
+                start = pos;
+                windows++;
+            } else {
+                TEST_ASSERT_EQUAL_UINT32(0, len);     // only a closed window stops short
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(FRAMES - start, s_st.count);
+    if (s_st.count) check_window(start, s_st.count);    // the partial window so far
+    return windows;
+}
+
+static void test_init_rejects_bad_args(void) {
+    dsp_stats_t s;
+    TEST_ASSERT_FALSE(dsp_stats_init(NULL, CH, 100));
+    TEST_ASSERT_FALSE(dsp_stats_init(&s, 0, 100));
+    TEST_ASSERT_FALSE(dsp_stats_init(&s, DSP_STATS_MAX_CH + 1, 100));
+    TEST_ASSERT_FALSE(dsp_stats_init(&s, CH, 0));
+    TEST_ASSERT_FALSE(dsp_stats_init(&s, CH, DSP_STATS_MAX_FRAMES + 1));
+    TEST_ASSERT_TRUE(dsp_stats_init(&s, CH, DSP_STATS_MAX_FRAMES));
+
+    // nothing accumulated yet: an all-zero result
+    dsp_stats_result_t r;
+    memset(&r, 0xA5, sizeof(r));
+    dsp_stats_result(&s, 0, &r);
+    TEST_ASSERT_EQUAL_INT32(0, r.min);
+    TEST_ASSERT_EQUAL_INT32(0, r.max);
+    TEST_ASSERT_EQUAL_UINT32(0, r.clips);
+    TEST_ASSERT_TRUE(r.mean == 0.0 && r.rms == 0.0);
+}
+
+// Windows much shorter than a block: several close inside one call sequence
+static void test_short_windows(void) {
+    fill();
+    TEST_ASSERT_EQUAL_UINT32(FRAMES / 7, run(7));
+    TEST_ASSERT_EQUAL_UINT32(FRAMES, run(1));
+}
+
+// Windows spanning many blocks, closing at arbitrary points inside one
+static void test_long_windows(void) {
+    fill();
+    TEST_ASSERT_EQUAL_UINT32(FRAMES / 1000, run(1000));
+    TEST_ASSERT_EQUAL_UINT32(FRAMES / 4093, run(4093));
+    TEST_ASSERT_EQUAL_UINT32(0, run(FRAMES + 1));
+}
+
+// |x| >= DSP_STATS_CLIP_LEVEL counts, one LSB inside doesn't, on either sign
+static void test_clip_level(void) {
+    static const int32_t v[] = {
+        DSP_STATS_CLIP_LEVEL - 1, DSP_STATS_CLIP_LEVEL, DSP_STATS_CLIP_LEVEL + 1, (1 << 23) - 1,
+        -DSP_STATS_CLIP_LEVEL + 1, -DSP_STATS_CLIP_LEVEL, -DSP_STATS_CLIP_LEVEL - 1, -(1 << 23),
+        0,
+    };
+    const uint32_t n = sizeof(v) / sizeof(v[0]);
+    TEST_ASSERT_TRUE(dsp_stats_init(&s_st, 1, n));
+    // one frame at a time, so the count carries across calls as well
+    for (uint32_t i = 0; i < n; ++i) TEST_ASSERT_EQUAL_UINT32(1, dsp_stats_accumulate(&s_st, &v[i], 1));
+    TEST_ASSERT_TRUE(dsp_stats_ready(&s_st));
+    dsp_stats_result_t r;
+    dsp_stats_result(&s_st, 0, &r);
+    TEST_ASSERT_EQUAL_UINT32(6, r.clips);
+    TEST_ASSERT_EQUAL_INT32(-(1 << 23), r.min);
+    TEST_ASSERT_EQUAL_INT32((1 << 23) - 1, r.max);
+
+    dsp_stats_reset(&s_st);
+    TEST_ASSERT_EQUAL_UINT32(n - 1, dsp_stats_accumulate(&s_st, v, n - 1));
+    dsp_stats_result(&s_st, 0, &r);
+    TEST_ASSERT_EQUAL_UINT32(6, r.clips);
+}
+
+// A whole DSP_STATS_MAX_FRAMES window at negative full scale: sumsq = 2^63 exactly
+static void test_full_scale_max_window(void) {
+    static int32_t blk[1024];
+    for (uint32_t i = 0; i < 1024; ++i) blk[i] = -(1 << 23);
+    TEST_ASSERT_TRUE(dsp_stats_init(&s_st, 1, DSP_STATS_MAX_FRAMES));
+    for (uint32_t k = 0; k < DSP_STATS_MAX_FRAMES / 1024; ++k) TEST_ASSERT_EQUAL_UINT32(1024, dsp_stats_accumulate(&s_st, blk, 1024));
+    TEST_ASSERT_TRUE(dsp_stats_ready(&s_st));
+    TEST_ASSERT_TRUE(s_st.acc[0].sumsq == (uint64_t)1 << 63);
+    dsp_stats_result_t r;
+    dsp_stats_result(&s_st, 0, &r);
+    TEST_ASSERT_EQUAL_DOUBLE(-8388608.0, r.mean);
+    TEST_ASSERT_EQUAL_DOUBLE(8388608.0, r.rms);
+    TEST_ASSERT_EQUAL_UINT32(DSP_STATS_MAX_FRAMES, r.clips);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_short_windows);
+    RUN_TEST(test_long_windows);
+    RUN_TEST(test_clip_level);
+    RUN_TEST(test_full_scale_max_window);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,119 @@
+/* dsp_synth: each channel is its documented DC + (c + 1) x 50 Hz sine + small
+   noise, runs are reproducible per seed, both ring layouts carry the same
+   samples, and skip() keeps the sines in phase across a dropped block. */
+
+#include "unity.h"
+#include "dsp_pack24.h"
+#include "dsp_synth.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PI      3.14159265358979323846
+#define FS      8000
+#define CH      4
+#define FRAMES  800                         // 0.1 s: whole periods of every channel's sine
+#define FS24    (1 << 23)
+
+static dsp_synth_t s_a, s_b;
+static uint32_t s_w[FRAMES * DSP_SYNTH_MAX_CH];
+static uint32_t s_w2[FRAMES * DSP_SYNTH_MAX_CH];
+static uint8_t  s_p[FRAMES * DSP_SYNTH_MAX_CH * 3];
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static int32_t slot(const uint32_t *w, uint32_t i) {
+    return (int32_t)(w[i] << 8) >> 8;
+}
+
+static void test_init_rejects_bad_args(void) {
+    TEST_ASSERT_FALSE(dsp_synth_init(NULL, CH, FS, 1));
+    TEST_ASSERT_FALSE(dsp_synth_init(&s_a, 0, FS, 1));
+    TEST_ASSERT_FALSE(dsp_synth_init(&s_a, DSP_SYNTH_MAX_CH + 1, FS, 1));
+    TEST_ASSERT_FALSE(dsp_synth_init(&s_a, CH, 0, 1));
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_a, DSP_SYNTH_MAX_CH, FS, 0));   // seed 0 is remapped
+}
+
+// Mean is the DC level, the fitted sine at (c + 1) x 50 Hz is FS/4, the rest is noise
+static void test_signal_per_channel(void) {
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_a, CH, FS, 1234));
+    dsp_synth_fill(&s_a, (uint8_t *)s_w, 4, FRAMES);
+    for (uint32_t c = 0; c < CH; ++c) {
+        const double w = 2.0 * PI * (c + 1) * DSP_SYNTH_BASE_HZ / FS;
+        double sum = 0.0, ss = 0.0, sc = 0.0;
+        for (uint32_t i = 0; i < FRAMES; ++i) {
+            const double x = slot(s_w, i * CH + c);
+            sum += x;
+            ss += x * sin(w * i);
+            sc += x * cos(w * i);
+        }
+        const double dc = ((int32_t)c - CH / 2) * (FS24 / 32.0);
+        const double amp = 2.0 * sqrt(ss * ss + sc * sc) / FRAMES;
+        TEST_ASSERT_DOUBLE_WITHIN(20.0, dc, sum / FRAMES);
+        TEST_ASSERT_DOUBLE_WITHIN(FS24 / 4 * 0.01, FS24 / 4, amp);
+
+        // what's left after DC and the sine is table rounding plus U(-128, 127)
+        for (uint32_t i = 0; i < FRAMES; ++i) {
+            const double r = slot(s_w, i * CH + c) - dc - FS24 / 4 * sin(w * i);
+            TEST_ASSERT_DOUBLE_WITHIN(128.0 + FS24 / 4 * 2.0 * PI / DSP_SYNTH_TAB, 0.0, r);
+        }
+    }
+}
+
+static void test_reproducible_per_seed(void) {
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_a, CH, FS, 77));
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_b, CH, FS, 77));
+    dsp_synth_fill(&s_a, (uint8_t *)s_w, 4, FRAMES);
+    dsp_synth_fill(&s_b, (uint8_t *)s_w2, 4, FRAMES);
+    TEST_ASSERT_EQUAL_MEMORY(s_w, s_w2, FRAMES * CH * 4);
+
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_b, CH, FS, 78));
+    dsp_synth_fill(&s_b, (uint8_t *)s_w2, 4, FRAMES);
+    TEST_ASSERT_TRUE(memcmp(s_w, s_w2, FRAMES * CH * 4) != 0);
+}
+
+// Slot words keep the padding byte clear; packed output is the same samples
+static void test_layouts_match(void) {
+    static int32_t un[FRAMES * CH];
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_a, CH, FS, 5));
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_b, CH, FS, 5));
+    dsp_synth_fill(&s_a, (uint8_t *)s_w, 4, FRAMES);
+    dsp_synth_fill(&s_b, s_p, 3, FRAMES);
+    dsp_unpack24(s_p, un, FRAMES * CH);
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) {
+        TEST_ASSERT_EQUAL_HEX32(0, s_w[i] & 0xFF000000u);
+        TEST_ASSERT_EQUAL_INT32(slot(s_w, i), un[i]);
+    }
+}
+
+// A skipped block leaves every channel's sine where a generated one would
+static void test_skip_keeps_phase(void) {
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_a, CH, FS, 9));
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_b, CH, FS, 9));
+    dsp_synth_fill(&s_a, (uint8_t *)s_w, 4, 123);
+    dsp_synth_skip(&s_b, 123);
+    for (uint32_t c = 0; c < CH; ++c) TEST_ASSERT_EQUAL_UINT32(s_a.phase[c], s_b.phase[c]);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_signal_per_channel);
+    RUN_TEST(test_reproducible_per_seed);
+    RUN_TEST(test_layouts_match);
+    RUN_TEST(test_skip_keeps_phase);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
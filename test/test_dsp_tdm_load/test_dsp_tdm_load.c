@@ -0,0 +1,142 @@
+/* 2 against 4 channels through the per-block path at the app defaults:
+   8 kHz, 8 ms blocks of 24-in-32 slots, 96-tap 8:1 decimation chain to
+   1 kHz, packed 24-bit payload.
+
+   Each block is copied out of the "DMA buffer" as the ISR does, sign-extended,
+   decimated and packed. Reported per channel count: time per block, share of
+   the 8 ms block period (one core), raw and published bytes per second. The
+   4-channel chain must give the 2-channel result on the channels they share. */
+
+#include "unity.h"
+#include "../bench.h"
+#include "dsp_cic.h"
+#include "dsp_pack24.h"
+#include "dsp_synth.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define RATE_HZ     8000                    // DEF_SAMPLE_RATE_HZ
+#define BLOCK_MS    8                       // DEF_BLOCK_MS
+#define FRAMES      (RATE_HZ * BLOCK_MS / 1000)
+#define RATIO       8                       // DEF_DS_RATES "1000"
+#define NTAPS       96                      // DEF_DS_TAPS
+#define CIC_ORDER   4                       // DS_CIC_ORDER
+#define FC          0.4f                    // DS_CUTOFF
+#define MAX_CH      4
+#define BLOCKS      16                      // distinct input blocks (25 KB), cycled by the bench
+#define BENCH_REPS  2000
+#define OUT_FRAMES  (FRAMES / RATIO + 1)
+
+static dsp_synth_t s_synth;
+static uint32_t s_src4[BLOCKS][FRAMES * MAX_CH];   // 4-channel blocks
+static uint32_t s_src2[BLOCKS][FRAMES * 2];        // their first two channels
+static uint32_t s_slot[FRAMES * MAX_CH];           // ring slot the ISR copies into
+static int32_t  s_in32[FRAMES * MAX_CH];
+static int32_t  s_out32[OUT_FRAMES * MAX_CH];
+static uint8_t  s_pay[OUT_FRAMES * MAX_CH * 3];
+static int32_t  s_dec4[BLOCKS * OUT_FRAMES * MAX_CH];
+static int32_t  s_dec2[BLOCKS * OUT_FRAMES * 2];
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void make_blocks(void) {
+    TEST_ASSERT_TRUE(dsp_synth_init(&s_synth, MAX_CH, RATE_HZ, 42));
+    for (uint32_t b = 0; b < BLOCKS; ++b) {
+        dsp_synth_fill(&s_synth, (uint8_t *)s_src4[b], 4, FRAMES);
+        for (uint32_t i = 0; i < FRAMES; ++i) {
+            s_src2[b][i * 2]     = s_src4[b][i * MAX_CH];
+            s_src2[b][i * 2 + 1] = s_src4[b][i * MAX_CH + 1];
+        }
+    }
+}
+
+// One block: ISR copy, 24-in-32 -> int32, decimate, pack for the payload. Returns output frames.
+static uint32_t process_block(dsp_decim_chain_t *d, const uint32_t *dma, uint32_t ch) {
+    memcpy(s_slot, dma, (size_t)FRAMES * ch * 4);
+    for (uint32_t i = 0; i < FRAMES * ch; ++i) s_in32[i] = (int32_t)(s_slot[i] << 8) >> 8;
+    const uint32_t n = dsp_decim_chain_process(d, s_in32, FRAMES, s_out32);
+    for (uint32_t i = 0; i < n * ch; ++i) dsp_st24(s_pay + 3 * i, s_out32[i]);
+    return n;
+}
+
+static uint32_t decimate_all(uint32_t ch, int32_t *dec) {
+    dsp_decim_chain_t d;
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&d, RATIO, ch, CIC_ORDER, NTAPS, FC, FRAMES));
+    uint32_t m = 0;
+    for (uint32_t b = 0; b < BLOCKS; ++b) {
+        const uint32_t *dma = ch == MAX_CH ? s_src4[b] : s_src2[b];
+        const uint32_t n = process_block(&d, dma, ch);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(dsp_decim_chain_max_out(&d, FRAMES), n);
+        for (uint32_t i = 0; i < n * ch; ++i) TEST_ASSERT_EQUAL_INT32(s_out32[i], dsp_ld24(s_pay + 3 * i));
+        memcpy(dec + (size_t)m * ch, s_out32, (size_t)n * ch * sizeof(int32_t));
+        m += n;
+    }
+    dsp_decim_chain_destroy(&d);
+    return m;
+}
+
+// Channels 0 and 1 decimate the same in a 4-channel frame as in a stereo one
+static void test_four_channels_end_to_end(void) {
+    make_blocks();
+    const uint32_t m4 = decimate_all(MAX_CH, s_dec4);
+    const uint32_t m2 = decimate_all(2, s_dec2);
+    TEST_ASSERT_EQUAL_UINT32(BLOCKS * FRAMES / RATIO, m4);
+    TEST_ASSERT_EQUAL_UINT32(m4, m2);
+    for (uint32_t k = 0; k < m4; ++k) {
+        TEST_ASSERT_EQUAL_INT32(s_dec2[k * 2],     s_dec4[k * MAX_CH]);
+        TEST_ASSERT_EQUAL_INT32(s_dec2[k * 2 + 1], s_dec4[k * MAX_CH + 1]);
+    }
+}
+
+static double bench(uint32_t ch) {
+    dsp_decim_chain_t d;
+    TEST_ASSERT_TRUE(dsp_decim_chain_create(&d, RATIO, ch, CIC_ORDER, NTAPS, FC, FRAMES));
+    const int64_t t0 = bench_now_us();
+    for (int r = 0; r < BENCH_REPS; ++r) {
+        process_block(&d, ch == MAX_CH ? s_src4[r % BLOCKS] : s_src2[r % BLOCKS], ch);
+    }
+    const int64_t us = bench_now_us() - t0;
+    dsp_decim_chain_destroy(&d);
+
+    char what[64], line[160];
+    snprintf(what, sizeof(what), "%lu ch block (%d frames)", (unsigned long)ch, FRAMES);
+    bench_report(what, us, BENCH_REPS, "block");
+    const double per_block = (double)us / BENCH_REPS;
+    snprintf(line, sizeof(line), "%lu ch: %.2f %% of the %d ms block period, %lu B/s raw, %lu B/s published",
+        (unsigned long)ch, 100.0 * per_block / (BLOCK_MS * 1000.0), BLOCK_MS,
+        (unsigned long)(RATE_HZ * ch * 4), (unsigned long)(RATE_HZ / RATIO * ch * 3));
+    TEST_MESSAGE(line);
+    return per_block;
+}
+
+// Cost per block for 2 and 4 channels; 4 must fit the block period with room to spare
+static void test_bench_2_vs_4(void) {
+    make_blocks();
+    const double t2 = bench(2);
+    const double t4 = bench(MAX_CH);
+    char line[96];
+    snprintf(line, sizeof(line), "4 ch / 2 ch: %.2fx", t2 > 0.0 ? t4 / t2 : 0.0);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN_DOUBLE(BLOCK_MS * 1000.0 / 2, t4);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_four_channels_end_to_end);
+    RUN_TEST(test_bench_2_vs_4);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
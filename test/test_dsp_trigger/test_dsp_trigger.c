@@ -0,0 +1,216 @@
+/* dsp_trigger: level, slope and window triggers fire once and re-arm only
+   past their hysteresis; slope history carries across calls, so any split
+   of the input into calls fires on the same frames; dsp_trig_scan returns
+   the frames up to and including the one that fired, with the firing
+   trigger's index, and every trigger sees every frame it consumed. */
+
+#include "unity.h"
+#include "dsp_trigger.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define CH          2
+#define FRAMES      4000
+
+static int32_t s_in[FRAMES * CH];
+
+static uint32_t s_rng = 0x1F83D9ABu;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    memset(s_in, 0, sizeof(s_in));
+}
+
+void tearDown(void) {}
+
+// One value per frame on channel 1 (channel 0 carries noise that must be ignored)
+static void load(const int32_t *v, uint32_t n) {
+    for (uint32_t i = 0; i < n; ++i) {
+        s_in[i * CH]     = (int32_t)(rnd() & 0xFFFFFF) - 0x800000;
+        s_in[i * CH + 1] = v[i];
+    }
+}
+
+/* Scan everything, one firing at a time; writes the frame index of each firing
+   to at[] and returns how many */
+static uint32_t fire_frames(dsp_trig_t *t, uint32_t n_trig, uint32_t frames, uint32_t *at) {
+    uint32_t pos = 0, n = 0;
+    while (pos < frames) {
+        int fired;
+        const uint32_t used = dsp_trig_scan(t, n_trig, s_in + (size_t)pos * CH, CH, frames - pos, &fired);
+        TEST_ASSERT_TRUE(used > 0 && used <= frames - pos);
+        pos += used;
+        if (fired >= 0) {
+            at[n] = pos - 1;
+            n++;
+        } else {
+            TEST_ASSERT_EQUAL_UINT32(frames, pos);
+        }
+    }
+    return n;
+}
+
+static void test_init_rejects_bad_args(void) {
+    dsp_trig_t t;
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_NONE, 0, 100, 0, 0, 0));
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_LEVEL, 0, 0, 0, 0, 0));
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_LEVEL, 0, 100, 0, -1, 0));
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 0, 100, 0, 0, 0));
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 0, 100, 0, 0, DSP_TRIG_MAX_SPAN + 1));
+    TEST_ASSERT_FALSE(dsp_trig_init(&t, DSP_TRIG_WINDOW, 0, 100, 100, 0, 0));
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_WINDOW, 0, -100, 100, 0, 0));
+    TEST_ASSERT_TRUE(t.armed);
+}
+
+/* a = 1000, hyst = 100: fires at |x| >= 1000 either sign, once; 900 doesn't
+   re-arm, 899 does */
+static void test_level_hysteresis(void) {
+    static const int32_t v[] = { 0, 999, 1000, 5000, 950, 900, -1200, 899, -999, -1000, 0, 2000 };
+    static const uint32_t want[] = { 2, 9, 11 };
+    dsp_trig_t t;
+    uint32_t at[8];
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_LEVEL, 1, 1000, 0, 100, 0));
+    load(v, sizeof(v) / sizeof(v[0]));
+    TEST_ASSERT_EQUAL_UINT32(3, fire_frames(&t, 1, sizeof(v) / sizeof(v[0]), at));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(want, at, 3);
+    TEST_ASSERT_FALSE(t.armed);
+    TEST_ASSERT_EQUAL_INT32(2000, t.last);
+}
+
+/* a = -100, b = 100, hyst = 20: outside fires; back in only re-arms once
+   inside [-80, 80] */
+static void test_window_hysteresis(void) {
+    static const int32_t v[] = { 0, -100, -101, -90, 90, 99, 80, 101, 120, 81, -81, -80, -200, 0, 100, 0 };
+    static const uint32_t want[] = { 2, 7, 12 };
+    dsp_trig_t t;
+    uint32_t at[8];
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_WINDOW, 1, -100, 100, 20, 0));
+    load(v, sizeof(v) / sizeof(v[0]));
+    TEST_ASSERT_EQUAL_UINT32(3, fire_frames(&t, 1, sizeof(v) / sizeof(v[0]), at));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(want, at, 3);
+    TEST_ASSERT_TRUE(t.armed);
+}
+
+/* span 3, a = 500, hyst = 100: compares x[n] with x[n - 3]. Nothing can fire
+   before the history holds three samples, however far from zero they start. */
+static void test_slope_hysteresis(void) {
+    static const int32_t v[] = { 5000, 5000, 5000, 5000, 5000, 5499, 5500, 5600, 5500, 5500, 5100, 6000, 6000, 6000, 6100, 7000 };
+    //  |x[n] - x[n-3]| from n = 3:                0     0   499   500   600     1     0   500   500   500   900   100  1000
+    static const uint32_t want[] = { 6, 10, 15 };
+    dsp_trig_t t;
+    uint32_t at[8];
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 1, 500, 0, 100, 3));
+    load(v, sizeof(v) / sizeof(v[0]));
+    TEST_ASSERT_EQUAL_UINT32(3, fire_frames(&t, 1, sizeof(v) / sizeof(v[0]), at));
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(want, at, 3);
+    TEST_ASSERT_EQUAL_INT32(1000, t.last);
+}
+
+/* A random walk with jumps through a slope trigger: one call per frame, random
+   splits and one call for everything fire on the same frames */
+static void test_slope_history_across_calls(void) {
+    static int32_t v[FRAMES];
+    static uint32_t ref[FRAMES], got[FRAMES];
+    int32_t x = 0;
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        x += (int32_t)(rnd() % 201) - 100;
+        if (rnd() % 100 == 0) x += (int32_t)(rnd() % 4001) - 2000;
+        v[i] = x;
+    }
+    load(v, FRAMES);
+
+    dsp_trig_t t;
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 1, 1500, 0, 300, 17));
+    const uint32_t n_ref = fire_frames(&t, 1, FRAMES, ref);
+    TEST_ASSERT_TRUE(n_ref > 5);
+
+    // one frame per call
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 1, 1500, 0, 300, 17));
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        int fired;
+        TEST_ASSERT_EQUAL_UINT32(1, dsp_trig_scan(&t, 1, s_in + (size_t)i * CH, CH, 1, &fired));
+        if (fired >= 0) got[n++] = i;
+    }
+    TEST_ASSERT_EQUAL_UINT32(n_ref, n);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(ref, got, n);
+
+    // random block sizes, shorter and longer than the span
+    TEST_ASSERT_TRUE(dsp_trig_init(&t, DSP_TRIG_SLOPE, 1, 1500, 0, 300, 17));
+    n = 0;
+    for (uint32_t pos = 0; pos < FRAMES;) {
+        uint32_t len = 1 + rnd() % 40;
+        if (len > FRAMES - pos) len = FRAMES - pos;
+        const uint32_t end = pos + len;
+        while (pos < end) {
+            int fired;
+            pos += dsp_trig_scan(&t, 1, s_in + (size_t)pos * CH, CH, end - pos, &fired);
+            if (fired >= 0) got[n++] = pos - 1;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(n_ref, n);
+    TEST_ASSERT_EQUAL_UINT32_ARRAY(ref, got, n);
+}
+
+/* Several triggers in one scan: the return value stops at the frame that
+   fired; on a frame where two fire, the lower index is reported and both
+   disarm; a trigger that didn't fire still saw every consumed frame. */
+static void test_scan_return_value(void) {
+    static const int32_t v[] = { 0, 10, 20, 30, 2000, 2100, 0, 0, -300, 0 };
+    dsp_trig_t t[3];
+    TEST_ASSERT_TRUE(dsp_trig_init(&t[0], DSP_TRIG_WINDOW, 1, -200, 5000, 10, 0));
+    TEST_ASSERT_TRUE(dsp_trig_init(&t[1], DSP_TRIG_LEVEL, 1, 1000, 0, 100, 0));
+    TEST_ASSERT_TRUE(dsp_trig_init(&t[2], DSP_TRIG_SLOPE, 1, 1500, 0, 100, 1));
+    load(v, sizeof(v) / sizeof(v[0]));
+
+    int fired;
+    // frame 4: level and slope both fire; level (1) is reported
+    TEST_ASSERT_EQUAL_UINT32(5, dsp_trig_scan(t, 3, s_in, CH, 10, &fired));
+    TEST_ASSERT_EQUAL_INT(1, fired);
+    TEST_ASSERT_FALSE(t[1].armed);
+    TEST_ASSERT_FALSE(t[2].armed);
+    TEST_ASSERT_TRUE(t[0].armed);
+    TEST_ASSERT_EQUAL_INT32(2000, t[0].last);       // the window saw frame 4 too
+
+    // frame 6: the slope re-armed on frame 5 (|2100 - 2000| < 1400) and fires on the drop to 0
+    TEST_ASSERT_EQUAL_UINT32(2, dsp_trig_scan(t, 3, s_in + 5 * CH, CH, 5, &fired));
+    TEST_ASSERT_EQUAL_INT(2, fired);
+
+    // frame 8: the window, below -200
+    TEST_ASSERT_EQUAL_UINT32(2, dsp_trig_scan(t, 3, s_in + 7 * CH, CH, 3, &fired));
+    TEST_ASSERT_EQUAL_INT(0, fired);
+
+    // nothing left to fire: all frames consumed, -1
+    TEST_ASSERT_EQUAL_UINT32(1, dsp_trig_scan(t, 3, s_in + 9 * CH, CH, 1, &fired));
+    TEST_ASSERT_EQUAL_INT(-1, fired);
+    TEST_ASSERT_EQUAL_UINT32(0, dsp_trig_scan(t, 3, s_in, CH, 0, &fired));
+    TEST_ASSERT_EQUAL_INT(-1, fired);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_args);
+    RUN_TEST(test_level_hysteresis);
+    RUN_TEST(test_window_hysteresis);
+    RUN_TEST(test_slope_hysteresis);
+    RUN_TEST(test_slope_history_across_calls);
+    RUN_TEST(test_scan_return_value);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,102 @@
+/* dsp_units: a rejected init leaves nothing that looks valid, and the Q kernel
+   agrees with the float one across the shift range, including shift 0. */
+
+#include "unity.h"
+#include "dsp_units.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FRAMES  8
+
+static dsp_units_t s_u;
+
+void setUp(void) {
+    memset(&s_u, 0x5A, sizeof(s_u));
+}
+
+void tearDown(void) {}
+
+// 24-in-32 slot words across the full range, both signs
+static void fill(uint32_t *w, uint32_t ch) {
+    static const int32_t v[FRAMES] = { 0, 1, -1, 8388607, -8388608, 12345, -678901, 4194304 };
+    for (uint32_t i = 0; i < FRAMES; ++i) {
+        for (uint32_t c = 0; c < ch; ++c) w[i * ch + c] = (uint32_t)v[(i + c) % FRAMES] & 0x00FFFFFF;
+    }
+}
+
+static void check_q_matches_f32(uint32_t ch) {
+    uint32_t in[FRAMES * 4];
+    float amps[FRAMES * 4];
+    int32_t na[FRAMES * 4];
+    fill(in, ch);
+    dsp_units_amps_f32(&s_u, (const uint8_t *)in, 4, FRAMES, amps);
+    dsp_units_amps_q(&s_u, (const uint8_t *)in, 4, FRAMES, na);
+    for (uint32_t i = 0; i < FRAMES * ch; ++i) {
+        const double want = (double)amps[i] * 1e9;
+        TEST_ASSERT_DOUBLE_WITHIN(fabs(want) * 1e-6 + 1.0, want, (double)na[i]);
+    }
+}
+
+static void test_rejected_init_clears(void) {
+    const float good[2] = { 50.0f, 200.0f };
+    const float bad[2]  = { 50.0f, 0.0f };
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 2, 1.8f, 0.01f, good));
+    TEST_ASSERT_EQUAL_UINT32(2, s_u.ch);
+
+    // second gain invalid: no channel count left behind for callers that test u->ch
+    TEST_ASSERT_FALSE(dsp_units_init(&s_u, 2, 1.8f, 0.01f, bad));
+    TEST_ASSERT_EQUAL_UINT32(0, s_u.ch);
+    TEST_ASSERT_TRUE(s_u.amps_per_lsb[0] == 0.0f);
+
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 2, 1.8f, 0.01f, good));
+    TEST_ASSERT_FALSE(dsp_units_init(&s_u, 2, 0.0f, 0.01f, good));
+    TEST_ASSERT_EQUAL_UINT32(0, s_u.ch);
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 2, 1.8f, 0.01f, good));
+    TEST_ASSERT_FALSE(dsp_units_init(&s_u, DSP_UNITS_MAX_CH + 1, 1.8f, 0.01f, good));
+    TEST_ASSERT_EQUAL_UINT32(0, s_u.ch);
+}
+
+static void test_q_matches_f32(void) {
+    const float gain[4] = { 100.0f, 200.0f, 500.0f, 1000.0f };   // full scale within the Q range (±2.1 A)
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 2, 1.8f, 0.01f, gain));
+    check_q_matches_f32(2);
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 4, 1.8f, 0.01f, gain));
+    check_q_matches_f32(4);
+}
+
+// ~1.5e9 nA per LSB: only shift 0 fits, where the rounding term used to shift by -1
+static void test_shift_zero(void) {
+    const float gain[2] = { 7.95e-8f, 7.95e-8f };
+    TEST_ASSERT_TRUE(dsp_units_init(&s_u, 2, 1.0f, 1.0f, gain));
+    TEST_ASSERT_EQUAL_UINT32(0, s_u.q_shift[0]);
+    uint32_t in[2] = { 1, 0x00FFFFFF };     // +1 and -1 LSB
+    int32_t na[2];
+    dsp_units_amps_q(&s_u, (const uint8_t *)in, 4, 1, na);
+    TEST_ASSERT_EQUAL_INT32(s_u.q_mult[0], na[0]);
+    TEST_ASSERT_EQUAL_INT32(-s_u.q_mult[1], na[1]);
+
+    // 2^31 nA per LSB or more can't be represented at all
+    const float tiny[2] = { 5e-8f, 5e-8f };
+    TEST_ASSERT_FALSE(dsp_units_init(&s_u, 2, 1.0f, 1.0f, tiny));
+    TEST_ASSERT_EQUAL_UINT32(0, s_u.ch);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejected_init_clears);
+    RUN_TEST(test_q_matches_f32);
+    RUN_TEST(test_shift_zero);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
@@ -0,0 +1,200 @@
+/* Block-to-consumer latency and consumer wakeups per second, DMA-complete
+   notification against the old polling sampler. On target only.
+
+   An I2S RX channel is brought up exactly as the driver does it in stereo
+   mode (8 kHz, 64-frame DMA buffers = one 512 B block, TLV_I2S_DMA_DESC_NUM
+   descriptors), with no pins attached: the DMA completes on the clock whether
+   or not an ADC is there. Its on_recv callback does what the driver's does:
+   stamp the block with esp_timer, copy it into a util_ring slot and, in
+   notify mode, vTaskNotifyGiveFromISR() the consumer.
+
+   The consumer runs where the old sampler_task did (priority 3, core 1) and
+   drains the ring either after ulTaskNotifyTake() or after
+   vTaskDelay(pdMS_TO_TICKS(8)), which is 0 ticks at CONFIG_FREERTOS_HZ = 100.
+   Latency is DMA stamp -> lease, in a util_hist. */
+
+#include "unity.h"
+#include "driver_TLV320ADC5120.h"
+#include "util_hist.h"
+#include "util_ring.h"
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "driver/i2s_std.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RATE_HZ         8000
+#define BLOCK_FRAMES    64                          // 8 ms, DEF_BLOCK_MS
+#define BLOCK_BYTES     (BLOCK_FRAMES * 2 * 4)      // stereo, 24-in-32 slots
+#define RING_COUNT      8
+#define RUN_MS          2000
+#define CONSUMER_PRIO   3
+#define CONSUMER_CORE   1
+
+typedef enum { MODE_NOTIFY, MODE_POLL } run_mode_t;
+
+typedef struct {
+    run_mode_t mode;
+    volatile bool stop;
+    uint32_t wakeups;       // consumer returns from its wait
+    uint32_t blocks;        // blocks leased
+    uint32_t gaps;          // blocks missed by sequence
+    hist_t   lat;           // DMA stamp -> lease, us
+    SemaphoreHandle_t done;
+} run_t;
+
+static i2s_chan_handle_t s_rx = NULL;
+static ring_t s_ring;
+static uint8_t s_buf[RING_COUNT * BLOCK_BYTES];
+static uint32_t s_seq[RING_COUNT];
+static int64_t s_blk_us[RING_COUNT];
+static TaskHandle_t s_consumer = NULL;
+static run_t s_run;
+
+// Same work as the driver's on_dma_recv, stereo 32-bit slots
+static IRAM_ATTR bool on_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    BaseType_t hp_task_woken = pdFALSE;
+
+    const int64_t now = esp_timer_get_time();
+    uint8_t *slot = ring_write_begin(&s_ring);
+    if (slot) {
+        s_blk_us[(slot - s_buf) / BLOCK_BYTES] = now;
+        memcpy(slot, event->dma_buf, event->size < BLOCK_BYTES ? event->size : BLOCK_BYTES);
+        ring_write_commit(&s_ring);
+    }
+    if (s_consumer) {
+        vTaskNotifyGiveFromISR(s_consumer, &hp_task_woken);
+    }
+    return hp_task_woken == pdTRUE;
+}
+
+static IRAM_ATTR bool on_recv_q_ovf(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx) {
+    return false;
+}
+
+static void consumer_task(void *arg) {
+    run_t *r = arg;
+    uint32_t expect = 0;
+    bool first = true;
+    while (!r->stop) {
+        if (r->mode == MODE_NOTIFY) {
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100)) == 0) continue;
+        } else {
+            vTaskDelay(pdMS_TO_TICKS(8));
+        }
+        r->wakeups++;
+
+        ring_block_t b;
+        while (ring_acquire(&s_ring, &b)) {
+            const int64_t now = esp_timer_get_time();
+            hist_add(&r->lat, (uint32_t)(now - s_blk_us[(b.data - s_buf) / BLOCK_BYTES]));
+            if (!first) r->gaps += b.seq - expect;
+            first = false;
+            expect = b.seq + 1;
+            r->blocks++;
+            ring_release(&s_ring);
+        }
+    }
+    xSemaphoreGive(r->done);
+    vTaskDelete(NULL);
+}
+
+void setUp(void) {
+    TEST_ASSERT_TRUE(ring_init(&s_ring, s_buf, s_seq, RING_COUNT, BLOCK_BYTES, RING_DROP_NEWEST));
+
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_0, I2S_ROLE_MASTER);
+    chan_cfg.dma_frame_num = BLOCK_FRAMES;
+    chan_cfg.dma_desc_num  = TLV_I2S_DMA_DESC_NUM;
+    TEST_ASSERT_EQUAL(ESP_OK, i2s_new_channel(&chan_cfg, NULL, &s_rx));
+
+    i2s_std_slot_config_t slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_24BIT, I2S_SLOT_MODE_STEREO);
+    slot_cfg.slot_bit_width = I2S_SLOT_BIT_WIDTH_32BIT;
+    slot_cfg.ws_width       = 24;
+    i2s_std_clk_config_t clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(RATE_HZ);
+    clk_cfg.mclk_multiple = I2S_MCLK_MULTIPLE_256;
+    i2s_std_config_t std_cfg = {
+        .clk_cfg  = clk_cfg,
+        .slot_cfg = slot_cfg,
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = I2S_GPIO_UNUSED,
+            .ws   = I2S_GPIO_UNUSED,
+            .dout = I2S_GPIO_UNUSED,
+            .din  = I2S_GPIO_UNUSED,
+        },
+    };
+    TEST_ASSERT_EQUAL(ESP_OK, i2s_channel_init_std_mode(s_rx, &std_cfg));
+
+    i2s_event_callbacks_t cbs = { .on_recv = on_recv, .on_recv_q_ovf = on_recv_q_ovf };
+    TEST_ASSERT_EQUAL(ESP_OK, i2s_channel_register_event_callback(s_rx, &cbs, NULL));
+}
+
+void tearDown(void) {
+    if (s_rx) {
+        i2s_del_channel(s_rx);
+        s_rx = NULL;
+    }
+}
+
+static void run(run_mode_t mode, const char *name) {
+    memset(&s_run, 0, sizeof(s_run));
+    s_run.mode = mode;
+    s_run.done = xSemaphoreCreateBinary();
+    TEST_ASSERT_NOT_NULL(s_run.done);
+
+    TaskHandle_t t = NULL;
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(consumer_task, "rt_consumer", 4096, &s_run, CONSUMER_PRIO, &t, CONSUMER_CORE));
+    s_consumer = mode == MODE_NOTIFY ? t : NULL;
+
+    TEST_ASSERT_EQUAL(ESP_OK, i2s_channel_enable(s_rx));
+    vTaskDelay(pdMS_TO_TICKS(RUN_MS));
+    TEST_ASSERT_EQUAL(ESP_OK, i2s_channel_disable(s_rx));
+
+    s_run.stop = true;
+    if (s_consumer) xTaskNotifyGive(s_consumer);
+    TEST_ASSERT_EQUAL(pdTRUE, xSemaphoreTake(s_run.done, pdMS_TO_TICKS(1000)));
+    s_consumer = NULL;
+    vSemaphoreDelete(s_run.done);
+
+    ring_stats_t rs;
+    ring_get_stats(&s_ring, &rs);
+    char line[160];
+    snprintf(line, sizeof(line), "%s: %lu blocks, %.0f wakeups/s, latency p50 %lu us, p99 %lu us, max %lu us, %lu dropped",
+        name, (unsigned long)s_run.blocks, s_run.wakeups * 1000.0 / RUN_MS,
+        (unsigned long)hist_percentile(&s_run.lat, 50.0f), (unsigned long)hist_percentile(&s_run.lat, 99.0f),
+        (unsigned long)s_run.lat.max, (unsigned long)rs.dropped);
+    TEST_MESSAGE(line);
+
+    // Every block of the run reaches the consumer, in order
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(RUN_MS * RATE_HZ / 1000 / BLOCK_FRAMES - 2, s_run.blocks);
+    TEST_ASSERT_EQUAL_UINT32(0, s_run.gaps);
+    TEST_ASSERT_EQUAL_UINT32(0, rs.dropped);
+}
+
+// One wakeup per block, and the block is leased well inside one block period
+static void test_notify(void) {
+    run(MODE_NOTIFY, "notify");
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(s_run.blocks + 1, s_run.wakeups);
+    TEST_ASSERT_LESS_THAN_UINT32(1000, hist_percentile(&s_run.lat, 99.0f));
+}
+
+// The baseline: the old sampler's loop, which never sleeps at 100 Hz tick
+static void test_poll_baseline(void) {
+    run(MODE_POLL, "poll (8 ms delay)");
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_notify);
+    RUN_TEST(test_poll_baseline);
+    return UNITY_END();
+}
+
+void app_main(void) {
+    run_tests();
+}
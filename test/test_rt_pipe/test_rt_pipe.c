@@ -0,0 +1,192 @@
+/* util_pipe under load: every buffer comes back to the pool, with a zero
+   reference count, however the lanes and holds interleave. On target only:
+   the pipe is built on FreeRTOS queues and pinned tasks, and runs here on
+   both cores exactly as the app runs it.
+
+   A source task fills BLOCKS buffers from a pool of DEPTH and submits each to
+   three lanes on two cores. Every lane's first stage checks the block arrives
+   in sequence with its contents intact; the others spin for a random few us,
+   and the hold stages sometimes pipe_hold() the block and pass it to a holder
+   task, which keeps it a while longer (now and then a whole tick), checks the
+   contents again and pipe_release()s it. A buffer recycled while any lane or
+   holder still has it is refilled with the next block's pattern, which the
+   late reader sees. At the end the pool must drain back to DEPTH free
+   buffers with every count at zero. */
+
+#include "unity.h"
+#include "util_pipe.h"
+
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define DEPTH           6
+#define FRAMES          64
+#define CH              2
+#define BLOCKS          10000
+#define LANE_PRIO       5
+#define HOLDER_PRIO     4
+#define HOLDER_CORE     0
+#define HOLD_Q_LEN      (DEPTH * 4)     // more than the holds that can be out at once
+#define DRAIN_MS        5000
+
+typedef struct {
+    uint32_t next_seq;
+    uint32_t rng;
+} stage_ctx_t;
+
+static pipe_t s_pipe;
+static QueueHandle_t s_hold_q;
+static stage_ctx_t s_ctx[PIPE_MAX_LANES * PIPE_MAX_STAGES];
+static uint32_t s_n_ctx;
+static atomic_uint s_errors;
+static atomic_uint s_holds;
+static atomic_uint s_releases;
+
+static uint32_t rnd(uint32_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 17;
+    *s ^= *s << 5;
+    return *s;
+}
+
+static void spin_us(uint32_t us) {
+    const int64_t t0 = esp_timer_get_time();
+    while (esp_timer_get_time() - t0 < us) {}
+}
+
+static int32_t pattern(uint32_t seq, uint32_t i) {
+    return (int32_t)(seq * 2654435761u + i);
+}
+
+static bool intact(const pipe_buf_t *b) {
+    for (uint32_t i = 0; i < FRAMES * CH; ++i) {
+        if (b->data[i] != pattern(b->seq, i)) return false;
+    }
+    return true;
+}
+
+static stage_ctx_t *new_ctx(uint32_t seed) {
+    stage_ctx_t *c = &s_ctx[s_n_ctx++];
+    c->next_seq = 0;
+    c->rng = seed;
+    return c;
+}
+
+static void stage_check(void *ctx, const pipe_buf_t *b) {
+    stage_ctx_t *c = ctx;
+    if (b->seq != c->next_seq || !intact(b)) atomic_fetch_add(&s_errors, 1);
+    c->next_seq = b->seq + 1;
+}
+
+static void stage_spin(void *ctx, const pipe_buf_t *b) {
+    stage_ctx_t *c = ctx;
+    spin_us(rnd(&c->rng) % 40);
+}
+
+// One block in four goes to the holder
+static void stage_hold(void *ctx, const pipe_buf_t *b) {
+    stage_ctx_t *c = ctx;
+    if (rnd(&c->rng) % 4) return;
+    pipe_hold(b);
+    atomic_fetch_add(&s_holds, 1);
+    xQueueSend(s_hold_q, &b, portMAX_DELAY);
+}
+
+static void holder_task(void *arg) {
+    uint32_t rng = 0x6A09E667u;
+    const pipe_buf_t *b;
+    while (1) {
+        if (xQueueReceive(s_hold_q, &b, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        if (rnd(&rng) % 64 == 0) {
+            vTaskDelay(1);
+        } else {
+            spin_us(rnd(&rng) % 200);
+        }
+        if (!intact(b)) atomic_fetch_add(&s_errors, 1);
+        atomic_fetch_add(&s_releases, 1);
+        pipe_release(&s_pipe, b);
+    }
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+static void test_refs_return_to_pool(void) {
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_init(&s_pipe, DEPTH, FRAMES, CH));
+    s_hold_q = xQueueCreate(HOLD_Q_LEN, sizeof(pipe_buf_t *));
+    TEST_ASSERT_NOT_NULL(s_hold_q);
+
+    // lane 0, core 0: check, hold
+    // lane 1, core 1: check, spin
+    // lane 2, core 1: check, hold, spin, hold (a block can be held twice)
+    static const int core[] = { 0, 1, 1 };
+    for (uint32_t l = 0; l < 3; ++l) {
+        TEST_ASSERT_EQUAL_INT((int)l, pipe_add_lane(&s_pipe, core[l]));
+        TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, l, "check", stage_check, new_ctx(0)));
+    }
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, 0, "hold", stage_hold, new_ctx(0x243F6A88u)));
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, 1, "spin", stage_spin, new_ctx(0x85A308D3u)));
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, 2, "hold", stage_hold, new_ctx(0x13198A2Eu)));
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, 2, "spin", stage_spin, new_ctx(0x03707344u)));
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_add_stage(&s_pipe, 2, "hold", stage_hold, new_ctx(0xA4093822u)));
+
+    TEST_ASSERT_EQUAL(pdPASS, xTaskCreatePinnedToCore(holder_task, "rt_holder", 4096, NULL, HOLDER_PRIO, NULL, HOLDER_CORE));
+    TEST_ASSERT_EQUAL(ESP_OK, pipe_start(&s_pipe, LANE_PRIO, 4096));
+
+    const int64_t t0 = esp_timer_get_time();
+    for (uint32_t seq = 0; seq < BLOCKS; ++seq) {
+        pipe_buf_t *b = pipe_get(&s_pipe);
+        TEST_ASSERT_EQUAL_UINT32(0, atomic_load(&b->refs));
+        for (uint32_t i = 0; i < FRAMES * CH; ++i) b->data[i] = pattern(seq, i);
+        b->seq  = seq;
+        b->t_us = esp_timer_get_time();
+        pipe_submit(&s_pipe, b);
+    }
+
+    // everything back in the pool
+    uint32_t waited_ms = 0;
+    while (uxQueueMessagesWaiting(s_pipe.free_q) < DEPTH && waited_ms < DRAIN_MS) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        waited_ms += 10;
+    }
+    const int64_t span_us = esp_timer_get_time() - t0;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%lu blocks in %lld ms: %lu holds, %lu source waits, %lu in flight at most, lane backlog %lu / %lu / %lu",
+        (unsigned long)BLOCKS, (long long)(span_us / 1000), (unsigned long)atomic_load(&s_holds), (unsigned long)s_pipe.waits,
+        (unsigned long)s_pipe.high_water, (unsigned long)s_pipe.lanes[0].backlog,
+        (unsigned long)s_pipe.lanes[1].backlog, (unsigned long)s_pipe.lanes[2].backlog);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT32(DEPTH, uxQueueMessagesWaiting(s_pipe.free_q));
+    for (uint32_t i = 0; i < DEPTH; ++i) TEST_ASSERT_EQUAL_UINT32(0, atomic_load(&s_pipe.bufs[i].refs));
+    TEST_ASSERT_EQUAL_UINT32(0, atomic_load(&s_errors));
+    TEST_ASSERT_EQUAL_UINT32(atomic_load(&s_holds), atomic_load(&s_releases));
+    TEST_ASSERT_TRUE(atomic_load(&s_holds) > BLOCKS / 4);
+    TEST_ASSERT_TRUE(s_pipe.waits > 0);                         // the pool did run dry
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(DEPTH, s_pipe.high_water);
+    for (uint32_t l = 0; l < s_pipe.n_lanes; ++l) {
+        for (uint32_t k = 0; k < s_pipe.lanes[l].n_stages; ++k) {
+            TEST_ASSERT_EQUAL_UINT32(BLOCKS, s_pipe.lanes[l].stages[k].calls);
+        }
+    }
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_refs_return_to_pool);
+    return UNITY_END();
+}
+
+void app_main(void) {
+    run_tests();
+}
@@ -0,0 +1,106 @@
+/* TDM slot allocator (tlv320adc5120_slot_plan): stereo and TDM packing, and
+   rejection of bad device lists, channel counts past TLV_MAX_CH and frames
+   whose BCLK the ADC can't drive. Host only (pio test -e native). */
+
+#include "unity.h"
+#include "driver_TLV320ADC5120_slots.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static uint8_t  s_slot0[TLV_MAX_DEVS];
+static uint32_t s_frame_slots;
+
+void setUp(void) {
+    memset(s_slot0, 0xFF, sizeof(s_slot0));
+    s_frame_slots = 0;
+}
+
+void tearDown(void) {}
+
+static tlv320adc5120_slots_t plan(uint32_t devs, const uint8_t *dev_ch, uint32_t ch, uint32_t fs) {
+    return tlv320adc5120_slot_plan(devs, dev_ch, ch, fs, s_slot0, &s_frame_slots);
+}
+
+static void test_stereo(void) {
+    const uint8_t dev_ch[1] = { 4 };        // ignored in stereo mode
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK, plan(1, dev_ch, 2, 96000));
+    TEST_ASSERT_EQUAL_UINT8(0, s_slot0[0]);
+    TEST_ASSERT_EQUAL_UINT32(2, s_frame_slots);
+}
+
+static void test_tdm_packing(void) {
+    // consecutive runs in device order; the frame rounds up to whole 4-slot groups
+    const uint8_t one[1] = { 4 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK, plan(1, one, 4, 48000));
+    TEST_ASSERT_EQUAL_UINT8(0, s_slot0[0]);
+    TEST_ASSERT_EQUAL_UINT32(4, s_frame_slots);
+
+    const uint8_t mixed[3] = { 2, 3, 4 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK, plan(3, mixed, 9, 48000));
+    TEST_ASSERT_EQUAL_UINT8(0, s_slot0[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, s_slot0[1]);
+    TEST_ASSERT_EQUAL_UINT8(5, s_slot0[2]);
+    TEST_ASSERT_EQUAL_UINT32(12, s_frame_slots);
+
+    const uint8_t full[4] = { 4, 4, 4, 4 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK, plan(4, full, 16, 48000));
+    for (uint32_t i = 0; i < 4; ++i) TEST_ASSERT_EQUAL_UINT8(4 * i, s_slot0[i]);
+    TEST_ASSERT_EQUAL_UINT32(TLV_MAX_CH, s_frame_slots);
+
+    // two channels from two devices is TDM, not the stereo layout
+    const uint8_t two[2] = { 1, 1 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK, plan(2, two, 2, 48000));
+    TEST_ASSERT_EQUAL_UINT8(1, s_slot0[1]);
+    TEST_ASSERT_EQUAL_UINT32(4, s_frame_slots);
+}
+
+static void test_bad_devices(void) {
+    const uint8_t ch[TLV_MAX_DEVS + 1] = { 4, 4, 4, 4, 4 };
+    const uint8_t zero[2] = { 4, 0 };
+    const uint8_t five[1] = { TLV_DEV_CH + 1 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_DEV, plan(0, ch, 4, 48000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_DEV, plan(TLV_MAX_DEVS + 1, ch, 16, 48000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_DEV, plan(2, zero, 4, 48000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_DEV, plan(1, five, 5, 48000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_DEV, plan(1, NULL, 4, 48000));
+}
+
+static void test_channel_count(void) {
+    const uint8_t full[4] = { 4, 4, 4, 4 };
+    const uint8_t pair[2] = { 4, 2 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_COUNT, plan(4, full, TLV_MAX_CH + 1, 8000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_COUNT, plan(4, full, 15, 8000));     // not the sum of dev_ch
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_COUNT, plan(2, pair, 4, 8000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BAD_COUNT, plan(2, pair, 0, 8000));
+}
+
+static void test_bclk_limit(void) {
+    // fs x frame slots x 32 <= 24.576 MHz: 16 slots to 48 kHz, 8 to 96 kHz, 4 to 192 kHz
+    const uint8_t full[4] = { 4, 4, 4, 4 };
+    const uint8_t two[2]  = { 4, 4 };
+    const uint8_t odd[2]  = { 4, 1 };       // 5 channels still take 8 slots
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK,   plan(4, full, 16, 48000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BCLK, plan(4, full, 16, 96000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK,   plan(2, two, 8, 96000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BCLK, plan(2, two, 8, 192000));
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BCLK, plan(2, odd, 5, 192000));
+    TEST_ASSERT_EQUAL_UINT32(8, s_frame_slots);
+    const uint8_t one[1] = { 2 };
+    TEST_ASSERT_EQUAL(TLV_SLOTS_OK,   plan(1, one, 2, 384000));       // stereo: 2 slots
+    TEST_ASSERT_EQUAL(TLV_SLOTS_BCLK, plan(1, one, 2, 384001));
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_stereo);
+    RUN_TEST(test_tdm_packing);
+    RUN_TEST(test_bad_devices);
+    RUN_TEST(test_channel_count);
+    RUN_TEST(test_bclk_limit);
+    return UNITY_END();
+}
+
+int main(void) {
+    return run_tests();
+}
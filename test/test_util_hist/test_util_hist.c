@@ -0,0 +1,153 @@
+/* util_hist: bucket edges (exact below HIST_SUB, then HIST_SUB buckets per
+   octave), hist_count_above at and around an edge, and percentiles against
+   exact ones over 1e5 log-uniform samples: never below the true value, and
+   within 3 % of it. Host only (pio test -e native). */
+
+#include "unity.h"
+#include "util_hist.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SAMPLES     100000
+#define MAX_ERR     0.03
+
+static hist_t   s_h;
+static uint32_t s_v[SAMPLES];
+
+static uint32_t s_rng = 0x510E527Fu;
+
+static uint32_t rnd(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void) {
+    hist_reset(&s_h);
+}
+
+void tearDown(void) {}
+
+static int cmp_u32(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Upper edge of v's bucket, as the median of { v, something far above }:
+   the lower sample's bucket top, not clamped by max */
+static uint32_t edge_of(uint32_t v) {
+    hist_reset(&s_h);
+    hist_add(&s_h, v);
+    hist_add(&s_h, UINT32_MAX);
+    return hist_percentile(&s_h, 50.0f);
+}
+
+static void test_empty(void) {
+    TEST_ASSERT_EQUAL_UINT32(0, hist_percentile(&s_h, 50.0f));
+    TEST_ASSERT_EQUAL_UINT32(0, hist_percentile(&s_h, 100.0f));
+    TEST_ASSERT_EQUAL_UINT32(0, hist_count_above(&s_h, 0));
+}
+
+static void test_bucket_edges(void) {
+    // below HIST_SUB, and the first octave (width 1): every value its own bucket
+    for (uint32_t v = 0; v < 2 * HIST_SUB; ++v) TEST_ASSERT_EQUAL_UINT32(v, edge_of(v));
+    // 64 .. 127: width 2
+    TEST_ASSERT_EQUAL_UINT32(65, edge_of(64));
+    TEST_ASSERT_EQUAL_UINT32(65, edge_of(65));
+    TEST_ASSERT_EQUAL_UINT32(67, edge_of(66));
+    TEST_ASSERT_EQUAL_UINT32(127, edge_of(126));
+    // octave 512 .. 1023, width 16: 1000 is in 992 .. 1007
+    TEST_ASSERT_EQUAL_UINT32(1007, edge_of(992));
+    TEST_ASSERT_EQUAL_UINT32(1007, edge_of(1000));
+    TEST_ASSERT_EQUAL_UINT32(991, edge_of(991));
+    // the top octave, width 2^26: the last bucket ends at UINT32_MAX
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, edge_of(UINT32_MAX - 1));
+    TEST_ASSERT_EQUAL_UINT32(0xF3FFFFFFu, edge_of(0xF0000000u));
+}
+
+// Every bucket is at most 1 / HIST_SUB of its lower edge wide
+static void test_bucket_width(void) {
+    for (uint32_t k = 0; k < 20000; ++k) {
+        const uint32_t v = (uint32_t)exp2((rnd() % 32000) / 1000.0);
+        const uint32_t e = edge_of(v);
+        TEST_ASSERT_TRUE(e >= v);
+        TEST_ASSERT_TRUE((uint64_t)(e - v) * HIST_SUB <= v);
+    }
+}
+
+// Values in v's own bucket count as not above it
+static void test_count_above(void) {
+    const uint32_t v[] = { 5, 64, 65, 66, 67, 68, 1000, 5000 };
+    for (uint32_t i = 0; i < sizeof(v) / sizeof(v[0]); ++i) hist_add(&s_h, v[i]);
+    TEST_ASSERT_EQUAL_UINT32(8, hist_count_above(&s_h, 0));
+    TEST_ASSERT_EQUAL_UINT32(7, hist_count_above(&s_h, 5));
+    TEST_ASSERT_EQUAL_UINT32(5, hist_count_above(&s_h, 64));    // 65 shares 64's bucket
+    TEST_ASSERT_EQUAL_UINT32(5, hist_count_above(&s_h, 65));
+    TEST_ASSERT_EQUAL_UINT32(3, hist_count_above(&s_h, 67));
+    TEST_ASSERT_EQUAL_UINT32(1, hist_count_above(&s_h, 999));   // 1000 shares its bucket (992 .. 1007)
+    TEST_ASSERT_EQUAL_UINT32(1, hist_count_above(&s_h, 1007));
+    TEST_ASSERT_EQUAL_UINT32(0, hist_count_above(&s_h, 5000));
+    TEST_ASSERT_EQUAL_UINT32(0, hist_count_above(&s_h, UINT32_MAX));
+}
+
+/* 1e5 samples log-uniform from 1 us to ~70 min: at every percentile the
+   histogram's answer is at or above the exact one, and within MAX_ERR of it;
+   count, max and sum are exact. */
+static void test_percentiles_vs_exact(void) {
+    static const float p[] = { 0.1f, 1, 10, 25, 50, 75, 90, 95, 99, 99.9f, 99.99f, 100 };
+    uint64_t sum = 0;
+    uint32_t max = 0;
+    for (uint32_t i = 0; i < SAMPLES; ++i) {
+        s_v[i] = (uint32_t)exp2((rnd() % 320000) / 10000.0);
+        hist_add(&s_h, s_v[i]);
+        sum += s_v[i];
+        if (s_v[i] > max) max = s_v[i];
+    }
+    qsort(s_v, SAMPLES, sizeof(s_v[0]), cmp_u32);
+    TEST_ASSERT_EQUAL_UINT32(SAMPLES, s_h.count);
+    TEST_ASSERT_EQUAL_UINT32(max, s_h.max);
+    TEST_ASSERT_TRUE(s_h.sum == sum);
+
+    double worst = 0.0;
+    for (uint32_t i = 0; i < sizeof(p) / sizeof(p[0]); ++i) {
+        uint32_t rank = (uint32_t)ceil((double)p[i] * SAMPLES / 100.0);
+        if (rank < 1) rank = 1;
+        const uint32_t exact = s_v[rank - 1];
+        const uint32_t got = hist_percentile(&s_h, p[i]);
+        char msg[96];
+        snprintf(msg, sizeof(msg), "p%.2f: exact %lu, hist %lu", p[i], (unsigned long)exact, (unsigned long)got);
+        TEST_ASSERT_TRUE_MESSAGE(got >= exact, msg);
+        const double err = (double)(got - exact) / exact;
+        TEST_ASSERT_TRUE_MESSAGE(err <= MAX_ERR, msg);
+        if (err > worst) worst = err;
+    }
+    TEST_ASSERT_EQUAL_UINT32(max, hist_percentile(&s_h, 100.0f));
+
+    char line[64];
+    snprintf(line, sizeof(line), "worst percentile error %.2f %%", 100.0 * worst);
+    TEST_MESSAGE(line);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty);
+    RUN_TEST(test_bucket_edges);
+    RUN_TEST(test_bucket_width);
+    RUN_TEST(test_count_above);
+    RUN_TEST(test_percentiles_vs_exact);
+    return UNITY_END();
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    run_tests();
+}
+#else
+int main(void) {
+    return run_tests();
+}
+#endif
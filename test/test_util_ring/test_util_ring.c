@@ -0,0 +1,370 @@
+/* util_ring: single-threaded cases for index wraparound, lease / release order
+   and both overrun policies, then a producer / consumer stress run on two
+   pthreads that checks every block's contents, sequence continuity and the
+   drop / overwrite counters. Host only (pio test -e native). */
+
+#include "unity.h"
+#include "util_ring.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+#define COUNT       8
+#define SLOT        16
+#define STRESS_N    2000000u
+
+static ring_t   s_ring;
+static uint8_t  s_buf[COUNT * SLOT];
+static uint32_t s_seq[COUNT];
+
+void setUp(void) {
+    memset(s_buf, 0, sizeof(s_buf));
+}
+
+void tearDown(void) {}
+
+static void init(ring_overrun_t policy) {
+    TEST_ASSERT_TRUE(ring_init(&s_ring, s_buf, s_seq, COUNT, SLOT, policy));
+}
+
+// Write v into the next slot; false when the producer had to drop it
+static bool put(uint32_t v) {
+    uint8_t *slot = ring_write_begin(&s_ring);
+    if (!slot) return false;
+    memcpy(slot, &v, sizeof(v));
+    ring_write_commit(&s_ring);
+    return true;
+}
+
+static uint32_t value_of(const ring_block_t *b) {
+    uint32_t v;
+    memcpy(&v, b->data, sizeof(v));
+    return v;
+}
+
+/* Indices are free-running; start them just below 2^32 */
+static void start_at(uint32_t idx) {
+    atomic_store(&s_ring.head, idx);
+    atomic_store(&s_ring.lease, idx);
+    atomic_store(&s_ring.tail, idx);
+}
+
+static void test_init_rejects_bad_geometry(void) {
+    TEST_ASSERT_FALSE(ring_init(&s_ring, s_buf, s_seq, 6, SLOT, RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(ring_init(&s_ring, s_buf, s_seq, 1, SLOT, RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(ring_init(&s_ring, s_buf, s_seq, COUNT, 0, RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(ring_init(&s_ring, NULL, s_seq, COUNT, SLOT, RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(ring_init(&s_ring, s_buf, NULL, COUNT, SLOT, RING_DROP_NEWEST));
+    TEST_ASSERT_TRUE(ring_init(&s_ring, s_buf, s_seq, COUNT, SLOT, RING_DROP_NEWEST));
+}
+
+static void test_empty(void) {
+    init(RING_DROP_NEWEST);
+    ring_block_t b;
+    TEST_ASSERT_FALSE(ring_acquire(&s_ring, &b));
+    ring_release(&s_ring); // nothing leased: no-op
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.produced);
+    TEST_ASSERT_EQUAL_UINT32(0, st.pending);
+    TEST_ASSERT_EQUAL_UINT32(0, st.leased);
+}
+
+/* Many laps of the slot array, one block at a time and in bursts of count */
+static void test_wraparound_slots(void) {
+    init(RING_DROP_NEWEST);
+    ring_block_t b;
+    uint32_t next = 0;
+    for (uint32_t lap = 0; lap < 10 * COUNT; ++lap) {
+        const uint32_t burst = (lap % 2) ? COUNT : 1 + lap % 3;
+        for (uint32_t i = 0; i < burst; ++i) TEST_ASSERT_TRUE(put(next + i));
+        for (uint32_t i = 0; i < burst; ++i) {
+            TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+            TEST_ASSERT_EQUAL_UINT32(next, b.seq);
+            TEST_ASSERT_EQUAL_UINT32(next, value_of(&b));
+            TEST_ASSERT_EQUAL_PTR(s_buf + (next % COUNT) * SLOT, b.data);
+            ring_release(&s_ring);
+            next++;
+        }
+        TEST_ASSERT_FALSE(ring_acquire(&s_ring, &b));
+    }
+}
+
+/* The 32-bit indices overflow mid-ring: fullness, slots and seq stay right */
+static void test_wraparound_index_overflow(void) {
+    init(RING_DROP_NEWEST);
+    const uint32_t base = UINT32_MAX - 2;
+    start_at(base);
+    for (uint32_t i = 0; i < COUNT; ++i) TEST_ASSERT_TRUE(put(i));
+    TEST_ASSERT_FALSE(put(99));     // full across the overflow
+
+    ring_block_t b;
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+        TEST_ASSERT_EQUAL_UINT32(base + i, b.seq);
+        TEST_ASSERT_EQUAL_UINT32(i, value_of(&b));
+        TEST_ASSERT_EQUAL_PTR(s_buf + ((base + i) & (COUNT - 1)) * SLOT, b.data);
+        ring_release(&s_ring);
+    }
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.pending);
+    TEST_ASSERT_EQUAL_UINT32(1, st.dropped);
+}
+
+/* Several leases at once come out oldest first and go back oldest first;
+   a leased slot is never handed to the producer */
+static void test_lease_release_order(void) {
+    init(RING_DROP_NEWEST);
+    for (uint32_t i = 0; i < COUNT; ++i) TEST_ASSERT_TRUE(put(i));
+
+    ring_block_t b[3];
+    for (uint32_t i = 0; i < 3; ++i) {
+        TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b[i]));
+        TEST_ASSERT_EQUAL_UINT32(i, b[i].seq);
+    }
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(3, st.leased);
+    TEST_ASSERT_EQUAL_UINT32(COUNT - 3, st.pending);
+
+    // full: leased slots included, so nothing gets written
+    TEST_ASSERT_FALSE(put(100));
+
+    // one release frees exactly the oldest slot (block 0's)
+    ring_release(&s_ring);
+    uint8_t *slot = ring_write_begin(&s_ring);
+    TEST_ASSERT_EQUAL_PTR(b[0].data, slot);
+    memcpy(slot, &(uint32_t){ COUNT }, 4);
+    ring_write_commit(&s_ring);
+    TEST_ASSERT_EQUAL_UINT32(1, value_of(&b[1]));   // still-leased data untouched
+    TEST_ASSERT_EQUAL_UINT32(2, value_of(&b[2]));
+
+    ring_release(&s_ring);
+    ring_release(&s_ring);
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.leased);
+    ring_release(&s_ring); // extra release with no lease: ignored
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(0, st.leased);
+    TEST_ASSERT_EQUAL_UINT32(COUNT - 2, st.pending);
+
+    ring_block_t r;
+    for (uint32_t v = 3; v <= COUNT; ++v) {
+        TEST_ASSERT_TRUE(ring_acquire(&s_ring, &r));
+        TEST_ASSERT_EQUAL_UINT32(v, value_of(&r));
+        ring_release(&s_ring);
+    }
+}
+
+static void test_drop_newest(void) {
+    init(RING_DROP_NEWEST);
+    for (uint32_t i = 0; i < COUNT; ++i) TEST_ASSERT_TRUE(put(i));
+    for (uint32_t i = 0; i < 5; ++i) TEST_ASSERT_FALSE(put(100 + i));
+
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(COUNT, st.produced);   // drops take no sequence number
+    TEST_ASSERT_EQUAL_UINT32(5, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, st.overwritten);
+    TEST_ASSERT_EQUAL_UINT32(COUNT, st.high_water);
+
+    // the oldest blocks survive, in order
+    ring_block_t b;
+    for (uint32_t i = 0; i < COUNT; ++i) {
+        TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+        TEST_ASSERT_EQUAL_UINT32(i, b.seq);
+        TEST_ASSERT_EQUAL_UINT32(i, value_of(&b));
+        ring_release(&s_ring);
+    }
+    TEST_ASSERT_TRUE(put(COUNT));
+    TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+    TEST_ASSERT_EQUAL_UINT32(COUNT, b.seq);
+}
+
+static void test_overwrite_oldest(void) {
+    init(RING_OVERWRITE_OLDEST);
+    for (uint32_t i = 0; i < COUNT + 3; ++i) TEST_ASSERT_TRUE(put(i));
+
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(COUNT + 3, st.produced);
+    TEST_ASSERT_EQUAL_UINT32(3, st.overwritten);
+    TEST_ASSERT_EQUAL_UINT32(0, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(COUNT, st.pending);
+
+    // the newest count blocks survive; the gap shows in seq
+    ring_block_t b;
+    for (uint32_t i = 3; i < COUNT + 3; ++i) {
+        TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+        TEST_ASSERT_EQUAL_UINT32(i, b.seq);
+        TEST_ASSERT_EQUAL_UINT32(i, value_of(&b));
+        ring_release(&s_ring);
+    }
+    TEST_ASSERT_FALSE(ring_acquire(&s_ring, &b));
+}
+
+/* The oldest block is leased: it cannot be overwritten, so the new one drops */
+static void test_overwrite_skips_leased(void) {
+    init(RING_OVERWRITE_OLDEST);
+    for (uint32_t i = 0; i < COUNT; ++i) TEST_ASSERT_TRUE(put(i));
+    ring_block_t held;
+    TEST_ASSERT_TRUE(ring_acquire(&s_ring, &held));
+    TEST_ASSERT_FALSE(put(100));
+    TEST_ASSERT_EQUAL_UINT32(0, value_of(&held));
+
+    ring_stats_t st;
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, st.overwritten);
+
+    // released: the next write may overwrite again (block 1, the oldest pending)
+    ring_release(&s_ring);
+    TEST_ASSERT_TRUE(put(COUNT));
+    TEST_ASSERT_TRUE(put(COUNT + 1));
+    ring_get_stats(&s_ring, &st);
+    TEST_ASSERT_EQUAL_UINT32(1, st.overwritten);
+    ring_block_t b;
+    TEST_ASSERT_TRUE(ring_acquire(&s_ring, &b));
+    TEST_ASSERT_EQUAL_UINT32(2, b.seq);
+}
+
+/* ---------- two-thread stress ---------- */
+
+#define S_COUNT     64
+#define S_SLOT      64  // 16 words, all stamped with the block's seq
+
+typedef struct {
+    ring_t   ring;
+    uint8_t  buf[S_COUNT * S_SLOT];
+    uint32_t seq[S_COUNT];
+    uint32_t attempts;          // producer
+    atomic_bool done;
+    // consumer results
+    uint32_t received;
+    uint32_t gaps;              // seqs never received
+    uint32_t torn;              // slots whose words did not all match seq
+    uint32_t out_of_order;
+} stress_t;
+
+static stress_t s_st;
+
+/* Both sides do a little work per block, varied so the ring keeps running
+   empty and full; an occasional yield adds longer stalls */
+static void jitter(uint32_t i, uint32_t every) {
+    volatile uint32_t spin = (i * 2654435761u) >> 25;   // 0..127
+    while (spin) spin--;
+    if (i % every == 0) sched_yield();
+}
+
+static void *producer(void *arg) {
+    stress_t *s = arg;
+    uint32_t committed = 0;
+    for (uint32_t i = 0; i < STRESS_N; ++i) {
+        uint32_t *w = (uint32_t *)ring_write_begin(&s->ring);
+        if (w) {
+            // commit assigns seq = head, which is the count of commits so far
+            for (uint32_t k = 0; k < S_SLOT / 4; ++k) w[k] = committed;
+            ring_write_commit(&s->ring);
+            committed++;
+        }
+        jitter(i, 97);      // yield often enough that a single-core host keeps up
+    }
+    s->attempts = STRESS_N;
+    atomic_store(&s->done, true);
+    return NULL;
+}
+
+static void *consumer(void *arg) {
+    stress_t *s = arg;
+    ring_block_t b;
+    uint32_t expect = 0, i = 0;     // seq of the next block if none were lost
+    for (;;) {
+        if (!ring_acquire(&s->ring, &b)) {
+            // done is read first: a block committed before it is still picked up
+            const bool done = atomic_load(&s->done);
+            if (!ring_acquire(&s->ring, &b)) {
+                if (done) break;
+                continue;
+            }
+        }
+        const uint32_t *w = (const uint32_t *)b.data;
+        for (uint32_t k = 0; k < S_SLOT / 4; ++k) {
+            if (w[k] != b.seq) { s->torn++; break; }
+        }
+        if (b.seq < expect) {
+            s->out_of_order++;
+        } else {
+            s->gaps += b.seq - expect;
+            expect = b.seq + 1;
+        }
+        s->received++;
+        ring_release(&s->ring);
+        jitter(++i, 3001);
+    }
+    return NULL;
+}
+
+static void stress(ring_overrun_t policy) {
+    memset(&s_st, 0, sizeof(s_st));
+    TEST_ASSERT_TRUE(ring_init(&s_st.ring, s_st.buf, s_st.seq, S_COUNT, S_SLOT, policy));
+    pthread_t p, c;
+    TEST_ASSERT_EQUAL(0, pthread_create(&c, NULL, consumer, &s_st));
+    TEST_ASSERT_EQUAL(0, pthread_create(&p, NULL, producer, &s_st));
+    pthread_join(p, NULL);
+    pthread_join(c, NULL);
+
+    ring_stats_t st;
+    ring_get_stats(&s_st.ring, &st);
+    char line[200];
+    snprintf(line, sizeof(line), "%s: %u attempts, %u produced, %u received, %u dropped, %u overwritten, high water %u",
+        policy == RING_DROP_NEWEST ? "drop-newest" : "overwrite-oldest",
+        s_st.attempts, st.produced, s_st.received, st.dropped, st.overwritten, st.high_water);
+    TEST_MESSAGE(line);
+
+    TEST_ASSERT_EQUAL_UINT32(0, s_st.torn);
+    TEST_ASSERT_EQUAL_UINT32(0, s_st.out_of_order);
+    TEST_ASSERT_EQUAL_UINT32(s_st.attempts, st.produced + st.dropped);
+    TEST_ASSERT_EQUAL_UINT32(st.produced, s_st.received + st.overwritten);
+    TEST_ASSERT_EQUAL_UINT32(0, st.pending);
+    TEST_ASSERT_EQUAL_UINT32(0, st.leased);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(S_COUNT, st.high_water);
+    if (policy == RING_DROP_NEWEST) {
+        // drops take no sequence number: what arrives is gap-free
+        TEST_ASSERT_EQUAL_UINT32(0, s_st.gaps);
+        TEST_ASSERT_EQUAL_UINT32(0, st.overwritten);
+    } else {
+        // every overwritten block is a hole in the sequence
+        TEST_ASSERT_EQUAL_UINT32(st.overwritten, s_st.gaps);
+    }
+}
+
+static void test_stress_drop_newest(void) {
+    stress(RING_DROP_NEWEST);
+}
+
+static void test_stress_overwrite_oldest(void) {
+    stress(RING_OVERWRITE_OLDEST);
+}
+
+static int run_tests(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_geometry);
+    RUN_TEST(test_empty);
+    RUN_TEST(test_wraparound_slots);
+    RUN_TEST(test_wraparound_index_overflow);
+    RUN_TEST(test_lease_release_order);
+    RUN_TEST(test_drop_newest);
+    RUN_TEST(test_overwrite_oldest);
+    RUN_TEST(test_overwrite_skips_leased);
+    RUN_TEST(test_stress_drop_newest);
+    RUN_TEST(test_stress_overwrite_oldest);
+    return UNITY_END();
+}
+
+int main(void) {
+    return run_tests();
+}